@@ -17,9 +17,27 @@
 #ifndef ARCH_CONFIG_H
 #define ARCH_CONFIG_H
 
-typedef enum CPU_FEATURE { SSE4_2 = 0, AVX2_FMA = 1, AVX_512 = 2 } CPU_FEATURE;
+typedef enum CPU_FEATURE {
+  SSE4_2 = 0,
+  AVX2_FMA = 1,
+  AVX_512 = 2,
+  AVX_512_VNNI = 3,
+  AVX_VNNI = 4,
+  AMX_INT8 = 5
+} CPU_FEATURE;
 
-#if defined(AVX512)
+// One 16x16 int32 accumulator tile, fed by a 16x64 u8 data tile and a 16x64 s8 weight tile in VNNI order
+#if defined(AMX)
+#define GEMM_SHUFFLE_KERNEL_M 16
+#define GEMM_SHUFFLE_KERNEL_N 16
+#define GEMM_SHUFFLE_KERNEL_K 64
+#define CONV_SHUFFLE_KERNEL_M GEMM_SHUFFLE_KERNEL_M
+#define CONV_SHUFFLE_KERNEL_N GEMM_SHUFFLE_KERNEL_N
+#define CONV_SHUFFLE_KERNEL_K GEMM_SHUFFLE_KERNEL_K
+#define FC_SHUFFLE_KERNEL_M GEMM_SHUFFLE_KERNEL_M
+#define FC_SHUFFLE_KERNEL_N GEMM_SHUFFLE_KERNEL_N
+#define FC_SHUFFLE_KERNEL_K GEMM_SHUFFLE_KERNEL_K
+#elif defined(AVX512)
 #define GEMM_SHUFFLE_KERNEL_M 8
 #define GEMM_SHUFFLE_KERNEL_N 8
 #define GEMM_SHUFFLE_KERNEL_K 8
@@ -51,4 +69,19 @@ typedef enum CPU_FEATURE { SSE4_2 = 0, AVX2_FMA = 1, AVX_512 = 2 } CPU_FEATURE;
 #define FC_SHUFFLE_KERNEL_K GEMM_SHUFFLE_KERNEL_K
 #endif
 
+// Largest batch a fully connected layer runs as a GEMV, streaming the weight once instead of padding the batch to
+// FC_SHUFFLE_KERNEL_N columns. AMX keeps the GEMM, its weight panel is in the VNNI tile order.
+#define FC_GEMV_MAX_BATCH 4
+
+// Multiply-adds an op runs per thread under AUTO_THREADS_NUM, below it a thread costs more to wake and join than it
+// saves
+#define AUTO_THREADS_WORK_PER_THREAD (1 << 22)
+
+// Cache sizes assumed when neither cpuid nor sysfs reports them
+#define CACHE_DEFAULT_L1_SIZE (32 << 10)
+#define CACHE_DEFAULT_L2_SIZE (1 << 20)
+
+// Runs of every candidate blocking the tuner keeps the fastest of
+#define AUTOTUNE_REPEAT 3
+
 #endif
@@ -18,18 +18,27 @@
 #define ARCH_CPUID_H
 #include <string>
 #include "../common.h"
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 static bool cpuid_support_feature(CPU_FEATURE f) {
   bool support_sse4_2;
   bool support_avx2;
   bool support_fma;
   bool support_avx512;
+  bool support_avx512_vnni;
+  bool support_avx_vnni;
+  bool support_amx_int8;
+  bool support_osxsave;
   {
     uint32_t eax, ebx, ecx, edx;
     eax = 1;
     __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
     support_sse4_2 = ecx & (1 << 20);
     support_fma = ecx & (1 << 12);
+    support_osxsave = ecx & (1 << 27);
   }
   {
     uint32_t eax, ebx, ecx, edx;
@@ -38,6 +47,23 @@ static bool cpuid_support_feature(CPU_FEATURE f) {
     __asm__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
     support_avx2 = ebx & (1 << 5);
     support_avx512 = ebx & ((1 << 16) + (1 << 17) + (1 << 30) + (1 << 31));
+    support_avx512_vnni = ecx & (1 << 11);
+    support_amx_int8 = (edx & (1 << 24)) && (edx & (1 << 25));  // AMX-TILE and AMX-INT8
+  }
+  {
+    uint32_t eax, ebx, ecx, edx;
+    eax = 7;
+    ecx = 1;
+    __asm__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    support_avx_vnni = eax & (1 << 4);
+  }
+  if (support_amx_int8) {
+    // the OS has to manage the XTILECFG and XTILEDATA states (XCR0 bits 17 and 18)
+    uint32_t xcr0 = 0, xcr0_high;
+    if (support_osxsave) {
+      __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+    }
+    support_amx_int8 = (xcr0 & (3 << 17)) == (3 << 17);
   }
   if (f == SSE4_2) {
     return support_sse4_2;
@@ -45,24 +71,93 @@ static bool cpuid_support_feature(CPU_FEATURE f) {
     return support_fma && support_avx2;
   } else if (f == AVX_512) {
     return support_avx512;
+  } else if (f == AVX_512_VNNI) {
+    return support_avx512 && support_avx512_vnni;
+  } else if (f == AVX_VNNI) {
+    return support_fma && support_avx2 && support_avx_vnni;
+  } else if (f == AMX_INT8) {
+    return support_avx512 && support_amx_int8;
   } else {
     throw "Unknown CPU ISA. Internal Error.\n";
   }
 }
 
+// Linux keeps the tile data state disabled until the process asks for it. The permission is per process, so
+// asking more than once is harmless.
+static bool cpuid_request_amx_permission() {
+#if defined(__linux__)
+  const int ARCH_REQ_XCOMP_PERM = 0x1023;
+  const int XFEATURE_XTILEDATA = 18;
+  return syscall(SYS_arch_prctl, ARCH_REQ_XCOMP_PERM, XFEATURE_XTILEDATA) == 0;
+#else
+  return true;
+#endif
+}
+
+// cache_type follows cpuid leaf 4: 1 data, 2 instruction, 3 unified
 struct cache_info {
   int cache_id;
   int cache_level;
+  int cache_type;
   size_t cache_size;
+  // Logical processors sharing the cache, an upper bound when it comes from cpuid
+  size_t sharing_threads;
   size_t logic_cores_per_package;
   bool hyper_threading;
   bool inclusive;
 };
 
+// Processor brand string of leaves 0x80000002-0x80000004, empty when the CPU does not report one
+static inline std::string cpuid_brand_string() {
+  uint32_t eax, ebx, ecx, edx;
+  eax = 0x80000000;
+  __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if (eax < 0x80000004) return std::string();
+
+  char brand[49] = {0};
+  for (uint32_t leaf = 0; leaf < 3; ++leaf) {
+    uint32_t regs[4];
+    regs[0] = 0x80000002 + leaf;
+    __asm__("cpuid" : "+a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3]));
+    memcpy(brand + leaf * 16, regs, sizeof(regs));
+  }
+  std::string ret(brand);
+  size_t begin = ret.find_first_not_of(' ');
+  return (begin == std::string::npos) ? std::string() : ret.substr(begin);
+}
+
+static bool cpuid_vendor_amd() {
+  uint32_t eax = 0, ebx, ecx, edx;
+  __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  char vendor[13] = {0};
+  memcpy(vendor, &ebx, 4);
+  memcpy(vendor + 4, &edx, 4);
+  memcpy(vendor + 8, &ecx, 4);
+  return (strcmp(vendor, "AuthenticAMD") == 0) || (strcmp(vendor, "HygonGenuine") == 0);
+}
+
+// Deterministic cache parameters: leaf 4 on Intel, leaf 0x8000001D on AMD, which has the same register layout but is
+// only there with the topology extensions (leaf 0x80000001 ecx bit 22). Returns -1 when cache_id is past the last
+// cache or the leaf is missing.
 static int cpuid_caches(int cache_id, struct cache_info& info) {
   uint32_t eax, ebx, ecx, edx;
+  uint32_t leaf = 4;
+
+  if (cpuid_vendor_amd()) {
+    eax = 0x80000000;
+    __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    if (eax < 0x8000001D) return -1;
+    eax = 0x80000001;
+    __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    if (((ecx >> 22) & 1) == 0) return -1;
+    leaf = 0x8000001D;
+  } else {
+    eax = 0;
+    __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    if (eax < 4) return -1;
+  }
 
-  eax = 4;         // get cache info
+  eax = leaf;      // get cache info
   ecx = cache_id;  // cache id
 
   __asm__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
@@ -72,6 +167,7 @@ static int cpuid_caches(int cache_id, struct cache_info& info) {
   if (cache_type == 0) return -1;
 
   size_t cache_level = (eax >> 5) & 0x7;
+  size_t sharing_threads = ((eax >> 14) & 0xfff) + 1;
   size_t cache_sets = ecx + 1;
   size_t cacheline_size = (ebx & 0xfff) + 1;
   size_t cacheline_partitions = ((ebx >> 12) & 0x3ff) + 1;
@@ -81,13 +177,81 @@ static int cpuid_caches(int cache_id, struct cache_info& info) {
 
   info.cache_id = cache_id;
   info.cache_level = cache_level;
+  info.cache_type = cache_type;
   info.cache_size = cache_size;
+  info.sharing_threads = sharing_threads;
   info.inclusive = inclusive;
+  info.logic_cores_per_package = 0;
 
-  eax = 0xb;
-  ecx = 1;
-  __asm__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
-  info.logic_cores_per_package = ebx;
+  eax = 0;
+  __asm__("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if (eax >= 0xb) {
+    eax = 0xb;
+    ecx = 1;
+    __asm__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    info.logic_cores_per_package = ebx & 0xffff;
+  }
+  return 0;
+}
+
+// Same as cpuid_caches from /sys/devices/system/cpu/cpu0/cache, for the hypervisors which hide or zero the cpuid
+// cache leaves. Linux only, -1 elsewhere.
+static int sysfs_caches(int cache_id, struct cache_info& info) {
+#if defined(__linux__)
+  std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(cache_id) + "/";
+  char buffer[256];
+  auto read = [&](const char* name) -> bool {
+    FILE* fp = fopen((dir + name).c_str(), "r");
+    if (fp == NULL) return false;
+    bool ok = fgets(buffer, sizeof(buffer), fp) != NULL;
+    fclose(fp);
+    return ok;
+  };
+
+  if (!read("level")) return -1;
+  info.cache_level = atoi(buffer);
+  if (!read("type")) return -1;
+  info.cache_type = (strncmp(buffer, "Data", 4) == 0) ? 1 : (strncmp(buffer, "Instruction", 11) == 0) ? 2 : 3;
+  if (!read("size")) return -1;
+  // "32K", "1024K" or "32M"
+  char* unit;
+  size_t cache_size = strtoul(buffer, &unit, 10);
+  if (*unit == 'K') cache_size <<= 10;
+  if (*unit == 'M') cache_size <<= 20;
+  info.cache_size = cache_size;
+  // A list of cpus and ranges, "0-7,64-71"
+  info.sharing_threads = 1;
+  if (read("shared_cpu_list")) {
+    size_t threads = 0;
+    for (char* p = buffer; *p != '\0' && *p != '\n';) {
+      size_t first = strtoul(p, &p, 10), last = first;
+      if (*p == '-') last = strtoul(p + 1, &p, 10);
+      threads += last - first + 1;
+      if (*p != ',') break;
+      ++p;
+    }
+    info.sharing_threads = std::max(threads, static_cast<size_t>(1));
+  }
+  info.cache_id = cache_id;
+  info.logic_cores_per_package = 0;
+  info.inclusive = false;
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+// Data or unified cache of the given level, whatever the enumeration order of the vendor. cpuid first, sysfs when it
+// reports nothing usable. Returns -1 when there is no such cache.
+static int find_cache(int cache_level, struct cache_info& info) {
+  for (int source = 0; source < 2; ++source) {
+    for (int cache_id = 0; cache_id < 16; ++cache_id) {
+      int ret = (source == 0) ? cpuid_caches(cache_id, info) : sysfs_caches(cache_id, info);
+      if (ret < 0) break;
+      if ((info.cache_level == cache_level) && (info.cache_type != 2) && (info.cache_size > 0)) return 0;
+    }
+  }
+  return -1;
 }
 
 #endif
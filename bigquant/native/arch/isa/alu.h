@@ -23,6 +23,8 @@
 #define MIN_PS _mm512_min_ps
 #define ADD_PS _mm512_add_ps
 #define SUB_PS _mm512_sub_ps
+#define MAX_PS_HALF _mm256_max_ps
+#define SUB_PS_HALF _mm256_sub_ps
 #elif defined(__AVX2__)
 #define MAX_PS _mm256_max_ps
 #define MIN_PS _mm256_min_ps
@@ -45,6 +47,8 @@
 #define SUB_EPI16 _mm512_sub_epi16
 #define ADDS_EPI16 _mm512_adds_epi16
 #define ABS_EPI16 _mm512_abs_epi16
+#define AND_SI _mm512_and_si512
+#define ANDNOT_SI _mm512_andnot_si512
 #elif defined(__AVX2__)
 #define ADD_EPI32 _mm256_add_epi32
 #define ADD_EPI32_HALF _mm_add_epi32
@@ -55,6 +59,8 @@
 #define SUB_EPI16 _mm256_sub_epi16
 #define ADDS_EPI16 _mm256_adds_epi16
 #define ABS_EPI16 _mm256_abs_epi16
+#define AND_SI _mm256_and_si256
+#define ANDNOT_SI _mm256_andnot_si256
 #define CMP_EPI16 _mm256_cmpgt_epi16
 #define TESTZ_SI256 _mm256_testz_si256
 #define TESTZ_SI _mm256_testz_si256
@@ -67,6 +73,8 @@
 #define SUB_EPI16 _mm_sub_epi16
 #define ADDS_EPI16 _mm_add_epi16
 #define ABS_EPI16 _mm_abs_epi16
+#define AND_SI _mm_and_si128
+#define ANDNOT_SI _mm_andnot_si128
 #define CMP_EPI16 _mm_cmpgt_epi16
 #define TESTZ_SI128 _mm_testz_si128
 #define TESTZ_SI TESTZ_SI128
@@ -97,6 +105,7 @@
 #else  // __SSE4_2__
 #define CVTSS_PS _mm_cvtss_f32
 #define CVTEPI32_PS _mm_cvtepi32_ps
+#define EPI32TOPS _mm_cvtepi32_ps
 #define EPI16TOEPI32 _mm_cvtepi16_epi32
 #define PSTOEPI32 _mm_cvttps_epi32
 #endif
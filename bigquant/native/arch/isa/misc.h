@@ -25,6 +25,7 @@
 #define SET1_EPI8 _mm512_set1_epi8
 #define SET1_EPI16 _mm512_set1_epi16
 #define SET1_EPI32 _mm512_set1_epi32
+#define SET1_EPI64 _mm512_set1_epi64
 #define SET1_PS _mm512_set1_ps
 #define SET1_PS_HALF _mm256_set1_ps
 #define SET_EPI8 _mm512_set_epi8
@@ -35,6 +36,7 @@
 #elif defined(__AVX2__)
 #define ZEROS _mm256_setzero_si256
 #define INIT(X) SIMDSITYPE X = ZEROS()
+#define SET1_EPI8 _mm256_set1_epi8
 #define SET1_EPI16 _mm256_set1_epi16
 #define SET1_EPI32 _mm256_set1_epi32
 #define SET_EPI32 _mm256_set_epi32
@@ -47,6 +49,7 @@
 #else  // __SSE4_2__
 #define ZEROS _mm_setzero_si128
 #define INIT(X) SIMDSITYPE X = ZEROS()
+#define SET1_EPI8 _mm_set1_epi8
 #define SET1_EPI16 _mm_set1_epi16
 #define SET1_PS _mm_set1_ps
 #define SET_EPI8 _mm_set_epi8
@@ -42,6 +42,10 @@
 #elif defined(__AVX2__)
 #define MADD_EPI8 _mm256_maddubs_epi16
 #define MADD_EPI16 _mm256_madd_epi16
+#if defined(__AVXVNNI__)
+// c + sum of the 4 adjacent u8 x s8 products, accumulated in int32
+#define DPBUSD_EPI32 _mm256_dpbusd_avx_epi32
+#endif
 #else  // __SSE4_2__
 #define MADD_EPI8 _mm_maddubs_epi16
 #define MADD_EPI16 _mm_madd_epi16
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdio.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include "common.h"
+
+// Blockings picked by timing the GEMM rather than derived from the cache sizes. The cache file is plain text with one
+// winner per line:
+//
+//   <cpu brand>\t<isa>\t<m> <n> <k> <threads> <m_in_l1> <m_in_l2> <m_in_l3> <n_in_l1> <n_in_l2> <n_in_l3> <mltn>
+//
+// Lines of other CPUs or ISAs are skipped, so one file may be shared by different machines.
+#if defined(AMX)
+#define TUNING_ISA "amx"
+#elif defined(AVX512_VNNI)
+#define TUNING_ISA "avx512vnni"
+#elif defined(AVX512)
+#define TUNING_ISA "avx512"
+#elif defined(__AVXVNNI__)
+#define TUNING_ISA "avxvnni"
+#elif defined(__AVX2__)
+#define TUNING_ISA "avx2"
+#else
+#define TUNING_ISA "sse42"
+#endif
+
+// m, n, k and threads_num of a tuned GEMM
+typedef std::array<size_t, 4> TuningKey;
+
+struct TuningCache {
+  TuningCache() : enabled_(false), cpu_(cpuid_brand_string()) {
+  }
+
+  void Setup(bool enabled, const char *path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    path_ = (path == NULL) ? "" : path;
+    entries_.clear();
+    if (!path_.empty()) {
+      Load();
+    }
+  }
+
+  bool Enabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+  }
+
+  bool Find(const TuningKey &key, BlocksInfo &blocks_info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end()) {
+      return false;
+    }
+    blocks_info = iter->second;
+    return true;
+  }
+
+  void Store(const TuningKey &key, const BlocksInfo &blocks_info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = blocks_info;
+    if (path_.empty()) {
+      return;
+    }
+    FILE *fp = fopen(path_.c_str(), "a");
+    if (fp == NULL) {
+      fprintf(stderr, "Cannot append to the tuning cache %s.\n", path_.c_str());
+      return;
+    }
+    fprintf(fp, "%s\t%s\t%zu %zu %zu %zu %zu %zu %zu %zu %zu %zu %d\n", cpu_.c_str(), TUNING_ISA, key[0], key[1],
+            key[2], key[3], blocks_info.m_in_l1_, blocks_info.m_in_l2_, blocks_info.m_in_l3_, blocks_info.n_in_l1_,
+            blocks_info.n_in_l2_, blocks_info.n_in_l3_, blocks_info.mltn_ ? 1 : 0);
+    fclose(fp);
+  }
+
+  // Held while timing, concurrent measurements would slow each other down
+  std::mutex &TuneMutex() {
+    return tune_mutex_;
+  }
+
+ private:
+  // A missing file is an empty cache, malformed lines are skipped
+  void Load() {
+    FILE *fp = fopen(path_.c_str(), "r");
+    if (fp == NULL) {
+      return;
+    }
+    std::string prefix = cpu_ + "\t" + TUNING_ISA + "\t";
+    char line[1024];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+      if (strncmp(line, prefix.c_str(), prefix.size()) != 0) {
+        continue;
+      }
+      TuningKey key;
+      BlocksInfo blocks_info;
+      int mltn;
+      if (sscanf(line + prefix.size(), "%zu %zu %zu %zu %zu %zu %zu %zu %zu %zu %d", &key[0], &key[1], &key[2],
+                 &key[3], &blocks_info.m_in_l1_, &blocks_info.m_in_l2_, &blocks_info.m_in_l3_, &blocks_info.n_in_l1_,
+                 &blocks_info.n_in_l2_, &blocks_info.n_in_l3_, &mltn) != 11) {
+        continue;
+      }
+      // A zero block would never advance the GEMM loops
+      if ((blocks_info.m_in_l1_ == 0) || (blocks_info.m_in_l2_ == 0) || (blocks_info.m_in_l3_ == 0) ||
+          (blocks_info.n_in_l1_ == 0) || (blocks_info.n_in_l2_ == 0) || (blocks_info.n_in_l3_ == 0)) {
+        continue;
+      }
+      blocks_info.mltn_ = (mltn != 0);
+      entries_[key] = blocks_info;
+    }
+    fclose(fp);
+  }
+
+  bool enabled_;
+  std::string cpu_;
+  std::string path_;
+  std::map<TuningKey, BlocksInfo> entries_;
+  std::mutex mutex_;
+  std::mutex tune_mutex_;
+};
+
+INLINE_SPECIFIER TuningCache &GetTuningCache() {
+  static TuningCache cache;
+  return cache;
+}
+#endif
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <cmath>
 #include <vector>
+#include <mutex>
 #include <float.h>
 #include <stdint.h>
 #include <cassert>
@@ -39,6 +40,8 @@
 #include "arch/config.h"
 
 #define UNROLL_NUM 4
+// Max number of execution plans (one per input shape) cached by one op
+#define MAX_PLAN_NUM 16
 
 #if defined(DEBUG)
 #define INLINE_ATTRIBUTE
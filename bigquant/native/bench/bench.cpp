@@ -0,0 +1,455 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency of QuantizedConvOp, QuantizedFCOp and MixPrecisionGEMM over the layers of real networks, for every batch
+// size and thread count asked for. Reports the latency percentiles, the GOPS (2 ops per multiply-add) and, when built
+// with BENCH_CBLAS, the speedup over cblas_sgemm of the same GEMM. The sgemm baseline is the lowered GEMM only, without
+// the im2col the quantized ops include. The results are written as JSON so that releases can be compared.
+//
+//   bench.out [--suite conv|fc|gemm|all] [--net name] [--batches 1,16] [--threads 1,0] [--iters 50] [--warmup 5]
+//             [--max-ms 2000] [--layout nhwc|nchw] [--pool] [--json file]
+//
+// threads 0 is every thread of the parallel backend. --pool runs on THREAD_POOL_BACKEND instead of OpenMP.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bigquant.h"
+#if defined(BENCH_CBLAS)
+#include <cblas.h>
+#endif
+
+// Token count of one BERT sequence, the FC batch of a BERT layer is batch x BENCH_BERT_SEQ_LEN rows
+#define BENCH_BERT_SEQ_LEN 128
+
+struct ConvShape {
+  const char *net_;
+  const char *name_;
+  size_t channel_in_;
+  size_t size_in_;
+  size_t channel_out_;
+  size_t kernel_;
+  size_t stride_;
+  size_t pad_;
+  size_t groups_;
+};
+
+struct FCShape {
+  const char *net_;
+  const char *name_;
+  size_t channel_in_;
+  size_t channel_out_;
+  // Rows per unit of batch, the sequence length for the transformer layers
+  size_t rows_per_batch_;
+};
+
+// ResNet-50 v1.5, every distinct layer once
+static const ConvShape kConvShapes[] = {
+    {"resnet50", "conv1", 3, 224, 64, 7, 2, 3, 1},
+    {"resnet50", "res2_1x1_reduce", 64, 56, 64, 1, 1, 0, 1},
+    {"resnet50", "res2_3x3", 64, 56, 64, 3, 1, 1, 1},
+    {"resnet50", "res2_1x1_expand", 64, 56, 256, 1, 1, 0, 1},
+    {"resnet50", "res2_1x1_in", 256, 56, 64, 1, 1, 0, 1},
+    {"resnet50", "res3_1x1_reduce_first", 256, 56, 128, 1, 1, 0, 1},
+    {"resnet50", "res3_3x3_stride", 128, 56, 128, 3, 2, 1, 1},
+    {"resnet50", "res3_downsample", 256, 56, 512, 1, 2, 0, 1},
+    {"resnet50", "res3_1x1_expand", 128, 28, 512, 1, 1, 0, 1},
+    {"resnet50", "res3_1x1_reduce", 512, 28, 128, 1, 1, 0, 1},
+    {"resnet50", "res3_3x3", 128, 28, 128, 3, 1, 1, 1},
+    {"resnet50", "res4_1x1_reduce_first", 512, 28, 256, 1, 1, 0, 1},
+    {"resnet50", "res4_3x3_stride", 256, 28, 256, 3, 2, 1, 1},
+    {"resnet50", "res4_downsample", 512, 28, 1024, 1, 2, 0, 1},
+    {"resnet50", "res4_1x1_expand", 256, 14, 1024, 1, 1, 0, 1},
+    {"resnet50", "res4_1x1_reduce", 1024, 14, 256, 1, 1, 0, 1},
+    {"resnet50", "res4_3x3", 256, 14, 256, 3, 1, 1, 1},
+    {"resnet50", "res5_1x1_reduce_first", 1024, 14, 512, 1, 1, 0, 1},
+    {"resnet50", "res5_3x3_stride", 512, 14, 512, 3, 2, 1, 1},
+    {"resnet50", "res5_downsample", 1024, 14, 2048, 1, 2, 0, 1},
+    {"resnet50", "res5_1x1_expand", 512, 7, 2048, 1, 1, 0, 1},
+    {"resnet50", "res5_1x1_reduce", 2048, 7, 512, 1, 1, 0, 1},
+    {"resnet50", "res5_3x3", 512, 7, 512, 3, 1, 1, 1},
+    // MobileNet-v2, the stem, one block per resolution and the head
+    {"mobilenet_v2", "conv1", 3, 224, 32, 3, 2, 1, 1},
+    {"mobilenet_v2", "block1_dw", 32, 112, 32, 3, 1, 1, 32},
+    {"mobilenet_v2", "block1_project", 32, 112, 16, 1, 1, 0, 1},
+    {"mobilenet_v2", "block2_expand", 16, 112, 96, 1, 1, 0, 1},
+    {"mobilenet_v2", "block2_dw_stride", 96, 112, 96, 3, 2, 1, 96},
+    {"mobilenet_v2", "block2_project", 96, 56, 24, 1, 1, 0, 1},
+    {"mobilenet_v2", "block3_expand", 24, 56, 144, 1, 1, 0, 1},
+    {"mobilenet_v2", "block3_dw", 144, 56, 144, 3, 1, 1, 144},
+    {"mobilenet_v2", "block3_project", 144, 56, 24, 1, 1, 0, 1},
+    {"mobilenet_v2", "block5_expand", 32, 28, 192, 1, 1, 0, 1},
+    {"mobilenet_v2", "block5_dw", 192, 28, 192, 3, 1, 1, 192},
+    {"mobilenet_v2", "block5_project", 192, 28, 32, 1, 1, 0, 1},
+    {"mobilenet_v2", "block8_expand", 64, 14, 384, 1, 1, 0, 1},
+    {"mobilenet_v2", "block8_dw", 384, 14, 384, 3, 1, 1, 384},
+    {"mobilenet_v2", "block8_project", 384, 14, 64, 1, 1, 0, 1},
+    {"mobilenet_v2", "block15_expand", 160, 7, 960, 1, 1, 0, 1},
+    {"mobilenet_v2", "block15_dw", 960, 7, 960, 3, 1, 1, 960},
+    {"mobilenet_v2", "block15_project", 960, 7, 160, 1, 1, 0, 1},
+    {"mobilenet_v2", "conv_last", 320, 7, 1280, 1, 1, 0, 1},
+    // VGG-16
+    {"vgg16", "conv1_1", 3, 224, 64, 3, 1, 1, 1},
+    {"vgg16", "conv1_2", 64, 224, 64, 3, 1, 1, 1},
+    {"vgg16", "conv2_1", 64, 112, 128, 3, 1, 1, 1},
+    {"vgg16", "conv2_2", 128, 112, 128, 3, 1, 1, 1},
+    {"vgg16", "conv3_1", 128, 56, 256, 3, 1, 1, 1},
+    {"vgg16", "conv3_2", 256, 56, 256, 3, 1, 1, 1},
+    {"vgg16", "conv4_1", 256, 28, 512, 3, 1, 1, 1},
+    {"vgg16", "conv4_2", 512, 28, 512, 3, 1, 1, 1},
+    {"vgg16", "conv5_1", 512, 14, 512, 3, 1, 1, 1},
+};
+
+static const FCShape kFCShapes[] = {
+    {"resnet50", "fc1000", 2048, 1000, 1},
+    {"mobilenet_v2", "fc1000", 1280, 1000, 1},
+    {"vgg16", "fc6", 25088, 4096, 1},
+    {"vgg16", "fc7", 4096, 4096, 1},
+    {"vgg16", "fc8", 4096, 1000, 1},
+    {"bert_base", "attention_qkv", 768, 2304, BENCH_BERT_SEQ_LEN},
+    {"bert_base", "attention_output", 768, 768, BENCH_BERT_SEQ_LEN},
+    {"bert_base", "intermediate", 768, 3072, BENCH_BERT_SEQ_LEN},
+    {"bert_base", "output", 3072, 768, BENCH_BERT_SEQ_LEN},
+};
+
+struct BenchOptions {
+  std::string suite_ = "all";
+  std::string net_;
+  std::vector<size_t> batches_ = {1, 16};
+  std::vector<size_t> threads_ = {1, 0};
+  size_t iters_ = 50;
+  size_t warmup_ = 5;
+  double max_ms_ = 2000.0;
+  LAYOUT layout_ = NHWC;
+  bool pool_ = false;
+  std::string json_;
+};
+
+struct Latency {
+  double min_;
+  double mean_;
+  double p50_;
+  double p90_;
+  double p99_;
+  size_t iters_;
+};
+
+static size_t GetConvOutSize(size_t in, size_t kernel, size_t stride, size_t pad) {
+  return (in + 2 * pad - kernel) / stride + 1;
+}
+
+static std::vector<size_t> ParseList(const char *arg) {
+  std::vector<size_t> ret;
+  for (const char *p = arg; *p != '\0';) {
+    char *end;
+    ret.push_back(strtoul(p, &end, 10));
+    p = (*end == ',') ? end + 1 : end;
+    if (end == p) {
+      break;
+    }
+  }
+  return ret;
+}
+
+static void FillRandom(std::vector<float> &v, float low, float high) {
+  unsigned int state = 12345;
+  for (size_t i = 0; i < v.size(); ++i) {
+    state = state * 1103515245 + 12345;
+    v[i] = low + (high - low) * ((state >> 8) & 0xffff) / 65535.0f;
+  }
+}
+
+// Runs f warmup times, then until iters runs or max_ms are done, at least 3 timed runs
+template <typename F>
+static Latency Measure(const BenchOptions &options, F f) {
+  for (size_t i = 0; i < options.warmup_; ++i) {
+    f();
+  }
+  std::vector<double> samples;
+  double total = 0.0;
+  while ((samples.size() < options.iters_) && ((samples.size() < 3) || (total < options.max_ms_ * 1e3))) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    total += samples.back();
+  }
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1) + 0.5)]; };
+  Latency ret = {samples.front(), total / samples.size(), percentile(0.5), percentile(0.9), percentile(0.99),
+                 samples.size()};
+  return ret;
+}
+
+static void SetThreads(const BenchOptions &options, size_t threads) {
+  BigQuantSetParallelBackend(options.pool_ ? THREAD_POOL_BACKEND : OPENMP_BACKEND, threads);
+#if defined(BENCH_CBLAS)
+  openblas_set_num_threads((threads == 0) ? openblas_get_num_procs() : static_cast<int>(threads));
+#endif
+}
+
+// Median latency of cblas_sgemm for C[m x n] = A[m x k] * B[n x k]^T, negative without cblas
+static double SGEMMBaseline(const BenchOptions &options, size_t m, size_t n, size_t k) {
+#if defined(BENCH_CBLAS)
+  std::vector<float> a(m * k), b(n * k), c(m * n);
+  FillRandom(a, -1.0f, 1.0f);
+  FillRandom(b, 0.0f, 1.0f);
+  return Measure(options, [&]() {
+           cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, m, n, k, 1.0f, a.data(), k, b.data(), k, 0.0f,
+                       c.data(), n);
+         }).p50_;
+#else
+  return -1.0;
+#endif
+}
+
+struct JsonWriter {
+  explicit JsonWriter(FILE *fp) : fp_(fp), first_(true) {
+  }
+
+  void Record(const char *suite, const char *net, const char *name, const char *shape, size_t batch, size_t threads,
+              double macs, const Latency &latency, double baseline_us) {
+    fprintf(fp_, "%s\n    {\"suite\": \"%s\", \"net\": \"%s\", \"layer\": \"%s\", \"shape\": \"%s\", ",
+            first_ ? "" : ",", suite, net, name, shape);
+    fprintf(fp_, "\"batch\": %zu, \"threads\": %zu, \"iters\": %zu, ", batch, threads, latency.iters_);
+    fprintf(fp_, "\"min_us\": %.2f, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p90_us\": %.2f, \"p99_us\": %.2f, ",
+            latency.min_, latency.mean_, latency.p50_, latency.p90_, latency.p99_);
+    fprintf(fp_, "\"gops\": %.2f, ", 2.0 * macs / latency.p50_ / 1e3);
+    if (baseline_us > 0.0) {
+      fprintf(fp_, "\"sgemm_p50_us\": %.2f, \"speedup_vs_sgemm\": %.3f}", baseline_us, baseline_us / latency.p50_);
+    } else {
+      fprintf(fp_, "\"sgemm_p50_us\": null, \"speedup_vs_sgemm\": null}");
+    }
+    fflush(fp_);
+    first_ = false;
+    fprintf(stderr, "%-5s %-13s %-22s batch %3zu threads %3zu  p50 %10.1f us  %8.1f GOPS\n", suite, net, name, batch,
+            threads, latency.p50_, 2.0 * macs / latency.p50_ / 1e3);
+  }
+
+  FILE *fp_;
+  bool first_;
+};
+
+static bool Selected(const BenchOptions &options, const char *suite, const char *net) {
+  return ((options.suite_ == "all") || (options.suite_ == suite)) && (options.net_.empty() || (options.net_ == net));
+}
+
+static void BenchConv(const BenchOptions &options, JsonWriter &writer) {
+  for (const ConvShape &s : kConvShapes) {
+    if (!Selected(options, "conv", s.net_)) {
+      continue;
+    }
+    size_t size_out = GetConvOutSize(s.size_in_, s.kernel_, s.stride_, s.pad_);
+    std::vector<float> weight(s.channel_out_ * s.channel_in_ / s.groups_ * s.kernel_ * s.kernel_);
+    FillRandom(weight, -1.0f, 1.0f);
+    QuantizedConvOp *op = QuantizedConvOpCreate();
+    QuantizedConvOpSetupConvParameter(op, options.layout_, s.channel_out_, s.channel_in_, s.groups_, s.kernel_,
+                                      s.kernel_, s.stride_, s.stride_, s.pad_, s.pad_, 1, 1, 0, AUTO_SELECT_CONV);
+    QuantizedConvOpInitWeight(op, weight.data());
+    char shape[128];
+    snprintf(shape, sizeof(shape), "%zux%zux%zu->%zu k%zu s%zu g%zu", s.channel_in_, s.size_in_, s.size_in_,
+             s.channel_out_, s.kernel_, s.stride_, s.groups_);
+    for (size_t batch : options.batches_) {
+      std::vector<float> data(batch * s.channel_in_ * s.size_in_ * s.size_in_);
+      std::vector<float> out(batch * s.channel_out_ * size_out * size_out);
+      FillRandom(data, 0.0f, 1.0f);
+      size_t gemm_m = s.channel_out_ / s.groups_, gemm_n = batch * size_out * size_out;
+      size_t gemm_k = s.channel_in_ / s.groups_ * s.kernel_ * s.kernel_;
+      double macs = 1.0 * s.groups_ * gemm_m * gemm_n * gemm_k;
+      for (size_t threads : options.threads_) {
+        SetThreads(options, threads);
+        Latency latency = Measure(options, [&]() {
+          QuantizedConvOpExecute(op, out.data(), data.data(), NULL, batch, s.channel_in_, s.size_in_, s.size_in_);
+        });
+        // A per group sgemm is no fair baseline for the depthwise layers
+        double baseline = (s.groups_ == 1) ? SGEMMBaseline(options, gemm_m, gemm_n, gemm_k) : -1.0;
+        writer.Record("conv", s.net_, s.name_, shape, batch, threads, macs, latency, baseline);
+      }
+    }
+    QuantizedConvOpFree(op);
+  }
+}
+
+static void BenchFC(const BenchOptions &options, JsonWriter &writer) {
+  for (const FCShape &s : kFCShapes) {
+    if (!Selected(options, "fc", s.net_)) {
+      continue;
+    }
+    std::vector<float> weight(s.channel_out_ * s.channel_in_);
+    FillRandom(weight, -1.0f, 1.0f);
+    QuantizedFCOp *op = QuantizedFCOpCreate();
+    QuantizedFCOpSetupFCParameter(op, NCHW, s.channel_out_, s.channel_in_, AUTO_SELECT_FC);
+    QuantizedFCOpInitWeight(op, weight.data());
+    char shape[128];
+    snprintf(shape, sizeof(shape), "%zu->%zu", s.channel_in_, s.channel_out_);
+    for (size_t batch : options.batches_) {
+      size_t rows = batch * s.rows_per_batch_;
+      std::vector<float> data(rows * s.channel_in_), out(rows * s.channel_out_);
+      FillRandom(data, -1.0f, 1.0f);
+      double macs = 1.0 * rows * s.channel_in_ * s.channel_out_;
+      for (size_t threads : options.threads_) {
+        SetThreads(options, threads);
+        Latency latency = Measure(options, [&]() {
+          QuantizedFCOpExecute(op, out.data(), data.data(), NULL, rows, s.channel_in_);
+        });
+        double baseline = SGEMMBaseline(options, rows, s.channel_out_, s.channel_in_);
+        writer.Record("fc", s.net_, s.name_, shape, batch, threads, macs, latency, baseline);
+      }
+    }
+    QuantizedFCOpFree(op);
+  }
+}
+
+// The GEMM of every ungrouped convolution, on operands already padded and shuffled. 16 and 64 are multiples of the
+// kernel tiles of every ISA, the padding is left out of the output.
+static void BenchGEMM(const BenchOptions &options, JsonWriter &writer) {
+  for (const ConvShape &s : kConvShapes) {
+    if ((s.groups_ != 1) || !Selected(options, "gemm", s.net_)) {
+      continue;
+    }
+    size_t size_out = GetConvOutSize(s.size_in_, s.kernel_, s.stride_, s.pad_);
+    size_t m = s.channel_out_, k = s.channel_in_ * s.kernel_ * s.kernel_;
+    size_t aligned_m = (m + 15) / 16 * 16, aligned_k = (k + 63) / 64 * 64;
+    char shape[128];
+    for (size_t batch : options.batches_) {
+      size_t n = batch * size_out * size_out, aligned_n = (n + 15) / 16 * 16;
+      snprintf(shape, sizeof(shape), "m%zu n%zu k%zu", m, n, k);
+      std::vector<int8_t> a(aligned_m * aligned_k);
+      std::vector<uint8_t> b(aligned_n * aligned_k);
+      for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<int8_t>(i % 127 - 63);
+      }
+      for (size_t i = 0; i < b.size(); ++i) {
+        b[i] = static_cast<uint8_t>(i % 127);
+      }
+      std::vector<float> c(m * n), ratio_a(aligned_m, 1.0f), ratio_b(aligned_n, 1.0f), kernel_sum(aligned_m, 0.0f),
+          min_b(aligned_n, 0.0f);
+      double macs = 1.0 * m * n * k;
+      for (size_t threads : options.threads_) {
+        SetThreads(options, threads);
+        Latency latency = Measure(options, [&]() {
+          MixPrecisionGEMM(NHWC, a.data(), b.data(), c.data(), aligned_m, aligned_n, aligned_k, ratio_a.data(),
+                           ratio_b.data(), kernel_sum.data(), min_b.data(), NULL, batch, m, size_out, size_out, 0.5f,
+                           aligned_m - m, aligned_n - n);
+        });
+        double baseline = SGEMMBaseline(options, m, n, k);
+        writer.Record("gemm", s.net_, s.name_, shape, batch, threads, macs, latency, baseline);
+      }
+    }
+  }
+}
+
+static std::string CPUModel() {
+  std::string ret = "unknown";
+  FILE *fp = fopen("/proc/cpuinfo", "r");
+  if (fp == NULL) {
+    return ret;
+  }
+  char line[512];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    const char *colon = strchr(line, ':');
+    if ((strncmp(line, "model name", 10) == 0) && (colon != NULL)) {
+      ret = colon + 2;
+      ret.erase(ret.find_last_not_of("\n") + 1);
+      break;
+    }
+  }
+  fclose(fp);
+  // Kept out of the JSON strings
+  std::replace(ret.begin(), ret.end(), '"', '\'');
+  std::replace(ret.begin(), ret.end(), '\\', '/');
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if ((arg == "--suite") && has_value) {
+      options.suite_ = argv[++i];
+    } else if ((arg == "--net") && has_value) {
+      options.net_ = argv[++i];
+    } else if ((arg == "--batches") && has_value) {
+      options.batches_ = ParseList(argv[++i]);
+    } else if ((arg == "--threads") && has_value) {
+      options.threads_ = ParseList(argv[++i]);
+    } else if ((arg == "--iters") && has_value) {
+      options.iters_ = std::max(strtoul(argv[++i], NULL, 10), 1UL);
+    } else if ((arg == "--warmup") && has_value) {
+      options.warmup_ = strtoul(argv[++i], NULL, 10);
+    } else if ((arg == "--max-ms") && has_value) {
+      options.max_ms_ = atof(argv[++i]);
+    } else if ((arg == "--layout") && has_value) {
+      options.layout_ = (strcmp(argv[++i], "nchw") == 0) ? NCHW : NHWC;
+    } else if (arg == "--pool") {
+      options.pool_ = true;
+    } else if ((arg == "--json") && has_value) {
+      options.json_ = argv[++i];
+    } else {
+      fprintf(stderr, "Unknown argument %s, see the head of bench/bench.cpp for the usage.\n", arg.c_str());
+      exit(-1);
+    }
+  }
+  if ((options.suite_ != "all") && (options.suite_ != "conv") && (options.suite_ != "fc") &&
+      (options.suite_ != "gemm")) {
+    fprintf(stderr, "Unknown suite %s, one of conv, fc, gemm or all.\n", options.suite_.c_str());
+    exit(-1);
+  }
+
+  FILE *fp = options.json_.empty() ? stdout : fopen(options.json_.c_str(), "w");
+  if (fp == NULL) {
+    fprintf(stderr, "Cannot open %s.\n", options.json_.c_str());
+    exit(-1);
+  }
+  time_t now = time(NULL);
+  char date[32];
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  fprintf(fp, "{\n  \"date\": \"%s\",\n  \"cpu\": \"%s\",\n  \"hardware_threads\": %u,\n", date, CPUModel().c_str(),
+          std::thread::hardware_concurrency());
+#if defined(GIT_VERSION)
+  fprintf(fp, "  \"git_version\": \"%s\",\n", GIT_VERSION);
+#endif
+#if defined(BENCH_CBLAS)
+  const char *baseline = "cblas_sgemm";
+#else
+  const char *baseline = "none";
+#endif
+  fprintf(fp, "  \"backend\": \"%s\",\n  \"layout\": \"%s\",\n  \"baseline\": \"%s\",\n",
+          options.pool_ ? "thread_pool" : "openmp", (options.layout_ == NHWC) ? "nhwc" : "nchw", baseline);
+  fprintf(fp, "  \"results\": [");
+  JsonWriter writer(fp);
+  if ((options.suite_ == "all") || (options.suite_ == "conv")) {
+    BenchConv(options, writer);
+  }
+  if ((options.suite_ == "all") || (options.suite_ == "fc")) {
+    BenchFC(options, writer);
+  }
+  if ((options.suite_ == "all") || (options.suite_ == "gemm")) {
+    BenchGEMM(options, writer);
+  }
+  fprintf(fp, "\n  ]\n}\n");
+  if (fp != stdout) {
+    fclose(fp);
+  }
+  SetThreads(options, 0);
+  return 0;
+}
@@ -20,8 +20,53 @@
 #include <stdint.h>
 
 typedef enum LAYOUT { NCHW = 0, NHWC = 1 } LAYOUT;
-typedef enum CONV_ALGORITHM { AUTO_SELECT_CONV = 0, SHUFFLE_CONV = 1 } CONV_ALGORITHM;
+// WINOGRAD_CONV runs F(2x2, 3x3) Winograd, 2.25x fewer multiplies for the 3x3 stride 1 dilation 1 convolutions
+// without groups and falls back to SHUFFLE_CONV for any other shape. It is opt-in, AUTO_SELECT_CONV never picks it:
+// the transforms widen the range quantized to int8, roughly 4x the relative error of SHUFFLE_CONV on a 64 -> 64 layer.
+// Its data is always quantized on the fly, calibrating it fails, and u8 activations run through fp32 copies.
+// DEPTHWISE_CONV vectorizes across the channels of the convolutions with one input and one output channel per group,
+// AUTO_SELECT_CONV always picks it for them.
+typedef enum CONV_ALGORITHM {
+  AUTO_SELECT_CONV = 0,
+  SHUFFLE_CONV = 1,
+  WINOGRAD_CONV = 2,
+  DEPTHWISE_CONV = 3
+} CONV_ALGORITHM;
 typedef enum FC_ALGORITHM { AUTO_SELECT_FC = 0, SHUFFLE_FC = 1 } FC_ALGORITHM;
+typedef enum POOL_MODE { MAX_POOL = 0, AVG_POOL = 1 } POOL_MODE;
+// Post ops applied to the convolution output, at most one of them can be set in fusion_mask
+typedef enum FUSION_MASK {
+  NO_FUSION = 0,
+  CONV_RELU_FUSION = 1,
+  CONV_BN_FUSION = 2,
+  CONV_BN_RELU_FUSION = 4,
+  CONV_RELU_BN_FUSION = 8
+} FUSION_MASK;
+// WEIGHT_7BIT quantizes each output channel of the weight to [-64, 64] so that the int16 pair sums of vpmaddubsw never
+// saturate. WEIGHT_8BIT uses the full [-127, 127] range for better accuracy, at the cost of a slower kernel on the ISAs
+// without VNNI.
+typedef enum WEIGHT_QUANTIZATION { WEIGHT_7BIT = 0, WEIGHT_8BIT = 1 } WEIGHT_QUANTIZATION;
+// Where the quantized weight lives on a multi-socket machine. NUMA_REPLICATE keeps a copy in the memory of every node,
+// each thread reading the one of its node, NUMA_INTERLEAVE one copy spread page by page over the nodes. Both need a
+// build with libnuma and fall back to NUMA_NONE on a single node.
+typedef enum NUMA_MODE { NUMA_NONE = 0, NUMA_REPLICATE = 1, NUMA_INTERLEAVE = 2 } NUMA_MODE;
+// Which threads run the parallel loops of the ops, see BigQuantSetParallelBackend
+typedef enum PARALLEL_BACKEND { OPENMP_BACKEND = 0, THREAD_POOL_BACKEND = 1, HOST_BACKEND = 2 } PARALLEL_BACKEND;
+typedef enum WEIGHT_BLOB_STATUS {
+  WEIGHT_BLOB_OK = 0,
+  WEIGHT_BLOB_IO_ERROR = -1,
+  WEIGHT_BLOB_FORMAT_ERROR = -2,
+  WEIGHT_BLOB_MISMATCH = -3,
+  WEIGHT_BLOB_UNSUPPORTED = -4
+} WEIGHT_BLOB_STATUS;
+
+// A host executor runs task(task_context, task_id) for every task_id in [0, tasks_num) and returns once they are all
+// done. The tasks of a region wait on nothing but themselves, they may run on fewer threads than tasks_num.
+typedef void (*PARALLEL_TASK)(void *task_context, size_t task_id);
+typedef void (*PARALLEL_EXECUTOR)(void *host_context, size_t tasks_num, PARALLEL_TASK task, void *task_context);
+
+// threads_num of QuantizedConvOpSetNumThreads and QuantizedFCOpSetNumThreads choosing it from the size of the layer
+#define AUTO_THREADS_NUM ((size_t)-1)
 
 struct FPTensorDesc {
   void *data;
@@ -42,12 +87,33 @@ struct QuantizedTensorDesc {
   size_t workspace_size;
 };
 
+// Counters of QuantizedConvOpGetProfile, summed over the executions since profiling was enabled. Times are in
+// microseconds and the phases exclude each other. quantize_us includes the im2col, an activation or requantization
+// fused into the GEMM counts as GEMM and a transpose fused into the range scan as find-extreme. total_us also covers
+// the planning and the bookkeeping in between. bytes estimates the traffic of the activations and the weight, gops is
+// 2 x multiply-adds / total_us.
+struct QuantizedOpProfile {
+  size_t executions;
+  double total_us;
+  double layout_transform_us;
+  double find_extreme_us;
+  double quantize_us;
+  double gemm_us;
+  double epilogue_us;
+  double bytes;
+  double gops;
+};
+typedef struct QuantizedOpProfile QuantizedOpProfile;
+
 struct QuantizedConvOp;
 typedef struct QuantizedConvOp QuantizedConvOp;
 
 struct QuantizedFCOp;
 typedef struct QuantizedFCOp QuantizedFCOp;
 
+struct QuantizedNetwork;
+typedef struct QuantizedNetwork QuantizedNetwork;
+
 #ifdef WINDOWS
 #define API_PREFIX __declspec(dllexport)
 #else
@@ -60,6 +126,18 @@ extern "C" {
 
 API_PREFIX int ManualRuntimeLoadLib(char *path);
 
+// OPENMP_BACKEND is the default, THREAD_POOL_BACKEND when built with PARALLEL_BACKEND=THREAD_POOL. threads_num 0 takes
+// the OpenMP default or one pool thread per hardware thread. Not concurrently with an execution.
+API_PREFIX void BigQuantSetParallelBackend(PARALLEL_BACKEND backend, size_t threads_num);
+
+// Switches to HOST_BACKEND, each parallel region of the ops becomes one call of executor with threads_num tasks
+API_PREFIX void BigQuantSetParallelExecutor(PARALLEL_EXECUTOR executor, void *host_context, size_t threads_num);
+
+// With enable set, the first plan of every GEMM shape times a few cache blockings and loop orders and keeps the
+// fastest. cache_path, which may be NULL, names a file of such winners keyed by CPU model, ISA and shape: it is loaded
+// right away and every new winner is appended to it. Only affects the plans made afterwards.
+API_PREFIX void BigQuantSetAutoTuning(int enable, const char *cache_path);
+
 API_PREFIX QuantizedConvOp *QuantizedConvOpCreate();
 
 API_PREFIX void QuantizedConvOpSetupConvParameter(QuantizedConvOp *p, LAYOUT layout, size_t channel_out,
@@ -70,9 +148,80 @@ API_PREFIX void QuantizedConvOpSetupConvParameter(QuantizedConvOp *p, LAYOUT lay
 
 API_PREFIX void QuantizedConvOpInitWeight(QuantizedConvOp *p, float *weight);
 
+// Must be called after the setup. Applies to the current weight and to the ones initialized or loaded later, not
+// concurrently with an execution.
+API_PREFIX void QuantizedConvOpSetNumaMode(QuantizedConvOp *p, NUMA_MODE mode);
+
+// At most threads_num threads of the parallel backend run an execution of the op, 0 (the default) lets it use them
+// all. AUTO_THREADS_NUM sizes every execution from the multiply-adds of its GEMM, so that a tiny layer does not pay
+// for waking the whole machine.
+API_PREFIX void QuantizedConvOpSetNumThreads(QuantizedConvOp *p, size_t threads_num);
+
+// Profiling costs two clock reads per phase, it is off by default. Enabling or disabling clears the counters.
+API_PREFIX void QuantizedConvOpSetProfiling(QuantizedConvOp *p, int enable);
+
+// Returns 0 with the counters in profile, or -1 when profiling is not enabled on the op
+API_PREFIX int QuantizedConvOpGetProfile(QuantizedConvOp *p, QuantizedOpProfile *profile);
+
+// May run concurrently on the same op, but not concurrently with the setup, weight or calibration calls
 API_PREFIX void QuantizedConvOpExecute(QuantizedConvOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                        size_t channel_in, size_t height_in, size_t width_in);
 
+API_PREFIX void QuantizedConvOpReserveWorkspace(QuantizedConvOp *p, size_t batch_size, size_t channel_in,
+                                                size_t height_in, size_t width_in);
+
+API_PREFIX void QuantizedConvOpSetFusionMask(QuantizedConvOp *p, size_t fusion_mask);
+
+// Must be called after QuantizedConvOpSetupConvParameter and before the weight is initialized or loaded
+API_PREFIX void QuantizedConvOpSetWeightQuantization(QuantizedConvOp *p, WEIGHT_QUANTIZATION mode);
+
+// Static activation quantization: Calibrate records the input range of every group over representative batches, and
+// once frozen Execute quantizes the data with that fixed range instead of scanning each input for its extremes.
+// Inputs outside the calibrated range are clamped. Calibrating again unfreezes the range until the next Freeze, and
+// Reset drops it and returns to dynamic quantization. Calibrate and Freeze return 0, or -1 when the algorithm has no
+// static quantization (WINOGRAD_CONV) or, for Freeze, when nothing was calibrated.
+API_PREFIX int QuantizedConvOpCalibrate(QuantizedConvOp *p, float *data, size_t batch_size, size_t channel_in,
+                                        size_t height_in, size_t width_in);
+
+API_PREFIX int QuantizedConvOpFreezeCalibration(QuantizedConvOp *p);
+
+API_PREFIX void QuantizedConvOpResetCalibration(QuantizedConvOp *p);
+
+// Chaining quantized convolutions without fp32 activations in between, NHWC only. The activations are u8 with value =
+// (q - zero_point) * scale and q within [0, 127]. GetInputQuantization gives the quantization matching the frozen
+// calibration of an op, to be set as the output quantization of the op feeding it. It returns 0, or -1 when the
+// calibration is not frozen.
+API_PREFIX int QuantizedConvOpGetInputQuantization(QuantizedConvOp *p, float *scale, uint8_t *zero_point);
+
+API_PREFIX void QuantizedConvOpSetOutputQuantization(QuantizedConvOp *p, float scale, uint8_t zero_point);
+
+// fp32 input, u8 output requantized as the GEMM produces it
+API_PREFIX void QuantizedConvOpExecuteToU8(QuantizedConvOp *p, uint8_t *dst, float *data, float *bias,
+                                           size_t batch_size, size_t channel_in, size_t height_in, size_t width_in);
+
+// u8 input, which skips the quantization of the data, fp32 output
+API_PREFIX void QuantizedConvOpExecuteFromU8(QuantizedConvOp *p, float *dst, uint8_t *data, float data_scale,
+                                             uint8_t data_zero_point, float *bias, size_t batch_size,
+                                             size_t channel_in, size_t height_in, size_t width_in);
+
+// u8 input and output
+API_PREFIX void QuantizedConvOpExecuteU8(QuantizedConvOp *p, uint8_t *dst, uint8_t *data, float data_scale,
+                                         uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                         size_t height_in, size_t width_in);
+
+API_PREFIX void QuantizedConvOpSetBatchNorm(QuantizedConvOp *p, float *global_mean, float *variance, float *scale,
+                                            float *shift, float eps);
+
+// Save the quantized weight of an initialized op to a versioned blob, and load it back into an op set up with the
+// same parameters, skipping the quantization. Both return a WEIGHT_BLOB_STATUS.
+API_PREFIX int QuantizedConvOpSaveWeight(QuantizedConvOp *p, const char *path);
+
+API_PREFIX int QuantizedConvOpLoadWeight(QuantizedConvOp *p, const char *path);
+
+// Use the blob in place instead of copying it: the weight stays mapped read-only until the op is freed or gets a new
+// weight, so all the processes mapping the same file share one physical copy through the page cache.
+API_PREFIX int QuantizedConvOpMapWeight(QuantizedConvOp *p, const char *path);
+
 API_PREFIX void QuantizedConvOpFree(QuantizedConvOp *p);
 
 API_PREFIX QuantizedFCOp *QuantizedFCOpCreate();
@@ -80,13 +229,56 @@ API_PREFIX QuantizedFCOp *QuantizedFCOpCreate();
 API_PREFIX void QuantizedFCOpSetupFCParameter(QuantizedFCOp *p, LAYOUT layout, size_t channel_out, size_t channel_in,
                                               FC_ALGORITHM algo);
 
+API_PREFIX void QuantizedFCOpSetWeightQuantization(QuantizedFCOp *p, WEIGHT_QUANTIZATION mode);
+
 API_PREFIX void QuantizedFCOpInitWeight(QuantizedFCOp *p, float *weight);
 
+API_PREFIX void QuantizedFCOpSetNumaMode(QuantizedFCOp *p, NUMA_MODE mode);
+
+API_PREFIX void QuantizedFCOpSetNumThreads(QuantizedFCOp *p, size_t threads_num);
+
+// May run concurrently on the same op, but not concurrently with the setup or weight calls
 API_PREFIX void QuantizedFCOpExecute(QuantizedFCOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                      size_t channel_in);
 
+API_PREFIX void QuantizedFCOpReserveWorkspace(QuantizedFCOp *p, size_t batch_size, size_t channel_in);
+
+API_PREFIX int QuantizedFCOpSaveWeight(QuantizedFCOp *p, const char *path);
+
+API_PREFIX int QuantizedFCOpLoadWeight(QuantizedFCOp *p, const char *path);
+
+API_PREFIX int QuantizedFCOpMapWeight(QuantizedFCOp *p, const char *path);
+
 API_PREFIX void QuantizedFCOpFree(QuantizedFCOp *p);
 
+// A network runs a sequence of ops in one call, keeping the NHWC activations in an arena planned at compile time.
+// Tensor 0 is the network input and every Add returns the id of the tensor written by the new node, the output of the
+// network is the one of the last node. The ops are referenced, not owned, and must outlive the network, their weight
+// initialized and their calibration frozen before Compile. The convolutions must be NHWC, the bias is copied and may
+// be NULL. Pooling skips the padded taps, fully connected layers read their input flattened in NHWC order.
+API_PREFIX QuantizedNetwork *QuantizedNetworkCreate();
+
+API_PREFIX int QuantizedNetworkAddConv(QuantizedNetwork *p, QuantizedConvOp *op, int input, float *bias);
+
+API_PREFIX int QuantizedNetworkAddFC(QuantizedNetwork *p, QuantizedFCOp *op, int input, float *bias);
+
+API_PREFIX int QuantizedNetworkAddPool(QuantizedNetwork *p, int input, POOL_MODE mode, size_t kernel_h, size_t kernel_w,
+                                       size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w);
+
+API_PREFIX int QuantizedNetworkAddEltwiseSum(QuantizedNetwork *p, int input_a, int input_b, int relu);
+
+API_PREFIX void QuantizedNetworkCompile(QuantizedNetwork *p, size_t channel_in, size_t height_in, size_t width_in);
+
+API_PREFIX void QuantizedNetworkGetOutputShape(QuantizedNetwork *p, size_t *channel, size_t *height, size_t *width);
+
+// Bytes of activations held by an execution, besides the input and output buffers
+API_PREFIX size_t QuantizedNetworkGetArenaSize(QuantizedNetwork *p, size_t batch_size);
+
+// May run concurrently on the same network, but not concurrently with Compile or with changes to its ops
+API_PREFIX void QuantizedNetworkExecute(QuantizedNetwork *p, float *dst, float *data, size_t batch_size);
+
+API_PREFIX void QuantizedNetworkFree(QuantizedNetwork *p);
+
 API_PREFIX void QuantizedConvKernelDescInit(QuantizedTensorDesc *quantized_tensor, size_t c_out, size_t c_in,
                                             size_t kernel_h, size_t kernel_w);
 
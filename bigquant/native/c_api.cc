@@ -17,11 +17,26 @@
 #include "internal_api.h"
 #include "base.h"
 #include "common.h"
+#include "parallel.h"
+#include "autotune.h"
 #include "alloc.h"
 #include "model.h"
 #include "ops/ops.h"
 #include "nn/convolution_op.h"
 #include "nn/fc_op.h"
+#include "nn/network.h"
+
+void InternalBigQuantSetParallelBackend(PARALLEL_BACKEND backend, size_t threads_num) {
+  SetParallelBackend(backend, threads_num, NULL, NULL);
+}
+
+void InternalBigQuantSetParallelExecutor(PARALLEL_EXECUTOR executor, void *host_context, size_t threads_num) {
+  SetParallelBackend(HOST_BACKEND, threads_num, executor, host_context);
+}
+
+void InternalBigQuantSetAutoTuning(int enable, const char *cache_path) {
+  GetTuningCache().Setup(enable != 0, cache_path);
+}
 
 // The following is Descriptor based APU
 QuantizedConvOp *InternalQuantizedConvOpCreate() {
@@ -42,10 +57,106 @@ void InternalQuantizedConvOpInitWeight(QuantizedConvOp *p, float *weight) {
   reinterpret_cast<ConvOp *>(p)->InitWeight(weight);
 }
 
+void InternalQuantizedConvOpSetNumaMode(QuantizedConvOp *p, NUMA_MODE mode) {
+  reinterpret_cast<ConvOp *>(p)->SetNumaMode(mode);
+}
+
+void InternalQuantizedConvOpSetNumThreads(QuantizedConvOp *p, size_t threads_num) {
+  reinterpret_cast<ConvOp *>(p)->SetNumThreads(threads_num);
+}
+
+void InternalQuantizedConvOpSetProfiling(QuantizedConvOp *p, int enable) {
+  reinterpret_cast<ConvOp *>(p)->SetProfiling(enable != 0);
+}
+
+int InternalQuantizedConvOpGetProfile(QuantizedConvOp *p, QuantizedOpProfile *profile) {
+  return reinterpret_cast<ConvOp *>(p)->GetProfile(*profile) ? 0 : -1;
+}
+
 void InternalQuantizedConvOpExecute(QuantizedConvOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                     size_t channel_in, size_t height_in, size_t width_in) {
   reinterpret_cast<ConvOp *>(p)->Execute(dst, data, bias, batch_size, channel_in, height_in, width_in);
 }
+
+void InternalQuantizedConvOpReserveWorkspace(QuantizedConvOp *p, size_t batch_size, size_t channel_in,
+                                             size_t height_in, size_t width_in) {
+  reinterpret_cast<ConvOp *>(p)->ReserveWorkspace(batch_size, channel_in, height_in, width_in);
+}
+
+void InternalQuantizedConvOpSetFusionMask(QuantizedConvOp *p, size_t fusion_mask) {
+  reinterpret_cast<ConvOp *>(p)->SetFusionMask(fusion_mask);
+}
+
+void InternalQuantizedConvOpSetWeightQuantization(QuantizedConvOp *p, WEIGHT_QUANTIZATION mode) {
+  reinterpret_cast<ConvOp *>(p)->SetWeightQuantization(mode);
+}
+
+int InternalQuantizedConvOpCalibrate(QuantizedConvOp *p, float *data, size_t batch_size, size_t channel_in,
+                                     size_t height_in, size_t width_in) {
+  return reinterpret_cast<ConvOp *>(p)->Calibrate(data, batch_size, channel_in, height_in, width_in);
+}
+
+int InternalQuantizedConvOpFreezeCalibration(QuantizedConvOp *p) {
+  return reinterpret_cast<ConvOp *>(p)->FreezeCalibration();
+}
+
+void InternalQuantizedConvOpResetCalibration(QuantizedConvOp *p) {
+  reinterpret_cast<ConvOp *>(p)->ResetCalibration();
+}
+
+int InternalQuantizedConvOpGetInputQuantization(QuantizedConvOp *p, float *scale, uint8_t *zero_point) {
+  QuantizedActivationDesc quantization;
+  if (!reinterpret_cast<ConvOp *>(p)->GetInputQuantization(quantization)) {
+    return -1;
+  }
+  *scale = quantization.scale_;
+  *zero_point = quantization.zero_point_;
+  return 0;
+}
+
+void InternalQuantizedConvOpSetOutputQuantization(QuantizedConvOp *p, float scale, uint8_t zero_point) {
+  reinterpret_cast<ConvOp *>(p)->SetOutputQuantization(scale, zero_point);
+}
+
+void InternalQuantizedConvOpExecuteToU8(QuantizedConvOp *p, uint8_t *dst, float *data, float *bias, size_t batch_size,
+                                        size_t channel_in, size_t height_in, size_t width_in) {
+  reinterpret_cast<ConvOp *>(p)->ExecuteQuantized(dst, true, data, NULL, bias, batch_size, channel_in, height_in,
+                                                  width_in);
+}
+
+void InternalQuantizedConvOpExecuteFromU8(QuantizedConvOp *p, float *dst, uint8_t *data, float data_scale,
+                                          uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                          size_t height_in, size_t width_in) {
+  QuantizedActivationDesc data_quantization = {data_scale, data_zero_point};
+  reinterpret_cast<ConvOp *>(p)->ExecuteQuantized(dst, false, data, &data_quantization, bias, batch_size, channel_in,
+                                                  height_in, width_in);
+}
+
+void InternalQuantizedConvOpExecuteU8(QuantizedConvOp *p, uint8_t *dst, uint8_t *data, float data_scale,
+                                      uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                      size_t height_in, size_t width_in) {
+  QuantizedActivationDesc data_quantization = {data_scale, data_zero_point};
+  reinterpret_cast<ConvOp *>(p)->ExecuteQuantized(dst, true, data, &data_quantization, bias, batch_size, channel_in,
+                                                  height_in, width_in);
+}
+
+void InternalQuantizedConvOpSetBatchNorm(QuantizedConvOp *p, float *global_mean, float *variance, float *scale,
+                                         float *shift, float eps) {
+  reinterpret_cast<ConvOp *>(p)->InitBatchNorm(global_mean, variance, scale, shift, eps);
+}
+
+int InternalQuantizedConvOpSaveWeight(QuantizedConvOp *p, const char *path) {
+  return reinterpret_cast<ConvOp *>(p)->SaveWeight(path);
+}
+
+int InternalQuantizedConvOpLoadWeight(QuantizedConvOp *p, const char *path) {
+  return reinterpret_cast<ConvOp *>(p)->LoadWeight(path);
+}
+
+int InternalQuantizedConvOpMapWeight(QuantizedConvOp *p, const char *path) {
+  return reinterpret_cast<ConvOp *>(p)->MapWeight(path);
+}
+
 void InternalQuantizedConvOpFree(QuantizedConvOp *p) {
   delete reinterpret_cast<ConvOp *>(p);
 }
@@ -60,19 +171,90 @@ void InternalQuantizedFCOpSetupFCParameter(QuantizedFCOp *p, LAYOUT layout, size
   reinterpret_cast<FCOp *>(p)->SetupFCKernelParameter(layout, channel_out, channel_in, algo);
 }
 
+void InternalQuantizedFCOpSetWeightQuantization(QuantizedFCOp *p, WEIGHT_QUANTIZATION mode) {
+  reinterpret_cast<FCOp *>(p)->SetWeightQuantization(mode);
+}
+
 void InternalQuantizedFCOpInitWeight(QuantizedFCOp *p, float *weight) {
   reinterpret_cast<FCOp *>(p)->InitWeight(weight);
 }
 
+void InternalQuantizedFCOpSetNumaMode(QuantizedFCOp *p, NUMA_MODE mode) {
+  reinterpret_cast<FCOp *>(p)->SetNumaMode(mode);
+}
+
+void InternalQuantizedFCOpSetNumThreads(QuantizedFCOp *p, size_t threads_num) {
+  reinterpret_cast<FCOp *>(p)->SetNumThreads(threads_num);
+}
+
 void InternalQuantizedFCOpExecute(QuantizedFCOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                   size_t channel_in) {
   reinterpret_cast<FCOp *>(p)->Execute(dst, data, bias, batch_size, channel_in);
 }
 
+void InternalQuantizedFCOpReserveWorkspace(QuantizedFCOp *p, size_t batch_size, size_t channel_in) {
+  reinterpret_cast<FCOp *>(p)->ReserveWorkspace(batch_size, channel_in);
+}
+
+int InternalQuantizedFCOpSaveWeight(QuantizedFCOp *p, const char *path) {
+  return reinterpret_cast<FCOp *>(p)->SaveWeight(path);
+}
+
+int InternalQuantizedFCOpLoadWeight(QuantizedFCOp *p, const char *path) {
+  return reinterpret_cast<FCOp *>(p)->LoadWeight(path);
+}
+
+int InternalQuantizedFCOpMapWeight(QuantizedFCOp *p, const char *path) {
+  return reinterpret_cast<FCOp *>(p)->MapWeight(path);
+}
+
 void InternalQuantizedFCOpFree(QuantizedFCOp *p) {
   delete reinterpret_cast<FCOp *>(p);
 }
 
+QuantizedNetwork *InternalQuantizedNetworkCreate() {
+  Network *p = new Network();
+  return reinterpret_cast<QuantizedNetwork *>(p);
+}
+
+int InternalQuantizedNetworkAddConv(QuantizedNetwork *p, QuantizedConvOp *op, int input, float *bias) {
+  return static_cast<int>(reinterpret_cast<Network *>(p)->AddConv(reinterpret_cast<ConvOp *>(op), input, bias));
+}
+
+int InternalQuantizedNetworkAddFC(QuantizedNetwork *p, QuantizedFCOp *op, int input, float *bias) {
+  return static_cast<int>(reinterpret_cast<Network *>(p)->AddFC(reinterpret_cast<FCOp *>(op), input, bias));
+}
+
+int InternalQuantizedNetworkAddPool(QuantizedNetwork *p, int input, POOL_MODE mode, size_t kernel_h, size_t kernel_w,
+                                    size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w) {
+  return static_cast<int>(reinterpret_cast<Network *>(p)->AddPool(input, mode, kernel_h, kernel_w, stride_h, stride_w,
+                                                                   pad_h, pad_w));
+}
+
+int InternalQuantizedNetworkAddEltwiseSum(QuantizedNetwork *p, int input_a, int input_b, int relu) {
+  return static_cast<int>(reinterpret_cast<Network *>(p)->AddEltwiseSum(input_a, input_b, relu != 0));
+}
+
+void InternalQuantizedNetworkCompile(QuantizedNetwork *p, size_t channel_in, size_t height_in, size_t width_in) {
+  reinterpret_cast<Network *>(p)->Compile(channel_in, height_in, width_in);
+}
+
+void InternalQuantizedNetworkGetOutputShape(QuantizedNetwork *p, size_t *channel, size_t *height, size_t *width) {
+  reinterpret_cast<Network *>(p)->GetOutputShape(*channel, *height, *width);
+}
+
+size_t InternalQuantizedNetworkGetArenaSize(QuantizedNetwork *p, size_t batch_size) {
+  return reinterpret_cast<Network *>(p)->ArenaSize(batch_size);
+}
+
+void InternalQuantizedNetworkExecute(QuantizedNetwork *p, float *dst, float *data, size_t batch_size) {
+  reinterpret_cast<Network *>(p)->Execute(dst, data, batch_size);
+}
+
+void InternalQuantizedNetworkFree(QuantizedNetwork *p) {
+  delete reinterpret_cast<Network *>(p);
+}
+
 // The following is  tensor based APU
 void InternalQuantizedConvKernelDescInit(QuantizedTensorDesc *quantized_tensor, size_t c_out, size_t c_in,
                                          size_t kernel_h, size_t kernel_w) {
@@ -31,6 +31,12 @@ HINSTANCE handler = NULL;
 void *handler = NULL;
 #endif
 
+void (*BigQuantSetParallelBackendRT)(PARALLEL_BACKEND backend, size_t threads_num);
+
+void (*BigQuantSetParallelExecutorRT)(PARALLEL_EXECUTOR executor, void *host_context, size_t threads_num);
+
+void (*BigQuantSetAutoTuningRT)(int enable, const char *cache_path);
+
 QuantizedConvOp *(*QuantizedConvOpCreateRT)();
 
 void (*QuantizedConvOpSetupConvParameterRT)(QuantizedConvOp *p, LAYOUT layout, size_t channel_out, size_t channel_in,
@@ -39,10 +45,52 @@ void (*QuantizedConvOpSetupConvParameterRT)(QuantizedConvOp *p, LAYOUT layout, s
                                             size_t dialation_w, size_t fusion_mask, CONV_ALGORITHM algo);
 
 void (*QuantizedConvOpInitWeightRT)(QuantizedConvOp *p, float *weight);
+void (*QuantizedConvOpSetNumaModeRT)(QuantizedConvOp *p, NUMA_MODE mode);
+void (*QuantizedConvOpSetNumThreadsRT)(QuantizedConvOp *p, size_t threads_num);
+void (*QuantizedConvOpSetProfilingRT)(QuantizedConvOp *p, int enable);
+int (*QuantizedConvOpGetProfileRT)(QuantizedConvOp *p, QuantizedOpProfile *profile);
 
 void (*QuantizedConvOpExecuteRT)(QuantizedConvOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                  size_t channel_in, size_t height_in, size_t width_in);
 
+void (*QuantizedConvOpReserveWorkspaceRT)(QuantizedConvOp *p, size_t batch_size, size_t channel_in, size_t height_in,
+                                          size_t width_in);
+
+void (*QuantizedConvOpSetFusionMaskRT)(QuantizedConvOp *p, size_t fusion_mask);
+
+void (*QuantizedConvOpSetWeightQuantizationRT)(QuantizedConvOp *p, WEIGHT_QUANTIZATION mode);
+
+int (*QuantizedConvOpCalibrateRT)(QuantizedConvOp *p, float *data, size_t batch_size, size_t channel_in,
+                                  size_t height_in, size_t width_in);
+
+int (*QuantizedConvOpFreezeCalibrationRT)(QuantizedConvOp *p);
+
+void (*QuantizedConvOpResetCalibrationRT)(QuantizedConvOp *p);
+
+int (*QuantizedConvOpGetInputQuantizationRT)(QuantizedConvOp *p, float *scale, uint8_t *zero_point);
+
+void (*QuantizedConvOpSetOutputQuantizationRT)(QuantizedConvOp *p, float scale, uint8_t zero_point);
+
+void (*QuantizedConvOpExecuteToU8RT)(QuantizedConvOp *p, uint8_t *dst, float *data, float *bias, size_t batch_size,
+                                     size_t channel_in, size_t height_in, size_t width_in);
+
+void (*QuantizedConvOpExecuteFromU8RT)(QuantizedConvOp *p, float *dst, uint8_t *data, float data_scale,
+                                       uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                       size_t height_in, size_t width_in);
+
+void (*QuantizedConvOpExecuteU8RT)(QuantizedConvOp *p, uint8_t *dst, uint8_t *data, float data_scale,
+                                   uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                   size_t height_in, size_t width_in);
+
+void (*QuantizedConvOpSetBatchNormRT)(QuantizedConvOp *p, float *global_mean, float *variance, float *scale,
+                                      float *shift, float eps);
+
+int (*QuantizedConvOpSaveWeightRT)(QuantizedConvOp *p, const char *path);
+
+int (*QuantizedConvOpLoadWeightRT)(QuantizedConvOp *p, const char *path);
+
+int (*QuantizedConvOpMapWeightRT)(QuantizedConvOp *p, const char *path);
+
 void (*QuantizedConvOpFreeRT)(QuantizedConvOp *p);
 
 QuantizedFCOp *(*QuantizedFCOpCreateRT)();
@@ -50,13 +98,46 @@ QuantizedFCOp *(*QuantizedFCOpCreateRT)();
 void (*QuantizedFCOpSetupFCParameterRT)(QuantizedFCOp *p, LAYOUT layout, size_t channel_out, size_t channel_in,
                                         FC_ALGORITHM algo);
 
+void (*QuantizedFCOpSetWeightQuantizationRT)(QuantizedFCOp *p, WEIGHT_QUANTIZATION mode);
+
 void (*QuantizedFCOpInitWeightRT)(QuantizedFCOp *p, float *weight);
+void (*QuantizedFCOpSetNumaModeRT)(QuantizedFCOp *p, NUMA_MODE mode);
+void (*QuantizedFCOpSetNumThreadsRT)(QuantizedFCOp *p, size_t threads_num);
 
 void (*QuantizedFCOpExecuteRT)(QuantizedFCOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                size_t channel_in);
 
+void (*QuantizedFCOpReserveWorkspaceRT)(QuantizedFCOp *p, size_t batch_size, size_t channel_in);
+
+int (*QuantizedFCOpSaveWeightRT)(QuantizedFCOp *p, const char *path);
+
+int (*QuantizedFCOpLoadWeightRT)(QuantizedFCOp *p, const char *path);
+
+int (*QuantizedFCOpMapWeightRT)(QuantizedFCOp *p, const char *path);
+
 void (*QuantizedFCOpFreeRT)(QuantizedFCOp *p);
 
+QuantizedNetwork *(*QuantizedNetworkCreateRT)();
+
+int (*QuantizedNetworkAddConvRT)(QuantizedNetwork *p, QuantizedConvOp *op, int input, float *bias);
+
+int (*QuantizedNetworkAddFCRT)(QuantizedNetwork *p, QuantizedFCOp *op, int input, float *bias);
+
+int (*QuantizedNetworkAddPoolRT)(QuantizedNetwork *p, int input, POOL_MODE mode, size_t kernel_h, size_t kernel_w,
+                                 size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w);
+
+int (*QuantizedNetworkAddEltwiseSumRT)(QuantizedNetwork *p, int input_a, int input_b, int relu);
+
+void (*QuantizedNetworkCompileRT)(QuantizedNetwork *p, size_t channel_in, size_t height_in, size_t width_in);
+
+void (*QuantizedNetworkGetOutputShapeRT)(QuantizedNetwork *p, size_t *channel, size_t *height, size_t *width);
+
+size_t (*QuantizedNetworkGetArenaSizeRT)(QuantizedNetwork *p, size_t batch_size);
+
+void (*QuantizedNetworkExecuteRT)(QuantizedNetwork *p, float *dst, float *data, size_t batch_size);
+
+void (*QuantizedNetworkFreeRT)(QuantizedNetwork *p);
+
 void (*QuantizedConvKernelDescInitRT)(QuantizedTensorDesc *quantized_tensor, size_t c_out, size_t c_in, size_t kernel_h,
                                       size_t kernel_w);
 
@@ -112,6 +193,12 @@ void BindSymbol() {
 #else
 #define BINDSYMBOL dlsym
 #endif
+  BigQuantSetParallelBackendRT = reinterpret_cast<void (*)(PARALLEL_BACKEND, size_t)>(
+      BINDSYMBOL(handler, "InternalBigQuantSetParallelBackend"));
+  BigQuantSetParallelExecutorRT = reinterpret_cast<void (*)(PARALLEL_EXECUTOR, void *, size_t)>(
+      BINDSYMBOL(handler, "InternalBigQuantSetParallelExecutor"));
+  BigQuantSetAutoTuningRT =
+      reinterpret_cast<void (*)(int, const char *)>(BINDSYMBOL(handler, "InternalBigQuantSetAutoTuning"));
   QuantizedConvOpCreateRT =
       reinterpret_cast<QuantizedConvOp *(*)()>(BINDSYMBOL(handler, "InternalQuantizedConvOpCreate"));
   QuantizedConvOpSetupConvParameterRT =
@@ -120,19 +207,96 @@ void BindSymbol() {
           BINDSYMBOL(handler, "InternalQuantizedConvOpSetupConvParameter"));
   QuantizedConvOpInitWeightRT =
       reinterpret_cast<void (*)(QuantizedConvOp *, float *)>(BINDSYMBOL(handler, "InternalQuantizedConvOpInitWeight"));
+  QuantizedConvOpSetNumaModeRT = reinterpret_cast<void (*)(QuantizedConvOp *, NUMA_MODE)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetNumaMode"));
+  QuantizedConvOpSetNumThreadsRT = reinterpret_cast<void (*)(QuantizedConvOp *, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetNumThreads"));
+  QuantizedConvOpSetProfilingRT = reinterpret_cast<void (*)(QuantizedConvOp *, int)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetProfiling"));
+  QuantizedConvOpGetProfileRT = reinterpret_cast<int (*)(QuantizedConvOp *, QuantizedOpProfile *)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpGetProfile"));
   QuantizedConvOpExecuteRT =
       reinterpret_cast<void (*)(QuantizedConvOp *, float *, float *, float *, size_t, size_t, size_t, size_t)>(
           BINDSYMBOL(handler, "InternalQuantizedConvOpExecute"));
+  QuantizedConvOpReserveWorkspaceRT = reinterpret_cast<void (*)(QuantizedConvOp *, size_t, size_t, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpReserveWorkspace"));
+  QuantizedConvOpSetFusionMaskRT = reinterpret_cast<void (*)(QuantizedConvOp *, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetFusionMask"));
+  QuantizedConvOpSetWeightQuantizationRT = reinterpret_cast<void (*)(QuantizedConvOp *, WEIGHT_QUANTIZATION)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetWeightQuantization"));
+  QuantizedConvOpCalibrateRT = reinterpret_cast<int (*)(QuantizedConvOp *, float *, size_t, size_t, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpCalibrate"));
+  QuantizedConvOpFreezeCalibrationRT =
+      reinterpret_cast<int (*)(QuantizedConvOp *)>(BINDSYMBOL(handler, "InternalQuantizedConvOpFreezeCalibration"));
+  QuantizedConvOpResetCalibrationRT =
+      reinterpret_cast<void (*)(QuantizedConvOp *)>(BINDSYMBOL(handler, "InternalQuantizedConvOpResetCalibration"));
+  QuantizedConvOpGetInputQuantizationRT = reinterpret_cast<int (*)(QuantizedConvOp *, float *, uint8_t *)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpGetInputQuantization"));
+  QuantizedConvOpSetOutputQuantizationRT = reinterpret_cast<void (*)(QuantizedConvOp *, float, uint8_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSetOutputQuantization"));
+  QuantizedConvOpExecuteToU8RT =
+      reinterpret_cast<void (*)(QuantizedConvOp *, uint8_t *, float *, float *, size_t, size_t, size_t, size_t)>(
+          BINDSYMBOL(handler, "InternalQuantizedConvOpExecuteToU8"));
+  QuantizedConvOpExecuteFromU8RT = reinterpret_cast<void (*)(QuantizedConvOp *, float *, uint8_t *, float, uint8_t,
+                                                             float *, size_t, size_t, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpExecuteFromU8"));
+  QuantizedConvOpExecuteU8RT = reinterpret_cast<void (*)(QuantizedConvOp *, uint8_t *, uint8_t *, float, uint8_t,
+                                                         float *, size_t, size_t, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpExecuteU8"));
+  QuantizedConvOpSetBatchNormRT =
+      reinterpret_cast<void (*)(QuantizedConvOp *, float *, float *, float *, float *, float)>(
+          BINDSYMBOL(handler, "InternalQuantizedConvOpSetBatchNorm"));
+  QuantizedConvOpSaveWeightRT = reinterpret_cast<int (*)(QuantizedConvOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpSaveWeight"));
+  QuantizedConvOpLoadWeightRT = reinterpret_cast<int (*)(QuantizedConvOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpLoadWeight"));
+  QuantizedConvOpMapWeightRT = reinterpret_cast<int (*)(QuantizedConvOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedConvOpMapWeight"));
   QuantizedConvOpFreeRT =
       reinterpret_cast<void (*)(QuantizedConvOp *)>(BINDSYMBOL(handler, "InternalQuantizedConvOpFree"));
   QuantizedFCOpCreateRT = reinterpret_cast<QuantizedFCOp *(*)()>(BINDSYMBOL(handler, "InternalQuantizedFCOpCreate"));
   QuantizedFCOpSetupFCParameterRT = reinterpret_cast<void (*)(QuantizedFCOp *, LAYOUT, size_t, size_t, FC_ALGORITHM)>(
       BINDSYMBOL(handler, "InternalQuantizedFCOpSetupFCParameter"));
+  QuantizedFCOpSetWeightQuantizationRT = reinterpret_cast<void (*)(QuantizedFCOp *, WEIGHT_QUANTIZATION)>(
+      BINDSYMBOL(handler, "InternalQuantizedFCOpSetWeightQuantization"));
   QuantizedFCOpInitWeightRT =
       reinterpret_cast<void (*)(QuantizedFCOp *, float *)>(BINDSYMBOL(handler, "InternalQuantizedFCOpInitWeight"));
+  QuantizedFCOpSetNumaModeRT =
+      reinterpret_cast<void (*)(QuantizedFCOp *, NUMA_MODE)>(BINDSYMBOL(handler, "InternalQuantizedFCOpSetNumaMode"));
+  QuantizedFCOpSetNumThreadsRT =
+      reinterpret_cast<void (*)(QuantizedFCOp *, size_t)>(BINDSYMBOL(handler, "InternalQuantizedFCOpSetNumThreads"));
   QuantizedFCOpExecuteRT = reinterpret_cast<void (*)(QuantizedFCOp *, float *, float *, float *, size_t, size_t)>(
       BINDSYMBOL(handler, "InternalQuantizedFCOpExecute"));
+  QuantizedFCOpReserveWorkspaceRT = reinterpret_cast<void (*)(QuantizedFCOp *, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedFCOpReserveWorkspace"));
+  QuantizedFCOpSaveWeightRT = reinterpret_cast<int (*)(QuantizedFCOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedFCOpSaveWeight"));
+  QuantizedFCOpLoadWeightRT = reinterpret_cast<int (*)(QuantizedFCOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedFCOpLoadWeight"));
+  QuantizedFCOpMapWeightRT = reinterpret_cast<int (*)(QuantizedFCOp *, const char *)>(
+      BINDSYMBOL(handler, "InternalQuantizedFCOpMapWeight"));
   QuantizedFCOpFreeRT = reinterpret_cast<void (*)(QuantizedFCOp *)>(BINDSYMBOL(handler, "InternalQuantizedFCOpFree"));
+  QuantizedNetworkCreateRT =
+      reinterpret_cast<QuantizedNetwork *(*)()>(BINDSYMBOL(handler, "InternalQuantizedNetworkCreate"));
+  QuantizedNetworkAddConvRT = reinterpret_cast<int (*)(QuantizedNetwork *, QuantizedConvOp *, int, float *)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkAddConv"));
+  QuantizedNetworkAddFCRT = reinterpret_cast<int (*)(QuantizedNetwork *, QuantizedFCOp *, int, float *)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkAddFC"));
+  QuantizedNetworkAddPoolRT =
+      reinterpret_cast<int (*)(QuantizedNetwork *, int, POOL_MODE, size_t, size_t, size_t, size_t, size_t, size_t)>(
+          BINDSYMBOL(handler, "InternalQuantizedNetworkAddPool"));
+  QuantizedNetworkAddEltwiseSumRT = reinterpret_cast<int (*)(QuantizedNetwork *, int, int, int)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkAddEltwiseSum"));
+  QuantizedNetworkCompileRT = reinterpret_cast<void (*)(QuantizedNetwork *, size_t, size_t, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkCompile"));
+  QuantizedNetworkGetOutputShapeRT = reinterpret_cast<void (*)(QuantizedNetwork *, size_t *, size_t *, size_t *)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkGetOutputShape"));
+  QuantizedNetworkGetArenaSizeRT = reinterpret_cast<size_t (*)(QuantizedNetwork *, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkGetArenaSize"));
+  QuantizedNetworkExecuteRT = reinterpret_cast<void (*)(QuantizedNetwork *, float *, float *, size_t)>(
+      BINDSYMBOL(handler, "InternalQuantizedNetworkExecute"));
+  QuantizedNetworkFreeRT =
+      reinterpret_cast<void (*)(QuantizedNetwork *)>(BINDSYMBOL(handler, "InternalQuantizedNetworkFree"));
   QuantizedConvKernelDescInitRT = reinterpret_cast<void (*)(QuantizedTensorDesc *, size_t, size_t, size_t, size_t)>(
       BINDSYMBOL(handler, "InternalQuantizedConvKernelDescInit"));
   QuantizedConvKernelInitRT =
@@ -177,36 +341,66 @@ void BindSymbol() {
 #undef BINDSYMBOL
 }
 
-int ManualRuntimeLoadLib(char *path) {
-#if defined(MANUAL_LOAD)
-  char lib_path[300];
-  strncpy(lib_path, path, 200);
 #if defined(WINDOWS)
-  char *ext = ".dll";
+static const char *kLibraryExt = ".dll";
 #elif defined(__APPLE__)
-  char *ext = ".dylib";
+static const char *kLibraryExt = ".dylib";
 #else
-  const char *ext = ".so";
+static const char *kLibraryExt = ".so";
 #endif
+
+// The libraries this CPU can run, from the most to the least specific ISA. Optional tiers such as avxvnni need a
+// recent compiler and may not be shipped, in which case the next one is loaded.
+static std::vector<std::string> SupportedLibraries() {
+  std::vector<std::string> libs;
+  if (cpuid_support_feature(AMX_INT8) && cpuid_request_amx_permission()) {
+    libs.push_back("libbigquant_amx");
+  }
+  if (cpuid_support_feature(AVX_512_VNNI)) {
+    libs.push_back("libbigquant_avx512vnni");
+  }
+  if (cpuid_support_feature(AVX_512)) {
+    libs.push_back("libbigquant_avx512");
+  }
+  if (cpuid_support_feature(AVX_VNNI)) {
+    libs.push_back("libbigquant_avxvnni");
+  }
+  if (cpuid_support_feature(AVX2_FMA)) {
+    libs.push_back("libbigquant_avx2");
+  }
+  if (cpuid_support_feature(SSE4_2)) {
+    libs.push_back("libbigquant_sse42");
+  }
+  return libs;
+}
+
+// Returns the empty string on success, the path of the preferred library otherwise
+static std::string OpenSupportedLibrary(const std::string &dir) {
+  std::vector<std::string> libs = SupportedLibraries();
+  for (size_t i = 0; i < libs.size(); ++i) {
+    std::string lib_path = dir + libs[i] + kLibraryExt;
+#if defined(WINDOWS)
+    handler = LoadLibrary(lib_path.c_str());
+#else   // WINSOWS
+    handler = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_NODELETE);
+#endif  // WINDOWS
+    if (handler != NULL) {
+      return "";
+    }
+  }
+  return libs.empty() ? "" : dir + libs[0] + kLibraryExt;
+}
+
+int ManualRuntimeLoadLib(char *path) {
+#if defined(MANUAL_LOAD)
   if (handler == NULL) {
-    if (cpuid_support_feature(AVX_512)) {
-      strncat(lib_path, "/libbigquant_avx512", 100);
-    } else if (cpuid_support_feature(AVX2_FMA)) {
-      strncat(lib_path, "/libbigquant_avx2", 100);
-    } else if (cpuid_support_feature(SSE4_2)) {
-      strncat(lib_path, "/libbigquant_sse42", 100);
-    } else {
+    if (SupportedLibraries().empty()) {
       fprintf(stderr, "Unsupported ISA. Bigquant supports Instruction Set from SSE42 to AVX512.\n");
       return -1;
     }
-    strncat(lib_path, ext, 100);
-#if defined(WINDOWS)
-    handler = LoadLibrary(lib_path);
-#else   // WINSOWS
-    handler = dlopen(lib_path, RTLD_NOW | RTLD_NODELETE);
-#endif  // WINDOWS
+    std::string lib_path = OpenSupportedLibrary(std::string(path) + "/");
     if (handler == NULL) {
-      fprintf(stderr, "%s failed to be loaded.\n", lib_path);
+      fprintf(stderr, "%s failed to be loaded.\n", lib_path.c_str());
       return -2;
     }
   }
@@ -226,31 +420,12 @@ int ManualRuntimeLoadLib(char *path) {
 
 void __attribute__((constructor)) init_shared_library() {
 #ifndef MANUAL_LOAD
-  std::string lib_path;
-#if defined(WINDOWS)
-  std::string ext = ".dll";
-#elif defined(__APPLE__)
-  std::string ext = ".dylib";
-#else
-  std::string ext = ".so";
-#endif
   if (handler == NULL) {
-    if (cpuid_support_feature(AVX_512)) {
-      lib_path = "libbigquant_avx512";
-    } else if (cpuid_support_feature(AVX2_FMA)) {
-      lib_path = "libbigquant_avx2";
-    } else if (cpuid_support_feature(SSE4_2)) {
-      lib_path = "libbigquant_sse42";
-    } else {
+    if (SupportedLibraries().empty()) {
       std::cerr << "Unsupported ISA. Bigquant supports Instruction Set from SSE42 to AVX512.\n" << std::endl;
       exit(-1);
     }
-    lib_path += ext;
-#if defined(WINDOWS)
-    handler = LoadLibrary(lib_path.c_str());
-#else   // WINSOWS
-    handler = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_NODELETE);
-#endif  // WINDOWS
+    std::string lib_path = OpenSupportedLibrary("");
     if (handler == NULL) {
       std::cerr << lib_path.c_str() << " failed to be loaded." << std::endl;
       exit(-1);
@@ -278,6 +453,18 @@ void __attribute__((destructor)) free_shared_library() {
 #endif
 }
 
+void BigQuantSetParallelBackend(PARALLEL_BACKEND backend, size_t threads_num) {
+  BigQuantSetParallelBackendRT(backend, threads_num);
+}
+
+void BigQuantSetParallelExecutor(PARALLEL_EXECUTOR executor, void *host_context, size_t threads_num) {
+  BigQuantSetParallelExecutorRT(executor, host_context, threads_num);
+}
+
+void BigQuantSetAutoTuning(int enable, const char *cache_path) {
+  BigQuantSetAutoTuningRT(enable, cache_path);
+}
+
 QuantizedConvOp *QuantizedConvOpCreate() {
   return QuantizedConvOpCreateRT();
 }
@@ -294,11 +481,97 @@ void QuantizedConvOpInitWeight(QuantizedConvOp *p, float *weight) {
   QuantizedConvOpInitWeightRT(p, weight);
 }
 
+void QuantizedConvOpSetNumaMode(QuantizedConvOp *p, NUMA_MODE mode) {
+  QuantizedConvOpSetNumaModeRT(p, mode);
+}
+
+void QuantizedConvOpSetNumThreads(QuantizedConvOp *p, size_t threads_num) {
+  QuantizedConvOpSetNumThreadsRT(p, threads_num);
+}
+
+void QuantizedConvOpSetProfiling(QuantizedConvOp *p, int enable) {
+  QuantizedConvOpSetProfilingRT(p, enable);
+}
+
+int QuantizedConvOpGetProfile(QuantizedConvOp *p, QuantizedOpProfile *profile) {
+  return QuantizedConvOpGetProfileRT(p, profile);
+}
+
 void QuantizedConvOpExecute(QuantizedConvOp *p, float *dst, float *data, float *bias, size_t batch_size,
                             size_t channel_in, size_t height_in, size_t width_in) {
   QuantizedConvOpExecuteRT(p, dst, data, bias, batch_size, channel_in, height_in, width_in);
 }
 
+void QuantizedConvOpReserveWorkspace(QuantizedConvOp *p, size_t batch_size, size_t channel_in, size_t height_in,
+                                     size_t width_in) {
+  QuantizedConvOpReserveWorkspaceRT(p, batch_size, channel_in, height_in, width_in);
+}
+
+void QuantizedConvOpSetFusionMask(QuantizedConvOp *p, size_t fusion_mask) {
+  QuantizedConvOpSetFusionMaskRT(p, fusion_mask);
+}
+
+void QuantizedConvOpSetWeightQuantization(QuantizedConvOp *p, WEIGHT_QUANTIZATION mode) {
+  QuantizedConvOpSetWeightQuantizationRT(p, mode);
+}
+
+int QuantizedConvOpCalibrate(QuantizedConvOp *p, float *data, size_t batch_size, size_t channel_in, size_t height_in,
+                             size_t width_in) {
+  return QuantizedConvOpCalibrateRT(p, data, batch_size, channel_in, height_in, width_in);
+}
+
+int QuantizedConvOpFreezeCalibration(QuantizedConvOp *p) {
+  return QuantizedConvOpFreezeCalibrationRT(p);
+}
+
+void QuantizedConvOpResetCalibration(QuantizedConvOp *p) {
+  QuantizedConvOpResetCalibrationRT(p);
+}
+
+int QuantizedConvOpGetInputQuantization(QuantizedConvOp *p, float *scale, uint8_t *zero_point) {
+  return QuantizedConvOpGetInputQuantizationRT(p, scale, zero_point);
+}
+
+void QuantizedConvOpSetOutputQuantization(QuantizedConvOp *p, float scale, uint8_t zero_point) {
+  QuantizedConvOpSetOutputQuantizationRT(p, scale, zero_point);
+}
+
+void QuantizedConvOpExecuteToU8(QuantizedConvOp *p, uint8_t *dst, float *data, float *bias, size_t batch_size,
+                                size_t channel_in, size_t height_in, size_t width_in) {
+  QuantizedConvOpExecuteToU8RT(p, dst, data, bias, batch_size, channel_in, height_in, width_in);
+}
+
+void QuantizedConvOpExecuteFromU8(QuantizedConvOp *p, float *dst, uint8_t *data, float data_scale,
+                                  uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                  size_t height_in, size_t width_in) {
+  QuantizedConvOpExecuteFromU8RT(p, dst, data, data_scale, data_zero_point, bias, batch_size, channel_in, height_in,
+                                 width_in);
+}
+
+void QuantizedConvOpExecuteU8(QuantizedConvOp *p, uint8_t *dst, uint8_t *data, float data_scale,
+                              uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                              size_t height_in, size_t width_in) {
+  QuantizedConvOpExecuteU8RT(p, dst, data, data_scale, data_zero_point, bias, batch_size, channel_in, height_in,
+                             width_in);
+}
+
+void QuantizedConvOpSetBatchNorm(QuantizedConvOp *p, float *global_mean, float *variance, float *scale, float *shift,
+                                 float eps) {
+  QuantizedConvOpSetBatchNormRT(p, global_mean, variance, scale, shift, eps);
+}
+
+int QuantizedConvOpSaveWeight(QuantizedConvOp *p, const char *path) {
+  return QuantizedConvOpSaveWeightRT(p, path);
+}
+
+int QuantizedConvOpLoadWeight(QuantizedConvOp *p, const char *path) {
+  return QuantizedConvOpLoadWeightRT(p, path);
+}
+
+int QuantizedConvOpMapWeight(QuantizedConvOp *p, const char *path) {
+  return QuantizedConvOpMapWeightRT(p, path);
+}
+
 void QuantizedConvOpFree(QuantizedConvOp *p) {
   QuantizedConvOpFreeRT(p);
 }
@@ -312,19 +585,88 @@ void QuantizedFCOpSetupFCParameter(QuantizedFCOp *p, LAYOUT layout, size_t chann
   QuantizedFCOpSetupFCParameterRT(p, layout, channel_out, channel_in, algo);
 }
 
+void QuantizedFCOpSetWeightQuantization(QuantizedFCOp *p, WEIGHT_QUANTIZATION mode) {
+  QuantizedFCOpSetWeightQuantizationRT(p, mode);
+}
+
 void QuantizedFCOpInitWeight(QuantizedFCOp *p, float *weight) {
   QuantizedFCOpInitWeightRT(p, weight);
 }
 
+void QuantizedFCOpSetNumaMode(QuantizedFCOp *p, NUMA_MODE mode) {
+  QuantizedFCOpSetNumaModeRT(p, mode);
+}
+
+void QuantizedFCOpSetNumThreads(QuantizedFCOp *p, size_t threads_num) {
+  QuantizedFCOpSetNumThreadsRT(p, threads_num);
+}
+
 void QuantizedFCOpExecute(QuantizedFCOp *p, float *dst, float *data, float *bias, size_t batch_size,
                           size_t channel_in) {
   QuantizedFCOpExecuteRT(p, dst, data, bias, batch_size, channel_in);
 }
 
+void QuantizedFCOpReserveWorkspace(QuantizedFCOp *p, size_t batch_size, size_t channel_in) {
+  QuantizedFCOpReserveWorkspaceRT(p, batch_size, channel_in);
+}
+
+int QuantizedFCOpSaveWeight(QuantizedFCOp *p, const char *path) {
+  return QuantizedFCOpSaveWeightRT(p, path);
+}
+
+int QuantizedFCOpLoadWeight(QuantizedFCOp *p, const char *path) {
+  return QuantizedFCOpLoadWeightRT(p, path);
+}
+
+int QuantizedFCOpMapWeight(QuantizedFCOp *p, const char *path) {
+  return QuantizedFCOpMapWeightRT(p, path);
+}
+
 void QuantizedFCOpFree(QuantizedFCOp *p) {
   QuantizedFCOpFreeRT(p);
 }
 
+QuantizedNetwork *QuantizedNetworkCreate() {
+  return QuantizedNetworkCreateRT();
+}
+
+int QuantizedNetworkAddConv(QuantizedNetwork *p, QuantizedConvOp *op, int input, float *bias) {
+  return QuantizedNetworkAddConvRT(p, op, input, bias);
+}
+
+int QuantizedNetworkAddFC(QuantizedNetwork *p, QuantizedFCOp *op, int input, float *bias) {
+  return QuantizedNetworkAddFCRT(p, op, input, bias);
+}
+
+int QuantizedNetworkAddPool(QuantizedNetwork *p, int input, POOL_MODE mode, size_t kernel_h, size_t kernel_w,
+                            size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w) {
+  return QuantizedNetworkAddPoolRT(p, input, mode, kernel_h, kernel_w, stride_h, stride_w, pad_h, pad_w);
+}
+
+int QuantizedNetworkAddEltwiseSum(QuantizedNetwork *p, int input_a, int input_b, int relu) {
+  return QuantizedNetworkAddEltwiseSumRT(p, input_a, input_b, relu);
+}
+
+void QuantizedNetworkCompile(QuantizedNetwork *p, size_t channel_in, size_t height_in, size_t width_in) {
+  QuantizedNetworkCompileRT(p, channel_in, height_in, width_in);
+}
+
+void QuantizedNetworkGetOutputShape(QuantizedNetwork *p, size_t *channel, size_t *height, size_t *width) {
+  QuantizedNetworkGetOutputShapeRT(p, channel, height, width);
+}
+
+size_t QuantizedNetworkGetArenaSize(QuantizedNetwork *p, size_t batch_size) {
+  return QuantizedNetworkGetArenaSizeRT(p, batch_size);
+}
+
+void QuantizedNetworkExecute(QuantizedNetwork *p, float *dst, float *data, size_t batch_size) {
+  QuantizedNetworkExecuteRT(p, dst, data, batch_size);
+}
+
+void QuantizedNetworkFree(QuantizedNetwork *p) {
+  QuantizedNetworkFreeRT(p);
+}
+
 void QuantizedConvKernelDescInit(QuantizedTensorDesc *quantized_tensor, size_t c_out, size_t c_in, size_t kernel_h,
                                  size_t kernel_w) {
   QuantizedConvKernelDescInitRT(quantized_tensor, c_out, c_in, kernel_h, kernel_w);
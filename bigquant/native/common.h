@@ -23,6 +23,7 @@
 #include <numa.h>
 #endif
 #include "alloc.h"
+#include "parallel.h"
 /*
 INLINE_SPECIFIER void aligned_malloc(void** p, size_t alignment, size_t size) {
   *p = NULL;
@@ -63,23 +64,29 @@ INLINE_SPECIFIER size_t GetAlignmentLength(size_t n, size_t alignment = 1) {
   return alignment * static_cast<size_t>(ceil(1.0 * n / alignment));
 }
 
+// Largest magnitude of a quantized weight under the given WEIGHT_QUANTIZATION
+INLINE_SPECIFIER float GetWeightThreshold(WEIGHT_QUANTIZATION mode) {
+  return (mode == WEIGHT_8BIT) ? 127.0f : 64.0f;
+}
+
 template <typename DType>
 void ComputeMatrixSumPerRow(DType *dst, DType *src, size_t m, size_t n) {
-#pragma omp parallel for
-  for (size_t i = 0; i < m; ++i) {
+  ParallelFor(m, [&](size_t i) {
     DType sum = 0;
     for (size_t j = 0; j < n; ++j) {
       sum += *(src + i * n + j);
     }
     dst[i] = sum;
-  }
+  });
 }
 
+// Number of NUMA nodes, 1 without libnuma or when the kernel has no NUMA support
 INLINE_SPECIFIER size_t GetSocketNum() {
 #ifdef NUMA
-  return numa_num_configured_nodes();
-  else return 1;
+  static const size_t socket_num = (numa_available() < 0) ? 1 : std::max(numa_num_configured_nodes(), 1);
+  return socket_num;
 #endif
+  return 1;
 }
 
 size_t GetBlockSize(size_t x, size_t y) {
@@ -91,49 +98,83 @@ size_t GetBlockNum(size_t buffer_size, size_t tile_size, float ratio = 0.5) {
 }
 
 size_t GetThreadsNum() {
-#ifdef _OPENMP
-  size_t n;
-#pragma omp parallel
-  {
-#pragma omp master
-    { n = omp_get_num_threads(); }
-  }
-  return n;
-#else
-  return 1;
-#endif
+  return GetMaxThreadsNum();
 }
 
 size_t GetThreadsNumWrapper() {
   return GetThreadsNum();
 }
 
-// TODO(yan): still need some improvement, cannot detect cache relation, unified or private
+struct CacheSizeInfo {
+  size_t l1_cache_size_;
+  size_t l2_cache_size_;
+  size_t l3_cache_size_;
+  bool has_l3_;
+  // Threads sharing one L3, a CCX on AMD, a socket on most Intel parts. 0 when unknown.
+  size_t l3_sharing_threads_;
+};
+
+// Cache sizes never change at runtime, so cpuid is only issued on the first query. Sizes nothing reports fall back to
+// the CACHE_DEFAULT_* ones.
+INLINE_SPECIFIER const CacheSizeInfo &GetCacheSizeInfo() {
+  static const CacheSizeInfo info = [] {
+    struct cache_info l1_info = {};
+    struct cache_info l2_info = {};
+    struct cache_info l3_info = {};
+    CacheSizeInfo ret;
+    ret.l1_cache_size_ = (find_cache(1, l1_info) >= 0) ? l1_info.cache_size : CACHE_DEFAULT_L1_SIZE;
+    ret.l2_cache_size_ = (find_cache(2, l2_info) >= 0) ? l2_info.cache_size : CACHE_DEFAULT_L2_SIZE;
+    ret.has_l3_ = find_cache(3, l3_info) >= 0;
+    ret.l3_cache_size_ = ret.has_l3_ ? l3_info.cache_size : 0;
+    // Hypervisors often report every cache as private, an L3 shared no wider than the L2 is not believed
+    bool l3_shared = ret.has_l3_ && (l3_info.sharing_threads > l2_info.sharing_threads);
+    ret.l3_sharing_threads_ = l3_shared ? l3_info.sharing_threads : 0;
+    return ret;
+  }();
+  return info;
+}
+
+// Blocking factors of one GEMM along m and n for each cache level
+struct BlocksInfo {
+  size_t m_in_l1_;
+  size_t m_in_l2_;
+  size_t m_in_l3_;
+  size_t n_in_l1_;
+  size_t n_in_l2_;
+  size_t n_in_l3_;
+  // Loop order, the outer blocks walk n and the inner ones m when set
+  bool mltn_;
+};
+
+// L1 and L2 are taken as private to a thread and the LLC as shared by the threads of one LLC domain. Whether the LLC
+// is inclusive of the L2 is not accounted for.
 template <size_t tile_m>
-INLINE_SPECIFIER void GetBlocksInfo(size_t m, size_t k, size_t &m_in_l1, size_t &m_in_l2, size_t &m_in_l3) {
-  size_t threads_num = GetThreadsNumWrapper();
-  struct cache_info l1_info;
-  struct cache_info l2_info;
-  struct cache_info l3_info;
+INLINE_SPECIFIER void GetBlocksInfo(size_t m, size_t k, size_t threads_num, size_t &m_in_l1, size_t &m_in_l2,
+                                    size_t &m_in_l3) {
+  const CacheSizeInfo &cache_size_info = GetCacheSizeInfo();
 
   size_t block_size = GetBlockSize(tile_m, k);
 
-  cpuid_caches(0, l1_info);
-  size_t l1_cache_size = l1_info.cache_size;
+  size_t l1_cache_size = cache_size_info.l1_cache_size_;
   size_t block_num_per_L1 = GetBlockNum(l1_cache_size, block_size);
 
-  cpuid_caches(2, l2_info);
-  size_t l2_cache_size = l2_info.cache_size;
+  size_t l2_cache_size = cache_size_info.l2_cache_size_;
   size_t block_num_per_L2 = GetBlockNum(l2_cache_size, block_size) / block_num_per_L1 * block_num_per_L1;
 
-  int ret = cpuid_caches(3, l3_info);
-  size_t l3_cache_size = l3_info.cache_size;
+  int ret = cache_size_info.has_l3_ ? 0 : -1;
+  size_t l3_cache_size = cache_size_info.l3_cache_size_;
 
+  // Threads spread over several LLC domains, CCXs or sockets, have one LLC per domain
+  size_t llc_threads_num = threads_num;
+  if (cache_size_info.l3_sharing_threads_ != 0) {
+    llc_threads_num = std::min(threads_num, cache_size_info.l3_sharing_threads_);
+  }
 #if defined(LLC_EXCLUSIVE)
-  l3_cache_size /= threads_num;
+  l3_cache_size /= llc_threads_num;
   l3_cache_size += l2_cache_size;
 #else
-  l3_cache_size += l2_cache_size * threads_num;
+  size_t llc_domains = (threads_num + llc_threads_num - 1) / llc_threads_num;
+  l3_cache_size = l3_cache_size * llc_domains + l2_cache_size * threads_num;
 #endif
   size_t block_num_per_L3 = GetBlockNum(l3_cache_size, block_size) / block_num_per_L2 * block_num_per_L2;
 
@@ -160,4 +201,16 @@ INLINE_SPECIFIER void GetBlocksInfo(size_t m, size_t k, size_t &m_in_l1, size_t
   std::cerr << "m:" << m << " m_in_l3:" << m_in_l3 << " m_in_l2: " << m_in_l2 << " m_in_l1:" << m_in_l1 << std::endl;
 #endif
 }
+
+template <size_t tile_m>
+INLINE_SPECIFIER void GetBlocksInfo(size_t m, size_t k, size_t &m_in_l1, size_t &m_in_l2, size_t &m_in_l3) {
+  GetBlocksInfo<tile_m>(m, k, GetThreadsNumWrapper(), m_in_l1, m_in_l2, m_in_l3);
+}
+
+template <size_t tile_m, size_t tile_n>
+INLINE_SPECIFIER void GetBlocksInfo(size_t m, size_t n, size_t k, size_t threads_num, BlocksInfo &blocks_info) {
+  GetBlocksInfo<tile_m>(m, k, threads_num, blocks_info.m_in_l1_, blocks_info.m_in_l2_, blocks_info.m_in_l3_);
+  GetBlocksInfo<tile_n>(n, k, threads_num, blocks_info.n_in_l1_, blocks_info.n_in_l2_, blocks_info.n_in_l3_);
+  blocks_info.mltn_ = m < n;
+}
 #endif
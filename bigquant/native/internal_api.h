@@ -28,6 +28,12 @@
 
 extern "C" {
 
+void InternalBigQuantSetParallelBackend(PARALLEL_BACKEND backend, size_t threads_num);
+
+void InternalBigQuantSetParallelExecutor(PARALLEL_EXECUTOR executor, void *host_context, size_t threads_num);
+
+void InternalBigQuantSetAutoTuning(int enable, const char *cache_path);
+
 QuantizedConvOp *InternalQuantizedConvOpCreate();
 
 void InternalQuantizedConvOpSetupConvParameter(QuantizedConvOp *p, LAYOUT layout, size_t channel_out, size_t channel_in,
@@ -37,9 +43,55 @@ void InternalQuantizedConvOpSetupConvParameter(QuantizedConvOp *p, LAYOUT layout
 
 void InternalQuantizedConvOpInitWeight(QuantizedConvOp *p, float *weight);
 
+void InternalQuantizedConvOpSetNumaMode(QuantizedConvOp *p, NUMA_MODE mode);
+
+void InternalQuantizedConvOpSetNumThreads(QuantizedConvOp *p, size_t threads_num);
+
+void InternalQuantizedConvOpSetProfiling(QuantizedConvOp *p, int enable);
+
+int InternalQuantizedConvOpGetProfile(QuantizedConvOp *p, QuantizedOpProfile *profile);
+
 void InternalQuantizedConvOpExecute(QuantizedConvOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                     size_t channel_in, size_t height_in, size_t width_in);
 
+void InternalQuantizedConvOpReserveWorkspace(QuantizedConvOp *p, size_t batch_size, size_t channel_in,
+                                             size_t height_in, size_t width_in);
+
+void InternalQuantizedConvOpSetFusionMask(QuantizedConvOp *p, size_t fusion_mask);
+
+void InternalQuantizedConvOpSetWeightQuantization(QuantizedConvOp *p, WEIGHT_QUANTIZATION mode);
+
+int InternalQuantizedConvOpCalibrate(QuantizedConvOp *p, float *data, size_t batch_size, size_t channel_in,
+                                     size_t height_in, size_t width_in);
+
+int InternalQuantizedConvOpFreezeCalibration(QuantizedConvOp *p);
+
+void InternalQuantizedConvOpResetCalibration(QuantizedConvOp *p);
+
+int InternalQuantizedConvOpGetInputQuantization(QuantizedConvOp *p, float *scale, uint8_t *zero_point);
+
+void InternalQuantizedConvOpSetOutputQuantization(QuantizedConvOp *p, float scale, uint8_t zero_point);
+
+void InternalQuantizedConvOpExecuteToU8(QuantizedConvOp *p, uint8_t *dst, float *data, float *bias, size_t batch_size,
+                                        size_t channel_in, size_t height_in, size_t width_in);
+
+void InternalQuantizedConvOpExecuteFromU8(QuantizedConvOp *p, float *dst, uint8_t *data, float data_scale,
+                                          uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                          size_t height_in, size_t width_in);
+
+void InternalQuantizedConvOpExecuteU8(QuantizedConvOp *p, uint8_t *dst, uint8_t *data, float data_scale,
+                                      uint8_t data_zero_point, float *bias, size_t batch_size, size_t channel_in,
+                                      size_t height_in, size_t width_in);
+
+void InternalQuantizedConvOpSetBatchNorm(QuantizedConvOp *p, float *global_mean, float *variance, float *scale,
+                                         float *shift, float eps);
+
+int InternalQuantizedConvOpSaveWeight(QuantizedConvOp *p, const char *path);
+
+int InternalQuantizedConvOpLoadWeight(QuantizedConvOp *p, const char *path);
+
+int InternalQuantizedConvOpMapWeight(QuantizedConvOp *p, const char *path);
+
 void InternalQuantizedConvOpFree(QuantizedConvOp *p);
 
 QuantizedFCOp *InternalQuantizedFCOpCreate();
@@ -47,13 +99,48 @@ QuantizedFCOp *InternalQuantizedFCOpCreate();
 void InternalQuantizedFCOpSetupFCParameter(QuantizedFCOp *p, LAYOUT layout, size_t channel_out, size_t channel_in,
                                            FC_ALGORITHM algo);
 
+void InternalQuantizedFCOpSetWeightQuantization(QuantizedFCOp *p, WEIGHT_QUANTIZATION mode);
+
 void InternalQuantizedFCOpInitWeight(QuantizedFCOp *p, float *weight);
 
+void InternalQuantizedFCOpSetNumaMode(QuantizedFCOp *p, NUMA_MODE mode);
+
+void InternalQuantizedFCOpSetNumThreads(QuantizedFCOp *p, size_t threads_num);
+
 void InternalQuantizedFCOpExecute(QuantizedFCOp *p, float *dst, float *data, float *bias, size_t batch_size,
                                   size_t channel_in);
 
+void InternalQuantizedFCOpReserveWorkspace(QuantizedFCOp *p, size_t batch_size, size_t channel_in);
+
+int InternalQuantizedFCOpSaveWeight(QuantizedFCOp *p, const char *path);
+
+int InternalQuantizedFCOpLoadWeight(QuantizedFCOp *p, const char *path);
+
+int InternalQuantizedFCOpMapWeight(QuantizedFCOp *p, const char *path);
+
 void InternalQuantizedFCOpFree(QuantizedFCOp *p);
 
+QuantizedNetwork *InternalQuantizedNetworkCreate();
+
+int InternalQuantizedNetworkAddConv(QuantizedNetwork *p, QuantizedConvOp *op, int input, float *bias);
+
+int InternalQuantizedNetworkAddFC(QuantizedNetwork *p, QuantizedFCOp *op, int input, float *bias);
+
+int InternalQuantizedNetworkAddPool(QuantizedNetwork *p, int input, POOL_MODE mode, size_t kernel_h, size_t kernel_w,
+                                    size_t stride_h, size_t stride_w, size_t pad_h, size_t pad_w);
+
+int InternalQuantizedNetworkAddEltwiseSum(QuantizedNetwork *p, int input_a, int input_b, int relu);
+
+void InternalQuantizedNetworkCompile(QuantizedNetwork *p, size_t channel_in, size_t height_in, size_t width_in);
+
+void InternalQuantizedNetworkGetOutputShape(QuantizedNetwork *p, size_t *channel, size_t *height, size_t *width);
+
+size_t InternalQuantizedNetworkGetArenaSize(QuantizedNetwork *p, size_t batch_size);
+
+void InternalQuantizedNetworkExecute(QuantizedNetwork *p, float *dst, float *data, size_t batch_size);
+
+void InternalQuantizedNetworkFree(QuantizedNetwork *p);
+
 void InternalQuantizedConvKernelDescInit(QuantizedTensorDesc *quantized_tensor, size_t c_out, size_t c_in,
                                          size_t kernel_h, size_t kernel_w);
 
@@ -20,10 +20,11 @@
 #include "../base.h"
 #include "../common.h"
 #include "../tensor.h"
+#include "../workspace.h"
+#include "../weight_blob.h"
+#include "../profile.h"
 #include "../ops/ops.h"
-#ifdef TIME_PROFILE
-#include <chrono>
-#endif
+#include <algorithm>
 
 struct ConvolutionKernelDesc {
   LAYOUT layout_;
@@ -43,6 +44,8 @@ struct ConvolutionKernelDesc {
   size_t dilation_w_;
 
   size_t fusion_mask_;
+  WEIGHT_QUANTIZATION weight_quantization_;
+  NUMA_MODE numa_mode_;
 };
 
 struct ConvolutionDataDesc {
@@ -52,24 +55,308 @@ struct ConvolutionDataDesc {
   size_t width_in_;
 };
 
+// Everything that only depends on the input shape and the number of threads, computed once per shape and reused by
+// later executions.
+struct ConvolutionPlan {
+  size_t batch_size_;
+  size_t height_in_;
+  size_t width_in_;
+  size_t threads_num_;
+
+  size_t height_out_;
+  size_t width_out_;
+  size_t gemm_n_;
+  size_t aligned_gemm_n_;
+  size_t workspace_size_;
+  BlocksInfo blocks_info_;
+
+  bool Match(const ConvolutionDataDesc &conv_data_desc, size_t threads_num) const {
+    return (batch_size_ == conv_data_desc.batch_size_) && (height_in_ == conv_data_desc.height_in_) &&
+           (width_in_ == conv_data_desc.width_in_) && (threads_num_ == threads_num);
+  }
+};
+
+// Inference batch norm folded into the convolution epilogue, y = (x - global_mean) * mul_variance_coeff * scale + shift
+// with mul_variance_coeff = 1 / sqrt(variance + eps). scale and shift are optional.
+struct BatchNormDesc {
+  std::vector<float> global_mean_;
+  std::vector<float> mul_variance_coeff_;
+  std::vector<float> scale_;
+  std::vector<float> shift_;
+
+  void Init(float *global_mean, float *variance, float *scale, float *shift, float eps, size_t channel) {
+    global_mean_.assign(global_mean, global_mean + channel);
+    mul_variance_coeff_.resize(channel);
+    for (size_t c = 0; c < channel; ++c) {
+      mul_variance_coeff_[c] = 1.0f / sqrtf(variance[c] + eps);
+    }
+    if (scale != NULL) {
+      scale_.assign(scale, scale + channel);
+    } else {
+      scale_.clear();
+    }
+    if (shift != NULL) {
+      shift_.assign(shift, shift + channel);
+    } else {
+      shift_.clear();
+    }
+  }
+
+  bool Empty() const {
+    return global_mean_.empty();
+  }
+
+  float *GlobalMean(size_t offset) {
+    return global_mean_.empty() ? NULL : global_mean_.data() + offset;
+  }
+
+  float *MulVarianceCoeff(size_t offset) {
+    return mul_variance_coeff_.empty() ? NULL : mul_variance_coeff_.data() + offset;
+  }
+
+  float *Scale(size_t offset) {
+    return scale_.empty() ? NULL : scale_.data() + offset;
+  }
+
+  float *Shift(size_t offset) {
+    return shift_.empty() ? NULL : shift_.data() + offset;
+  }
+};
+
+// Activation range of every group recorded over representative inputs. Once frozen the data is quantized with this
+// fixed range, so the im2col no longer needs the extremes along channels nor the ones of each patch.
+struct DataCalibrationDesc {
+  std::vector<float> min_;
+  std::vector<float> max_;
+  bool frozen_;
+
+  DataCalibrationDesc() : frozen_(false) {
+  }
+
+  void Reset() {
+    min_.clear();
+    max_.clear();
+    frozen_ = false;
+  }
+
+  // Zero is always part of the range, it is the value of the padded border. A new input unfreezes the range until the
+  // next Freeze.
+  void Update(const float *data, const ConvolutionDataDesc &conv_data_desc,
+              const ConvolutionKernelDesc &conv_kernel_desc) {
+    frozen_ = false;
+    size_t groups = conv_kernel_desc.group_;
+    size_t channels_per_group = conv_kernel_desc.channel_in_per_group_;
+    size_t spatial_size = conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    if (min_.size() != groups) {
+      min_.assign(groups, 0.0f);
+      max_.assign(groups, 0.0f);
+    }
+    for (size_t b = 0; b < conv_data_desc.batch_size_; ++b) {
+      const float *image = data + b * conv_kernel_desc.channel_in_ * spatial_size;
+      for (size_t g = 0; g < groups; ++g) {
+        float local_min, local_max;
+        if (conv_kernel_desc.layout_ == NCHW) {
+          FindMinMaxValue(image + g * channels_per_group * spatial_size, channels_per_group * spatial_size, local_min,
+                          local_max);
+          min_[g] = std::min(min_[g], local_min);
+          max_[g] = std::max(max_[g], local_max);
+        } else {
+          for (size_t s = 0; s < spatial_size; ++s) {
+            FindMinMaxValue(image + (s * groups + g) * channels_per_group, channels_per_group, local_min, local_max);
+            min_[g] = std::min(min_[g], local_min);
+            max_[g] = std::max(max_[g], local_max);
+          }
+        }
+      }
+    }
+  }
+
+  bool Freeze() {
+    if (min_.empty()) {
+      return false;
+    }
+    for (size_t g = 0; g < min_.size(); ++g) {
+      if (max_[g] <= min_[g]) {
+        max_[g] = min_[g] + 1.0f;
+      }
+    }
+    frozen_ = true;
+    return true;
+  }
+
+  bool Frozen() const {
+    return frozen_;
+  }
+};
+
+// Activations passed between quantized layers without going through fp32: u8 NHWC with value = (q - zero_point_) *
+// scale_. The codes stay within [0, QUANTIZED_ACTIVATION_MAX], the data range of the shuffle GEMM, so that a layer can
+// feed its u8 output straight into the next one.
+#define QUANTIZED_ACTIVATION_MAX 127
+
+struct QuantizedActivationDesc {
+  float scale_;
+  uint8_t zero_point_;
+};
+
+static inline void DequantizeActivation(float *dst, const uint8_t *src, size_t length,
+                                        const QuantizedActivationDesc &quantization) {
+  float zero_point = quantization.zero_point_;
+  ParallelFor(length, [&](size_t i) {
+    dst[i] = (src[i] - zero_point) * quantization.scale_;
+  });
+}
+
+static inline void QuantizeActivation(uint8_t *dst, const float *src, size_t length,
+                                      const QuantizedActivationDesc &quantization) {
+  float inv_scale = 1.0f / quantization.scale_;
+  float zero_point = quantization.zero_point_;
+  ParallelFor(length, [&](size_t i) {
+    float value = std::min(std::max(src[i] * inv_scale + zero_point, 0.0f), float(QUANTIZED_ACTIVATION_MAX));
+    dst[i] = static_cast<uint8_t>(value + 0.5f);
+  });
+}
+
+static inline bool FusionNeedBatchNorm(size_t fusion_mask) {
+  return (fusion_mask & (CONV_BN_FUSION | CONV_BN_RELU_FUSION | CONV_RELU_BN_FUSION)) != 0;
+}
+
 struct BaseConvolutionAlgo {
 
-  BaseConvolutionAlgo() = default;
+  BaseConvolutionAlgo() : weight_blob_(NULL) {
+  }
 
   BaseConvolutionAlgo(const BaseConvolutionAlgo&) = delete;
 
   BaseConvolutionAlgo& operator=(const BaseConvolutionAlgo&) = delete;
 
-  virtual ~BaseConvolutionAlgo(){
-
+  virtual ~BaseConvolutionAlgo() {
+    ReleaseWeightBlob();
   };
   virtual void InitWeight(float *weight, ConvolutionKernelDesc &conv_kernel_desc) = 0;
+  virtual void InitPlan(ConvolutionPlan &plan, ConvolutionDataDesc &conv_data_desc,
+                        ConvolutionKernelDesc &conv_kernel_desc) {
+    plan.height_out_ = GetConvOutSize(conv_data_desc.height_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.stride_h_,
+                                      conv_kernel_desc.pad_h_, conv_kernel_desc.dilation_h_);
+    plan.width_out_ = GetConvOutSize(conv_data_desc.width_in_, conv_kernel_desc.kernel_w_, conv_kernel_desc.stride_w_,
+                                     conv_kernel_desc.pad_w_, conv_kernel_desc.dilation_w_);
+  }
+  // Only reads the algorithm state, everything of the execution itself lives in workspace, so executions with their
+  // own workspaces can run concurrently.
   virtual void Execute(float *out, float *data, float *bias, ConvolutionDataDesc &conv_data_desc,
-                       ConvolutionKernelDesc &conv_kernel_desc) = 0;
+                       ConvolutionKernelDesc &conv_kernel_desc, const ConvolutionPlan &plan,
+                       Workspace &workspace) = 0;
+  // Only the algorithms returning true implement ExecuteQuantized, the op runs the other ones on fp32 copies
+  virtual bool SupportQuantizedActivation() const {
+    return false;
+  }
+  // The algorithms returning false quantize their data on the fly and reject Calibrate and FreezeCalibration
+  virtual bool SupportCalibration() const {
+    return true;
+  }
+  // out is u8 NHWC when out_quantization is given and data is u8 NHWC when data_quantization is given, fp32 otherwise
+  virtual void ExecuteQuantized(void *out, const QuantizedActivationDesc *out_quantization, void *data,
+                                const QuantizedActivationDesc *data_quantization, float *bias,
+                                ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                                const ConvolutionPlan &plan, Workspace &workspace) {
+  }
+  // Pre-allocate the scratch memory Execute needs for the given data shape, so later executions with the same or
+  // smaller shape do not allocate.
+  virtual void ReserveWorkspace(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                                Workspace &workspace) {
+  }
+  // Place the quantized weight according to conv_kernel_desc.numa_mode_, the algorithms without a quantized weight
+  // panel keep theirs where it is
+  virtual void PlaceWeight(ConvolutionKernelDesc &conv_kernel_desc) {
+  }
+  // Serialize the quantized weight to / restore it from a weight blob. Return a WEIGHT_BLOB_STATUS.
+  virtual int SaveWeight(WeightBlobWriter &writer, ConvolutionKernelDesc &conv_kernel_desc) {
+    return WEIGHT_BLOB_UNSUPPORTED;
+  }
+  // With zero_copy the weight tensors point into the reader's mapping instead of owning a copy, the caller keeps the
+  // mapping alive as long as the weight is used.
+  virtual int LoadWeight(WeightBlobReader &reader, ConvolutionKernelDesc &conv_kernel_desc, bool zero_copy) {
+    return WEIGHT_BLOB_UNSUPPORTED;
+  }
+
+  // Use the weight blob in place. The blob is mapped read-only and shared, through the page cache, by every process
+  // mapping the same file.
+  int MapWeight(const char *path, ConvolutionKernelDesc &conv_kernel_desc) {
+    WeightBlobReader *reader = new WeightBlobReader();
+    int ret = reader->Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = LoadWeight(*reader, conv_kernel_desc, true);
+    }
+    if (ret != WEIGHT_BLOB_OK) {
+      delete reader;
+      return ret;
+    }
+    // LoadWeight already dropped the previous weight and its mapping
+    weight_blob_ = reader;
+    return ret;
+  }
+
+  void ReleaseWeightBlob() {
+    if (weight_blob_) {
+      delete weight_blob_;
+      weight_blob_ = NULL;
+    }
+  }
+
+  void InitBatchNorm(float *global_mean, float *variance, float *scale, float *shift, float eps,
+                     ConvolutionKernelDesc &conv_kernel_desc) {
+    batch_norm_.Init(global_mean, variance, scale, shift, eps, conv_kernel_desc.channel_out_);
+  }
+
+  bool HasBatchNorm() const {
+    return !batch_norm_.Empty();
+  }
+
+  // Return 0, or -1 when the algorithm has no static quantization
+  int Calibrate(float *data, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc) {
+    if (!SupportCalibration()) {
+      fprintf(stderr, "The convolution algorithm quantizes its data dynamically, calibration rejected.\n");
+      return -1;
+    }
+    data_calibration_.Update(data, conv_data_desc, conv_kernel_desc);
+    return 0;
+  }
+
+  // Without any calibrated input the data keeps being quantized dynamically and -1 is returned
+  int FreezeCalibration() {
+    if (!SupportCalibration()) {
+      fprintf(stderr, "The convolution algorithm quantizes its data dynamically, calibration rejected.\n");
+      return -1;
+    }
+    if (!data_calibration_.Freeze()) {
+      fprintf(stderr, "Convolution calibration frozen before any input was calibrated, ignored.\n");
+      return -1;
+    }
+    return 0;
+  }
+
+  void ResetCalibration() {
+    data_calibration_.Reset();
+  }
+
+  // The u8 quantization matching the frozen input range, for the layer feeding this one. Returns false without one.
+  bool GetInputQuantization(QuantizedActivationDesc &quantization) {
+    if (!data_calibration_.Frozen()) {
+      return false;
+    }
+    // zero has to be exact, it is also the value of the padded border
+    float min = std::min(*std::min_element(data_calibration_.min_.begin(), data_calibration_.min_.end()), 0.0f);
+    float max = std::max(*std::max_element(data_calibration_.max_.begin(), data_calibration_.max_.end()), 0.0f);
+    quantization.scale_ = (max > min) ? (max - min) / QUANTIZED_ACTIVATION_MAX : 1.0f;
+    quantization.zero_point_ =
+        static_cast<uint8_t>(std::min(-min / quantization.scale_ + 0.5f, float(QUANTIZED_ACTIVATION_MAX)));
+    return true;
+  }
 
  protected:
-  size_t height_out_;
-  size_t width_out_;
+  BatchNormDesc batch_norm_;
+  DataCalibrationDesc data_calibration_;
+  WeightBlobReader *weight_blob_;
 };
 
 #endif
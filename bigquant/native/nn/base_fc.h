@@ -20,31 +20,98 @@
 #include "../base.h"
 #include "../common.h"
 #include "../tensor.h"
+#include "../workspace.h"
+#include "../weight_blob.h"
 #include "../ops/ops.h"
 
 struct FCKernelDesc {
   LAYOUT layout_;
   size_t channel_out_;
   size_t channel_in_;
+  WEIGHT_QUANTIZATION weight_quantization_;
+  NUMA_MODE numa_mode_;
 };
 struct FCDataDesc {
   size_t batch_size_;
   size_t channel_in_;
 };
 
+// Shape dependent state of one FC execution, computed once per batch size and reused by later executions.
+struct FCPlan {
+  size_t batch_size_;
+  size_t threads_num_;
+
+  size_t aligned_fc_n_;
+  size_t workspace_size_;
+  BlocksInfo blocks_info_;
+  // Small batches run as a GEMV over the unpadded batch
+  bool gemv_;
+
+  bool Match(const FCDataDesc &fc_data_desc, size_t threads_num) const {
+    return (batch_size_ == fc_data_desc.batch_size_) && (threads_num_ == threads_num);
+  }
+};
+
 struct BaseFCAlgo {
 
-  BaseFCAlgo() = default;
+  BaseFCAlgo() : weight_blob_(NULL) {
+  }
 
   BaseFCAlgo(const BaseFCAlgo&) = delete;
 
   BaseFCAlgo& operator=(const BaseFCAlgo&) = delete;
 
   virtual ~BaseFCAlgo() {
+    ReleaseWeightBlob();
   }
   virtual void InitWeight(float *weight, FCKernelDesc &fc_kernel_desc) = 0;
-  virtual void Execute(float *out, float *data, float *bias, FCDataDesc &fc_data_desc,
-                       FCKernelDesc &fc_kernel_desc) = 0;
+  virtual void InitPlan(FCPlan &plan, FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc) = 0;
+  // Only reads the algorithm state, everything of the execution itself lives in workspace, so executions with their
+  // own workspaces can run concurrently.
+  virtual void Execute(float *out, float *data, float *bias, FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc,
+                       const FCPlan &plan, Workspace &workspace) = 0;
+  // Pre-allocate the scratch memory Execute needs for the given batch size.
+  virtual void ReserveWorkspace(FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc, Workspace &workspace) {
+  }
+  // Place the quantized weight according to fc_kernel_desc.numa_mode_
+  virtual void PlaceWeight(FCKernelDesc &fc_kernel_desc) {
+  }
+  // Serialize the quantized weight to / restore it from a weight blob. Return a WEIGHT_BLOB_STATUS.
+  virtual int SaveWeight(WeightBlobWriter &writer, FCKernelDesc &fc_kernel_desc) {
+    return WEIGHT_BLOB_UNSUPPORTED;
+  }
+  // With zero_copy the weight tensors point into the reader's mapping instead of owning a copy, the caller keeps the
+  // mapping alive as long as the weight is used.
+  virtual int LoadWeight(WeightBlobReader &reader, FCKernelDesc &fc_kernel_desc, bool zero_copy) {
+    return WEIGHT_BLOB_UNSUPPORTED;
+  }
+
+  // Use the weight blob in place. The blob is mapped read-only and shared, through the page cache, by every process
+  // mapping the same file.
+  int MapWeight(const char *path, FCKernelDesc &fc_kernel_desc) {
+    WeightBlobReader *reader = new WeightBlobReader();
+    int ret = reader->Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = LoadWeight(*reader, fc_kernel_desc, true);
+    }
+    if (ret != WEIGHT_BLOB_OK) {
+      delete reader;
+      return ret;
+    }
+    // LoadWeight already dropped the previous weight and its mapping
+    weight_blob_ = reader;
+    return ret;
+  }
+
+  void ReleaseWeightBlob() {
+    if (weight_blob_) {
+      delete weight_blob_;
+      weight_blob_ = NULL;
+    }
+  }
+
+ protected:
+  WeightBlobReader *weight_blob_;
 };
 
 #endif
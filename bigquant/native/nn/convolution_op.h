@@ -19,15 +19,14 @@
 
 #include "base_convolution.h"
 #include "shuffle_convolution.h"
-
-#ifdef TIME_PROFILE
-#include <chrono>
-#endif
+#include "winograd_convolution.h"
+#include "depthwise_convolution.h"
+#include "../profile.h"
 
 // typedef enum CONV_ALGORITHM {SHULLFE_CONV=0} CONV_ALGORITHM;
 
 struct ConvOp {
-  ConvOp() : algo_id_(AUTO_SELECT_CONV), algo_(NULL) {
+  ConvOp() : algo_id_(AUTO_SELECT_CONV), algo_(NULL), has_output_quantization_(false), threads_num_(0) {
   }
 
   ~ConvOp() {
@@ -47,19 +46,37 @@ struct ConvOp {
     ChooseAlgo(algo);
   }
 
-  void SetupConvolutionDataParameter(size_t batch_size, size_t channel_in, size_t height_in, size_t width_in) {
-    conv_data_desc_ = {batch_size, channel_in, height_in, width_in};
-  }
-
   void ChooseAlgo(CONV_ALGORITHM algo_id) {
     algo_id_ = algo_id;
+    ClearPlans();
     switch (algo_id_) {
       case SHUFFLE_CONV: {
         algo_ = new ShuffleConvolutionAlgo(conv_kernel_desc_);
         break;
       }
+      case WINOGRAD_CONV: {
+        if (WinogradSupported(conv_kernel_desc_)) {
+          algo_ = new WinogradConvolutionAlgo(conv_kernel_desc_);
+        } else {
+          algo_ = new ShuffleConvolutionAlgo(conv_kernel_desc_);
+        }
+        break;
+      }
+      case DEPTHWISE_CONV: {
+        if (DepthwiseSupported(conv_kernel_desc_)) {
+          algo_ = new DepthwiseConvolutionAlgo(conv_kernel_desc_);
+        } else {
+          algo_ = new ShuffleConvolutionAlgo(conv_kernel_desc_);
+        }
+        break;
+      }
       default: {
-        algo_ = new ShuffleConvolutionAlgo(conv_kernel_desc_);
+        // Winograd stays opt-in, it quantizes the transformed tiles with a larger error
+        if (DepthwiseSupported(conv_kernel_desc_)) {
+          algo_ = new DepthwiseConvolutionAlgo(conv_kernel_desc_);
+        } else {
+          algo_ = new ShuffleConvolutionAlgo(conv_kernel_desc_);
+        }
         break;
       }
     }
@@ -67,17 +84,256 @@ struct ConvOp {
 
   void InitWeight(float *weight) {
     algo_->InitWeight(weight, conv_kernel_desc_);
+    ClearPlans();
+  }
+
+  bool FindPlan(ConvolutionDataDesc &conv_data_desc, size_t threads_num, ConvolutionPlan &plan) {
+    for (auto iter = plans_.begin(); iter < plans_.end(); ++iter) {
+      if (iter->Match(conv_data_desc, threads_num)) {
+        plan = *iter;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns a copy, another thread may evict the cached one meanwhile. A new plan is made outside the lock, auto
+  // tuning it may take a while and the executions of the shapes already planned must not wait for it. Two threads
+  // planning the same shape keep the first plan stored.
+  ConvolutionPlan GetPlan(ConvolutionDataDesc &conv_data_desc) {
+    size_t threads_num = GetMaxThreadsNum();
+    ConvolutionPlan plan;
+    {
+      std::lock_guard<std::mutex> lock(plans_mutex_);
+      if (FindPlan(conv_data_desc, threads_num, plan)) {
+        return plan;
+      }
+    }
+    plan.batch_size_ = conv_data_desc.batch_size_;
+    plan.height_in_ = conv_data_desc.height_in_;
+    plan.width_in_ = conv_data_desc.width_in_;
+    plan.threads_num_ = threads_num;
+    algo_->InitPlan(plan, conv_data_desc, conv_kernel_desc_);
+    std::lock_guard<std::mutex> lock(plans_mutex_);
+    if (FindPlan(conv_data_desc, threads_num, plan)) {
+      return plan;
+    }
+    if (plans_.size() >= MAX_PLAN_NUM) {
+      plans_.erase(plans_.begin());
+    }
+    plans_.push_back(plan);
+    return plan;
+  }
+
+  void ClearPlans() {
+    std::lock_guard<std::mutex> lock(plans_mutex_);
+    plans_.clear();
+  }
+
+  void SetFusionMask(size_t fusion_mask) {
+    conv_kernel_desc_.fusion_mask_ = fusion_mask;
+  }
+
+  // Takes effect at the next InitWeight, LoadWeight or MapWeight
+  void SetWeightQuantization(WEIGHT_QUANTIZATION mode) {
+    conv_kernel_desc_.weight_quantization_ = mode;
+  }
+
+  // Places the current weight right away, and the later ones as they come
+  void SetNumaMode(NUMA_MODE mode) {
+    conv_kernel_desc_.numa_mode_ = mode;
+    if (algo_ != NULL) {
+      algo_->PlaceWeight(conv_kernel_desc_);
+    }
+  }
+
+  void SetNumThreads(size_t threads_num) {
+    threads_num_ = threads_num;
+  }
+
+  size_t GetOutputSpatialSize(ConvolutionDataDesc &conv_data_desc) {
+    ConvolutionKernelDesc &desc = conv_kernel_desc_;
+    size_t height_out = GetConvOutSize(conv_data_desc.height_in_, desc.kernel_h_, desc.stride_h_, desc.pad_h_,
+                                       desc.dilation_h_);
+    size_t width_out = GetConvOutSize(conv_data_desc.width_in_, desc.kernel_w_, desc.stride_w_, desc.pad_w_,
+                                      desc.dilation_w_);
+    return conv_data_desc.batch_size_ * height_out * width_out;
+  }
+
+  // Of the GEMM of one execution
+  size_t GetMultiplyAdds(ConvolutionDataDesc &conv_data_desc) {
+    ConvolutionKernelDesc &desc = conv_kernel_desc_;
+    return desc.channel_out_ * GetOutputSpatialSize(conv_data_desc) * desc.channel_in_per_group_ * desc.kernel_h_ *
+           desc.kernel_w_;
+  }
+
+  // Multiply-adds of the GEMM of one execution decide the threads under AUTO_THREADS_NUM
+  size_t GetThreadsLimit(ConvolutionDataDesc &conv_data_desc) {
+    return GetOpThreadsNum(threads_num_, GetMultiplyAdds(conv_data_desc));
+  }
+
+  void SetProfiling(bool enabled) {
+    profiler_.Enable(enabled);
   }
 
+  bool GetProfile(QuantizedOpProfile &profile) {
+    return profiler_.Get(profile);
+  }
+
+  // The input and output read and written once, fp32 or u8, plus the s8 weight
+  double GetProfiledBytes(ConvolutionDataDesc &conv_data_desc, bool quantized_data, bool quantized_out) {
+    ConvolutionKernelDesc &desc = conv_kernel_desc_;
+    double input_size = static_cast<double>(conv_data_desc.batch_size_) * conv_data_desc.channel_in_ *
+                        conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    double output_size = static_cast<double>(GetOutputSpatialSize(conv_data_desc)) * desc.channel_out_;
+    double weight_size = static_cast<double>(desc.channel_out_) * desc.channel_in_per_group_ * desc.kernel_h_ *
+                         desc.kernel_w_;
+    return input_size * (quantized_data ? sizeof(uint8_t) : sizeof(float)) +
+           output_size * (quantized_out ? sizeof(uint8_t) : sizeof(float)) + weight_size;
+  }
+
+  void InitBatchNorm(float *global_mean, float *variance, float *scale, float *shift, float eps) {
+    algo_->InitBatchNorm(global_mean, variance, scale, shift, eps, conv_kernel_desc_);
+  }
+
+  int Calibrate(float *data, size_t batch_size, size_t channel_in, size_t height_in, size_t width_in) {
+    ConvolutionDataDesc conv_data_desc = {batch_size, channel_in, height_in, width_in};
+    return algo_->Calibrate(data, conv_data_desc, conv_kernel_desc_);
+  }
+
+  // The static im2col needs a different workspace, hence the plans are recomputed
+  int FreezeCalibration() {
+    int ret = algo_->FreezeCalibration();
+    ClearPlans();
+    return ret;
+  }
+
+  void ResetCalibration() {
+    algo_->ResetCalibration();
+    ClearPlans();
+  }
+
+  int SaveWeight(const char *path) {
+    WeightBlobWriter writer;
+    int ret = writer.Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = algo_->SaveWeight(writer, conv_kernel_desc_);
+    }
+    int close_ret = writer.Close();
+    return (ret == WEIGHT_BLOB_OK) ? close_ret : ret;
+  }
+
+  int LoadWeight(const char *path) {
+    WeightBlobReader reader;
+    int ret = reader.Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = algo_->LoadWeight(reader, conv_kernel_desc_, false);
+      ClearPlans();
+    }
+    return ret;
+  }
+
+  int MapWeight(const char *path) {
+    int ret = algo_->MapWeight(path, conv_kernel_desc_);
+    ClearPlans();
+    return ret;
+  }
+
+  // Safe to call from several threads at once, each execution runs in a workspace of its own. Changing the weight, the
+  // calibration or the parameters concurrently with an execution is not.
   void Execute(float *out, float *data, float *bias, size_t batch_size, size_t channel_in, size_t height_in,
                size_t width_in) {
-    SetupConvolutionDataParameter(batch_size, channel_in, height_in, width_in);
-    algo_->Execute(out, data, bias, conv_data_desc_, conv_kernel_desc_);
+    CheckBatchNorm();
+    ConvolutionDataDesc conv_data_desc = {batch_size, channel_in, height_in, width_in};
+    ScopedProfile profile(profiler_, GetProfiledBytes(conv_data_desc, false, false),
+                          2.0 * GetMultiplyAdds(conv_data_desc));
+    ScopedThreadsLimit threads_limit(GetThreadsLimit(conv_data_desc));
+    ConvolutionPlan plan = GetPlan(conv_data_desc);
+    ScopedWorkspace workspace(workspace_pool_);
+    algo_->Execute(out, data, bias, conv_data_desc, conv_kernel_desc_, plan, workspace.Get());
+  }
+
+  void SetOutputQuantization(float scale, uint8_t zero_point) {
+    output_quantization_ = {scale, zero_point};
+    has_output_quantization_ = true;
+  }
+
+  bool GetInputQuantization(QuantizedActivationDesc &quantization) {
+    return algo_->GetInputQuantization(quantization);
+  }
+
+  // out is u8 NHWC with the output quantization when quantized_out is set, data is u8 NHWC when data_quantization is
+  // given. The algorithms which cannot read or write them directly run on fp32 copies.
+  void ExecuteQuantized(void *out, bool quantized_out, void *data, const QuantizedActivationDesc *data_quantization,
+                        float *bias, size_t batch_size, size_t channel_in, size_t height_in, size_t width_in) {
+    CheckBatchNorm();
+    if (conv_kernel_desc_.layout_ != NHWC) {
+      fprintf(stderr, "Quantized activations are NHWC, but the convolution is set up as NCHW.\n");
+      exit(-1);
+    }
+    if (quantized_out && !has_output_quantization_) {
+      fprintf(stderr, "Convolution with quantized output, but the output quantization is not set.\n");
+      exit(-1);
+    }
+    const QuantizedActivationDesc *out_quantization = quantized_out ? &output_quantization_ : NULL;
+    ConvolutionDataDesc conv_data_desc = {batch_size, channel_in, height_in, width_in};
+    ScopedProfile profile(profiler_, GetProfiledBytes(conv_data_desc, data_quantization != NULL, quantized_out),
+                          2.0 * GetMultiplyAdds(conv_data_desc));
+    ScopedThreadsLimit threads_limit(GetThreadsLimit(conv_data_desc));
+    ConvolutionPlan plan = GetPlan(conv_data_desc);
+    ScopedWorkspace workspace(workspace_pool_);
+    if (algo_->SupportQuantizedActivation()) {
+      algo_->ExecuteQuantized(out, out_quantization, data, data_quantization, bias, conv_data_desc,
+                              conv_kernel_desc_, plan, workspace.Get());
+      return;
+    }
+    size_t input_size = batch_size * height_in * width_in * channel_in;
+    size_t output_size = batch_size * plan.height_out_ * plan.width_out_ * conv_kernel_desc_.channel_out_;
+    ScopedWorkspace activations(workspace_pool_);
+    activations.Get().Reserve(Workspace::AlignedSize(sizeof(float) * input_size) +
+                              Workspace::AlignedSize(sizeof(float) * output_size));
+    float *fp_data = static_cast<float *>(data);
+    float *fp_out = static_cast<float *>(out);
+    if (data_quantization != NULL) {
+      fp_data = activations.Get().Acquire<float>(input_size);
+      ProfileTimer timer(PROFILE_QUANTIZE);
+      DequantizeActivation(fp_data, static_cast<uint8_t *>(data), input_size, *data_quantization);
+    }
+    if (out_quantization != NULL) {
+      fp_out = activations.Get().Acquire<float>(output_size);
+    }
+    algo_->Execute(fp_out, fp_data, bias, conv_data_desc, conv_kernel_desc_, plan, workspace.Get());
+    if (out_quantization != NULL) {
+      ProfileTimer timer(PROFILE_EPILOGUE);
+      QuantizeActivation(static_cast<uint8_t *>(out), fp_out, output_size, *out_quantization);
+    }
+  }
+
+  void CheckBatchNorm() {
+    if (FusionNeedBatchNorm(conv_kernel_desc_.fusion_mask_) && !algo_->HasBatchNorm()) {
+      fprintf(stderr, "Convolution fused with batch norm, but batch norm statistics are not set.\n");
+      exit(-1);
+    }
+  }
+
+  // Grows the workspace the next execution picks up
+  void ReserveWorkspace(size_t batch_size, size_t channel_in, size_t height_in, size_t width_in) {
+    ConvolutionDataDesc conv_data_desc = {batch_size, channel_in, height_in, width_in};
+    ScopedThreadsLimit threads_limit(GetThreadsLimit(conv_data_desc));
+    ScopedWorkspace workspace(workspace_pool_);
+    algo_->ReserveWorkspace(conv_data_desc, conv_kernel_desc_, workspace.Get());
   }
 
   CONV_ALGORITHM algo_id_;
   BaseConvolutionAlgo *algo_;
   ConvolutionKernelDesc conv_kernel_desc_;
-  ConvolutionDataDesc conv_data_desc_;
+  std::vector<ConvolutionPlan> plans_;
+  std::mutex plans_mutex_;
+  WorkspacePool workspace_pool_;
+  QuantizedActivationDesc output_quantization_;
+  bool has_output_quantization_;
+  // 0 for all the threads of the backend, AUTO_THREADS_NUM to size every execution from its work
+  size_t threads_num_;
+  OpProfiler profiler_;
 };
 #endif
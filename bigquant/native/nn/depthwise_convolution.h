@@ -0,0 +1,198 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NN_DEPTHWISE_CONVOLUTION_H
+#define NN_DEPTHWISE_CONVOLUTION_H
+#include "base_convolution.h"
+
+// One input and one output channel per group, the shuffle algorithm would run one GEMM with a single row per group
+static inline bool DepthwiseSupported(const ConvolutionKernelDesc &conv_kernel_desc) {
+  return (conv_kernel_desc.group_ > 1) && (conv_kernel_desc.channel_in_per_group_ == 1) &&
+         (conv_kernel_desc.channel_out_per_group_ == 1);
+}
+
+// The data is quantized per channel, which is also the granularity of the calibration for this shape, and the weight
+// per channel over its kernel_h x kernel_w taps. Nothing saturates, so the weight always uses the full s8 range
+// whatever the weight quantization mode.
+struct DepthwiseConvolutionAlgo : public BaseConvolutionAlgo {
+  DepthwiseConvolutionAlgo(const ConvolutionKernelDesc &conv_kernel_desc) {
+    data_threshold_ = 255.0f;
+    weight_threshold_ = 127.0f;
+    quantized_weight_ = NULL;
+    weight_ratio_ = NULL;
+    sum_per_channel_out_ = NULL;
+  }
+
+  ~DepthwiseConvolutionAlgo() {
+    ReleaseWeight();
+  }
+
+  void ReleaseWeight() {
+    if (quantized_weight_) {
+      delete quantized_weight_;
+      quantized_weight_ = NULL;
+    }
+    if (weight_ratio_) {
+      delete weight_ratio_;
+      weight_ratio_ = NULL;
+    }
+    if (sum_per_channel_out_) {
+      delete sum_per_channel_out_;
+      sum_per_channel_out_ = NULL;
+    }
+  }
+
+  // The weight is channel x kernel_h x kernel_w in both layouts, it is stored transposed so that the channels of a
+  // tap are contiguous like the ones of an NHWC pixel, and the taps interleaved by pairs for madd
+  void InitWeight(float *weight, ConvolutionKernelDesc &conv_kernel_desc) {
+    ReleaseWeight();
+    channel_ = conv_kernel_desc.channel_out_;
+    size_t kernel_size = conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_;
+    size_t pairs = (kernel_size + 1) / 2;
+    quantized_weight_ = new Tensor<int8_t>(make_shape(pairs, channel_, 2), 64);
+    memset(quantized_weight_->data_, 0, sizeof(int8_t) * pairs * channel_ * 2);
+    weight_ratio_ = new Tensor<float>(make_shape(channel_), 64);
+    sum_per_channel_out_ = new Tensor<float>(make_shape(channel_), 64);
+    for (size_t c = 0; c < channel_; ++c) {
+      const float *src = weight + c * kernel_size;
+      float max_abs = 0.0f;
+      for (size_t k = 0; k < kernel_size; ++k) {
+        max_abs = std::max(max_abs, fabsf(src[k]));
+      }
+      float ratio = (max_abs > 0.0f) ? max_abs / weight_threshold_ : 1.0f;
+      float quantized_sum = 0.0f;
+      for (size_t k = 0; k < kernel_size; ++k) {
+        float quantized = roundf(src[k] / ratio);
+        quantized_weight_->data_[((k / 2) * channel_ + c) * 2 + k % 2] = static_cast<int8_t>(quantized);
+        quantized_sum += quantized;
+      }
+      weight_ratio_->data_[c] = ratio;
+      // The zero point compensation from the quantized weight, so that it cancels exactly against the products
+      sum_per_channel_out_->data_[c] = quantized_sum;
+    }
+  }
+
+  size_t WorkspaceSize(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                       size_t threads_num) {
+    size_t input_size =
+        conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_ * conv_data_desc.channel_in_;
+    size_t pairs = (conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_ + 1) / 2;
+    size_t size = Workspace::AlignedSize(sizeof(uint8_t) * input_size) +
+                  Workspace::AlignedSize(sizeof(uint8_t) * conv_kernel_desc.channel_in_) +
+                  8 * Workspace::AlignedSize(sizeof(float) * conv_kernel_desc.channel_in_) +
+                  Workspace::AlignedSize(sizeof(float) * threads_num * 2 * conv_kernel_desc.channel_in_) +
+                  Workspace::AlignedSize(sizeof(const uint8_t *) * threads_num * 2 * pairs);
+    if (conv_kernel_desc.layout_ != NHWC) {
+      size += Workspace::AlignedSize(sizeof(float) * input_size);
+    }
+    return size;
+  }
+
+  void ReserveWorkspace(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                        Workspace &workspace) {
+    workspace.Reserve(WorkspaceSize(conv_data_desc, conv_kernel_desc, GetMaxThreadsNum()));
+  }
+
+  void InitPlan(ConvolutionPlan &plan, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc) {
+    BaseConvolutionAlgo::InitPlan(plan, conv_data_desc, conv_kernel_desc);
+    plan.gemm_n_ = conv_data_desc.batch_size_ * plan.height_out_ * plan.width_out_;
+    plan.aligned_gemm_n_ = plan.gemm_n_;
+    plan.workspace_size_ = WorkspaceSize(conv_data_desc, conv_kernel_desc, plan.threads_num_);
+  }
+
+  // x ~ (q - zero_point) * ratio per channel with an integer zero point, so sum(w * x) = weight_ratio * ratio *
+  // (sum(w_q * q) - zero_point * sum(w_q)). The padded border reads zero_point, which cancels exactly.
+  void Execute(float *out, float *data, float *bias, ConvolutionDataDesc &conv_data_desc,
+               ConvolutionKernelDesc &conv_kernel_desc, const ConvolutionPlan &plan, Workspace &workspace) {
+    size_t spatial_size = conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    workspace.Reserve(plan.workspace_size_);
+    size_t pairs = (conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_ + 1) / 2;
+    uint8_t *quantized_data = workspace.Acquire<uint8_t>(spatial_size * channel_);
+    uint8_t *zero_point = workspace.Acquire<uint8_t>(channel_);
+    float *data_min = workspace.Acquire<float>(channel_);
+    float *data_max = workspace.Acquire<float>(channel_);
+    float *data_scale = workspace.Acquire<float>(channel_);
+    float *data_shift = workspace.Acquire<float>(channel_);
+    float *out_scale = workspace.Acquire<float>(channel_);
+    float *out_shift = workspace.Acquire<float>(channel_);
+    float *post_scale = workspace.Acquire<float>(channel_);
+    float *post_shift = workspace.Acquire<float>(channel_);
+    float *extreme_workspace = workspace.Acquire<float>(plan.threads_num_ * 2 * channel_);
+    const uint8_t **taps_workspace = workspace.Acquire<const uint8_t *>(plan.threads_num_ * 2 * pairs);
+    if (conv_kernel_desc.layout_ != NHWC) {
+      float *nhwc_data = workspace.Acquire<float>(spatial_size * channel_);
+      TransformLayout(NHWC, conv_kernel_desc.layout_, nhwc_data, data, conv_data_desc.batch_size_, channel_,
+                      conv_data_desc.height_in_ * conv_data_desc.width_in_);
+      data = nhwc_data;
+    }
+    if (data_calibration_.Frozen()) {
+      memcpy(data_min, data_calibration_.min_.data(), sizeof(float) * channel_);
+      memcpy(data_max, data_calibration_.max_.data(), sizeof(float) * channel_);
+    } else {
+      ProfileTimer timer(PROFILE_FIND_EXTREME);
+      depthwise::NHWCFindMinMaxPerChannel(data_min, data_max, data, spatial_size, channel_, extreme_workspace);
+    }
+    size_t fusion_mask = conv_kernel_desc.fusion_mask_;
+    bool fold_batch_norm = (fusion_mask & (CONV_BN_FUSION | CONV_BN_RELU_FUSION)) != 0;
+    bool post_batch_norm = (fusion_mask & CONV_RELU_BN_FUSION) != 0;
+    for (size_t c = 0; c < channel_; ++c) {
+      float ratio = (data_max[c] > data_min[c]) ? (data_max[c] - data_min[c]) / data_threshold_ : 1.0f;
+      // min <= 0 <= max, the zero point is within [0, data_threshold]
+      data_shift[c] = roundf(-data_min[c] / ratio);
+      data_scale[c] = 1.0f / ratio;
+      zero_point[c] = static_cast<uint8_t>(data_shift[c]);
+      out_scale[c] = weight_ratio_->data_[c] * ratio;
+      out_shift[c] = ((bias == NULL) ? 0.0f : bias[c]) - data_shift[c] * sum_per_channel_out_->data_[c] * out_scale[c];
+      if (fold_batch_norm || post_batch_norm) {
+        // (x - global_mean) * mul_variance_coeff * scale + shift as x * post_scale + post_shift
+        float scale = batch_norm_.mul_variance_coeff_[c] * (batch_norm_.scale_.empty() ? 1.0f : batch_norm_.scale_[c]);
+        post_scale[c] = scale;
+        post_shift[c] =
+            (batch_norm_.shift_.empty() ? 0.0f : batch_norm_.shift_[c]) - batch_norm_.global_mean_[c] * scale;
+      }
+      if (fold_batch_norm) {
+        out_scale[c] *= post_scale[c];
+        out_shift[c] = out_shift[c] * post_scale[c] + post_shift[c];
+      }
+    }
+    {
+      ProfileTimer timer(PROFILE_QUANTIZE);
+      depthwise::NHWCQuantizeByChannel(quantized_data, data, spatial_size, channel_, data_scale, data_shift);
+    }
+    // The direct convolution stands for the GEMM
+    ProfileTimer timer(PROFILE_GEMM);
+    bool relu = (fusion_mask & (CONV_RELU_FUSION | CONV_BN_RELU_FUSION | CONV_RELU_BN_FUSION)) != 0;
+    depthwise::NHWCDepthwiseConv(out, quantized_data, quantized_weight_->data_, conv_data_desc.batch_size_, channel_,
+                                 conv_data_desc.height_in_, conv_data_desc.width_in_, conv_kernel_desc.kernel_h_,
+                                 conv_kernel_desc.kernel_w_, conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_,
+                                 conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_, conv_kernel_desc.dilation_h_,
+                                 conv_kernel_desc.dilation_w_, plan.height_out_, plan.width_out_, zero_point,
+                                 out_scale, out_shift, taps_workspace, conv_kernel_desc.layout_, relu,
+                                 post_batch_norm ? post_scale : NULL, post_batch_norm ? post_shift : NULL);
+  }
+
+ private:
+  // (kernel_h x kernel_w + 1) / 2 pairs x channel x 2
+  Tensor<int8_t> *quantized_weight_;
+  Tensor<float> *weight_ratio_;
+  Tensor<float> *sum_per_channel_out_;
+
+  size_t channel_;
+
+  float weight_threshold_;
+  float data_threshold_;
+};
+#endif
@@ -21,7 +21,7 @@
 #include "shuffle_fc.h"
 
 struct FCOp {
-  FCOp() : algo_id_(AUTO_SELECT_FC), algo_(NULL) {
+  FCOp() : algo_id_(AUTO_SELECT_FC), algo_(NULL), threads_num_(0) {
   }
 
   ~FCOp() {
@@ -37,12 +37,22 @@ struct FCOp {
     ChooseAlgo(algo);
   }
 
-  void SetupFCDataParameter(size_t batch_size, size_t channel_in) {
-    fc_data_desc_ = {batch_size, channel_in};
+  // Takes effect at the next InitWeight, LoadWeight or MapWeight
+  void SetWeightQuantization(WEIGHT_QUANTIZATION mode) {
+    fc_kernel_desc_.weight_quantization_ = mode;
+  }
+
+  // Places the current weight right away, and the later ones as they come
+  void SetNumaMode(NUMA_MODE mode) {
+    fc_kernel_desc_.numa_mode_ = mode;
+    if (algo_ != NULL) {
+      algo_->PlaceWeight(fc_kernel_desc_);
+    }
   }
 
   void ChooseAlgo(FC_ALGORITHM algo_id) {
     algo_id_ = algo_id;
+    ClearPlans();
     switch (algo_id_) {
       case SHUFFLE_FC: {
         algo_ = new ShuffleFCAlgo();
@@ -55,19 +65,113 @@ struct FCOp {
     }
   }
 
+  void SetNumThreads(size_t threads_num) {
+    threads_num_ = threads_num;
+  }
+
+  size_t GetThreadsLimit(FCDataDesc &fc_data_desc) {
+    return GetOpThreadsNum(threads_num_, fc_data_desc.batch_size_ * fc_data_desc.channel_in_ *
+                                             fc_kernel_desc_.channel_out_);
+  }
+
   void InitWeight(float *weight) {
     algo_->InitWeight(weight, fc_kernel_desc_);
+    ClearPlans();
   }
 
+  // Returns a copy, another thread may evict the cached one meanwhile
+  bool FindPlan(FCDataDesc &fc_data_desc, size_t threads_num, FCPlan &plan) {
+    for (auto iter = plans_.begin(); iter < plans_.end(); ++iter) {
+      if (iter->Match(fc_data_desc, threads_num)) {
+        plan = *iter;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // A new plan is made outside the lock, auto tuning it may take a while and the executions of the shapes already
+  // planned must not wait for it. Two threads planning the same shape keep the first plan stored.
+  FCPlan GetPlan(FCDataDesc &fc_data_desc) {
+    size_t threads_num = GetMaxThreadsNum();
+    FCPlan plan;
+    {
+      std::lock_guard<std::mutex> lock(plans_mutex_);
+      if (FindPlan(fc_data_desc, threads_num, plan)) {
+        return plan;
+      }
+    }
+    plan.batch_size_ = fc_data_desc.batch_size_;
+    plan.threads_num_ = threads_num;
+    algo_->InitPlan(plan, fc_data_desc, fc_kernel_desc_);
+    std::lock_guard<std::mutex> lock(plans_mutex_);
+    if (FindPlan(fc_data_desc, threads_num, plan)) {
+      return plan;
+    }
+    if (plans_.size() >= MAX_PLAN_NUM) {
+      plans_.erase(plans_.begin());
+    }
+    plans_.push_back(plan);
+    return plan;
+  }
+
+  void ClearPlans() {
+    std::lock_guard<std::mutex> lock(plans_mutex_);
+    plans_.clear();
+  }
+
+  int SaveWeight(const char *path) {
+    WeightBlobWriter writer;
+    int ret = writer.Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = algo_->SaveWeight(writer, fc_kernel_desc_);
+    }
+    int close_ret = writer.Close();
+    return (ret == WEIGHT_BLOB_OK) ? close_ret : ret;
+  }
+
+  int LoadWeight(const char *path) {
+    WeightBlobReader reader;
+    int ret = reader.Open(path);
+    if (ret == WEIGHT_BLOB_OK) {
+      ret = algo_->LoadWeight(reader, fc_kernel_desc_, false);
+      ClearPlans();
+    }
+    return ret;
+  }
+
+  int MapWeight(const char *path) {
+    int ret = algo_->MapWeight(path, fc_kernel_desc_);
+    ClearPlans();
+    return ret;
+  }
+
+  // Safe to call from several threads at once, each execution runs in a workspace of its own. Changing the weight or
+  // the parameters concurrently with an execution is not.
   void Execute(float *out, float *data, float *bias, size_t batch_size, size_t channel_in) {
-    SetupFCDataParameter(batch_size, channel_in);
-    algo_->Execute(out, data, bias, fc_data_desc_, fc_kernel_desc_);
+    FCDataDesc fc_data_desc = {batch_size, channel_in};
+    ScopedThreadsLimit threads_limit(GetThreadsLimit(fc_data_desc));
+    FCPlan plan = GetPlan(fc_data_desc);
+    ScopedWorkspace workspace(workspace_pool_);
+    algo_->Execute(out, data, bias, fc_data_desc, fc_kernel_desc_, plan, workspace.Get());
+  }
+
+  // Grows the workspace the next execution picks up
+  void ReserveWorkspace(size_t batch_size, size_t channel_in) {
+    FCDataDesc fc_data_desc = {batch_size, channel_in};
+    ScopedThreadsLimit threads_limit(GetThreadsLimit(fc_data_desc));
+    ScopedWorkspace workspace(workspace_pool_);
+    algo_->ReserveWorkspace(fc_data_desc, fc_kernel_desc_, workspace.Get());
   }
 
   FC_ALGORITHM algo_id_;
   BaseFCAlgo *algo_;
   FCKernelDesc fc_kernel_desc_;
-  FCDataDesc fc_data_desc_;
+  std::vector<FCPlan> plans_;
+  std::mutex plans_mutex_;
+  WorkspacePool workspace_pool_;
+  // 0 for all the threads of the backend, AUTO_THREADS_NUM to size every execution from its work
+  size_t threads_num_;
 };
 
 #endif
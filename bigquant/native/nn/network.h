@@ -0,0 +1,378 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NN_NETWORK_H
+#define NN_NETWORK_H
+
+#include "convolution_op.h"
+#include "fc_op.h"
+
+enum NetworkNodeType { NETWORK_CONV = 0, NETWORK_FC = 1, NETWORK_POOL = 2, NETWORK_ELTWISE_SUM = 3 };
+
+// Node i reads the tensors in inputs_ and writes tensor i + 1, tensor 0 is the network input
+struct NetworkNode {
+  NetworkNodeType type_;
+  ConvOp *conv_;
+  FCOp *fc_;
+  std::vector<float> bias_;
+  size_t inputs_[2];
+  size_t input_num_;
+  POOL_MODE pool_mode_;
+  size_t kernel_h_;
+  size_t kernel_w_;
+  size_t stride_h_;
+  size_t stride_w_;
+  size_t pad_h_;
+  size_t pad_w_;
+  bool relu_;
+};
+
+// An NHWC activation. Its size and offset are per sample, the arena of a batch scales all of them by the batch size.
+struct NetworkTensor {
+  size_t channel_;
+  size_t height_;
+  size_t width_;
+  bool quantized_;
+  QuantizedActivationDesc quantization_;
+  size_t size_;
+  size_t slab_;
+  size_t last_use_;
+};
+
+// A sequence of layers run in one call with the activations kept in an arena. Compile infers the shapes and assigns
+// every intermediate tensor to a slab of the arena, a slab being reused as soon as the tensors held in it are no longer
+// read, so a chain needs two slabs whatever its depth. The input and output tensors are the buffers of the caller.
+// Between two convolutions able to read and write u8 activations directly, the tensor is stored as u8 with the
+// quantization of the frozen calibration of the consumer.
+struct Network {
+  Network() : compiled_(false), arena_size_(0) {
+  }
+
+  Network(const Network &) = delete;
+
+  Network &operator=(const Network &) = delete;
+
+  size_t AddNode(NetworkNode &node) {
+    for (size_t i = 0; i < node.input_num_; ++i) {
+      if (node.inputs_[i] > nodes_.size()) {
+        fprintf(stderr, "Network node reads tensor %zu, which does not exist yet.\n", node.inputs_[i]);
+        exit(-1);
+      }
+    }
+    nodes_.push_back(node);
+    compiled_ = false;
+    return nodes_.size();
+  }
+
+  size_t AddConv(ConvOp *conv, size_t input, float *bias) {
+    NetworkNode node = MakeNode(NETWORK_CONV, input);
+    node.conv_ = conv;
+    if (bias != NULL) {
+      node.bias_.assign(bias, bias + conv->conv_kernel_desc_.channel_out_);
+    }
+    return AddNode(node);
+  }
+
+  // The input is flattened in NHWC order
+  size_t AddFC(FCOp *fc, size_t input, float *bias) {
+    NetworkNode node = MakeNode(NETWORK_FC, input);
+    node.fc_ = fc;
+    if (bias != NULL) {
+      node.bias_.assign(bias, bias + fc->fc_kernel_desc_.channel_out_);
+    }
+    return AddNode(node);
+  }
+
+  size_t AddPool(size_t input, POOL_MODE mode, size_t kernel_h, size_t kernel_w, size_t stride_h, size_t stride_w,
+                 size_t pad_h, size_t pad_w) {
+    NetworkNode node = MakeNode(NETWORK_POOL, input);
+    node.pool_mode_ = mode;
+    node.kernel_h_ = kernel_h;
+    node.kernel_w_ = kernel_w;
+    node.stride_h_ = stride_h;
+    node.stride_w_ = stride_w;
+    node.pad_h_ = pad_h;
+    node.pad_w_ = pad_w;
+    return AddNode(node);
+  }
+
+  size_t AddEltwiseSum(size_t input_a, size_t input_b, bool relu) {
+    NetworkNode node = MakeNode(NETWORK_ELTWISE_SUM, input_a);
+    node.inputs_[1] = input_b;
+    node.input_num_ = 2;
+    node.relu_ = relu;
+    return AddNode(node);
+  }
+
+  // Also sets the output quantization of the convolutions writing u8 tensors, the calibration of the convolutions has
+  // to be frozen before for them to be found.
+  void Compile(size_t channel_in, size_t height_in, size_t width_in) {
+    if (nodes_.empty()) {
+      fprintf(stderr, "Network compiled without any node.\n");
+      exit(-1);
+    }
+    tensors_.assign(nodes_.size() + 1, NetworkTensor());
+    NetworkTensor &input = tensors_[0];
+    input.channel_ = channel_in;
+    input.height_ = height_in;
+    input.width_ = width_in;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      InferShape(nodes_[i], tensors_[i + 1]);
+    }
+    for (size_t t = 0; t < tensors_.size(); ++t) {
+      tensors_[t].last_use_ = t;
+      tensors_[t].quantized_ = false;
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      for (size_t j = 0; j < nodes_[i].input_num_; ++j) {
+        tensors_[nodes_[i].inputs_[j]].last_use_ = i + 1;
+      }
+    }
+    for (size_t t = 1; t < tensors_.size() - 1; ++t) {
+      PlanQuantization(t);
+      NetworkTensor &tensor = tensors_[t];
+      size_t pixels = tensor.channel_ * tensor.height_ * tensor.width_;
+      tensor.size_ = Workspace::AlignedSize(tensor.quantized_ ? pixels : sizeof(float) * pixels);
+    }
+    PlanSlabs();
+    compiled_ = true;
+  }
+
+  void GetOutputShape(size_t &channel, size_t &height, size_t &width) {
+    CheckCompiled();
+    channel = tensors_.back().channel_;
+    height = tensors_.back().height_;
+    width = tensors_.back().width_;
+  }
+
+  size_t ArenaSize(size_t batch_size) {
+    CheckCompiled();
+    return arena_size_ * batch_size;
+  }
+
+  // Safe to call from several threads at once like the ops, each execution has an arena of its own
+  void Execute(float *out, float *data, size_t batch_size) {
+    CheckCompiled();
+    ScopedWorkspace arena(arena_pool_);
+    arena.Get().Reserve(arena_size_ * batch_size);
+    char *base = static_cast<char *>(arena.Get().data_);
+    std::vector<void *> buffers(tensors_.size());
+    buffers[0] = data;
+    buffers.back() = out;
+    for (size_t t = 1; t < tensors_.size() - 1; ++t) {
+      buffers[t] = base + slab_offsets_[tensors_[t].slab_] * batch_size;
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      NetworkNode &node = nodes_[i];
+      const NetworkTensor &input = tensors_[node.inputs_[0]];
+      const NetworkTensor &output = tensors_[i + 1];
+      void *src = buffers[node.inputs_[0]];
+      void *dst = buffers[i + 1];
+      float *bias = node.bias_.empty() ? NULL : node.bias_.data();
+      switch (node.type_) {
+        case NETWORK_CONV: {
+          if (input.quantized_ || output.quantized_) {
+            node.conv_->ExecuteQuantized(dst, output.quantized_, src, input.quantized_ ? &input.quantization_ : NULL,
+                                         bias, batch_size, input.channel_, input.height_, input.width_);
+          } else {
+            node.conv_->Execute(static_cast<float *>(dst), static_cast<float *>(src), bias, batch_size,
+                                input.channel_, input.height_, input.width_);
+          }
+          break;
+        }
+        case NETWORK_FC: {
+          node.fc_->Execute(static_cast<float *>(dst), static_cast<float *>(src), bias, batch_size,
+                            input.channel_ * input.height_ * input.width_);
+          break;
+        }
+        case NETWORK_POOL: {
+          pool::NHWCPool(static_cast<float *>(dst), static_cast<float *>(src), batch_size, input.channel_,
+                         input.height_, input.width_, node.kernel_h_, node.kernel_w_, node.pad_h_, node.pad_w_,
+                         node.stride_h_, node.stride_w_, output.height_, output.width_, node.pool_mode_ == AVG_POOL);
+          break;
+        }
+        case NETWORK_ELTWISE_SUM: {
+          pool::EltwiseSum(static_cast<float *>(dst), static_cast<float *>(src),
+                           static_cast<float *>(buffers[node.inputs_[1]]),
+                           batch_size * output.channel_ * output.height_ * output.width_, node.relu_);
+          break;
+        }
+      }
+    }
+  }
+
+ private:
+  NetworkNode MakeNode(NetworkNodeType type, size_t input) {
+    NetworkNode node;
+    node.type_ = type;
+    node.conv_ = NULL;
+    node.fc_ = NULL;
+    node.inputs_[0] = input;
+    node.inputs_[1] = 0;
+    node.input_num_ = 1;
+    node.pool_mode_ = MAX_POOL;
+    node.kernel_h_ = node.kernel_w_ = node.stride_h_ = node.stride_w_ = 1;
+    node.pad_h_ = node.pad_w_ = 0;
+    node.relu_ = false;
+    return node;
+  }
+
+  void InferShape(const NetworkNode &node, NetworkTensor &output) {
+    const NetworkTensor &input = tensors_[node.inputs_[0]];
+    switch (node.type_) {
+      case NETWORK_CONV: {
+        const ConvolutionKernelDesc &desc = node.conv_->conv_kernel_desc_;
+        if (desc.layout_ != NHWC || desc.channel_in_ != input.channel_) {
+          fprintf(stderr, "Network convolution expects %zu NHWC input channels, got %zu.\n", desc.channel_in_,
+                  input.channel_);
+          exit(-1);
+        }
+        output.channel_ = desc.channel_out_;
+        output.height_ = GetConvOutSize(input.height_, desc.kernel_h_, desc.stride_h_, desc.pad_h_, desc.dilation_h_);
+        output.width_ = GetConvOutSize(input.width_, desc.kernel_w_, desc.stride_w_, desc.pad_w_, desc.dilation_w_);
+        break;
+      }
+      case NETWORK_FC: {
+        const FCKernelDesc &desc = node.fc_->fc_kernel_desc_;
+        if (desc.channel_in_ != input.channel_ * input.height_ * input.width_) {
+          fprintf(stderr, "Network fully connected layer expects %zu input features, got %zu.\n", desc.channel_in_,
+                  input.channel_ * input.height_ * input.width_);
+          exit(-1);
+        }
+        output.channel_ = desc.channel_out_;
+        output.height_ = 1;
+        output.width_ = 1;
+        break;
+      }
+      case NETWORK_POOL: {
+        output.channel_ = input.channel_;
+        output.height_ = GetConvOutSize(input.height_, node.kernel_h_, node.stride_h_, node.pad_h_, 1);
+        output.width_ = GetConvOutSize(input.width_, node.kernel_w_, node.stride_w_, node.pad_w_, 1);
+        break;
+      }
+      case NETWORK_ELTWISE_SUM: {
+        const NetworkTensor &other = tensors_[node.inputs_[1]];
+        if (other.channel_ != input.channel_ || other.height_ != input.height_ || other.width_ != input.width_) {
+          fprintf(stderr, "Network element-wise sum of tensors with different shapes.\n");
+          exit(-1);
+        }
+        output.channel_ = input.channel_;
+        output.height_ = input.height_;
+        output.width_ = input.width_;
+        break;
+      }
+    }
+  }
+
+  // Tensor t is kept as u8 when written by a convolution and only read by convolutions which all share the same
+  // frozen input quantization, and all of them handle u8 activations without going through fp32 copies
+  void PlanQuantization(size_t t) {
+    NetworkTensor &tensor = tensors_[t];
+    const NetworkNode &producer = nodes_[t - 1];
+    if (producer.type_ != NETWORK_CONV || !producer.conv_->algo_->SupportQuantizedActivation()) {
+      return;
+    }
+    bool has_consumer = false;
+    QuantizedActivationDesc quantization = {0.0f, 0};
+    for (size_t i = t; i < nodes_.size(); ++i) {
+      const NetworkNode &node = nodes_[i];
+      bool reads = false;
+      for (size_t j = 0; j < node.input_num_; ++j) {
+        reads = reads || (node.inputs_[j] == t);
+      }
+      if (!reads) {
+        continue;
+      }
+      QuantizedActivationDesc consumer_quantization;
+      if (node.type_ != NETWORK_CONV || !node.conv_->algo_->SupportQuantizedActivation() ||
+          !node.conv_->GetInputQuantization(consumer_quantization)) {
+        return;
+      }
+      if (has_consumer && (consumer_quantization.scale_ != quantization.scale_ ||
+                           consumer_quantization.zero_point_ != quantization.zero_point_)) {
+        return;
+      }
+      quantization = consumer_quantization;
+      has_consumer = true;
+    }
+    if (has_consumer) {
+      tensor.quantized_ = true;
+      tensor.quantization_ = quantization;
+      producer.conv_->SetOutputQuantization(quantization.scale_, quantization.zero_point_);
+    }
+  }
+
+  // Greedy in execution order: the tensors no longer read are released before a node takes a slab for its output,
+  // the smallest free slab large enough is preferred, otherwise the largest free one grows, otherwise a new one opens
+  void PlanSlabs() {
+    std::vector<size_t> slab_sizes;
+    std::vector<bool> slab_free;
+    for (size_t t = 1; t < tensors_.size() - 1; ++t) {
+      for (size_t held = 1; held < t; ++held) {
+        if (tensors_[held].last_use_ < t) {
+          slab_free[tensors_[held].slab_] = true;
+        }
+      }
+      for (size_t held = 1; held < t; ++held) {
+        if (tensors_[held].last_use_ >= t) {
+          slab_free[tensors_[held].slab_] = false;
+        }
+      }
+      size_t need = tensors_[t].size_;
+      size_t best = slab_sizes.size();
+      for (size_t s = 0; s < slab_sizes.size(); ++s) {
+        if (!slab_free[s]) {
+          continue;
+        }
+        if (best == slab_sizes.size()) {
+          best = s;
+        } else if (slab_sizes[best] < need) {
+          best = (slab_sizes[s] > slab_sizes[best]) ? s : best;
+        } else if (slab_sizes[s] >= need && slab_sizes[s] < slab_sizes[best]) {
+          best = s;
+        }
+      }
+      if (best == slab_sizes.size()) {
+        slab_sizes.push_back(need);
+        slab_free.push_back(false);
+      }
+      slab_sizes[best] = std::max(slab_sizes[best], need);
+      slab_free[best] = false;
+      tensors_[t].slab_ = best;
+    }
+    slab_offsets_.assign(slab_sizes.size(), 0);
+    arena_size_ = 0;
+    for (size_t s = 0; s < slab_sizes.size(); ++s) {
+      slab_offsets_[s] = arena_size_;
+      arena_size_ += slab_sizes[s];
+    }
+  }
+
+  void CheckCompiled() {
+    if (!compiled_) {
+      fprintf(stderr, "Network used before being compiled.\n");
+      exit(-1);
+    }
+  }
+
+  std::vector<NetworkNode> nodes_;
+  std::vector<NetworkTensor> tensors_;
+  std::vector<size_t> slab_offsets_;
+  bool compiled_;
+  size_t arena_size_;
+  WorkspacePool arena_pool_;
+};
+#endif
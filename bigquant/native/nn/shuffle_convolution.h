@@ -20,33 +20,49 @@
 
 struct ShuffleConvolutionAlgo : public BaseConvolutionAlgo {
   ShuffleConvolutionAlgo(const ConvolutionKernelDesc &conv_kernel_desc) : internal_layout_(NHWC) {
-    weight_threshold_ = 64.0f;
+    weight_quantization_ = WEIGHT_7BIT;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
     data_threshold_ = 127.0f;
     transformed_kernel_ = NULL;
     sum_per_channel_out_ = NULL;
-    data_workspace_ = NULL;
   }
 
   ~ShuffleConvolutionAlgo() {
-    size_t group = group_weight_.size();
-    for (size_t g = 0; g < group; ++g) {
+    ReleaseWeight();
+  }
+
+  void ReleaseWeight() {
+    for (size_t g = 0; g < group_weight_.size(); ++g) {
       delete group_weight_[g];
+    }
+    for (size_t g = 0; g < quantized_weight_.size(); ++g) {
       delete quantized_weight_[g];
     }
+    group_weight_.clear();
+    quantized_weight_.clear();
     if (transformed_kernel_) {
       delete transformed_kernel_;
+      transformed_kernel_ = NULL;
     }
     if (sum_per_channel_out_) {
       delete sum_per_channel_out_;
+      sum_per_channel_out_ = NULL;
     }
+    numa_weight_.Release();
+    ReleaseWeightBlob();
   }
 
-  void QuantizeKernel(float sw_threshold) {
+  // quantized_sum, if given, receives the per channel sum of the quantized weight instead of the fp one
+  void QuantizeKernel(float sw_threshold, float *quantized_sum) {
     for (size_t g = 0; g < group_weight_.size(); ++g) {
       shuffle::PadQuantizeShuffle2D<float, CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_K>(
           quantized_weight_[g]->data_, gemm_m_, gemm_k_, aligned_gemm_m_, aligned_gemm_k_, group_weight_[g]->data_,
           quantized_weight_[g]->min_.data_, quantized_weight_[g]->max_.data_, quantized_weight_[g]->ratio_.data_,
-          sw_threshold);
+          sw_threshold, (quantized_sum == NULL) ? NULL : quantized_sum + g * gemm_m_);
+#if defined(AMX)
+      shuffle::VNNIShuffle2D<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_K>(quantized_weight_[g]->data_,
+                                                                          aligned_gemm_m_, aligned_gemm_k_);
+#endif
     }
   }
 
@@ -68,7 +84,16 @@ struct ShuffleConvolutionAlgo : public BaseConvolutionAlgo {
   }
 
   void InitWeight(float *weight, ConvolutionKernelDesc &conv_kernel_desc) {
-    ComputeKernelSum(weight, conv_kernel_desc);
+    ReleaseWeight();
+    weight_quantization_ = conv_kernel_desc.weight_quantization_;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
+    // The full range scheme takes the data zero point compensation from the quantized weight, filled in by
+    // QuantizeKernel below, so that it cancels exactly against what the kernel multiplies
+    if (weight_quantization_ == WEIGHT_8BIT) {
+      sum_per_channel_out_ = new Tensor<float>(make_shape(conv_kernel_desc.channel_out_), 64);
+    } else {
+      ComputeKernelSum(weight, conv_kernel_desc);
+    }
     if (conv_kernel_desc.layout_ != internal_layout_) {
       KernelLayoutTransform(weight, conv_kernel_desc);
       weight = transformed_kernel_->data_;
@@ -108,113 +133,382 @@ struct ShuffleConvolutionAlgo : public BaseConvolutionAlgo {
                                       conv_kernel_desc.kernel_w_ * conv_kernel_desc.kernel_h_;
       }
     }
-    QuantizeKernel(weight_threshold_);
+    QuantizeKernel(weight_threshold_, (weight_quantization_ == WEIGHT_8BIT) ? sum_per_channel_out_->data_ : NULL);
+    PlaceWeight(conv_kernel_desc);
   }
 
-  void InitData(float *srcdata, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
-                float sw_threshold, bool layout_transform) {
-    // Allocate Memory
-    height_out_ = GetConvOutSize(conv_data_desc.height_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.stride_h_,
-                                 conv_kernel_desc.pad_h_, conv_kernel_desc.dilation_h_);
-    width_out_ = GetConvOutSize(conv_data_desc.width_in_, conv_kernel_desc.kernel_w_, conv_kernel_desc.stride_w_,
-                                conv_kernel_desc.pad_w_, conv_kernel_desc.dilation_w_);
-    gemm_n_ = conv_data_desc.batch_size_ * height_out_ * width_out_;
-    aligned_gemm_n_ = GetAlignmentLength(gemm_n_, CONV_SHUFFLE_KERNEL_N);
-    quantized_data_.resize(conv_kernel_desc.group_);
+  void PlaceWeight(ConvolutionKernelDesc &conv_kernel_desc) {
+    std::vector<int8_t *> panels(quantized_weight_.size());
+    for (size_t g = 0; g < quantized_weight_.size(); ++g) {
+      panels[g] = quantized_weight_[g]->data_;
+    }
+    numa_weight_.Place(panels, aligned_gemm_m_ * aligned_gemm_k_, conv_kernel_desc.numa_mode_);
+  }
+
+  WeightBlobHeader WeightHeader(const ConvolutionKernelDesc &conv_kernel_desc) {
+    WeightBlobHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic_ = WEIGHT_BLOB_MAGIC;
+    header.version_ = WEIGHT_BLOB_VERSION;
+    header.type_ = CONV_WEIGHT_BLOB;
+    header.layout_ = conv_kernel_desc.layout_;
+    header.kernel_m_ = CONV_SHUFFLE_KERNEL_M;
+    header.kernel_n_ = CONV_SHUFFLE_KERNEL_N;
+    header.kernel_k_ = CONV_SHUFFLE_KERNEL_K;
+    header.channel_out_ = conv_kernel_desc.channel_out_;
+    header.channel_in_ = conv_kernel_desc.channel_in_;
+    header.group_ = conv_kernel_desc.group_;
+    header.kernel_h_ = conv_kernel_desc.kernel_h_;
+    header.kernel_w_ = conv_kernel_desc.kernel_w_;
+    header.gemm_m_ = conv_kernel_desc.channel_out_per_group_;
+    header.gemm_k_ = conv_kernel_desc.channel_in_per_group_ * conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_;
+    header.aligned_gemm_m_ = GetAlignmentLength(header.gemm_m_, CONV_SHUFFLE_KERNEL_M);
+    header.aligned_gemm_k_ = GetAlignmentLength(header.gemm_k_, CONV_SHUFFLE_KERNEL_K);
+    header.weight_threshold_ = GetWeightThreshold(conv_kernel_desc.weight_quantization_);
+    header.weight_quantization_ = conv_kernel_desc.weight_quantization_;
+    return header;
+  }
+
+  int SaveWeight(WeightBlobWriter &writer, ConvolutionKernelDesc &conv_kernel_desc) {
+    if (sum_per_channel_out_ == NULL) {
+      return WEIGHT_BLOB_UNSUPPORTED;
+    }
+    WeightBlobHeader header = WeightHeader(conv_kernel_desc);
+    header.weight_threshold_ = weight_threshold_;
+    header.weight_quantization_ = weight_quantization_;
+    // placeholder, rewritten with the final size at the end
+    if (writer.Write(&header, sizeof(header)) != WEIGHT_BLOB_OK ||
+        writer.Write(sum_per_channel_out_->data_, sizeof(float) * conv_kernel_desc.channel_out_) != WEIGHT_BLOB_OK) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
     for (size_t g = 0; g < conv_kernel_desc.group_; ++g) {
-      quantized_data_[g] = new QuantizedTensor<float, uint8_t>(make_shape(aligned_gemm_n_, aligned_gemm_k_),
-                                                               make_shape(gemm_n_), make_shape(gemm_n_, gemm_k_), 64);
+      if (writer.Write(quantized_weight_[g]->data_, sizeof(int8_t) * aligned_gemm_m_ * aligned_gemm_k_) !=
+              WEIGHT_BLOB_OK ||
+          writer.Write(quantized_weight_[g]->min_.data_, sizeof(float) * gemm_m_) != WEIGHT_BLOB_OK ||
+          writer.Write(quantized_weight_[g]->max_.data_, sizeof(float) * gemm_m_) != WEIGHT_BLOB_OK ||
+          writer.Write(quantized_weight_[g]->ratio_.data_, sizeof(float) * gemm_m_) != WEIGHT_BLOB_OK) {
+        return WEIGHT_BLOB_IO_ERROR;
+      }
+    }
+    return writer.WriteHeader(header);
+  }
+
+  int LoadWeight(WeightBlobReader &reader, ConvolutionKernelDesc &conv_kernel_desc, bool zero_copy) {
+    const WeightBlobHeader *header = reader.Header();
+    if (header == NULL) {
+      return WEIGHT_BLOB_FORMAT_ERROR;
+    }
+    WeightBlobHeader expect = WeightHeader(conv_kernel_desc);
+    if (!WeightBlobMatch(*header, expect)) {
+      return WEIGHT_BLOB_MISMATCH;
+    }
+    // Validate every section before touching the current weight
+    size_t group = conv_kernel_desc.group_;
+    const float *kernel_sum = reader.Read<float>(conv_kernel_desc.channel_out_);
+    std::vector<const int8_t *> panel(group);
+    std::vector<const float *> min(group), max(group), ratio(group);
+    for (size_t g = 0; g < group; ++g) {
+      panel[g] = reader.Read<int8_t>(expect.aligned_gemm_m_ * expect.aligned_gemm_k_);
+      min[g] = reader.Read<float>(expect.gemm_m_);
+      max[g] = reader.Read<float>(expect.gemm_m_);
+      ratio[g] = reader.Read<float>(expect.gemm_m_);
+      if (panel[g] == NULL || min[g] == NULL || max[g] == NULL || ratio[g] == NULL) {
+        return WEIGHT_BLOB_FORMAT_ERROR;
+      }
     }
+    if (kernel_sum == NULL) {
+      return WEIGHT_BLOB_FORMAT_ERROR;
+    }
+
+    ReleaseWeight();
+    weight_quantization_ = conv_kernel_desc.weight_quantization_;
+    weight_threshold_ = header->weight_threshold_;
+    gemm_m_ = expect.gemm_m_;
+    gemm_k_ = expect.gemm_k_;
+    aligned_gemm_m_ = expect.aligned_gemm_m_;
+    aligned_gemm_k_ = expect.aligned_gemm_k_;
+    quantized_weight_.resize(group);
+    if (zero_copy) {
+      // Non-owning views of the read-only mapping, the kernels never write the weight
+      sum_per_channel_out_ = new Tensor<float>(make_shape(conv_kernel_desc.channel_out_));
+      sum_per_channel_out_->SetData(const_cast<float *>(kernel_sum));
+      for (size_t g = 0; g < group; ++g) {
+        quantized_weight_[g] = new QuantizedTensor<float, int8_t>(
+            make_shape(aligned_gemm_m_, aligned_gemm_k_), make_shape(gemm_m_), make_shape(gemm_m_, gemm_k_));
+        quantized_weight_[g]->SetData(const_cast<int8_t *>(panel[g]));
+        quantized_weight_[g]->min_.SetData(const_cast<float *>(min[g]));
+        quantized_weight_[g]->max_.SetData(const_cast<float *>(max[g]));
+        quantized_weight_[g]->ratio_.SetData(const_cast<float *>(ratio[g]));
+      }
+      PlaceWeight(conv_kernel_desc);
+      return WEIGHT_BLOB_OK;
+    }
+    sum_per_channel_out_ = new Tensor<float>(make_shape(conv_kernel_desc.channel_out_), 64);
+    memcpy(sum_per_channel_out_->data_, kernel_sum, sizeof(float) * conv_kernel_desc.channel_out_);
+    for (size_t g = 0; g < group; ++g) {
+      quantized_weight_[g] = new QuantizedTensor<float, int8_t>(make_shape(aligned_gemm_m_, aligned_gemm_k_),
+                                                                make_shape(gemm_m_), make_shape(gemm_m_, gemm_k_), 64);
+      memcpy(quantized_weight_[g]->data_, panel[g], sizeof(int8_t) * aligned_gemm_m_ * aligned_gemm_k_);
+      memcpy(quantized_weight_[g]->min_.data_, min[g], sizeof(float) * gemm_m_);
+      memcpy(quantized_weight_[g]->max_.data_, max[g], sizeof(float) * gemm_m_);
+      memcpy(quantized_weight_[g]->ratio_.data_, ratio[g], sizeof(float) * gemm_m_);
+    }
+    PlaceWeight(conv_kernel_desc);
+    return WEIGHT_BLOB_OK;
+  }
+
+  size_t WorkspaceSize(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                       bool layout_transform) {
+    size_t height_out =
+        GetConvOutSize(conv_data_desc.height_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.stride_h_,
+                       conv_kernel_desc.pad_h_, conv_kernel_desc.dilation_h_);
+    size_t width_out = GetConvOutSize(conv_data_desc.width_in_, conv_kernel_desc.kernel_w_, conv_kernel_desc.stride_w_,
+                                      conv_kernel_desc.pad_w_, conv_kernel_desc.dilation_w_);
+    size_t gemm_n = conv_data_desc.batch_size_ * height_out * width_out;
+    size_t gemm_k = conv_kernel_desc.channel_in_per_group_ * conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_;
+    size_t input_spatial_size = conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    size_t size_per_group =
+        Workspace::AlignedSize(sizeof(uint8_t) * GetAlignmentLength(gemm_n, CONV_SHUFFLE_KERNEL_N) *
+                               GetAlignmentLength(gemm_k, CONV_SHUFFLE_KERNEL_K)) +
+        3 * Workspace::AlignedSize(sizeof(float) * gemm_n) +
+        2 * Workspace::AlignedSize(sizeof(float) * input_spatial_size);
+    size_t size = conv_kernel_desc.group_ * size_per_group;
     if (layout_transform) {
-      data_workspace_ = new Tensor<float>(make_shape(conv_data_desc.batch_size_, conv_data_desc.height_in_,
-                                                     conv_data_desc.width_in_, conv_data_desc.channel_in_),
-                                          64);
-    }
-    // Init data
-    std::vector<uint8_t *> quantized_data(conv_kernel_desc.group_);
-    std::vector<float *> min(conv_kernel_desc.group_);
-    std::vector<float *> max(conv_kernel_desc.group_);
-    std::vector<float *> ratio(conv_kernel_desc.group_);
+      size += Workspace::AlignedSize(sizeof(float) * input_spatial_size * conv_data_desc.channel_in_);
+    }
+    if (data_calibration_.Frozen()) {
+      size += Workspace::AlignedSize(sizeof(uint8_t) * input_spatial_size * conv_data_desc.channel_in_);
+    }
+    return size;
+  }
+
+  void ReserveWorkspace(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                        Workspace &workspace) {
+    bool transpose_data = (conv_kernel_desc.layout_ != internal_layout_) ? true : false;
+    workspace.Reserve(WorkspaceSize(conv_data_desc, conv_kernel_desc, transpose_data));
+  }
+
+  void InitPlan(ConvolutionPlan &plan, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc) {
+    BaseConvolutionAlgo::InitPlan(plan, conv_data_desc, conv_kernel_desc);
+    bool transpose_data = (conv_kernel_desc.layout_ != internal_layout_) ? true : false;
+    plan.gemm_n_ = conv_data_desc.batch_size_ * plan.height_out_ * plan.width_out_;
+    plan.aligned_gemm_n_ = GetAlignmentLength(plan.gemm_n_, CONV_SHUFFLE_KERNEL_N);
+    plan.workspace_size_ = WorkspaceSize(conv_data_desc, conv_kernel_desc, transpose_data);
+    // The groups run side by side, each one blocked for its share of the threads. Only the single GEMM of an
+    // ungrouped convolution is tuned.
+    size_t groups = conv_kernel_desc.group_;
+    if (groups == 1) {
+      shuffle::TuneBlocksInfo<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K>(
+          aligned_gemm_m_, plan.aligned_gemm_n_, aligned_gemm_k_, plan.threads_num_, plan.blocks_info_);
+    } else {
+      size_t threads_per_group = (plan.threads_num_ + groups - 1) / groups;
+      GetBlocksInfo<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N>(aligned_gemm_m_, plan.aligned_gemm_n_,
+                                                                  aligned_gemm_k_, threads_per_group,
+                                                                  plan.blocks_info_);
+    }
+  }
+
+  // Per group views of the workspace of one execution
+  struct DataBuffers {
+    explicit DataBuffers(size_t groups)
+        : data_workspace_(NULL),
+          quantized_data_(groups),
+          data_min_(groups),
+          data_max_(groups),
+          data_ratio_(groups),
+          min_per_channel_(groups),
+          max_per_channel_(groups) {}
+
+    float *data_workspace_;
+    std::vector<uint8_t *> quantized_data_;
+    std::vector<float *> data_min_;
+    std::vector<float *> data_max_;
+    std::vector<float *> data_ratio_;
+    std::vector<float *> min_per_channel_;
+    std::vector<float *> max_per_channel_;
+  };
+
+  // Carve buffers out of the workspace, which only grows when the input shape grows
+  void AcquireBuffers(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                      const ConvolutionPlan &plan, bool layout_transform, Workspace &workspace, DataBuffers &buffers) {
+    size_t input_spatial_size = conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    workspace.Reserve(plan.workspace_size_);
     for (size_t g = 0; g < conv_kernel_desc.group_; ++g) {
-      quantized_data[g] = quantized_data_[g]->data_;
-      min[g] = quantized_data_[g]->min_.data_;
-      max[g] = quantized_data_[g]->max_.data_;
-      ratio[g] = quantized_data_[g]->ratio_.data_;
+      buffers.quantized_data_[g] = workspace.Acquire<uint8_t>(plan.aligned_gemm_n_ * aligned_gemm_k_);
+      buffers.data_min_[g] = workspace.Acquire<float>(plan.gemm_n_);
+      buffers.data_max_[g] = workspace.Acquire<float>(plan.gemm_n_);
+      buffers.data_ratio_[g] = workspace.Acquire<float>(plan.gemm_n_);
+      buffers.min_per_channel_[g] = workspace.Acquire<float>(input_spatial_size);
+      buffers.max_per_channel_[g] = workspace.Acquire<float>(input_spatial_size);
     }
-#ifdef TIME_PROFILE
-    auto start = std::chrono::system_clock::now();
-#endif
-    if (conv_kernel_desc.layout_ == NCHW && layout_transform == false) {
+    buffers.data_workspace_ =
+        layout_transform ? workspace.Acquire<float>(input_spatial_size * conv_data_desc.channel_in_) : NULL;
+  }
+
+  // An input already quantized only needs its patches gathered, with the same quantization for every group
+  void InitQuantizedData(const uint8_t *srcdata, const QuantizedActivationDesc &data_quantization,
+                         ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                         const ConvolutionPlan &plan, Workspace &workspace, DataBuffers &buffers) {
+    AcquireBuffers(conv_data_desc, conv_kernel_desc, plan, false, workspace, buffers);
+    size_t groups = conv_kernel_desc.group_;
+    float min = -data_quantization.zero_point_ * data_quantization.scale_;
+    std::vector<float> range_min(groups, min);
+    std::vector<float> range_max(groups, min + QUANTIZED_ACTIVATION_MAX * data_quantization.scale_);
+    std::vector<float> range_ratio(groups, data_quantization.scale_);
+    std::vector<uint8_t> zerofill(groups, data_quantization.zero_point_);
+    ProfileTimer timer(PROFILE_QUANTIZE);
+    shuffle::PadShuffleQuantizedIm2col<float>(
+        srcdata, conv_data_desc.batch_size_, conv_kernel_desc.channel_in_per_group_, groups, conv_data_desc.height_in_,
+        conv_data_desc.width_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_, conv_kernel_desc.pad_h_,
+        conv_kernel_desc.pad_w_, conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_, conv_kernel_desc.dilation_h_,
+        conv_kernel_desc.dilation_w_, buffers.quantized_data_.data(), buffers.data_min_.data(),
+        buffers.data_max_.data(), buffers.data_ratio_.data(), range_min.data(), range_max.data(), range_ratio.data(),
+        zerofill.data());
+  }
+
+  void InitData(float *srcdata, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                const ConvolutionPlan &plan, float sw_threshold, bool layout_transform, Workspace &workspace,
+                DataBuffers &buffers) {
+    AcquireBuffers(conv_data_desc, conv_kernel_desc, plan, layout_transform, workspace, buffers);
+    size_t input_spatial_size = conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_;
+    uint8_t *quantized_input = data_calibration_.Frozen()
+                                   ? workspace.Acquire<uint8_t>(input_spatial_size * conv_data_desc.channel_in_)
+                                   : NULL;
+    ProfileTimer timer(PROFILE_QUANTIZE);
+    if (data_calibration_.Frozen()) {
+      // Reads either layout directly, the transpose to the internal layout happens while quantizing
+      if (conv_kernel_desc.layout_ == NCHW) {
+        shuffle::PadQuantizeShuffleIm2colStatic<float, NCHW>(
+            srcdata, conv_data_desc.batch_size_, conv_kernel_desc.channel_in_per_group_, conv_kernel_desc.group_,
+            conv_data_desc.height_in_, conv_data_desc.width_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_,
+            conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_, conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_,
+            conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, buffers.quantized_data_.data(),
+            buffers.data_min_.data(), buffers.data_max_.data(), buffers.data_ratio_.data(),
+            data_calibration_.min_.data(), data_calibration_.max_.data(), sw_threshold, quantized_input);
+      } else {
+        shuffle::PadQuantizeShuffleIm2colStatic<float, NHWC>(
+            srcdata, conv_data_desc.batch_size_, conv_kernel_desc.channel_in_per_group_, conv_kernel_desc.group_,
+            conv_data_desc.height_in_, conv_data_desc.width_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_,
+            conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_, conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_,
+            conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, buffers.quantized_data_.data(),
+            buffers.data_min_.data(), buffers.data_max_.data(), buffers.data_ratio_.data(),
+            data_calibration_.min_.data(), data_calibration_.max_.data(), sw_threshold, quantized_input);
+      }
+    } else if (conv_kernel_desc.layout_ == NCHW && layout_transform == false) {
       shuffle::PadQuantizeShuffleIm2colWrapper<float, NCHW>(
           srcdata, conv_data_desc.batch_size_, conv_kernel_desc.channel_in_per_group_, conv_kernel_desc.group_,
           conv_data_desc.height_in_, conv_data_desc.width_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_,
           conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_, conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_,
-          conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, quantized_data.data(), min.data(), max.data(),
-          ratio.data(), data_workspace_->data_, sw_threshold, layout_transform);
+          conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, buffers.quantized_data_.data(),
+          buffers.data_min_.data(), buffers.data_max_.data(), buffers.data_ratio_.data(), buffers.data_workspace_,
+          sw_threshold, layout_transform, buffers.min_per_channel_.data(), buffers.max_per_channel_.data());
     } else {
       shuffle::PadQuantizeShuffleIm2colWrapper<float, NHWC>(
           srcdata, conv_data_desc.batch_size_, conv_kernel_desc.channel_in_per_group_, conv_kernel_desc.group_,
           conv_data_desc.height_in_, conv_data_desc.width_in_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_,
           conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_, conv_kernel_desc.stride_h_, conv_kernel_desc.stride_w_,
-          conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, quantized_data.data(), min.data(), max.data(),
-          ratio.data(), NULL, sw_threshold, layout_transform);
+          conv_kernel_desc.dilation_h_, conv_kernel_desc.dilation_w_, buffers.quantized_data_.data(),
+          buffers.data_min_.data(), buffers.data_max_.data(), buffers.data_ratio_.data(), buffers.data_workspace_,
+          sw_threshold, layout_transform, buffers.min_per_channel_.data(), buffers.max_per_channel_.data());
     }
-
-#ifdef TIME_PROFILE
-    auto end = std::chrono::system_clock::now();
-    auto diff = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cerr << "im2col " << diff.count() << "us" << std::endl;
-#endif
   }
 
   void Execute(float *out, float *data, float *bias, ConvolutionDataDesc &conv_data_desc,
-               ConvolutionKernelDesc &conv_kernel_desc) {
-    // Allocate memory
-    bool transpose_data = (conv_kernel_desc.layout_ != internal_layout_) ? true : false;
-    InitData(data, conv_data_desc, conv_kernel_desc, data_threshold_, transpose_data);
-    // Run
-    for (size_t g = 0; g < conv_kernel_desc.group_; ++g) {
-#ifdef TIME_PROFILE
-      auto start = std::chrono::system_clock::now();
-#endif
-      float *tempbias = (bias == NULL) ? bias : bias + g * conv_kernel_desc.channel_out_per_group_;
-      if (conv_kernel_desc.layout_ == NCHW) {
-        shuffle::ConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NCHW>(
-            quantized_weight_[g]->data_, quantized_data_[g]->data_, out, aligned_gemm_m_, aligned_gemm_n_,
-            aligned_gemm_k_, quantized_weight_[g]->ratio_.data_, quantized_data_[g]->ratio_.data_,
-            sum_per_channel_out_->data_ + g * conv_kernel_desc.channel_out_per_group_, quantized_data_[g]->min_.data_,
-            tempbias, conv_data_desc.batch_size_, conv_kernel_desc.group_,
-            conv_kernel_desc.channel_out_ / conv_kernel_desc.group_, g, height_out_, width_out_, 0.5,
-            aligned_gemm_m_ - gemm_m_, aligned_gemm_n_ - gemm_n_);
-      } else {
-        shuffle::ConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NHWC>(
-            quantized_weight_[g]->data_, quantized_data_[g]->data_, out, aligned_gemm_m_, aligned_gemm_n_,
-            aligned_gemm_k_, quantized_weight_[g]->ratio_.data_, quantized_data_[g]->ratio_.data_,
-            sum_per_channel_out_->data_ + g * conv_kernel_desc.channel_out_per_group_, quantized_data_[g]->min_.data_,
-            tempbias, conv_data_desc.batch_size_, conv_kernel_desc.group_,
-            conv_kernel_desc.channel_out_ / conv_kernel_desc.group_, g, height_out_, width_out_, 0.5,
-            aligned_gemm_m_ - gemm_m_, aligned_gemm_n_ - gemm_n_);
-      }
-#ifdef TIME_PROFILE
-      auto end = std::chrono::system_clock::now();
-      auto diff = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-      std::cerr << aligned_gemm_m_ << "," << aligned_gemm_n_ << "," << aligned_gemm_k_ << ",";
-      std::cerr << diff.count() << "us, "
-                << (2.0 * aligned_gemm_m_ * aligned_gemm_n_ * aligned_gemm_k_) / diff.count() / 1.0e3 << " glops"
-                << std::endl;
+               ConvolutionKernelDesc &conv_kernel_desc, const ConvolutionPlan &plan, Workspace &workspace) {
+    ExecuteQuantized(out, NULL, data, NULL, bias, conv_data_desc, conv_kernel_desc, plan, workspace);
+  }
 
-#endif
+  bool SupportQuantizedActivation() const {
+    return true;
+  }
+
+  // A u8 input skips the quantization, a u8 output is requantized tile by tile as the GEMM produces it
+  void ExecuteQuantized(void *out, const QuantizedActivationDesc *out_quantization, void *data,
+                        const QuantizedActivationDesc *data_quantization, float *bias,
+                        ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                        const ConvolutionPlan &plan, Workspace &workspace) {
+    DataBuffers buffers(conv_kernel_desc.group_);
+    if (data_quantization != NULL) {
+      InitQuantizedData(static_cast<uint8_t *>(data), *data_quantization, conv_data_desc, conv_kernel_desc, plan,
+                        workspace, buffers);
+    } else {
+      bool transpose_data = (conv_kernel_desc.layout_ != internal_layout_) ? true : false;
+      InitData(static_cast<float *>(data), conv_data_desc, conv_kernel_desc, plan, data_threshold_, transpose_data,
+               workspace, buffers);
+    }
+    OutputRequantization requantize_desc;
+    OutputRequantization *requantize = NULL;
+    float *fp_out = static_cast<float *>(out);
+    if (out_quantization != NULL) {
+      requantize_desc.data_ = static_cast<uint8_t *>(out);
+      requantize_desc.inv_scale_ = 1.0f / out_quantization->scale_;
+      requantize_desc.zero_point_ = out_quantization->zero_point_;
+      requantize_desc.upper_ = QUANTIZED_ACTIVATION_MAX;
+      requantize = &requantize_desc;
+      fp_out = NULL;
+    }
+    bool conv_relu_fusion = (conv_kernel_desc.fusion_mask_ & CONV_RELU_FUSION) != 0;
+    bool conv_bn_fusion = (conv_kernel_desc.fusion_mask_ & CONV_BN_FUSION) != 0;
+    bool conv_bn_relu_fusion = (conv_kernel_desc.fusion_mask_ & CONV_BN_RELU_FUSION) != 0;
+    bool conv_relu_bn_fusion = (conv_kernel_desc.fusion_mask_ & CONV_RELU_BN_FUSION) != 0;
+    if (conv_kernel_desc.group_ > 1) {
+      GroupExecute(fp_out, requantize, bias, conv_data_desc, conv_kernel_desc, plan, buffers, conv_relu_fusion,
+                   conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion);
+      return;
+    }
+    ProfileTimer timer(PROFILE_GEMM);
+    if (conv_kernel_desc.layout_ == NCHW) {
+      shuffle::ConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NCHW>(
+          quantized_weight_[0]->data_, buffers.quantized_data_[0], fp_out, aligned_gemm_m_, plan.aligned_gemm_n_,
+          aligned_gemm_k_, quantized_weight_[0]->ratio_.data_, buffers.data_ratio_[0], sum_per_channel_out_->data_,
+          buffers.data_min_[0], bias, conv_data_desc.batch_size_, 1, conv_kernel_desc.channel_out_, 0,
+          plan.height_out_, plan.width_out_, 0.5, aligned_gemm_m_ - gemm_m_, plan.aligned_gemm_n_ - plan.gemm_n_,
+          conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, batch_norm_.GlobalMean(0),
+          batch_norm_.MulVarianceCoeff(0), batch_norm_.Scale(0), batch_norm_.Shift(0), &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, requantize, &numa_weight_);
+    } else {
+      shuffle::ConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NHWC>(
+          quantized_weight_[0]->data_, buffers.quantized_data_[0], fp_out, aligned_gemm_m_, plan.aligned_gemm_n_,
+          aligned_gemm_k_, quantized_weight_[0]->ratio_.data_, buffers.data_ratio_[0], sum_per_channel_out_->data_,
+          buffers.data_min_[0], bias, conv_data_desc.batch_size_, 1, conv_kernel_desc.channel_out_, 0,
+          plan.height_out_, plan.width_out_, 0.5, aligned_gemm_m_ - gemm_m_, plan.aligned_gemm_n_ - plan.gemm_n_,
+          conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, batch_norm_.GlobalMean(0),
+          batch_norm_.MulVarianceCoeff(0), batch_norm_.Scale(0), batch_norm_.Shift(0), &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, requantize, &numa_weight_);
     }
-    FreeMemory(conv_kernel_desc);
   }
 
-  void FreeMemory(ConvolutionKernelDesc &conv_kernel_desc) {
-    for (size_t g = 0; g < conv_kernel_desc.group_; ++g) {
-      delete quantized_data_[g];
+  // Every group in one parallel loop, see GroupedConvShuffleGEMM
+  void GroupExecute(float *out, const OutputRequantization *requantize, float *bias,
+                    ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                    const ConvolutionPlan &plan, DataBuffers &buffers, bool conv_relu_fusion, bool conv_bn_fusion,
+                    bool conv_bn_relu_fusion, bool conv_relu_bn_fusion) {
+    size_t groups = conv_kernel_desc.group_;
+    std::vector<int8_t *> group_weight(groups);
+    std::vector<float *> group_weight_ratio(groups);
+    for (size_t g = 0; g < groups; ++g) {
+      group_weight[g] = quantized_weight_[g]->data_;
+      group_weight_ratio[g] = quantized_weight_[g]->ratio_.data_;
     }
-    if (data_workspace_) {
-      delete data_workspace_;
-      data_workspace_ = NULL;
+    ProfileTimer timer(PROFILE_GEMM);
+    if (conv_kernel_desc.layout_ == NCHW) {
+      shuffle::GroupedConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NCHW>(
+          group_weight.data(), buffers.quantized_data_.data(), out, aligned_gemm_m_, plan.aligned_gemm_n_,
+          aligned_gemm_k_, group_weight_ratio.data(), buffers.data_ratio_.data(), sum_per_channel_out_->data_,
+          buffers.data_min_.data(), bias, conv_data_desc.batch_size_, groups, conv_kernel_desc.channel_out_per_group_,
+          plan.height_out_, plan.width_out_, 0.5, aligned_gemm_m_ - gemm_m_, plan.aligned_gemm_n_ - plan.gemm_n_,
+          conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, batch_norm_.GlobalMean(0),
+          batch_norm_.MulVarianceCoeff(0), batch_norm_.Scale(0), batch_norm_.Shift(0), &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, requantize, &numa_weight_);
+    } else {
+      shuffle::GroupedConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NHWC>(
+          group_weight.data(), buffers.quantized_data_.data(), out, aligned_gemm_m_, plan.aligned_gemm_n_,
+          aligned_gemm_k_, group_weight_ratio.data(), buffers.data_ratio_.data(), sum_per_channel_out_->data_,
+          buffers.data_min_.data(), bias, conv_data_desc.batch_size_, groups, conv_kernel_desc.channel_out_per_group_,
+          plan.height_out_, plan.width_out_, 0.5, aligned_gemm_m_ - gemm_m_, plan.aligned_gemm_n_ - plan.gemm_n_,
+          conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, batch_norm_.GlobalMean(0),
+          batch_norm_.MulVarianceCoeff(0), batch_norm_.Scale(0), batch_norm_.Shift(0), &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, requantize, &numa_weight_);
     }
   }
 
@@ -223,18 +517,16 @@ struct ShuffleConvolutionAlgo : public BaseConvolutionAlgo {
   Tensor<float> *sum_per_channel_out_;
   std::vector<Tensor<float> *> group_weight_;
   std::vector<QuantizedTensor<float, int8_t> *> quantized_weight_;
-  Tensor<float> *data_workspace_;
-  std::vector<QuantizedTensor<float, uint8_t> *> quantized_data_;
+  NumaWeight numa_weight_;
 
   const LAYOUT internal_layout_;
 
   size_t gemm_m_;
-  size_t gemm_n_;
   size_t gemm_k_;
   size_t aligned_gemm_m_;
-  size_t aligned_gemm_n_;
   size_t aligned_gemm_k_;
 
+  WEIGHT_QUANTIZATION weight_quantization_;
   float weight_threshold_;
   float data_threshold_;
 };
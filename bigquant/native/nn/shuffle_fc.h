@@ -21,11 +21,18 @@
 
 struct ShuffleFCAlgo : public BaseFCAlgo {
   ShuffleFCAlgo() {
-    weight_threshold_ = 64.0f;
+    weight_quantization_ = WEIGHT_7BIT;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
     data_threshold_ = 127.0f;
+    sum_per_channel_out_ = NULL;
+    quantized_kernel_ = NULL;
   }
 
   ~ShuffleFCAlgo() {
+    ReleaseWeight();
+  }
+
+  void ReleaseWeight() {
     if (sum_per_channel_out_) {
       delete sum_per_channel_out_;
       sum_per_channel_out_ = NULL;
@@ -34,62 +41,221 @@ struct ShuffleFCAlgo : public BaseFCAlgo {
       delete quantized_kernel_;
       quantized_kernel_ = NULL;
     }
+    numa_weight_.Release();
+    ReleaseWeightBlob();
   }
 
   void InitWeight(float *weight, FCKernelDesc &fc_kernel_desc) {
+    ReleaseWeight();
     fc_m_ = fc_kernel_desc.channel_out_;
     fc_k_ = fc_kernel_desc.channel_in_;
     aligned_fc_m_ = GetAlignmentLength(fc_m_, FC_SHUFFLE_KERNEL_M);
     aligned_fc_k_ = GetAlignmentLength(fc_k_, FC_SHUFFLE_KERNEL_K);
+    weight_quantization_ = fc_kernel_desc.weight_quantization_;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
 
     sum_per_channel_out_ = new Tensor<float>(make_shape(fc_kernel_desc.channel_out_), 64);
-    ComputeMatrixSumPerRow<float>(sum_per_channel_out_->data_, weight, fc_kernel_desc.channel_out_,
-                                  fc_kernel_desc.channel_in_);
+    // The full range scheme takes the data zero point compensation from the quantized weight instead
+    if (weight_quantization_ == WEIGHT_7BIT) {
+      ComputeMatrixSumPerRow<float>(sum_per_channel_out_->data_, weight, fc_kernel_desc.channel_out_,
+                                    fc_kernel_desc.channel_in_);
+    }
     quantized_kernel_ = new QuantizedTensor<float, int8_t>(make_shape(aligned_fc_m_, aligned_fc_k_), make_shape(fc_m_),
                                                            make_shape(fc_m_, fc_k_), 64);
     shuffle::PadQuantizeShuffle2D<float, FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_K>(
         quantized_kernel_->data_, fc_m_, fc_k_, aligned_fc_m_, aligned_fc_k_, weight, quantized_kernel_->min_.data_,
-        quantized_kernel_->max_.data_, quantized_kernel_->ratio_.data_, weight_threshold_);
+        quantized_kernel_->max_.data_, quantized_kernel_->ratio_.data_, weight_threshold_,
+        (weight_quantization_ == WEIGHT_8BIT) ? sum_per_channel_out_->data_ : NULL);
+#if defined(AMX)
+    shuffle::VNNIShuffle2D<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_K>(quantized_kernel_->data_, aligned_fc_m_,
+                                                                    aligned_fc_k_);
+#endif
+    PlaceWeight(fc_kernel_desc);
   }
 
-  void Execute(float *out, float *data, float *bias, FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc) {
-    fc_n_ = fc_data_desc.batch_size_;
-    aligned_fc_n_ = GetAlignmentLength(fc_n_, FC_SHUFFLE_KERNEL_N);
-    quantized_data_ = new QuantizedTensor<float, uint8_t>(make_shape(aligned_fc_n_, aligned_fc_k_), make_shape(fc_n_),
-                                                          make_shape(fc_n_, fc_k_), 64);
+  void PlaceWeight(FCKernelDesc &fc_kernel_desc) {
+    if (quantized_kernel_ == NULL) {
+      return;
+    }
+    numa_weight_.Place(std::vector<int8_t *>(1, quantized_kernel_->data_), aligned_fc_m_ * aligned_fc_k_,
+                       fc_kernel_desc.numa_mode_);
+  }
+
+  WeightBlobHeader WeightHeader(const FCKernelDesc &fc_kernel_desc) {
+    WeightBlobHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic_ = WEIGHT_BLOB_MAGIC;
+    header.version_ = WEIGHT_BLOB_VERSION;
+    header.type_ = FC_WEIGHT_BLOB;
+    header.layout_ = fc_kernel_desc.layout_;
+    header.kernel_m_ = FC_SHUFFLE_KERNEL_M;
+    header.kernel_n_ = FC_SHUFFLE_KERNEL_N;
+    header.kernel_k_ = FC_SHUFFLE_KERNEL_K;
+    header.channel_out_ = fc_kernel_desc.channel_out_;
+    header.channel_in_ = fc_kernel_desc.channel_in_;
+    header.group_ = 1;
+    header.kernel_h_ = 1;
+    header.kernel_w_ = 1;
+    header.gemm_m_ = fc_kernel_desc.channel_out_;
+    header.gemm_k_ = fc_kernel_desc.channel_in_;
+    header.aligned_gemm_m_ = GetAlignmentLength(header.gemm_m_, FC_SHUFFLE_KERNEL_M);
+    header.aligned_gemm_k_ = GetAlignmentLength(header.gemm_k_, FC_SHUFFLE_KERNEL_K);
+    header.weight_threshold_ = GetWeightThreshold(fc_kernel_desc.weight_quantization_);
+    header.weight_quantization_ = fc_kernel_desc.weight_quantization_;
+    return header;
+  }
 
+  int SaveWeight(WeightBlobWriter &writer, FCKernelDesc &fc_kernel_desc) {
+    if (quantized_kernel_ == NULL) {
+      return WEIGHT_BLOB_UNSUPPORTED;
+    }
+    WeightBlobHeader header = WeightHeader(fc_kernel_desc);
+    header.weight_threshold_ = weight_threshold_;
+    header.weight_quantization_ = weight_quantization_;
+    // placeholder, rewritten with the final size at the end
+    if (writer.Write(&header, sizeof(header)) != WEIGHT_BLOB_OK ||
+        writer.Write(sum_per_channel_out_->data_, sizeof(float) * fc_m_) != WEIGHT_BLOB_OK ||
+        writer.Write(quantized_kernel_->data_, sizeof(int8_t) * aligned_fc_m_ * aligned_fc_k_) != WEIGHT_BLOB_OK ||
+        writer.Write(quantized_kernel_->min_.data_, sizeof(float) * fc_m_) != WEIGHT_BLOB_OK ||
+        writer.Write(quantized_kernel_->max_.data_, sizeof(float) * fc_m_) != WEIGHT_BLOB_OK ||
+        writer.Write(quantized_kernel_->ratio_.data_, sizeof(float) * fc_m_) != WEIGHT_BLOB_OK) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    return writer.WriteHeader(header);
+  }
+
+  int LoadWeight(WeightBlobReader &reader, FCKernelDesc &fc_kernel_desc, bool zero_copy) {
+    const WeightBlobHeader *header = reader.Header();
+    if (header == NULL) {
+      return WEIGHT_BLOB_FORMAT_ERROR;
+    }
+    WeightBlobHeader expect = WeightHeader(fc_kernel_desc);
+    if (!WeightBlobMatch(*header, expect)) {
+      return WEIGHT_BLOB_MISMATCH;
+    }
+    const float *kernel_sum = reader.Read<float>(expect.gemm_m_);
+    const int8_t *panel = reader.Read<int8_t>(expect.aligned_gemm_m_ * expect.aligned_gemm_k_);
+    const float *min = reader.Read<float>(expect.gemm_m_);
+    const float *max = reader.Read<float>(expect.gemm_m_);
+    const float *ratio = reader.Read<float>(expect.gemm_m_);
+    if (kernel_sum == NULL || panel == NULL || min == NULL || max == NULL || ratio == NULL) {
+      return WEIGHT_BLOB_FORMAT_ERROR;
+    }
+
+    ReleaseWeight();
+    weight_quantization_ = fc_kernel_desc.weight_quantization_;
+    weight_threshold_ = header->weight_threshold_;
+    fc_m_ = expect.gemm_m_;
+    fc_k_ = expect.gemm_k_;
+    aligned_fc_m_ = expect.aligned_gemm_m_;
+    aligned_fc_k_ = expect.aligned_gemm_k_;
+    if (zero_copy) {
+      // Non-owning views of the read-only mapping, the kernels never write the weight
+      sum_per_channel_out_ = new Tensor<float>(make_shape(fc_m_));
+      sum_per_channel_out_->SetData(const_cast<float *>(kernel_sum));
+      quantized_kernel_ = new QuantizedTensor<float, int8_t>(make_shape(aligned_fc_m_, aligned_fc_k_),
+                                                             make_shape(fc_m_), make_shape(fc_m_, fc_k_));
+      quantized_kernel_->SetData(const_cast<int8_t *>(panel));
+      quantized_kernel_->min_.SetData(const_cast<float *>(min));
+      quantized_kernel_->max_.SetData(const_cast<float *>(max));
+      quantized_kernel_->ratio_.SetData(const_cast<float *>(ratio));
+      PlaceWeight(fc_kernel_desc);
+      return WEIGHT_BLOB_OK;
+    }
+    sum_per_channel_out_ = new Tensor<float>(make_shape(fc_m_), 64);
+    memcpy(sum_per_channel_out_->data_, kernel_sum, sizeof(float) * fc_m_);
+    quantized_kernel_ = new QuantizedTensor<float, int8_t>(make_shape(aligned_fc_m_, aligned_fc_k_), make_shape(fc_m_),
+                                                           make_shape(fc_m_, fc_k_), 64);
+    memcpy(quantized_kernel_->data_, panel, sizeof(int8_t) * aligned_fc_m_ * aligned_fc_k_);
+    memcpy(quantized_kernel_->min_.data_, min, sizeof(float) * fc_m_);
+    memcpy(quantized_kernel_->max_.data_, max, sizeof(float) * fc_m_);
+    memcpy(quantized_kernel_->ratio_.data_, ratio, sizeof(float) * fc_m_);
+    PlaceWeight(fc_kernel_desc);
+    return WEIGHT_BLOB_OK;
+  }
+
+  size_t WorkspaceSize(FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc) {
+    size_t fc_n = fc_data_desc.batch_size_;
+    return Workspace::AlignedSize(sizeof(uint8_t) * GetAlignmentLength(fc_n, FC_SHUFFLE_KERNEL_N) *
+                                  GetAlignmentLength(fc_kernel_desc.channel_in_, FC_SHUFFLE_KERNEL_K)) +
+           3 * Workspace::AlignedSize(sizeof(float) * fc_n);
+  }
+
+  void ReserveWorkspace(FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc, Workspace &workspace) {
+    workspace.Reserve(WorkspaceSize(fc_data_desc, fc_kernel_desc));
+  }
+
+  void InitPlan(FCPlan &plan, FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc) {
+#if defined(AMX)
+    plan.gemv_ = false;
+#else
+    plan.gemv_ = (fc_data_desc.batch_size_ <= FC_GEMV_MAX_BATCH);
+#endif
+    plan.aligned_fc_n_ = GetAlignmentLength(fc_data_desc.batch_size_, FC_SHUFFLE_KERNEL_N);
+    plan.workspace_size_ = WorkspaceSize(fc_data_desc, fc_kernel_desc);
+    if (plan.gemv_) {
+      GetBlocksInfo<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_N>(aligned_fc_m_, plan.aligned_fc_n_, aligned_fc_k_,
+                                                              plan.threads_num_, plan.blocks_info_);
+    } else {
+      shuffle::TuneBlocksInfo<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_N, FC_SHUFFLE_KERNEL_K>(
+          aligned_fc_m_, plan.aligned_fc_n_, aligned_fc_k_, plan.threads_num_, plan.blocks_info_);
+    }
+  }
+
+  void Execute(float *out, float *data, float *bias, FCDataDesc &fc_data_desc, FCKernelDesc &fc_kernel_desc,
+               const FCPlan &plan, Workspace &workspace) {
+    size_t fc_n = fc_data_desc.batch_size_;
+    size_t aligned_fc_n = plan.aligned_fc_n_;
+    workspace.Reserve(plan.workspace_size_);
+    uint8_t *quantized_data = workspace.Acquire<uint8_t>(aligned_fc_n * aligned_fc_k_);
+    float *data_min = workspace.Acquire<float>(fc_n);
+    float *data_max = workspace.Acquire<float>(fc_n);
+    float *data_ratio = workspace.Acquire<float>(fc_n);
+
+#if !defined(AMX)
+    if (plan.gemv_) {
+      // The output is batch x channel_out for both layouts
+      shuffle::PadQuantizeShuffle2D<float, 1, FC_SHUFFLE_KERNEL_K>(quantized_data, fc_n, fc_k_, fc_n, aligned_fc_k_,
+                                                                     data, data_min, data_max, data_ratio,
+                                                                     data_threshold_);
+      shuffle::ShuffleGEMV<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_K>(
+          quantized_kernel_->data_, quantized_data, out, aligned_fc_m_, fc_n, aligned_fc_k_,
+          quantized_kernel_->ratio_.data_, data_ratio, sum_per_channel_out_->data_, data_min, bias, fc_m_,
+          &numa_weight_);
+      return;
+    }
+#endif
     shuffle::PadQuantizeShuffle2D<float, FC_SHUFFLE_KERNEL_N, FC_SHUFFLE_KERNEL_K>(
-        quantized_data_->data_, fc_n_, fc_k_, aligned_fc_n_, aligned_fc_k_, data, quantized_data_->min_.data_,
-        quantized_data_->max_.data_, quantized_data_->ratio_.data_, data_threshold_);
+        quantized_data, fc_n, fc_k_, aligned_fc_n, aligned_fc_k_, data, data_min, data_max, data_ratio,
+        data_threshold_);
     if (fc_kernel_desc.layout_ == NCHW) {
       shuffle::ConvShuffleGEMM<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_N, FC_SHUFFLE_KERNEL_K, NCHW>(
-          quantized_kernel_->data_, quantized_data_->data_, out, aligned_fc_m_, aligned_fc_n_, aligned_fc_k_,
-          quantized_kernel_->ratio_.data_, quantized_data_->ratio_.data_, sum_per_channel_out_->data_,
-          quantized_data_->min_.data_, bias, fc_data_desc.batch_size_, 1, fc_kernel_desc.channel_out_, 0, 1, 1, 0.5,
-          aligned_fc_m_ - fc_m_, aligned_fc_n_ - fc_n_, false);
+          quantized_kernel_->data_, quantized_data, out, aligned_fc_m_, aligned_fc_n, aligned_fc_k_,
+          quantized_kernel_->ratio_.data_, data_ratio, sum_per_channel_out_->data_, data_min, bias,
+          fc_data_desc.batch_size_, 1, fc_kernel_desc.channel_out_, 0, 1, 1, 0.5, aligned_fc_m_ - fc_m_,
+          aligned_fc_n - fc_n, false, false, false, false, NULL, NULL, NULL, NULL, &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, NULL, &numa_weight_);
     } else {
       shuffle::ConvShuffleGEMM<FC_SHUFFLE_KERNEL_M, FC_SHUFFLE_KERNEL_N, FC_SHUFFLE_KERNEL_K, NHWC>(
-          quantized_kernel_->data_, quantized_data_->data_, out, aligned_fc_m_, aligned_fc_n_, aligned_fc_k_,
-          quantized_kernel_->ratio_.data_, quantized_data_->ratio_.data_, sum_per_channel_out_->data_,
-          quantized_data_->min_.data_, bias, fc_data_desc.batch_size_, 1, fc_kernel_desc.channel_out_, 0, 1, 1, 0.5,
-          aligned_fc_m_ - fc_m_, aligned_fc_n_ - fc_n_, false);
+          quantized_kernel_->data_, quantized_data, out, aligned_fc_m_, aligned_fc_n, aligned_fc_k_,
+          quantized_kernel_->ratio_.data_, data_ratio, sum_per_channel_out_->data_, data_min, bias,
+          fc_data_desc.batch_size_, 1, fc_kernel_desc.channel_out_, 0, 1, 1, 0.5, aligned_fc_m_ - fc_m_,
+          aligned_fc_n - fc_n, false, false, false, false, NULL, NULL, NULL, NULL, &plan.blocks_info_,
+          weight_quantization_ == WEIGHT_8BIT, NULL, &numa_weight_);
     }
-    delete quantized_data_;
-    quantized_data_ = NULL;
   }
 
  private:
   size_t fc_m_;
-  size_t fc_n_;
   size_t fc_k_;
   size_t aligned_fc_m_;
-  size_t aligned_fc_n_;
   size_t aligned_fc_k_;
 
   Tensor<float> *sum_per_channel_out_;
   QuantizedTensor<float, int8_t> *quantized_kernel_;
-  QuantizedTensor<float, uint8_t> *quantized_data_;
+  NumaWeight numa_weight_;
 
+  WEIGHT_QUANTIZATION weight_quantization_;
   float weight_threshold_;
   float data_threshold_;
 };
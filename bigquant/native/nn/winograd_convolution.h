@@ -0,0 +1,188 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NN_WINOGRAD_CONVOLUTION_H
+#define NN_WINOGRAD_CONVOLUTION_H
+#include "base_convolution.h"
+
+// Winograd F(2x2, 3x3) needs a dense 3x3 kernel sliding by one pixel
+static inline bool WinogradSupported(const ConvolutionKernelDesc &conv_kernel_desc) {
+  return (conv_kernel_desc.group_ == 1) && (conv_kernel_desc.kernel_h_ == 3) && (conv_kernel_desc.kernel_w_ == 3) &&
+         (conv_kernel_desc.stride_h_ == 1) && (conv_kernel_desc.stride_w_ == 1) &&
+         (conv_kernel_desc.dilation_h_ == 1) && (conv_kernel_desc.dilation_w_ == 1);
+}
+
+// Each tile element of the transformed weight is quantized per output channel and each tile element of a transformed
+// input tile with its own range, so the quantization follows the value growth of the transforms. The data is always
+// quantized on the fly, a calibrated input range would not bound the transformed tiles, hence calibration is rejected.
+struct WinogradConvolutionAlgo : public BaseConvolutionAlgo {
+  WinogradConvolutionAlgo(const ConvolutionKernelDesc &conv_kernel_desc) {
+    weight_quantization_ = WEIGHT_7BIT;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
+    data_threshold_ = 127.0f;
+    quantized_weight_ = NULL;
+    sum_per_channel_out_ = NULL;
+  }
+
+  ~WinogradConvolutionAlgo() {
+    ReleaseWeight();
+  }
+
+  bool SupportCalibration() const {
+    return false;
+  }
+
+  void ReleaseWeight() {
+    if (quantized_weight_) {
+      delete quantized_weight_;
+      quantized_weight_ = NULL;
+    }
+    if (sum_per_channel_out_) {
+      delete sum_per_channel_out_;
+      sum_per_channel_out_ = NULL;
+    }
+  }
+
+  void InitWeight(float *weight, ConvolutionKernelDesc &conv_kernel_desc) {
+    ReleaseWeight();
+    weight_quantization_ = conv_kernel_desc.weight_quantization_;
+    weight_threshold_ = GetWeightThreshold(weight_quantization_);
+    gemm_m_ = conv_kernel_desc.channel_out_;
+    gemm_k_ = conv_kernel_desc.channel_in_;
+    aligned_gemm_m_ = GetAlignmentLength(gemm_m_, CONV_SHUFFLE_KERNEL_M);
+    aligned_gemm_k_ = GetAlignmentLength(gemm_k_, CONV_SHUFFLE_KERNEL_K);
+    size_t kernel_size = conv_kernel_desc.kernel_h_ * conv_kernel_desc.kernel_w_;
+    Tensor<float> nhwc_weight(make_shape(gemm_m_, gemm_k_, conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_));
+    if (conv_kernel_desc.layout_ != NHWC) {
+      nhwc_weight.Allocate(64);
+      TransformLayout(NHWC, conv_kernel_desc.layout_, nhwc_weight.data_, weight, gemm_m_, gemm_k_, kernel_size);
+    } else {
+      nhwc_weight.SetData(weight);
+    }
+    Tensor<float> transformed_weight(make_shape(WINOGRAD_TILE_SIZE, gemm_m_, gemm_k_), 64);
+    winograd::NHWCWinograd3x3KernelProcess(transformed_weight.data_, nhwc_weight.data_, gemm_m_, gemm_k_,
+                                           conv_kernel_desc.kernel_h_, conv_kernel_desc.kernel_w_);
+    quantized_weight_ = new QuantizedTensor<float, int8_t>(
+        make_shape(WINOGRAD_TILE_SIZE, aligned_gemm_m_, aligned_gemm_k_), make_shape(WINOGRAD_TILE_SIZE * gemm_m_),
+        make_shape(WINOGRAD_TILE_SIZE, gemm_m_, gemm_k_), 64);
+    sum_per_channel_out_ = new Tensor<float>(make_shape(WINOGRAD_TILE_SIZE * gemm_m_), 64);
+    // Same zero point compensation as the shuffle algorithm, from the quantized weight under the full range scheme
+    if (weight_quantization_ != WEIGHT_8BIT) {
+      ComputeMatrixSumPerRow<float>(sum_per_channel_out_->data_, transformed_weight.data_,
+                                    WINOGRAD_TILE_SIZE * gemm_m_, gemm_k_);
+    }
+    winograd::NHWCWinogradQuantizeKernelByChannel(
+        quantized_weight_->data_, transformed_weight.data_, gemm_m_, gemm_k_, aligned_gemm_m_, aligned_gemm_k_,
+        quantized_weight_->min_.data_, quantized_weight_->max_.data_, quantized_weight_->ratio_.data_,
+        weight_threshold_, (weight_quantization_ == WEIGHT_8BIT) ? sum_per_channel_out_->data_ : NULL);
+  }
+
+  size_t WorkspaceSize(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                       size_t threads_num) {
+    size_t height_out = GetConvOutSize(conv_data_desc.height_in_, 3, 1, conv_kernel_desc.pad_h_, 1);
+    size_t width_out = GetConvOutSize(conv_data_desc.width_in_, 3, 1, conv_kernel_desc.pad_w_, 1);
+    size_t tiles = conv_data_desc.batch_size_ * ((height_out + 1) / 2) * ((width_out + 1) / 2);
+    size_t input_size =
+        conv_data_desc.batch_size_ * conv_data_desc.height_in_ * conv_data_desc.width_in_ * conv_data_desc.channel_in_;
+    size_t size = Workspace::AlignedSize(sizeof(uint8_t) * WINOGRAD_TILE_SIZE *
+                                         GetAlignmentLength(tiles, CONV_SHUFFLE_KERNEL_N) *
+                                         GetAlignmentLength(conv_kernel_desc.channel_in_, CONV_SHUFFLE_KERNEL_K)) +
+                  3 * Workspace::AlignedSize(sizeof(float) * WINOGRAD_TILE_SIZE * tiles) +
+                  Workspace::AlignedSize(sizeof(float) * threads_num * (WINOGRAD_TILE_SIZE + 1) *
+                                         conv_kernel_desc.channel_in_) +
+                  Workspace::AlignedSize(sizeof(float) * WINOGRAD_TILE_SIZE * tiles * conv_kernel_desc.channel_out_);
+    if (conv_kernel_desc.layout_ != NHWC) {
+      size += Workspace::AlignedSize(sizeof(float) * input_size);
+    }
+    return size;
+  }
+
+  void ReserveWorkspace(ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc,
+                        Workspace &workspace) {
+    workspace.Reserve(WorkspaceSize(conv_data_desc, conv_kernel_desc, GetMaxThreadsNum()));
+  }
+
+  void InitPlan(ConvolutionPlan &plan, ConvolutionDataDesc &conv_data_desc, ConvolutionKernelDesc &conv_kernel_desc) {
+    BaseConvolutionAlgo::InitPlan(plan, conv_data_desc, conv_kernel_desc);
+    plan.gemm_n_ = conv_data_desc.batch_size_ * ((plan.height_out_ + 1) / 2) * ((plan.width_out_ + 1) / 2);
+    plan.aligned_gemm_n_ = GetAlignmentLength(plan.gemm_n_, CONV_SHUFFLE_KERNEL_N);
+    plan.workspace_size_ = WorkspaceSize(conv_data_desc, conv_kernel_desc, plan.threads_num_);
+    shuffle::TuneBlocksInfo<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K>(
+        aligned_gemm_m_, plan.aligned_gemm_n_, aligned_gemm_k_, plan.threads_num_, plan.blocks_info_);
+  }
+
+  void Execute(float *out, float *data, float *bias, ConvolutionDataDesc &conv_data_desc,
+               ConvolutionKernelDesc &conv_kernel_desc, const ConvolutionPlan &plan, Workspace &workspace) {
+    size_t batch_size = conv_data_desc.batch_size_;
+    size_t patch_y_num = (plan.height_out_ + 1) / 2;
+    size_t patch_x_num = (plan.width_out_ + 1) / 2;
+    size_t tiles = plan.gemm_n_;
+    workspace.Reserve(plan.workspace_size_);
+    uint8_t *transformed_data =
+        workspace.Acquire<uint8_t>(WINOGRAD_TILE_SIZE * plan.aligned_gemm_n_ * aligned_gemm_k_);
+    float *data_min = workspace.Acquire<float>(WINOGRAD_TILE_SIZE * tiles);
+    float *data_max = workspace.Acquire<float>(WINOGRAD_TILE_SIZE * tiles);
+    float *data_ratio = workspace.Acquire<float>(WINOGRAD_TILE_SIZE * tiles);
+    float *tile_workspace = workspace.Acquire<float>(plan.threads_num_ * (WINOGRAD_TILE_SIZE + 1) * gemm_k_);
+    float *intermedia_out = workspace.Acquire<float>(WINOGRAD_TILE_SIZE * tiles * gemm_m_);
+    if (conv_kernel_desc.layout_ != NHWC) {
+      float *nhwc_data = workspace.Acquire<float>(batch_size * conv_data_desc.height_in_ * conv_data_desc.width_in_ *
+                                                   conv_data_desc.channel_in_);
+      TransformLayout(NHWC, conv_kernel_desc.layout_, nhwc_data, data, batch_size, conv_data_desc.channel_in_,
+                      conv_data_desc.height_in_ * conv_data_desc.width_in_);
+      data = nhwc_data;
+    }
+    {
+      ProfileTimer timer(PROFILE_QUANTIZE);
+      winograd::NHWCWinograd3x3DataProcess(transformed_data, data, batch_size, gemm_k_, conv_data_desc.height_in_,
+                                           conv_data_desc.width_in_, conv_kernel_desc.pad_h_, conv_kernel_desc.pad_w_,
+                                           patch_y_num, patch_x_num, data_min, data_max, data_ratio, data_threshold_,
+                                           tile_workspace);
+    }
+    {
+      ProfileTimer timer(PROFILE_GEMM);
+      winograd::NHWCWinograd3x3ElementWiseBatchMul(intermedia_out, quantized_weight_->data_, transformed_data,
+                                                   batch_size, patch_y_num, patch_x_num, gemm_k_, gemm_m_,
+                                                   quantized_weight_->ratio_.data_, sum_per_channel_out_->data_,
+                                                   data_ratio, data_min, &plan.blocks_info_,
+                                                   weight_quantization_ == WEIGHT_8BIT);
+    }
+    bool conv_relu_fusion = (conv_kernel_desc.fusion_mask_ & CONV_RELU_FUSION) != 0;
+    bool conv_bn_fusion = (conv_kernel_desc.fusion_mask_ & CONV_BN_FUSION) != 0;
+    bool conv_bn_relu_fusion = (conv_kernel_desc.fusion_mask_ & CONV_BN_RELU_FUSION) != 0;
+    bool conv_relu_bn_fusion = (conv_kernel_desc.fusion_mask_ & CONV_RELU_BN_FUSION) != 0;
+    ProfileTimer timer(PROFILE_EPILOGUE);
+    winograd::NHWCWinograd3x3PostProcess(out, intermedia_out, batch_size, patch_y_num, patch_x_num, gemm_m_,
+                                         plan.height_out_, plan.width_out_, conv_kernel_desc.layout_, bias,
+                                         conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+                                         batch_norm_.GlobalMean(0), batch_norm_.MulVarianceCoeff(0),
+                                         batch_norm_.Scale(0), batch_norm_.Shift(0));
+  }
+
+ private:
+  QuantizedTensor<float, int8_t> *quantized_weight_;
+  Tensor<float> *sum_per_channel_out_;
+
+  size_t gemm_m_;
+  size_t gemm_k_;
+  size_t aligned_gemm_m_;
+  size_t aligned_gemm_k_;
+
+  WEIGHT_QUANTIZATION weight_quantization_;
+  float weight_threshold_;
+  float data_threshold_;
+};
+#endif
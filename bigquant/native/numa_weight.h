@@ -0,0 +1,131 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NUMA_WEIGHT_H
+#define NUMA_WEIGHT_H
+#include "base.h"
+#include "common.h"
+#ifdef NUMA
+#include <sched.h>
+#endif
+
+// Node of the cpu the calling thread runs on, 0 on a single node or without libnuma
+INLINE_SPECIFIER size_t GetCurrentNumaNode() {
+#ifdef NUMA
+  if (GetSocketNum() > 1) {
+    int cpu = sched_getcpu();
+    int node = (cpu < 0) ? -1 : numa_node_of_cpu(cpu);
+    if (node >= 0) {
+      return node;
+    }
+  }
+#endif
+  return 0;
+}
+
+// The quantized weight panels of one op placed in memory according to a NUMA_MODE. NUMA_REPLICATE copies them to the
+// local memory of every node and each GEMM thread reads the copy of the node it runs on. NUMA_INTERLEAVE keeps one
+// copy with its pages spread round robin over the nodes, which balances the remote traffic without the extra memory.
+// On a single node, without libnuma or with NUMA_NONE nothing is placed and the kernels read the original panels.
+struct NumaWeight {
+  NumaWeight() : panel_size_(0), panel_num_(0) {
+  }
+
+  ~NumaWeight() {
+    Release();
+  }
+
+  NumaWeight(const NumaWeight &) = delete;
+
+  NumaWeight &operator=(const NumaWeight &) = delete;
+
+  // panels are copied, they all hold panel_size bytes
+  void Place(const std::vector<int8_t *> &panels, size_t panel_size, NUMA_MODE mode) {
+    Release();
+#ifdef NUMA
+    if ((mode == NUMA_NONE) || (GetSocketNum() <= 1) || panels.empty()) {
+      return;
+    }
+    // 64 bytes keep every panel as aligned as the kernels load it
+    panel_size_ = GetAlignmentLength(panel_size, 64);
+    panel_num_ = panels.size();
+    size_t nodes = numa_max_node() + 1;
+    if (mode == NUMA_INTERLEAVE) {
+      owned_.push_back(Copy(panels, panel_size, numa_alloc_interleaved(panel_size_ * panel_num_)));
+      node_copy_.assign(nodes, owned_[0]);
+      return;
+    }
+    node_copy_.assign(nodes, NULL);
+    for (size_t node = 0; node < nodes; ++node) {
+      if (numa_bitmask_isbitset(numa_all_nodes_ptr, node)) {
+        node_copy_[node] = Copy(panels, panel_size, numa_alloc_onnode(panel_size_ * panel_num_, node));
+        owned_.push_back(node_copy_[node]);
+      }
+    }
+    // The nodes without memory of their own read the copy of the first node which has some
+    for (size_t node = 0; node < nodes; ++node) {
+      if (node_copy_[node] == NULL) {
+        node_copy_[node] = owned_[0];
+      }
+    }
+#endif
+  }
+
+  void Release() {
+#ifdef NUMA
+    for (size_t i = 0; i < owned_.size(); ++i) {
+      numa_free(owned_[i], panel_size_ * panel_num_);
+    }
+#endif
+    owned_.clear();
+    node_copy_.clear();
+    panel_size_ = 0;
+    panel_num_ = 0;
+  }
+
+  bool Placed() const {
+    return !node_copy_.empty();
+  }
+
+  // The copy of panel g the threads of node read
+  int8_t *Panel(size_t node, size_t g) const {
+    return node_copy_[(node < node_copy_.size()) ? node : 0] + g * panel_size_;
+  }
+
+ private:
+  int8_t *Copy(const std::vector<int8_t *> &panels, size_t panel_size, void *memory) {
+    if (memory == NULL) {
+      fprintf(stderr, "Failed to Allocate NUMA Memory.\n");
+      exit(-1);
+    }
+    int8_t *copy = static_cast<int8_t *>(memory);
+    for (size_t g = 0; g < panels.size(); ++g) {
+      memcpy(copy + g * panel_size_, panels[g], panel_size);
+    }
+    return copy;
+  }
+
+  size_t panel_size_;
+  size_t panel_num_;
+  std::vector<int8_t *> owned_;
+  std::vector<int8_t *> node_copy_;
+};
+
+// The panel g a GEMM thread reads, pa when the weight is not placed
+INLINE_SPECIFIER int8_t *NumaLocalPanel(const NumaWeight *numa_weight, int8_t *pa, size_t g = 0) {
+  return ((numa_weight == NULL) || !numa_weight->Placed()) ? pa : numa_weight->Panel(GetCurrentNumaNode(), g);
+}
+#endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OPS_DEPTHWISE_DEPTHWISE_H
+#define OPS_DEPTHWISE_DEPTHWISE_H
+
+#include "../../base.h"
+#include "../../common.h"
+#include "../kernel-common.h"
+
+// Every output channel of a depthwise convolution only reads its own input channel, so instead of one GEMM with a
+// single row per channel the channels of an NHWC pixel are processed side by side, PS_OPERAND_WIDTH at a time. The
+// data is quantized to u8 per channel and the weight to s8 per channel. The taps are taken in pairs, the two u8 x s8
+// products of a channel summed by madd into its s32 accumulator, so no intermediate saturation is possible.
+namespace depthwise {
+
+// The u8 of two taps for PS_OPERAND_WIDTH channels, interleaved per channel and widened to s16
+static INLINE_SPECIFIER SIMDSITYPE INLINE_ATTRIBUTE LoadU8PairAsEPI16(const uint8_t *first, const uint8_t *second) {
+#if defined(AVX512)
+  __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(second));
+  return _mm512_cvtepu8_epi16(
+      _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(a, b)), _mm_unpackhi_epi8(a, b), 1));
+#elif defined(__AVX2__)
+  __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(first));
+  __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(second));
+  return _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(a, b));
+#else
+  int32_t a, b;
+  memcpy(&a, first, sizeof(a));
+  memcpy(&b, second, sizeof(b));
+  return _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b)));
+#endif
+}
+
+// 2 * PS_OPERAND_WIDTH s8 widened to s16
+static INLINE_SPECIFIER SIMDSITYPE INLINE_ATTRIBUTE LoadS8AsEPI16(const int8_t *src) {
+#if defined(AVX512)
+  return _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+#elif defined(__AVX2__)
+  return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+#else
+  return _mm_cvtepi8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)));
+#endif
+}
+
+// PS_OPERAND_WIDTH floats within [0, 255] rounded and stored as u8
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE StorePSAsU8(uint8_t *dst, SIMDPSTYPE value) {
+#if defined(AVX512)
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm512_cvtusepi32_epi8(_mm512_cvtps_epi32(value)));
+#elif defined(__AVX2__)
+  __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(_mm256_cvtps_epi32(value), _mm256_setzero_si256()),
+                                       _mm256_setzero_si256());
+  // the 4 bytes of each 128 bit lane next to each other
+  packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm256_castsi256_si128(packed));
+#else
+  __m128i packed = _mm_packus_epi16(_mm_packus_epi32(_mm_cvtps_epi32(value), _mm_setzero_si128()), _mm_setzero_si128());
+  int32_t bytes = _mm_cvtsi128_si32(packed);
+  memcpy(dst, &bytes, sizeof(bytes));
+#endif
+}
+
+// Range of every channel over spatial_size NHWC pixels. Zero is always part of the range, it is the value of the
+// padded border. workspace holds 2 * channel floats per thread.
+void NHWCFindMinMaxPerChannel(float *min, float *max, const float *data, size_t spatial_size, size_t channel,
+                              float *workspace) {
+  size_t used_threads_num = 1;
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    if (thread_id == 0) {
+      used_threads_num = threads_num;
+    }
+    float *local_min = workspace + thread_id * 2 * channel;
+    float *local_max = local_min + channel;
+    memset(local_min, 0, sizeof(float) * 2 * channel);
+    for (size_t s = ThreadRangeBegin(spatial_size, thread_id, threads_num);
+         s < ThreadRangeBegin(spatial_size, thread_id + 1, threads_num); ++s) {
+      const float *row = data + s * channel;
+      size_t c = 0;
+      for (; c + PS_OPERAND_WIDTH <= channel; c += PS_OPERAND_WIDTH) {
+        SIMDPSTYPE value = LOADU_PS(row + c);
+        STOREU_PS(local_min + c, MIN_PS(LOADU_PS(local_min + c), value));
+        STOREU_PS(local_max + c, MAX_PS(LOADU_PS(local_max + c), value));
+      }
+      for (; c < channel; ++c) {
+        local_min[c] = std::min(local_min[c], row[c]);
+        local_max[c] = std::max(local_max[c], row[c]);
+      }
+    }
+  });
+  memcpy(min, workspace, sizeof(float) * channel);
+  memcpy(max, workspace + channel, sizeof(float) * channel);
+  for (size_t t = 1; t < used_threads_num; ++t) {
+    const float *local_min = workspace + t * 2 * channel;
+    const float *local_max = local_min + channel;
+    for (size_t c = 0; c < channel; ++c) {
+      min[c] = std::min(min[c], local_min[c]);
+      max[c] = std::max(max[c], local_max[c]);
+    }
+  }
+}
+
+// dst = round(src * scale + shift) per channel, clamped to the u8 range
+void NHWCQuantizeByChannel(uint8_t *dst, const float *src, size_t spatial_size, size_t channel, const float *scale,
+                           const float *shift) {
+  ParallelFor(spatial_size, [&](size_t s) {
+    const float *row = src + s * channel;
+    uint8_t *quantized_row = dst + s * channel;
+    size_t c = 0;
+    for (; c + PS_OPERAND_WIDTH <= channel; c += PS_OPERAND_WIDTH) {
+      SIMDPSTYPE value = FMA_PS(LOADU_PS(row + c), LOADU_PS(scale + c), LOADU_PS(shift + c));
+      StorePSAsU8(quantized_row + c, MIN_PS(MAX_PS(value, ZERO_PS()), SET1_PS(255.0f)));
+    }
+    for (; c < channel; ++c) {
+      float value = std::min(std::max(row[c] * scale[c] + shift[c], 0.0f), 255.0f);
+      quantized_row[c] = static_cast<uint8_t>(value + 0.5f);
+    }
+  });
+}
+
+// data is batch_size x height x width x channel u8, weight is (kernel_h x kernel_w + 1) / 2 pairs x channel x 2 s8,
+// the second tap of the last pair zero for an odd kernel. Taps falling into the padded border read zero_point, the u8
+// value of zero for every channel. Every output is
+//   result = sum * out_scale + out_shift, then max(result, 0) with relu, then result * post_scale + post_shift
+// if post_scale is given, written as NHWC or NCHW. taps_workspace holds 2 * pairs pointers per thread.
+void NHWCDepthwiseConv(float *out, const uint8_t *data, const int8_t *weight, size_t batch_size, size_t channel,
+                       size_t height, size_t width, size_t kernel_h, size_t kernel_w, size_t pad_h, size_t pad_w,
+                       size_t stride_h, size_t stride_w, size_t dilation_h, size_t dilation_w, size_t height_out,
+                       size_t width_out, const uint8_t *zero_point, const float *out_scale, const float *out_shift,
+                       const uint8_t **taps_workspace, LAYOUT layout, bool relu, const float *post_scale,
+                       const float *post_shift) {
+  size_t kernel_size = kernel_h * kernel_w;
+  size_t pairs = (kernel_size + 1) / 2;
+  size_t out_spatial_size = height_out * width_out;
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    const uint8_t **taps = taps_workspace + thread_id * 2 * pairs;
+    // read against the zero weight closing an odd kernel
+    taps[2 * pairs - 1] = zero_point;
+    float lane[PS_OPERAND_WIDTH];
+    for (size_t row = ThreadRangeBegin(batch_size * height_out, thread_id, threads_num);
+         row < ThreadRangeBegin(batch_size * height_out, thread_id + 1, threads_num); ++row) {
+      size_t n = row / height_out;
+      size_t y = row % height_out;
+      for (size_t x = 0; x < width_out; ++x) {
+        for (size_t ky = 0; ky < kernel_h; ++ky) {
+          for (size_t kx = 0; kx < kernel_w; ++kx) {
+            int in_y = static_cast<int>(y * stride_h + ky * dilation_h) - static_cast<int>(pad_h);
+            int in_x = static_cast<int>(x * stride_w + kx * dilation_w) - static_cast<int>(pad_w);
+            bool inside = (in_y >= 0) && (in_y < static_cast<int>(height)) && (in_x >= 0) &&
+                          (in_x < static_cast<int>(width));
+            taps[ky * kernel_w + kx] = inside ? data + ((n * height + in_y) * width + in_x) * channel : zero_point;
+          }
+        }
+        size_t out_pixel = (n * height_out + y) * width_out + x;
+        size_t c = 0;
+        for (; c + PS_OPERAND_WIDTH <= channel; c += PS_OPERAND_WIDTH) {
+          SIMDSITYPE sum = ZEROS();
+          for (size_t p = 0; p < pairs; ++p) {
+            SIMDSITYPE value = LoadU8PairAsEPI16(taps[2 * p] + c, taps[2 * p + 1] + c);
+            sum = ADD_EPI32(sum, MADD_EPI16(value, LoadS8AsEPI16(weight + (p * channel + c) * 2)));
+          }
+          SIMDPSTYPE result = FMA_PS(EPI32TOPS(sum), LOADU_PS(out_scale + c), LOADU_PS(out_shift + c));
+          if (relu) {
+            result = MAX_PS(result, ZERO_PS());
+          }
+          if (post_scale != NULL) {
+            result = FMA_PS(result, LOADU_PS(post_scale + c), LOADU_PS(post_shift + c));
+          }
+          if (layout == NHWC) {
+            STOREU_PS(out + out_pixel * channel + c, result);
+          } else {
+            STOREU_PS(lane, result);
+            for (size_t i = 0; i < PS_OPERAND_WIDTH; ++i) {
+              out[((n * channel + c + i) * out_spatial_size) + y * width_out + x] = lane[i];
+            }
+          }
+        }
+        for (; c < channel; ++c) {
+          int32_t sum = 0;
+          for (size_t p = 0; p < pairs; ++p) {
+            const int8_t *pair = weight + (p * channel + c) * 2;
+            sum += taps[2 * p][c] * pair[0] + taps[2 * p + 1][c] * pair[1];
+          }
+          float result = static_cast<float>(sum) * out_scale[c] + out_shift[c];
+          if (relu) {
+            result = fmaxf(result, 0.0f);
+          }
+          if (post_scale != NULL) {
+            result = result * post_scale[c] + post_shift[c];
+          }
+          if (layout == NHWC) {
+            out[out_pixel * channel + c] = result;
+          } else {
+            out[((n * channel + c) * out_spatial_size) + y * width_out + x] = result;
+          }
+        }
+      }
+    }
+  });
+}
+}
+#endif
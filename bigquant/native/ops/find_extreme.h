@@ -18,6 +18,7 @@
 #define OPS_FIND_EXTREME_H
 
 #include "../base.h"
+#include "../parallel.h"
 
 template <typename DType>
 void GenericFindMinMaxValue(const DType *p, size_t length, DType &min, DType &max) {
@@ -140,17 +141,23 @@ void FindMinMaxValue<float>(const float *p, size_t length, float &min, float &ma
 
 template <typename DType>
 void OMPFindMinMaxValue(DType *p, size_t length, DType &min_value, DType &max_value) {
-  DType min = FLT_MAX;
-  DType max = -FLT_MAX;
-#pragma omp parallel for reduction(min : min) reduction(max : max)
-  for (size_t i = 0; i < length; ++i) {
-    DType value = p[i];
-    min = fminf(min, value);
-    max = fmaxf(max, value);
-  }
-  // such assignment is because icpc openmp cannot support reference reduction
-  min_value = min;
-  max_value = max;
+  // One partial extreme per thread, reduced serially
+  std::vector<DType> partial_min(GetMaxThreadsNum(), FLT_MAX);
+  std::vector<DType> partial_max(GetMaxThreadsNum(), -FLT_MAX);
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    DType min = FLT_MAX;
+    DType max = -FLT_MAX;
+    for (size_t i = ThreadRangeBegin(length, thread_id, threads_num);
+         i < ThreadRangeBegin(length, thread_id + 1, threads_num); ++i) {
+      DType value = p[i];
+      min = fminf(min, value);
+      max = fmaxf(max, value);
+    }
+    partial_min[thread_id] = min;
+    partial_max[thread_id] = max;
+  });
+  min_value = *std::min_element(partial_min.begin(), partial_min.end());
+  max_value = *std::max_element(partial_max.begin(), partial_max.end());
 }
 
 #endif
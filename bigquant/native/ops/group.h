@@ -18,6 +18,7 @@
 #define OPS_GROUP_H
 
 #include "../base.h"
+#include "../parallel.h"
 
 template <typename DType, LAYOUT layout>
 void UnGroupKernel(DType* dst[], DType* src, size_t group, size_t channel_out, size_t channel_in, size_t hxw) {
@@ -28,17 +29,15 @@ void UnGroupKernel(DType* dst[], DType* src, size_t group, size_t channel_out, s
     // for NCHW, there's no need to ungroup kernel
     assert(false);
   } else {  // NHWC
-#pragma omp parallel for proc_bind(close) collapse(3)
-    for (size_t g = 0; g < group; ++g) {
-      for (size_t c_out = 0; c_out < channel_out_per_group; ++c_out) {
-        for (size_t i = 0; i < hxw; ++i) {
-          size_t dst_index = c_out * hxw * channel_in_per_group + i * channel_in_per_group;
-          size_t src_index =
-              (g * channel_out_per_group + c_out) * hxw * channel_in_per_group + i * channel_in_per_group;
-          std::memcpy(dst[g] + dst_index, src + src_index, sizeof(DType) * channel_in_per_group);
-        }
-      }
-    }
+    ParallelFor(group * channel_out_per_group * hxw, [&](size_t idx) {
+      size_t g = idx / (channel_out_per_group * hxw);
+      size_t c_out = idx / hxw % channel_out_per_group;
+      size_t i = idx % hxw;
+      size_t dst_index = c_out * hxw * channel_in_per_group + i * channel_in_per_group;
+      size_t src_index =
+          (g * channel_out_per_group + c_out) * hxw * channel_in_per_group + i * channel_in_per_group;
+      std::memcpy(dst[g] + dst_index, src + src_index, sizeof(DType) * channel_in_per_group);
+    });
   }
 }
 #endif
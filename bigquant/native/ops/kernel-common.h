@@ -79,6 +79,15 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE PRELU(SIMDPSTYPE &result, const SI
   result = MAX_PS(result, threshold);
 }
 
+// c += the int32 dot products of 4 adjacent u8 x s8 pairs, for s8 weights of the full range. MADD_EPI8 alone may
+// saturate its int16 pair sums then, so the u8 operand is split into its low 7 bits and its top bit and each half is
+// widened to int32 right away.
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ExactDotAccumulate(SIMDSITYPE &c, const SIMDSITYPE &b_low,
+                                                                 const SIMDSITYPE &b_high, const SIMDSITYPE &a,
+                                                                 const SIMDSITYPE &ones) {
+  c = ADD_EPI32(c, ADD_EPI32(MADD_EPI16(MADD_EPI8(b_low, a), ones), MADD_EPI16(MADD_EPI8(b_high, a), ones)));
+}
+
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE BN(SIMDPSTYPE &result, const SIMDPSTYPE &global_mean,
                                                  const SIMDPSTYPE &mul_variance_coeff, const SIMDPSTYPE &scale,
                                                  const SIMDPSTYPE &shift) {
@@ -99,4 +108,84 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ScalarBN(float &result, const floa
   result += shift;
 }
 
+// Apply the post ops selected by the fusion flags to one output channel of the GEMM result, in the order the flag
+// names them. The bn parameters are indexed by the output channel inside the current group.
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE Fusion(SIMDPSTYPE &result, size_t channel, bool conv_relu_fusion,
+                                                     bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                     bool conv_relu_bn_fusion, float *global_mean,
+                                                     float *mul_variance_coeff, float *scale, float *shift) {
+  if (conv_relu_fusion || conv_relu_bn_fusion) {
+    PRELU(result, ZERO_PS());
+  }
+  if (conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    BN(result, SET1_PS(global_mean[channel]), SET1_PS(mul_variance_coeff[channel]),
+       SET1_PS((scale == NULL) ? 1.0f : scale[channel]), SET1_PS((shift == NULL) ? 0.0f : shift[channel]));
+  }
+  if (conv_bn_relu_fusion) {
+    PRELU(result, ZERO_PS());
+  }
+}
+
+#if defined(AVX512)
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE FusionHalf(SIMDPSTYPEHALF &result, size_t channel, bool conv_relu_fusion,
+                                                         bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                         bool conv_relu_bn_fusion, float *global_mean,
+                                                         float *mul_variance_coeff, float *scale, float *shift) {
+  if (conv_relu_fusion || conv_relu_bn_fusion) {
+    result = MAX_PS_HALF(result, SET1_PS_HALF(0.0f));
+  }
+  if (conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    result = MUL_PS_HALF(SUB_PS_HALF(result, SET1_PS_HALF(global_mean[channel])),
+                         SET1_PS_HALF(mul_variance_coeff[channel]));
+    result = FMA_PS_HALF(result, SET1_PS_HALF((scale == NULL) ? 1.0f : scale[channel]),
+                         SET1_PS_HALF((shift == NULL) ? 0.0f : shift[channel]));
+  }
+  if (conv_bn_relu_fusion) {
+    result = MAX_PS_HALF(result, SET1_PS_HALF(0.0f));
+  }
+}
+#endif
+
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ScalarFusion(float &result, size_t channel, bool conv_relu_fusion,
+                                                           bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                           bool conv_relu_bn_fusion, float *global_mean,
+                                                           float *mul_variance_coeff, float *scale, float *shift) {
+  if (conv_relu_fusion || conv_relu_bn_fusion) {
+    result = fmaxf(result, 0.0f);
+  }
+  if (conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    ScalarBN(result, global_mean[channel], mul_variance_coeff[channel], (scale == NULL) ? 1.0f : scale[channel],
+             (shift == NULL) ? 0.0f : shift[channel]);
+  }
+  if (conv_bn_relu_fusion) {
+    result = fmaxf(result, 0.0f);
+  }
+}
+
+// u8 NHWC destination of a GEMM whose output is requantized in place of being written as floats,
+// q = round(x * inv_scale + zero_point) clamped to [0, upper]
+struct OutputRequantization {
+  uint8_t *data_;
+  float inv_scale_;
+  float zero_point_;
+  float upper_;
+};
+
+// The kernel wrote its tile NHWC into a kernel_n x kernel_m buffer, one pixel per row, tile_n pixels of tile_m valid
+// channels. Only their u8 values reach the output, starting at channel of pixel.
+template <size_t kernel_m, size_t kernel_n>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE RequantizeTile(const OutputRequantization &requantize, const float *tile,
+                                                             size_t tile_m, size_t tile_n, size_t pixel,
+                                                             size_t channel, size_t total_channels) {
+  for (size_t ky = 0; ky < tile_n; ++ky) {
+    const float *src = tile + ky * kernel_m;
+    uint8_t *dst = requantize.data_ + (pixel + ky) * total_channels + channel;
+    for (size_t kx = 0; kx < tile_m; ++kx) {
+      float value = std::min(std::max(src[kx] * requantize.inv_scale_ + requantize.zero_point_, 0.0f),
+                             requantize.upper_);
+      dst[kx] = static_cast<uint8_t>(value + 0.5f);
+    }
+  }
+}
+
 #endif
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OPS_SHUFFLE_KERNEL_AMX_IGEMM_16X16X64_H
+#define OPS_SHUFFLE_KERNEL_AMX_IGEMM_16X16X64_H
+#include "../../base.h"
+#include "../../arch/cpuid.h"
+#include "../kernel-common.h"
+
+// One kernel call multiplies a 16(n) x k u8 data panel with a 16(m) x k s8 weight panel. Every 64 wide k block of the
+// data panel is a row major 16x64 tile, the weight block is the same tile in VNNI order (see shuffle::VNNIShuffle2D),
+// so both are loaded straight from the shuffled panels. The int32 accumulator tile is laid out as [n][m].
+namespace kernel {
+namespace amx_igemm16x16x64 {
+
+static const size_t kTileRows = 16;
+static const size_t kTileBytesPerRow = 64;
+static const size_t kTileSize = kTileRows * kTileBytesPerRow;
+
+// Scalar model of tdpbusd. Does not depend on the target ISA so the packing can be checked on any machine.
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ReferenceTileDPBUSD(int32_t c[], const uint8_t *a, const int8_t *b) {
+  for (size_t n = 0; n < kTileRows; ++n) {
+    for (size_t m = 0; m < kTileRows; ++m) {
+      int32_t sum = c[n * kTileRows + m];
+      for (size_t r = 0; r < kTileRows; ++r) {
+        for (size_t t = 0; t < 4; ++t) {
+          sum += static_cast<int32_t>(a[n * kTileBytesPerRow + r * 4 + t]) *
+                 static_cast<int32_t>(b[r * kTileBytesPerRow + m * 4 + t]);
+        }
+      }
+      c[n * kTileRows + m] = sum;
+    }
+  }
+}
+
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ReferenceKernelReduce(const int8_t *pa, const uint8_t *pb, int32_t c[],
+                                                                    size_t length) {
+  for (size_t i = 0; i < length; i += kTileBytesPerRow) {
+    ReferenceTileDPBUSD(c, pb, pa);
+    pa += kTileSize;
+    pb += kTileSize;
+  }
+}
+
+#if defined(AMX)
+#if defined(__AMX_INT8__) && !defined(AMX_EMULATION)
+struct TileConfig {
+  uint8_t palette_id_;
+  uint8_t start_row_;
+  uint8_t reserved_[14];
+  uint16_t colsb_[16];
+  uint8_t rows_[16];
+};
+
+static INLINE_SPECIFIER TileConfig INLINE_ATTRIBUTE MakeTileConfig() {
+  TileConfig config;
+  memset(&config, 0, sizeof(config));
+  config.palette_id_ = 1;
+  for (size_t t = 0; t < 6; ++t) {
+    config.colsb_[t] = kTileBytesPerRow;
+    config.rows_[t] = kTileRows;
+  }
+  return config;
+}
+
+// tmm0/tmm1 accumulate even/odd k blocks, tmm2/tmm3 hold data tiles and tmm4/tmm5 weight tiles. The configuration is
+// thread state shared with the other AMX users of the process (oneDNN, MKL), which may release the tiles or load
+// their own palette between two of our GEMMs. Hence every parallel task of a GEMM holds a TileScope, which loads the
+// configuration before the first kernel and releases the tiles after the last one.
+struct TileScope {
+  TileScope() {
+    static const bool permitted = cpuid_request_amx_permission();
+    if (permitted == false) {
+      fprintf(stderr, "AMX tile data is not enabled by the OS.\n");
+      exit(-1);
+    }
+    static const TileConfig config = MakeTileConfig();
+    _tile_loadconfig(&config);
+  }
+
+  ~TileScope() {
+    _tile_release();
+  }
+
+  TileScope(const TileScope &) = delete;
+
+  TileScope &operator=(const TileScope &) = delete;
+};
+
+// Only within a TileScope
+
+template <size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE KernelReduce(int8_t *&pa, uint8_t *&pb, int32_t sum[], size_t length) {
+  int32_t odd_sum[kTileRows * kTileRows] __attribute__((aligned(64)));
+  size_t num = length / (2 * kernel_k);
+  _tile_zero(0);
+  _tile_zero(1);
+  for (size_t i = 0; i < num; ++i) {
+    _tile_loadd(2, pb, kTileBytesPerRow);
+    _tile_loadd(4, pa, kTileBytesPerRow);
+    _tile_loadd(3, pb + kTileSize, kTileBytesPerRow);
+    _tile_loadd(5, pa + kTileSize, kTileBytesPerRow);
+    _tile_dpbusd(0, 2, 4);
+    _tile_dpbusd(1, 3, 5);
+    pa += 2 * kTileSize;
+    pb += 2 * kTileSize;
+  }
+  if (length % (2 * kernel_k) != 0) {
+    _tile_loadd(2, pb, kTileBytesPerRow);
+    _tile_loadd(4, pa, kTileBytesPerRow);
+    _tile_dpbusd(0, 2, 4);
+    pa += kTileSize;
+    pb += kTileSize;
+  }
+  _tile_stored(0, sum, kTileRows * sizeof(int32_t));
+  _tile_stored(1, odd_sum, kTileRows * sizeof(int32_t));
+  for (size_t i = 0; i < kTileRows * kTileRows; ++i) {
+    sum[i] += odd_sum[i];
+  }
+}
+#else
+// AMX_EMULATION builds the whole AMX tier on top of the scalar model, for hosts or compilers without AMX
+struct TileScope {
+  TileScope() {
+  }
+};
+
+template <size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE KernelReduce(int8_t *&pa, uint8_t *&pb, int32_t sum[], size_t length) {
+  memset(sum, 0, sizeof(int32_t) * kTileRows * kTileRows);
+  ReferenceKernelReduce(pa, pb, sum, length);
+  pa += length * kTileRows;
+  pb += length * kTileRows;
+}
+#endif
+
+// Per lane variant of Fusion, the lanes are 16 consecutive output channels
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ChannelFusion(SIMDPSTYPE &result, size_t channel, bool conv_relu_fusion,
+                                                            bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                            bool conv_relu_bn_fusion, float *global_mean,
+                                                            float *mul_variance_coeff, float *scale, float *shift) {
+  if (conv_relu_fusion || conv_relu_bn_fusion) {
+    PRELU(result, ZERO_PS());
+  }
+  if (conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    BN(result, LOADU_PS(global_mean + channel), LOADU_PS(mul_variance_coeff + channel),
+       (scale == NULL) ? SET1_PS(1.0f) : LOADU_PS(scale + channel),
+       (shift == NULL) ? ZERO_PS() : LOADU_PS(shift + channel));
+  }
+  if (conv_bn_relu_fusion) {
+    PRELU(result, ZERO_PS());
+  }
+}
+
+template <size_t kernel_m, size_t kernel_n>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE CommitResult(int32_t sum[], void *result[], size_t length,
+                                                           size_t valid_lanes) {
+  for (size_t m = 0; m < length; ++m) {
+    for (size_t n = 0; n < valid_lanes; ++n) {
+      *(reinterpret_cast<int *>(result[m]) + n) = sum[n * kernel_m + m];
+    }
+  }
+}
+
+// result[n * kernel_m] points at 16 consecutive output channels of pixel j_index + n
+template <size_t kernel_m, size_t kernel_n>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE NHWCBlockFMA(int32_t sum[], float *result[], size_t length,
+                                                           size_t valid_lanes, size_t i_index, size_t j_index,
+                                                           float *ratio_a, float *ratio_b, float *min_b,
+                                                           float *kernel_sum, float *bias, bool conv_relu_fusion,
+                                                           bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                           bool conv_relu_bn_fusion, float *global_mean,
+                                                           float *mul_variance_coeff, float *scale, float *shift) {
+  SIMDPSTYPE simd_ratio_a = LOADU_PS(ratio_a + i_index);
+  SIMDPSTYPE simd_kernel_sum = LOADU_PS(kernel_sum + i_index);
+  SIMDPSTYPE simd_bias = (bias == NULL) ? ZERO_PS() : LOADU_PS(bias + i_index);
+  for (size_t n = 0; n < kernel_n; ++n) {
+    SIMDPSTYPE isum = EPI32TOPS(LOAD_SI(reinterpret_cast<SIMDSITYPE *>(sum + n * kernel_m)));
+    SIMDPSTYPE value = FMA_PS(isum, MUL_PS(simd_ratio_a, SET1_PS(ratio_b[j_index + n])),
+                              FMA_PS(simd_kernel_sum, SET1_PS(min_b[j_index + n]), simd_bias));
+    ChannelFusion(value, i_index, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+                  global_mean, mul_variance_coeff, scale, shift);
+    STOREU_PS(result[n * kernel_m], value);
+  }
+}
+
+// result[m * kernel_n] points at 16 consecutive pixels of output channel i_index + m, so the accumulator is read
+// column wise
+template <size_t kernel_m, size_t kernel_n>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE NCHWBlockFMA(int32_t sum[], float *result[], size_t length,
+                                                           size_t valid_lanes, size_t i_index, size_t j_index,
+                                                           float *ratio_a, float *ratio_b, float *min_b,
+                                                           float *kernel_sum, float *bias, bool conv_relu_fusion,
+                                                           bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                                                           bool conv_relu_bn_fusion, float *global_mean,
+                                                           float *mul_variance_coeff, float *scale, float *shift) {
+  const SIMDSITYPE column_index = SET_EPI32(240, 224, 208, 192, 176, 160, 144, 128, 112, 96, 80, 64, 48, 32, 16, 0);
+  SIMDPSTYPE simd_ratio_b = LOADU_PS(ratio_b + j_index);
+  SIMDPSTYPE simd_min_b = LOADU_PS(min_b + j_index);
+  for (size_t m = 0; m < kernel_m; ++m) {
+    SIMDPSTYPE isum = EPI32TOPS(_mm512_i32gather_epi32(column_index, sum + m, 4));
+    SIMDPSTYPE value = FMA_PS(isum, MUL_PS(SET1_PS(ratio_a[i_index + m]), simd_ratio_b),
+                              FMA_PS(simd_min_b, SET1_PS(kernel_sum[i_index + m]),
+                                     SET1_PS((bias == NULL) ? 0.0f : bias[i_index + m])));
+    Fusion(value, i_index + m, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+           mul_variance_coeff, scale, shift);
+    STOREU_PS(result[m * kernel_n], value);
+  }
+}
+
+template <size_t kernel_m, size_t kernel_n>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE FMAResult(int32_t sum[], float *result[], size_t length,
+                                                        size_t valid_lanes, size_t i_index, size_t j_index,
+                                                        float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum,
+                                                        float *bias, bool conv_relu_fusion, bool conv_bn_fusion,
+                                                        bool conv_bn_relu_fusion, bool conv_relu_bn_fusion,
+                                                        float *global_mean, float *mul_variance_coeff, float *scale,
+                                                        float *shift) {
+  for (size_t m = 0; m < length; ++m) {
+    for (size_t n = 0; n < valid_lanes; ++n) {
+      float value = ratio_a[i_index + m] * ratio_b[j_index + n] * sum[n * kernel_m + m] +
+                    kernel_sum[i_index + m] * min_b[j_index + n] + ((bias == NULL) ? 0.0f : bias[i_index + m]);
+      ScalarFusion(value, i_index + m, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+                   global_mean, mul_variance_coeff, scale, shift);
+      *(reinterpret_cast<float *>(result[m * kernel_n + n])) = value;
+    }
+  }
+}
+
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(int8_t *&pa, uint8_t *&pb, size_t k,
+                                                                 float fault_tolerance, void *result[], size_t length,
+                                                                 size_t valid_lanes) {
+  assert((kernel_m == 16) && (kernel_n == 16) && (kernel_k == 64));
+  int32_t sum[kernel_n * kernel_m] __attribute__((aligned(64)));
+  KernelReduce<kernel_k>(pa, pb, sum, k);
+  CommitResult<kernel_m, kernel_n>(sum, result, length, valid_lanes);
+}
+
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(
+    int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
+    size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
+    bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, bool exact_reduce) {
+  assert((kernel_m == 16) && (kernel_n == 16) && (kernel_k == 64));
+  // tdpbusd accumulates in int32, so exact_reduce needs no separate path
+  int32_t sum[kernel_n * kernel_m] __attribute__((aligned(64)));
+  KernelReduce<kernel_k>(pa, pb, sum, k);
+  if (is_block == false) {
+    FMAResult<kernel_m, kernel_n>(sum, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b,
+                                  kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                                  conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+  } else if (layout == NCHW) {
+    NCHWBlockFMA<kernel_m, kernel_n>(sum, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b,
+                                     kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                                     conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+  } else {
+    NHWCBlockFMA<kernel_m, kernel_n>(sum, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b,
+                                     kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                                     conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+  }
+}
+
+template <typename DType, size_t kernel_m, size_t kernel_n, size_t kernel_k>
+static INLINE_SPECIFIER bool INLINE_ATTRIBUTE NHWCRTGenrateTargetAddr(DType *result[], DType *pc, size_t valid_m,
+                                                                      size_t valid_n, size_t i_index, size_t j_index,
+                                                                      size_t cur_group, size_t channel_per_group,
+                                                                      size_t total_channels) {
+  if ((valid_m - i_index) >= kernel_m && (valid_n - j_index) >= kernel_n) {
+    NHWCGenrateBlockTargetAddr<float, kernel_m, kernel_n>(result, pc, valid_m, valid_n, i_index, j_index, cur_group,
+                                                          channel_per_group, total_channels);
+    return true;
+  } else {
+    NHWCGenrateTargetAddr<float, kernel_m, kernel_n>(result, pc, valid_m, valid_n, i_index, j_index, cur_group,
+                                                     channel_per_group, total_channels);
+    return false;
+  }
+}
+
+template <typename DType, size_t kernel_m, size_t kernel_n, size_t kernel_k>
+static INLINE_SPECIFIER bool INLINE_ATTRIBUTE NCHWRTGenrateTargetAddr(
+    DType *result[], DType *pc, size_t valid_m, size_t valid_n, size_t i_index, size_t j_index, size_t cur_group,
+    size_t feature_map_size_per_image, size_t feature_map_size_per_group, size_t feature_map_size_per_channel) {
+  size_t b0 = j_index / feature_map_size_per_channel;
+  size_t b1 = (j_index + kernel_n) / feature_map_size_per_channel;
+  if ((valid_m - i_index) >= kernel_m && (valid_n - j_index) >= kernel_n && (b0 == b1)) {
+    NCHWGenrateBlockTargetAddr<float, kernel_m, kernel_n>(result, pc, valid_m, valid_n, i_index, j_index, cur_group,
+                                                          feature_map_size_per_image, feature_map_size_per_group,
+                                                          feature_map_size_per_channel);
+    return true;
+  } else {
+    NCHWGenrateTargetAddr<float, kernel_m, kernel_n>(result, pc, valid_m, valid_n, i_index, j_index, cur_group,
+                                                     feature_map_size_per_image, feature_map_size_per_group,
+                                                     feature_map_size_per_channel);
+    return false;
+  }
+}
+#endif
+}
+}
+#endif
@@ -92,6 +92,71 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE AVX2Kernel4x8x8(int8_t *&pa, uint8
   pa += 32;
   pb += 64;
 }
+
+// Same tile and int32 lane layout as AVXVNNIKernel4x8x8, for the ISAs without vpdpbusd
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE AVX2ExactKernel4x8x8(int8_t *&pa, uint8_t *&pb, SIMDSITYPE &c11,
+                                                                   SIMDSITYPE &c12, SIMDSITYPE &c21, SIMDSITYPE &c22,
+                                                                   SIMDSITYPE &c31, SIMDSITYPE &c32, SIMDSITYPE &c41,
+                                                                   SIMDSITYPE &c42) {
+  SIMDSITYPE ones = SET1_EPI16(1);
+  SIMDSITYPE low_mask = SET1_EPI8(0x7f);
+  SIMDSITYPE b1 = LOAD_SI256(reinterpret_cast<SIMDSITYPE *>(pb));
+  SIMDSITYPE b2 = LOAD_SI256(reinterpret_cast<SIMDSITYPE *>(pb + 32));
+  SIMDSITYPE b1_low = AND_SI(b1, low_mask);
+  SIMDSITYPE b1_high = ANDNOT_SI(low_mask, b1);
+  SIMDSITYPE b2_low = AND_SI(b2, low_mask);
+  SIMDSITYPE b2_high = ANDNOT_SI(low_mask, b2);
+
+  SIMDSITYPE a1 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa)));
+  ExactDotAccumulate(c11, b1_low, b1_high, a1, ones);
+  ExactDotAccumulate(c12, b2_low, b2_high, a1, ones);
+
+  SIMDSITYPE a2 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 8)));
+  ExactDotAccumulate(c21, b1_low, b1_high, a2, ones);
+  ExactDotAccumulate(c22, b2_low, b2_high, a2, ones);
+
+  SIMDSITYPE a3 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 16)));
+  ExactDotAccumulate(c31, b1_low, b1_high, a3, ones);
+  ExactDotAccumulate(c32, b2_low, b2_high, a3, ones);
+
+  SIMDSITYPE a4 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 24)));
+  ExactDotAccumulate(c41, b1_low, b1_high, a4, ones);
+  ExactDotAccumulate(c42, b2_low, b2_high, a4, ones);
+
+  pa += 32;
+  pb += 64;
+}
+
+#if defined(__AVXVNNI__)
+// Same tile as AVX2Kernel4x8x8, but every int32 lane of c holds the dot product of 4 adjacent bytes, which is exactly
+// what MADD_EPI16(c, ones) produces from the int16 accumulators above, without the int16 saturation.
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE AVXVNNIKernel4x8x8(int8_t *&pa, uint8_t *&pb, SIMDSITYPE &c11,
+                                                                 SIMDSITYPE &c12, SIMDSITYPE &c21, SIMDSITYPE &c22,
+                                                                 SIMDSITYPE &c31, SIMDSITYPE &c32, SIMDSITYPE &c41,
+                                                                 SIMDSITYPE &c42) {
+  SIMDSITYPE b1 = LOAD_SI256(reinterpret_cast<SIMDSITYPE *>(pb));
+  SIMDSITYPE b2 = LOAD_SI256(reinterpret_cast<SIMDSITYPE *>(pb + 32));
+
+  SIMDSITYPE a1 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa)));
+  c11 = DPBUSD_EPI32(c11, b1, a1);
+  c12 = DPBUSD_EPI32(c12, b2, a1);
+
+  SIMDSITYPE a2 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 8)));
+  c21 = DPBUSD_EPI32(c21, b1, a2);
+  c22 = DPBUSD_EPI32(c22, b2, a2);
+
+  SIMDSITYPE a3 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 16)));
+  c31 = DPBUSD_EPI32(c31, b1, a3);
+  c32 = DPBUSD_EPI32(c32, b2, a3);
+
+  SIMDSITYPE a4 = reinterpret_cast<SIMDSITYPE>(BROADCASTLOAD_PD(reinterpret_cast<double *>(pa + 24)));
+  c41 = DPBUSD_EPI32(c41, b1, a4);
+  c42 = DPBUSD_EPI32(c42, b2, a4);
+
+  pa += 32;
+  pb += 64;
+}
+#endif
 #else
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE SSE42Kernel4x4x8(int8_t *&pa, uint8_t *&pb, SIMDSITYPE &c11,
                                                                SIMDSITYPE &c12, SIMDSITYPE &c21, SIMDSITYPE &c22,
@@ -174,6 +239,41 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE PostHaddReduce(SIMDSITYPE &c11, SI
 #endif
 }
 
+#ifdef __AVX2__
+// The int32 accumulators of AVXVNNIKernel4x8x8 and AVX2ExactKernel4x8x8 do not need to be drained every UNROLL_NUM
+// steps
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE VNNIPairReduce(SIMDSITYPE &c1, SIMDSITYPE &c2, SIMDSITYPE &sum,
+                                                             SIMDSITYPE &threshold, SIMDSITYPE &ones) {
+}
+
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE PostVNNIReduce(SIMDSITYPE &c11, SIMDSITYPE &c12, SIMDSITYPE &c21,
+                                                             SIMDSITYPE &c22, SIMDSITYPE &c31, SIMDSITYPE &c32,
+                                                             SIMDSITYPE &c41, SIMDSITYPE &c42, SIMDSITYPE &sum1,
+                                                             SIMDSITYPE &sum2, SIMDSITYPE &sum3, SIMDSITYPE &sum4) {
+  sum1 = ADD_EPI32(HADD_EPI32(c11, c12), sum1);
+  sum2 = ADD_EPI32(HADD_EPI32(c21, c22), sum2);
+  sum3 = ADD_EPI32(HADD_EPI32(c31, c32), sum3);
+  sum4 = ADD_EPI32(HADD_EPI32(c41, c42), sum4);
+  SIMDSITYPE index = SET_EPI32(7, 6, 3, 2, 5, 4, 1, 0);
+  sum1 = ReOrderResult(sum1, index);
+  sum2 = ReOrderResult(sum2, index);
+  sum3 = ReOrderResult(sum3, index);
+  sum4 = ReOrderResult(sum4, index);
+}
+#endif
+
+#if defined(__AVXVNNI__)
+#define AVX2_IGEMM4XN_KERNEL AVXVNNIKernel4x8x8
+#define AVX2_IGEMM4XN_SUM VNNIPairReduce
+#define AVX2_IGEMM4XN_REDUCE PostVNNIReduce
+#define AVX2_IGEMM4XN_EXACT_KERNEL AVXVNNIKernel4x8x8
+#elif defined(__AVX2__)
+#define AVX2_IGEMM4XN_KERNEL AVX2Kernel4x8x8
+#define AVX2_IGEMM4XN_SUM HaddPairReduce
+#define AVX2_IGEMM4XN_REDUCE PostHaddReduce
+#define AVX2_IGEMM4XN_EXACT_KERNEL AVX2ExactKernel4x8x8
+#endif
+
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE CommitBlockResult(SIMDSITYPE &sum1, SIMDSITYPE &sum2, SIMDSITYPE &sum3,
                                                                 SIMDSITYPE &sum4, void *result[], size_t length,
                                                                 size_t valid_lanes) {
@@ -274,6 +374,16 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE NCHWFMABlockResult(
   result2 = FMA_PS(EPI32TOPS(sum2), coeffi2, FMA_PS(simd_min_b, SET1_PS(kernel_sum[i_index + 1]), bias2));
   result3 = FMA_PS(EPI32TOPS(sum3), coeffi3, FMA_PS(simd_min_b, SET1_PS(kernel_sum[i_index + 2]), bias3));
   result4 = FMA_PS(EPI32TOPS(sum4), coeffi4, FMA_PS(simd_min_b, SET1_PS(kernel_sum[i_index + 3]), bias4));
+  if (conv_relu_fusion || conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    Fusion(result1, i_index, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+           mul_variance_coeff, scale, shift);
+    Fusion(result2, i_index + 1, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
+    Fusion(result3, i_index + 2, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
+    Fusion(result4, i_index + 3, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
+  }
   STOREU_PS(result[0 * kernel_n], result1);
   STOREU_PS(result[1 * kernel_n], result2);
   STOREU_PS(result[2 * kernel_n], result3);
@@ -286,7 +396,6 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE NHWCFMABlockResult(
     size_t valid_lanes, size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum,
     float *bias, bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion,
     float *global_mean, float *mul_variance_coeff, float *scale, float *shift) {
-  const static SIMDPSTYPE zero = ZERO_PS();
   SIMDPSTYPE bias1, bias2, bias3, bias4;
   SIMDPSTYPE simd_ratio_b = LOADU_PS(ratio_b + j_index);
   SIMDPSTYPE simd_min_b = LOADU_PS(min_b + j_index);
@@ -317,39 +426,15 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE NHWCFMABlockResult(
   result2 = FMA_PS(EPI32TOPS(sum2), coeffi2, bias2);  // b1,...b8
   result3 = FMA_PS(EPI32TOPS(sum3), coeffi3, bias3);  // c1,...c8
   result4 = FMA_PS(EPI32TOPS(sum4), coeffi4, bias4);  // d1,...d8
-  if (conv_relu_fusion) {                             // conv + relu
-    PRELU(result1, zero);
-    PRELU(result2, zero);
-    PRELU(result3, zero);
-    PRELU(result4, zero);
-  } else if (conv_bn_fusion) {  // conv + bn
-    SIMDPSTYPE global_mean1 = SET1_PS(global_mean[i_index]);
-    SIMDPSTYPE global_mean2 = SET1_PS(global_mean[i_index + 1]);
-    SIMDPSTYPE global_mean3 = SET1_PS(global_mean[i_index + 2]);
-    SIMDPSTYPE global_mean4 = SET1_PS(global_mean[i_index + 3]);
-    SIMDPSTYPE mul_variance_coeff1 = SET1_PS(mul_variance_coeff[i_index]);
-    SIMDPSTYPE mul_variance_coeff2 = SET1_PS(mul_variance_coeff[i_index + 1]);
-    SIMDPSTYPE mul_variance_coeff3 = SET1_PS(mul_variance_coeff[i_index + 2]);
-    SIMDPSTYPE mul_variance_coeff4 = SET1_PS(mul_variance_coeff[i_index + 3]);
-    SIMDPSTYPE scale1 = SET1_PS((scale == NULL) ? 1.0f : scale[i_index]);
-    SIMDPSTYPE scale2 = SET1_PS((scale == NULL) ? 1.0f : scale[i_index + 1]);
-    SIMDPSTYPE scale3 = SET1_PS((scale == NULL) ? 1.0f : scale[i_index + 2]);
-    SIMDPSTYPE scale4 = SET1_PS((scale == NULL) ? 1.0f : scale[i_index + 3]);
-    SIMDPSTYPE shift1 = SET1_PS((shift == NULL) ? 0.0f : shift[i_index]);
-    SIMDPSTYPE shift2 = SET1_PS((shift == NULL) ? 0.0f : shift[i_index + 1]);
-    SIMDPSTYPE shift3 = SET1_PS((shift == NULL) ? 0.0f : shift[i_index + 2]);
-    SIMDPSTYPE shift4 = SET1_PS((shift == NULL) ? 0.0f : shift[i_index + 3]);
-    BN(result1, global_mean1, mul_variance_coeff1, scale1, scale1);
-    BN(result2, global_mean2, mul_variance_coeff2, scale2, scale2);
-    BN(result3, global_mean3, mul_variance_coeff3, scale3, scale3);
-    BN(result4, global_mean4, mul_variance_coeff4, scale4, scale4);
-  } else if (conv_bn_relu_fusion) {  // conv + bn + relu
-
-  } else if (conv_relu_bn_fusion) {  // conv + relu + fusion
-    PRELU(result1, zero);
-    PRELU(result2, zero);
-    PRELU(result3, zero);
-    PRELU(result4, zero);
+  if (conv_relu_fusion || conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    Fusion(result1, i_index, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+           mul_variance_coeff, scale, shift);
+    Fusion(result2, i_index + 1, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
+    Fusion(result3, i_index + 2, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
+    Fusion(result4, i_index + 3, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+           global_mean, mul_variance_coeff, scale, shift);
   }
   // AVX2	SSE4_2
   // a1,b1,a2,b2,a5,b5,a6,b6;	a1,b1,a2,b2
@@ -459,20 +544,8 @@ FMAResult(SIMDSITYPE &sum1, SIMDSITYPE &sum2, SIMDSITYPE &sum3, SIMDSITYPE &sum4
                                      kernel_sum[i_index] * min_b[j_index + ky] + bias1;
     }
     for (size_t l = 0; l < length; ++l) {
-      if (conv_relu_fusion) {
-        *(result[l * kernel_n + ky]) = fmaxf(*(result[l * kernel_n + ky]), 0.0f);
-      } else if (conv_bn_fusion) {
-        ScalarBN((*result[l * kernel_n + ky]), global_mean[i_index + l], mul_variance_coeff[i_index + l],
-                 (scale == NULL) ? 1.0f : scale[i_index + l], (shift == NULL) ? 0.0f : shift[i_index + l]);
-      } else if (conv_bn_relu_fusion) {
-        ScalarBN((*result[l * kernel_n + ky]), global_mean[i_index + l], mul_variance_coeff[i_index + l],
-                 (scale == NULL) ? 1.0f : scale[i_index + l], (shift == NULL) ? 0.0f : shift[i_index + l]);
-        *(result[l * kernel_n + ky]) = fmaxf(*(result[l * kernel_n + ky]), 0.0f);
-      } else if (conv_relu_bn_fusion) {
-        *(result[l * kernel_n + ky]) = fmaxf(*(result[l * kernel_n + ky]), 0.0f);
-        ScalarBN((*result[l * kernel_n + ky]), global_mean[i_index + l], mul_variance_coeff[i_index + l],
-                 (scale == NULL) ? 1.0f : scale[i_index + l], (shift == NULL) ? 0.0f : shift[i_index + l]);
-      }
+      ScalarFusion(*(result[l * kernel_n + ky]), i_index + l, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                   conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
     }
     if (ky == 3) {
       tmp1 = EXTRACT_SI128(sum1, 1);
@@ -550,6 +623,10 @@ FMAResult(SIMDSITYPE &sum1, SIMDSITYPE &sum2, SIMDSITYPE &sum3, SIMDSITYPE &sum4
         *(result[0 * kernel_n + ky]) = ratio_a[i_index] * ratio_b[j_index + ky] * EXTRACT_EPI32(sum1, 0) +
                                        kernel_sum[i_index] * min_b[j_index + ky] + bias1;
       }
+      for (size_t l = 0; l < length; ++l) {
+        ScalarFusion(*(result[l * kernel_n + ky]), i_index + l, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                     conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+      }
     }
     sum1 = SRLI_SI128(sum1, 4);
     sum2 = SRLI_SI128(sum2, 4);
@@ -639,11 +716,11 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(int8_t *&pa, ui
 #ifdef __AVX2__
   assert((kernel_m == 4) && (kernel_n == 8) && (kernel_k == 8));
   if ((length >= kernel_m) && (valid_lanes >= kernel_n)) {
-    ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, kernel_m, kernel_n, AVX2Kernel4x8x8, HaddPairReduce,
-                          PostHaddReduce, CommitBlockResult);
+    ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, kernel_m, kernel_n, AVX2_IGEMM4XN_KERNEL,
+                          AVX2_IGEMM4XN_SUM, AVX2_IGEMM4XN_REDUCE, CommitBlockResult);
   } else {
-    ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, AVX2Kernel4x8x8, HaddPairReduce,
-                          PostHaddReduce, CommitResult);
+    ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, AVX2_IGEMM4XN_KERNEL,
+                          AVX2_IGEMM4XN_SUM, AVX2_IGEMM4XN_REDUCE, CommitResult);
   }
 #else
   assert((kernel_m == 4) && (kernel_n == 4) && (kernel_k == 8));
@@ -657,39 +734,62 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(int8_t *&pa, ui
 #endif
 }
 
-template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
-static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(
+#ifdef __AVX2__
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout, typename kernel_function,
+          typename sum_function, typename reduce_function>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelLayout(
     int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
     size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
     bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
-    float *mul_variance_coeff, float *scale, float *shift, bool is_block) {
-#ifdef __AVX2__
-  assert((kernel_m == 4) && (kernel_n == 8) && (kernel_k == 8));
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, kernel_function kernel, sum_function sum,
+    reduce_function reduce) {
   if (layout == NCHW) {
     if (is_block) {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, kernel_m, kernel_n, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, AVX2Kernel4x8x8,
-                            HaddPairReduce, PostHaddReduce, NCHWFMABlockResult<kernel_m, kernel_n>);
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, kernel, sum, reduce,
+                            NCHWFMABlockResult<kernel_m, kernel_n>);
     } else {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, AVX2Kernel4x8x8,
-                            HaddPairReduce, PostHaddReduce, FMAResult<kernel_m, kernel_n>);
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, kernel, sum, reduce,
+                            FMAResult<kernel_m, kernel_n>);
     }
   } else {
     if (is_block) {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, kernel_m, kernel_n, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, AVX2Kernel4x8x8,
-                            HaddPairReduce, PostHaddReduce, NHWCFMABlockResult<kernel_m, kernel_n>);
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, kernel, sum, reduce,
+                            NHWCFMABlockResult<kernel_m, kernel_n>);
     } else {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, AVX2Kernel4x8x8,
-                            HaddPairReduce, PostHaddReduce, FMAResult<kernel_m, kernel_n>);
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, kernel, sum, reduce,
+                            FMAResult<kernel_m, kernel_n>);
     }
   }
+}
+#endif
+
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(
+    int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
+    size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
+    bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, bool exact_reduce) {
+#ifdef __AVX2__
+  assert((kernel_m == 4) && (kernel_n == 8) && (kernel_k == 8));
+  if (exact_reduce) {
+    ApplyKernelLayout<kernel_m, kernel_n, kernel_k, layout>(
+        pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
+        bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+        mul_variance_coeff, scale, shift, is_block, AVX2_IGEMM4XN_EXACT_KERNEL, VNNIPairReduce, PostVNNIReduce);
+  } else {
+    ApplyKernelLayout<kernel_m, kernel_n, kernel_k, layout>(
+        pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
+        bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+        mul_variance_coeff, scale, shift, is_block, AVX2_IGEMM4XN_KERNEL, AVX2_IGEMM4XN_SUM, AVX2_IGEMM4XN_REDUCE);
+  }
 #else
   assert((kernel_m == 4) && (kernel_n == 4) && (kernel_k == 8));
   if (layout == NCHW) {
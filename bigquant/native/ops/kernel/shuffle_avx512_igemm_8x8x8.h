@@ -17,11 +17,197 @@
 #ifndef OPS_SHUFFLE_KERNEL_AVX512_IGEMM_8X8X8_H
 #define OPS_SHUFFLE_KERNEL_AVX512_IGEMM_8X8X8_H
 #include "../../base.h"
+#include "../kernel-common.h"
 
 #if defined(AVX512)
 namespace kernel {
 namespace avx512_igemm8x8x8 {
 
+#if defined(AVX512_VNNI)
+// vpdpbusd multiplies 4 adjacent u8 x s8 pairs and accumulates them into one int32 lane, so the partial sums land in
+// the same layout the vpmaddubsw + vpmaddwd sequence below produces, without the int16 saturation in between.
+template <size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE KernelReduce(int8_t *&pa, uint8_t *&pb, SIMDSITYPE sum[], size_t length) {
+  size_t num = length / (kernel_k * UNROLL_NUM);
+  size_t remain = (length % (kernel_k * UNROLL_NUM)) / kernel_k;
+  __asm__ __volatile__(
+      "cmp $0, %10\n"
+      "je 2f\n"
+
+      "xor %%rbx, %%rbx\n"
+      ".align 2\n"
+      "1:"
+      "vmovdqa32 (%1), %%zmm8\n"
+      "vmovdqa32 64(%1), %%zmm9\n"
+      "vmovdqa32 128(%1), %%zmm10\n"
+      "vmovdqa32 192(%1), %%zmm11\n"
+      "add $256, %1\n"
+
+      // 1st round
+      "vbroadcastsd 0(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %2\n"
+
+      "vbroadcastsd 8(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %3\n"
+
+      "vbroadcastsd 16(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %4\n"
+
+      "vbroadcastsd 24(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %5\n"
+
+      "vbroadcastsd 32(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %6\n"
+
+      "vbroadcastsd 40(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %7\n"
+
+      "vbroadcastsd 48(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %8\n"
+
+      "vbroadcastsd 56(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %9\n"
+
+      "add $64, %0\n"
+
+      // 2nd round
+      "vbroadcastsd 0(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %2\n"
+
+      "vbroadcastsd 8(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %3\n"
+
+      "vbroadcastsd 16(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %4\n"
+
+      "vbroadcastsd 24(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %5\n"
+
+      "vbroadcastsd 32(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %6\n"
+
+      "vbroadcastsd 40(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %7\n"
+
+      "vbroadcastsd 48(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %8\n"
+
+      "vbroadcastsd 56(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm9, %9\n"
+
+      "add $64, %0\n"
+
+      // 3rd round
+      "vbroadcastsd 0(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %2\n"
+
+      "vbroadcastsd 8(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %3\n"
+
+      "vbroadcastsd 16(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %4\n"
+
+      "vbroadcastsd 24(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %5\n"
+
+      "vbroadcastsd 32(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %6\n"
+
+      "vbroadcastsd 40(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %7\n"
+
+      "vbroadcastsd 48(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %8\n"
+
+      "vbroadcastsd 56(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm10, %9\n"
+
+      "add $64, %0\n"
+
+      // 4th round
+      "vbroadcastsd 0(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %2\n"
+
+      "vbroadcastsd 8(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %3\n"
+
+      "vbroadcastsd 16(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %4\n"
+
+      "vbroadcastsd 24(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %5\n"
+
+      "vbroadcastsd 32(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %6\n"
+
+      "vbroadcastsd 40(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %7\n"
+
+      "vbroadcastsd 48(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %8\n"
+
+      "vbroadcastsd 56(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm11, %9\n"
+
+      "add $64, %0\n"
+
+      "add $1, %%rbx\n"
+      "cmp %10, %%rbx\n"
+      "jne 1b\n"
+
+      "2:"
+      "cmp $0, %11\n"
+      "je 4f\n"
+      "xor %%rbx, %%rbx\n"
+
+      ".align 2\n"
+      "3:"
+      "vmovdqa32 (%1), %%zmm8\n"
+
+      "vbroadcastsd 0(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %2\n"
+
+      "vbroadcastsd 8(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %3\n"
+
+      "vbroadcastsd 16(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %4\n"
+
+      "vbroadcastsd 24(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %5\n"
+
+      "vbroadcastsd 32(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %6\n"
+
+      "vbroadcastsd 40(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %7\n"
+
+      "vbroadcastsd 48(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %8\n"
+
+      "vbroadcastsd 56(%0), %%zmm12\n"
+      "vpdpbusd %%zmm12, %%zmm8, %9\n"
+
+      "add $64, %0\n"
+      "add $64, %1\n"
+      "add $1, %%rbx\n"
+      "cmp %11, %%rbx\n"
+      "jne 3b\n"
+
+      "4:"
+      : "+r"(pa), "+r"(pb), "+v"(sum[0]), "+v"(sum[1]), "+v"(sum[2]), "+v"(sum[3]), "+v"(sum[4]), "+v"(sum[5]),
+        "+v"(sum[6]), "+v"(sum[7])
+      : "r"(num), "r"(remain)
+      : "cc", "rbx", "zmm8", "zmm9", "zmm10", "zmm11", "zmm12");
+}
+
+// vpdpbusd never saturates, full range weights need no special care
+template <size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ExactKernelReduce(int8_t *&pa, uint8_t *&pb, SIMDSITYPE sum[],
+                                                                size_t length) {
+  KernelReduce<kernel_k>(pa, pb, sum, length);
+}
+#else
 template <size_t kernel_k>
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE KernelReduce(int8_t *&pa, uint8_t *&pb, SIMDSITYPE sum[], size_t length) {
   size_t num = length / (kernel_k * UNROLL_NUM);
@@ -296,6 +482,27 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE KernelReduce(int8_t *&pa, uint8_t
         "zmm12", "zmm13");
 }
 
+// The vpaddsw chain above is only exact for weights within [-64, 64]. Full range weights go through ExactDotAccumulate,
+// which lands in the same lane layout at twice the multiply cost.
+template <size_t kernel_k>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ExactKernelReduce(int8_t *&pa, uint8_t *&pb, SIMDSITYPE sum[],
+                                                                size_t length) {
+  SIMDSITYPE ones = SET1_EPI16(1);
+  SIMDSITYPE low_mask = SET1_EPI8(0x7f);
+  for (size_t i = 0; i < length; i += kernel_k) {
+    SIMDSITYPE b = LOAD_SI512(reinterpret_cast<SIMDSITYPE *>(pb));
+    SIMDSITYPE b_low = AND_SI(b, low_mask);
+    SIMDSITYPE b_high = ANDNOT_SI(low_mask, b);
+    for (size_t m = 0; m < 8; ++m) {
+      SIMDSITYPE a = SET1_EPI64(*reinterpret_cast<int64_t *>(pa + 8 * m));
+      ExactDotAccumulate(sum[m], b_low, b_high, a, ones);
+    }
+    pa += 64;
+    pb += 64;
+  }
+}
+#endif
+
 template <size_t kernel_k, typename postprocess_function>
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernel(int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance,
                                                           void *result[], size_t length, size_t valid_lanes,
@@ -313,12 +520,16 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernel(
     int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
     size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
     bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
-    float *mul_variance_coeff, float *scale, float *shift, postprocess_function postprocess) {
+    float *mul_variance_coeff, float *scale, float *shift, bool exact_reduce, postprocess_function postprocess) {
   SIMDSITYPE sum[8];
   for (size_t i = 0; i < 8; ++i) {
     sum[i] = ZEROS();
   }
-  KernelReduce<kernel_k>(pa, pb, sum, k);
+  if (exact_reduce) {
+    ExactKernelReduce<kernel_k>(pa, pb, sum, k);
+  } else {
+    KernelReduce<kernel_k>(pa, pb, sum, k);
+  }
   postprocess(sum, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum, bias,
               conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
               mul_variance_coeff, scale, shift);
@@ -439,6 +650,12 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE NCHWBlockFMA(SIMDSITYPE sum[], flo
                                FMA_PS_HALF(simd_min_b, SET1_PS_HALF(kernel_sum[i_index + 6]), simd_bias[6]));
   simd_result[7] = FMA_PS_HALF(EPI32TOPS_HALF(CASTSI512TOSI256(sum[7])), simd_coeffi[7],
                                FMA_PS_HALF(simd_min_b, SET1_PS_HALF(kernel_sum[i_index + 7]), simd_bias[7]));
+  if (conv_relu_fusion || conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    for (size_t m = 0; m < kernel_m; ++m) {
+      FusionHalf(simd_result[m], i_index + m, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                 conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+    }
+  }
 
   STOREU_PS_HALF(result[0 * kernel_n], simd_result[0]);
   STOREU_PS_HALF(result[1 * kernel_n], simd_result[1]);
@@ -526,6 +743,12 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE NHWCBlockFMA(SIMDSITYPE sum[], flo
                                FMA_PS_HALF(simd_min_b, SET1_PS_HALF(kernel_sum[i_index + 6]), simd_bias[6]));
   simd_result[7] = FMA_PS_HALF(EPI32TOPS_HALF(CASTSI512TOSI256(sum[7])), simd_coeffi[7],
                                FMA_PS_HALF(simd_min_b, SET1_PS_HALF(kernel_sum[i_index + 7]), simd_bias[7]));
+  if (conv_relu_fusion || conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion) {
+    for (size_t m = 0; m < kernel_m; ++m) {
+      FusionHalf(simd_result[m], i_index + m, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                 conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+    }
+  }
   // a1,a2,a3,a4,a5,a6,a7,a8
   // b1,b2,b3,b4,b5,b6,b7,b8
   // c1,c2,c3,c4,c5,c6,c7,c8
@@ -639,9 +862,11 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE FMAResult(SIMDSITYPE sum[], float
   for (size_t m = 0; m < length; ++m) {
     for (size_t n = 0; n < valid_lanes; ++n) {
       int *tmp = reinterpret_cast<int *>(&sum[m]);
-      *(reinterpret_cast<float *>(result[m * kernel_n + n])) = ratio_a[i_index + m] * ratio_b[j_index + n] * tmp[n] +
-                                                               kernel_sum[i_index + m] * min_b[j_index + n] +
-                                                               ((bias == NULL) ? 0.0f : bias[i_index + m]);
+      float value = ratio_a[i_index + m] * ratio_b[j_index + n] * tmp[n] +
+                    kernel_sum[i_index + m] * min_b[j_index + n] + ((bias == NULL) ? 0.0f : bias[i_index + m]);
+      ScalarFusion(value, i_index + m, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+                   global_mean, mul_variance_coeff, scale, shift);
+      *(reinterpret_cast<float *>(result[m * kernel_n + n])) = value;
     }
   }
 }
@@ -659,30 +884,30 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(
     int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
     size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
     bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
-    float *mul_variance_coeff, float *scale, float *shift, bool is_block) {
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, bool exact_reduce) {
   assert((kernel_m == 8) && (kernel_n == 8) && (kernel_k == 8));
   if (layout == NCHW) {
     if (is_block == false) {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, exact_reduce,
                             FMAResult<kernel_m, kernel_n>);
     } else {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, exact_reduce,
                             NCHWBlockFMA<kernel_m, kernel_n>);
     }
   } else {
     if (is_block == false) {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, exact_reduce,
                             FMAResult<kernel_m, kernel_n>);
     } else {
       ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b,
                             min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
-                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
+                            conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, exact_reduce,
                             NHWCBlockFMA<kernel_m, kernel_n>);
     }
   }
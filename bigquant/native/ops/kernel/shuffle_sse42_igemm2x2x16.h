@@ -17,6 +17,7 @@
 #ifndef OPS_SHUFFLE_KERNEL_SSE42_IGEMM2X2X16_H
 #define OPS_SHUFFLE_KERNEL_SSE42_IGEMM2X2X16_H
 #include "../../base.h"
+#include "../kernel-common.h"
 
 #if !defined(__AVX2__) && defined(__SSE4_2__)
 namespace kernel {
@@ -77,6 +78,34 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE SSE42Kernel2x2x16(int8_t *&pa, uin
   pb += 32;
 }
 
+// Full range weights may saturate the int16 pair sums of SSE42Kernel2x2x16, this tile keeps 4 int32 partial sums per
+// row and column pair instead.
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE SSE42ExactKernel2x2x16(int8_t *&pa, uint8_t *&pb, SIMDSITYPE &c11,
+                                                                     SIMDSITYPE &c12, SIMDSITYPE &c21,
+                                                                     SIMDSITYPE &c22) {
+  SIMDSITYPE ones = SET1_EPI16(1);
+  SIMDSITYPE low_mask = SET1_EPI8(0x7f);
+  SIMDSITYPE a1 = LOAD_SI128(reinterpret_cast<SIMDSITYPE *>(pa));
+  SIMDSITYPE a2 = LOAD_SI128(reinterpret_cast<SIMDSITYPE *>(pa + 16));
+  SIMDSITYPE b1 = LOAD_SI128(reinterpret_cast<SIMDSITYPE *>(pb));
+  SIMDSITYPE b2 = LOAD_SI128(reinterpret_cast<SIMDSITYPE *>(pb + 16));
+  SIMDSITYPE b1_low = AND_SI(b1, low_mask);
+  SIMDSITYPE b1_high = ANDNOT_SI(low_mask, b1);
+  SIMDSITYPE b2_low = AND_SI(b2, low_mask);
+  SIMDSITYPE b2_high = ANDNOT_SI(low_mask, b2);
+  ExactDotAccumulate(c11, b1_low, b1_high, a1, ones);
+  ExactDotAccumulate(c12, b2_low, b2_high, a1, ones);
+  ExactDotAccumulate(c21, b1_low, b1_high, a2, ones);
+  ExactDotAccumulate(c22, b2_low, b2_high, a2, ones);
+  pa += 32;
+  pb += 32;
+}
+
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE ExactReduce(SIMDSITYPE &c11, SIMDSITYPE &c12, SIMDSITYPE &c21,
+                                                          SIMDSITYPE &c22, SIMDSITYPE &accumulator) {
+  accumulator = ADD_EPI32(HADD_EPI32(HADD_EPI32(c11, c12), HADD_EPI32(c21, c22)), accumulator);
+}
+
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE Reduce(SIMDSITYPE &c11, SIMDSITYPE &c12, SIMDSITYPE &c21, SIMDSITYPE &c22,
                                                      SIMDSITYPE &accumulator) {
   SIMDSITYPE c11_lo = EPI16TOEPI32(c11);
@@ -180,6 +209,29 @@ ApplyKernel(int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *r
               mul_variance_coeff, scale, shift);
 }
 
+// The int32 tiles of SSE42ExactKernel2x2x16 never need the saturation check of KernelReduce
+template <size_t kernel_k, typename postprocess_function>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE
+ApplyExactKernel(int8_t *&pa, uint8_t *&pb, size_t k, float *result[], size_t length, size_t valid_lanes,
+                 size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum,
+                 float *bias, bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion,
+                 bool conv_relu_bn_fusion, float *global_mean, float *mul_variance_coeff, float *scale, float *shift,
+                 postprocess_function postprocess) {
+  INIT(c11);
+  INIT(c12);
+  INIT(c21);
+  INIT(c22);
+  INIT(accumulator);
+  while (k >= kernel_k) {
+    SSE42ExactKernel2x2x16(pa, pb, c11, c12, c21, c22);
+    k -= kernel_k;
+  }
+  ExactReduce(c11, c12, c21, c22, accumulator);
+  postprocess(accumulator, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum, bias,
+              conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+              mul_variance_coeff, scale, shift);
+}
+
 static INLINE_SPECIFIER void INLINE_ATTRIBUTE CommitBlockResult(SIMDSITYPE &sum, void *result[], size_t length,
                                                                 size_t valid_lanes) {
   STORELO_EPI64(reinterpret_cast<SIMDSITYPE *>(result[0]), sum);
@@ -223,6 +275,10 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE FMAResult(SIMDSITYPE &sum, float *
                                      kernel_sum[i_index] * min_b[j_index + ky] +
                                      ((bias == NULL) ? 0.0f : bias[i_index]);
     }
+    for (size_t l = 0; l < length; ++l) {
+      ScalarFusion(*(result[l * kernel_n + ky]), i_index + l, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                   conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift);
+    }
     sum = SRLI_SI128(sum, 4);
     sum_hi = SRLI_SI128(sum_hi, 4);
   }
@@ -247,8 +303,15 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE ApplyKernelWrapper(
     int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
     size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
     bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
-    float *mul_variance_coeff, float *scale, float *shift, bool is_block) {
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, bool exact_reduce) {
   assert((kernel_m == 2) && (kernel_n == 2) && (kernel_k == 16));
+  if (exact_reduce) {
+    ApplyExactKernel<kernel_k>(pa, pb, k, result, std::min(length, kernel_m), std::min(valid_lanes, kernel_n), i_index,
+                               j_index, ratio_a, ratio_b, min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion,
+                               conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
+                               FMAResult<kernel_m, kernel_n>);
+    return;
+  }
   ApplyKernel<kernel_k>(pa, pb, k, fault_tolerance, result, std::min(length, kernel_m), std::min(valid_lanes, kernel_n),
                         i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion,
                         conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift,
@@ -22,7 +22,12 @@
 
 void MixPrecisionGemm(ORDER order, enum TRANSPOSE transA, enum TRANSPOSE transB, int m, int n, int k, int8_t *a,
                       int lda, uint8_t *b, int ldb, int *c, int ldc, float fault_tolerance) {
-#if defined(AVX512)
+#if defined(AMX)
+  shuffle::InternalMixPrecisionGemm<GEMM_SHUFFLE_KERNEL_M, GEMM_SHUFFLE_KERNEL_N, GEMM_SHUFFLE_KERNEL_K>(
+      order, transA, transB, m, n, k, a, lda, b, ldb, c, ldc, fault_tolerance,
+      kernel::amx_igemm16x16x64::ApplyKernelWrapper<GEMM_SHUFFLE_KERNEL_M, GEMM_SHUFFLE_KERNEL_N,
+                                                    GEMM_SHUFFLE_KERNEL_K>);
+#elif defined(AVX512)
   // shuffle::InternalMixPrecisionGemm<GEMM_SHUFFLE_KERNEL_M, GEMM_SHUFFLE_KERNEL_N, GEMM_SHUFFLE_KERNEL_K>(order,
   // transA, transB, m, n, k, a, lda, b, ldb, c, ldc, fault_tolerance,
   // kernel::avx512_igemm4x4x64::ApplyKernelWrapper<GEMM_SHUFFLE_KERNEL_M, GEMM_SHUFFLE_KERNEL_N,
@@ -17,6 +17,10 @@
 #ifndef OPS_OPS_H
 #define OPS_OPS_H
 
+struct BlocksInfo;
+struct OutputRequantization;
+struct NumaWeight;
+
 template <typename DType>
 void FindMinMaxValue(const DType *p, size_t length, DType &min, DType &max);
 
@@ -75,13 +79,17 @@ namespace shuffle {
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadShuffle2D(DType *dst, size_t m, size_t n, DType *src);
 
+template <size_t shuffle_rows, size_t shuffle_cols>
+void VNNIShuffle2D(int8_t *dst, size_t pad_m, size_t pad_n);
+
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadQuantizeShuffle(int8_t *dst, size_t m, size_t n, DType *src, DType &min, DType &max, DType &ratio,
                         float sw_threshold);
 
+// quantized_sum, if given, receives the sum of each quantized row scaled back by ratio
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadQuantizeShuffle2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n, DType *src, DType *min,
-                          DType *max, DType *ratio, float sw_threshold);
+                          DType *max, DType *ratio, float sw_threshold, DType *quantized_sum = NULL);
 
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadQuantizeShuffle2D(uint8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n, DType *src, DType *min,
@@ -92,8 +100,32 @@ void PadQuantizeShuffleIm2colWrapper(DType *data, size_t batch_size, size_t chan
                                      size_t height, size_t width, size_t kernel_h, size_t kernel_w, size_t pad_h,
                                      size_t pad_w, size_t stride_h, size_t stride_w, size_t dilation_h,
                                      size_t dilation_w, uint8_t *data_col[], DType *min[], DType *max[], DType *ratio[],
-                                     DType *workspace, float sw_threshold = 255.0f, bool transpose = false);
+                                     DType *workspace, float sw_threshold = 255.0f, bool transpose = false,
+                                     DType *min_per_channel[] = NULL, DType *max_per_channel[] = NULL);
 
+// Quantizes with a fixed range per group, range_min[g] <= 0 <= range_max[g], clamping what falls outside. workspace
+// holds the quantized input, batch_size * channels * height * width bytes.
+template <typename DType, LAYOUT layout>
+void PadQuantizeShuffleIm2colStatic(DType *data, size_t batch_size, size_t channels_per_group, size_t groups,
+                                    size_t height, size_t width, size_t kernel_h, size_t kernel_w, size_t pad_h,
+                                    size_t pad_w, size_t stride_h, size_t stride_w, size_t dilation_h,
+                                    size_t dilation_w, uint8_t *data_col[], DType *min[], DType *max[], DType *ratio[],
+                                    const DType *range_min, const DType *range_max, float sw_threshold,
+                                    uint8_t *workspace = NULL);
+
+// Same patches from an NHWC input already quantized per group, value = q * range_ratio[g] + range_min[g], the padded
+// border reading zerofill[g]
+template <typename DType>
+void PadShuffleQuantizedIm2col(const uint8_t *quantized, size_t batch_size, size_t channels_per_group, size_t groups,
+                               size_t height, size_t width, size_t kernel_h, size_t kernel_w, size_t pad_h,
+                               size_t pad_w, size_t stride_h, size_t stride_w, size_t dilation_h, size_t dilation_w,
+                               uint8_t *data_col[], DType *min[], DType *max[], DType *ratio[],
+                               const DType *range_min, const DType *range_max, const DType *range_ratio,
+                               const uint8_t *zerofill);
+
+// exact_reduce keeps every partial sum in int32, which weights using the full s8 range need. With requantize the output
+// is written as u8 to requantize->data_ instead of pc, NHWC only. With numa_weight placed, the threads read its copy of
+// pa for their node instead of pa.
 template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
 void ConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, size_t m, size_t n, size_t k, float *ratio_a, float *ratio_b,
                      float *kernel_sum, float *min_b, float *bias, size_t batch_size, size_t groups,
@@ -101,7 +133,28 @@ void ConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, size_t m, size_t n, siz
                      float fault_tolerance = 0.5, size_t pad_m = 0, size_t pad_n = 0, bool conv_relu_fusion = false,
                      bool conv_bn_fusion = false, bool conv_bn_relu_fusion = false, bool conv_relu_bn_fusion = false,
                      float *global_mean = NULL, float *mul_variance_coeff = NULL, float *scale = NULL,
-                     float *shift = NULL);
+                     float *shift = NULL, const BlocksInfo *blocks_info = NULL, bool exact_reduce = false,
+                     const OutputRequantization *requantize = NULL, const NumaWeight *numa_weight = NULL);
+
+// One call for all the groups, pa, pb, ratio_a, ratio_b and min_b hold a pointer per group, numa_weight a panel per
+// group
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
+void GroupedConvShuffleGEMM(int8_t *pa[], uint8_t *pb[], float *pc, size_t m, size_t n, size_t k, float *ratio_a[],
+                            float *ratio_b[], float *kernel_sum, float *min_b[], float *bias, size_t batch_size,
+                            size_t groups, size_t channel_per_group, size_t height_out, size_t width_out,
+                            float fault_tolerance = 0.5, size_t pad_m = 0, size_t pad_n = 0,
+                            bool conv_relu_fusion = false, bool conv_bn_fusion = false,
+                            bool conv_bn_relu_fusion = false, bool conv_relu_bn_fusion = false,
+                            float *global_mean = NULL, float *mul_variance_coeff = NULL, float *scale = NULL,
+                            float *shift = NULL, const BlocksInfo *blocks_info = NULL, bool exact_reduce = false,
+                            const OutputRequantization *requantize = NULL, const NumaWeight *numa_weight = NULL);
+
+// The same product for at most FC_GEMV_MAX_BATCH columns, pa the weight panel of the GEMM, pb the n x k data row after
+// row and pc the n x valid_m output. Not available with AMX.
+template <size_t kernel_m, size_t kernel_k>
+void ShuffleGEMV(int8_t *pa, const uint8_t *pb, float *pc, size_t m, size_t n, size_t k, const float *ratio_a,
+                 const float *ratio_b, const float *kernel_sum, const float *min_b, const float *bias, size_t valid_m,
+                 const NumaWeight *numa_weight = NULL);
 }
 
 namespace dot {
@@ -117,14 +170,50 @@ void NHWCWinograd3x3KernelProcess(float *transformed_weight, float *weight, int
                                   int width);
 
 void NHWCWinogradQuantizeKernelByChannel(int8_t *quantized_kernel, float *transformed_kernel, size_t m, size_t n,
-                                         size_t pad_m, size_t pad_n, float *min, float *max, float *ratio);
+                                         size_t pad_m, size_t pad_n, float *min, float *max, float *ratio,
+                                         float sw_threshold, float *quantized_sum = NULL);
+
+void NHWCWinograd3x3DataProcess(uint8_t *transformed_data, float *data, size_t batch_size, size_t channel_in,
+                                size_t height, size_t width, size_t pad_h, size_t pad_w, size_t patch_y_num,
+                                size_t patch_x_num, float *min, float *max, float *ratio, float sw_threshold,
+                                float *workspace);
 
 void NHWCWinograd3x3ElementWiseBatchMul(float *intermedia_out, int8_t *transformed_kernel, uint8_t *transformed_data,
                                         size_t batch_size, size_t patch_y_num, size_t patch_x_num, size_t channel_in,
-                                        size_t channel_out, float *ratio_a, float *sum_a, float *ratio_b, float *min_b);
+                                        size_t channel_out, float *ratio_a, float *sum_a, float *ratio_b, float *min_b,
+                                        const BlocksInfo *blocks_info = NULL, bool exact_reduce = false);
 
 void NHWCWinograd3x3PostProcess(float *out, float *intermedia_out, size_t batch_size, size_t patch_y_num,
-                                size_t patch_x_num, size_t channel_out, size_t height_out, size_t width_out);
+                                size_t patch_x_num, size_t channel_out, size_t height_out, size_t width_out,
+                                LAYOUT layout = NHWC, float *bias = NULL, bool conv_relu_fusion = false,
+                                bool conv_bn_fusion = false, bool conv_bn_relu_fusion = false,
+                                bool conv_relu_bn_fusion = false, float *global_mean = NULL,
+                                float *mul_variance_coeff = NULL, float *scale = NULL, float *shift = NULL);
+}
+
+namespace depthwise {
+
+void NHWCFindMinMaxPerChannel(float *min, float *max, const float *data, size_t spatial_size, size_t channel,
+                              float *workspace);
+
+void NHWCQuantizeByChannel(uint8_t *dst, const float *src, size_t spatial_size, size_t channel, const float *scale,
+                           const float *shift);
+
+void NHWCDepthwiseConv(float *out, const uint8_t *data, const int8_t *weight, size_t batch_size, size_t channel,
+                       size_t height, size_t width, size_t kernel_h, size_t kernel_w, size_t pad_h, size_t pad_w,
+                       size_t stride_h, size_t stride_w, size_t dilation_h, size_t dilation_w, size_t height_out,
+                       size_t width_out, const uint8_t *zero_point, const float *out_scale, const float *out_shift,
+                       const uint8_t **taps_workspace, LAYOUT layout = NHWC, bool relu = false,
+                       const float *post_scale = NULL, const float *post_shift = NULL);
+}
+
+namespace pool {
+
+void NHWCPool(float *out, const float *data, size_t batch_size, size_t channel, size_t height, size_t width,
+              size_t kernel_h, size_t kernel_w, size_t pad_h, size_t pad_w, size_t stride_h, size_t stride_w,
+              size_t height_out, size_t width_out, bool average);
+
+void EltwiseSum(float *out, const float *a, const float *b, size_t length, bool relu);
 }
 
 #include "find_extreme.h"
@@ -134,6 +223,10 @@ void NHWCWinograd3x3PostProcess(float *out, float *intermedia_out, size_t batch_
 #include "./shuffle/pad_shuffle.h"
 #include "./shuffle/shuffle_im2col.h"
 #include "./shuffle/shuffle_igemm.h"
+#include "./shuffle/shuffle_igemv.h"
+#include "./winograd/winograd.h"
+#include "./depthwise/depthwise.h"
+#include "./pool/pool.h"
 #include "./mixprecison_gemm.h"
 #include "./dot.h"
 #endif
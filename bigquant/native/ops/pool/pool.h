@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OPS_POOL_POOL_H
+#define OPS_POOL_POOL_H
+
+#include "../../base.h"
+#include "../../common.h"
+#include "../kernel-common.h"
+
+// The fp32 layers between the quantized convolutions of a network. Everything is NHWC, so the channels of a pixel are
+// contiguous and processed PS_OPERAND_WIDTH at a time.
+namespace pool {
+
+// The taps falling into the padded border are skipped, max pooling never sees them and average pooling divides by the
+// number of taps inside the input only.
+void NHWCPool(float *out, const float *data, size_t batch_size, size_t channel, size_t height, size_t width,
+              size_t kernel_h, size_t kernel_w, size_t pad_h, size_t pad_w, size_t stride_h, size_t stride_w,
+              size_t height_out, size_t width_out, bool average) {
+  ParallelFor(batch_size * height_out, [&](size_t i) {
+    size_t n = i / height_out;
+    size_t y = i % height_out;
+    for (size_t x = 0; x < width_out; ++x) {
+      int y_begin = static_cast<int>(y * stride_h) - static_cast<int>(pad_h);
+      int x_begin = static_cast<int>(x * stride_w) - static_cast<int>(pad_w);
+      size_t ky_begin = static_cast<size_t>(std::max(-y_begin, 0));
+      size_t kx_begin = static_cast<size_t>(std::max(-x_begin, 0));
+      size_t ky_end = std::min(kernel_h, static_cast<size_t>(std::max(static_cast<int>(height) - y_begin, 0)));
+      size_t kx_end = std::min(kernel_w, static_cast<size_t>(std::max(static_cast<int>(width) - x_begin, 0)));
+      float *dst = out + ((n * height_out + y) * width_out + x) * channel;
+      if ((ky_begin >= ky_end) || (kx_begin >= kx_end)) {
+        memset(dst, 0, sizeof(float) * channel);
+        continue;
+      }
+      float count = static_cast<float>((ky_end - ky_begin) * (kx_end - kx_begin));
+      size_t c = 0;
+      for (; c + PS_OPERAND_WIDTH <= channel; c += PS_OPERAND_WIDTH) {
+        SIMDPSTYPE result = average ? ZERO_PS() : SET1_PS(-FLT_MAX);
+        for (size_t ky = ky_begin; ky < ky_end; ++ky) {
+          const float *row = data + ((n * height + y_begin + ky) * width + x_begin) * channel + c;
+          for (size_t kx = kx_begin; kx < kx_end; ++kx) {
+            SIMDPSTYPE value = LOADU_PS(row + kx * channel);
+            result = average ? ADD_PS(result, value) : MAX_PS(result, value);
+          }
+        }
+        STOREU_PS(dst + c, average ? MUL_PS(result, SET1_PS(1.0f / count)) : result);
+      }
+      for (; c < channel; ++c) {
+        float result = average ? 0.0f : -FLT_MAX;
+        for (size_t ky = ky_begin; ky < ky_end; ++ky) {
+          const float *row = data + ((n * height + y_begin + ky) * width + x_begin) * channel + c;
+          for (size_t kx = kx_begin; kx < kx_end; ++kx) {
+            result = average ? result + row[kx * channel] : std::max(result, row[kx * channel]);
+          }
+        }
+        dst[c] = average ? result / count : result;
+      }
+    }
+  });
+}
+
+// out = a + b, then max(out, 0) with relu. out may alias a or b.
+void EltwiseSum(float *out, const float *a, const float *b, size_t length, bool relu) {
+  ParallelFor((length + PS_OPERAND_WIDTH - 1) / PS_OPERAND_WIDTH, [&](size_t block) {
+    size_t i = block * PS_OPERAND_WIDTH;
+    if (i + PS_OPERAND_WIDTH <= length) {
+      SIMDPSTYPE result = ADD_PS(LOADU_PS(a + i), LOADU_PS(b + i));
+      STOREU_PS(out + i, relu ? MAX_PS(result, ZERO_PS()) : result);
+    } else {
+      for (size_t j = i; j < length; ++j) {
+        float result = a[j] + b[j];
+        out[j] = relu ? std::max(result, 0.0f) : result;
+      }
+    }
+  });
+}
+}
+#endif
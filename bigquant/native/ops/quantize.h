@@ -18,6 +18,7 @@
 #define OPS_QUANTIZE_H
 
 #include "../base.h"
+#include "../parallel.h"
 #include "./find_extreme.h"
 
 #if defined(AVX512)
@@ -203,10 +204,9 @@ void ParallelPadQuantize(int8_t *dst, size_t length, size_t pad_length, SrcType
                          SrcType &ratio, float threshold) {
   OMPFindMinMaxValue(src, length, min, max);
   ratio = (std::abs(max) > std::abs(min)) ? (threshold / std::abs(max)) : (threshold / std::abs(min));
-#pragma omp parallel for
-  for (size_t i = 0; i < length; ++i) {
+  ParallelFor(length, [&](size_t i) {
     dst[i] = static_cast<int8_t>(std::round(src[i] * ratio));
-  }
+  });
   memset(dst + length, 0, pad_length - length);
 }
 
@@ -215,18 +215,16 @@ void ParallelPadQuantize(uint8_t *dst, size_t length, size_t pad_length, SrcType
                          SrcType &ratio, float threshold) {
   OMPFindMinMaxValue(src, length, min, max);
   ratio = threshold / (max - min);
-#pragma omp parallel for
-  for (size_t i = 0; i < length; ++i) {
+  ParallelFor(length, [&](size_t i) {
     dst[i] = static_cast<uint8_t>(std::round((src[i] - min) * ratio));
-  }
+  });
   memset(dst + length, 0, pad_length - length);
 }
 
 template <typename DType>
 void PadQuantize2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n, DType *src, DType *min, DType *max,
                    DType *ratio, float sw_threshold) {
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t src_offset = i * n;
     size_t dst_offset = i * pad_n;
     if (i < m) {
@@ -234,14 +232,13 @@ void PadQuantize2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n,
     } else {
       memset(dst + dst_offset, 0, pad_n);
     }
-  }
+  });
 }
 
 template <typename DType>
 void PadQuantize2D(uint8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n, DType *src, DType *min, DType *max,
                    DType *ratio, float sw_threshold) {
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t src_offset = i * n;
     size_t dst_offset = i * pad_n;
     if (i < m) {
@@ -249,7 +246,7 @@ void PadQuantize2D(uint8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n,
     } else {
       memset(dst + dst_offset, 0, pad_n);
     }
-  }
+  });
 }
 
 template <typename DType, LAYOUT layout>
@@ -18,6 +18,7 @@
 #define PAD_SHUFFLE_H
 
 #include "../../base.h"
+#include "../../parallel.h"
 namespace shuffle {
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadShuffle2D(DType *dst, size_t m, size_t n, DType *src) {
@@ -25,8 +26,7 @@ void PadShuffle2D(DType *dst, size_t m, size_t n, DType *src) {
   size_t pad_n = GetAlignmentLength(n, shuffle_cols);
   size_t shuffle_cols_num = n / shuffle_cols * shuffle_cols;
   size_t patch_size = shuffle_cols * shuffle_rows;
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t x_block_id = i / shuffle_rows;
     size_t offset_in_block = (i % shuffle_rows) * shuffle_cols;
     size_t dst_index = x_block_id * shuffle_rows * pad_n + offset_in_block;
@@ -54,7 +54,26 @@ void PadShuffle2D(DType *dst, size_t m, size_t n, DType *src) {
     for (j = n; j < pad_n; ++j) {
       dst[dst_index++] = 0;
     }
-  }
+  });
+}
+
+// Reorders every shuffle_rows x shuffle_cols patch of a shuffled s8 panel into the VNNI order tdpbusd expects for its
+// second operand: row r of the patch holds k = 4r..4r+3 of all shuffle_rows rows.
+template <size_t shuffle_rows, size_t shuffle_cols>
+void VNNIShuffle2D(int8_t *dst, size_t pad_m, size_t pad_n) {
+  assert(shuffle_cols % 4 == 0);
+  size_t patch_size = shuffle_cols * shuffle_rows;
+  size_t patch_num = pad_m * pad_n / patch_size;
+  ParallelFor(patch_num, [&](size_t p) {
+    int8_t *patch = dst + p * patch_size;
+    int8_t tmp[shuffle_rows * shuffle_cols];
+    memcpy(tmp, patch, patch_size);
+    for (size_t i = 0; i < shuffle_rows; ++i) {
+      for (size_t j = 0; j < shuffle_cols; ++j) {
+        patch[(j / 4) * shuffle_rows * 4 + i * 4 + j % 4] = tmp[i * shuffle_cols + j];
+      }
+    }
+  });
 }
 
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
@@ -67,8 +86,7 @@ void PadQuantizeShuffle(int8_t *dst, size_t m, size_t n, DType *src, DType &min,
   OMPFindMinMaxValue(src, m * n, min, max);
   float scale = std::abs(((max + min) > 0) ? (1.0 * sw_threshold / max) : (1.0 * sw_threshold / min));
   ratio = 1.0 / scale;
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t x_block_id = i / shuffle_rows;
     size_t offset_in_block = (i % shuffle_rows) * shuffle_cols;
     size_t dst_index = x_block_id * shuffle_rows * pad_n + offset_in_block;
@@ -94,7 +112,7 @@ void PadQuantizeShuffle(int8_t *dst, size_t m, size_t n, DType *src, DType &min,
       }
       memset(&dst[dst_index], 0, pad_n - shuffle_cols_num);
     }
-  }
+  });
 }
 
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
@@ -104,8 +122,7 @@ void PadQuantizeShuffle2D(uint8_t *dst, size_t m, size_t n, size_t pad_m, size_t
   assert(GetAlignmentLength(n, shuffle_cols) == pad_n);
   size_t shuffle_cols_num = n / shuffle_cols * shuffle_cols;
   size_t patch_size = shuffle_cols * shuffle_rows;
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t x_block_id = i / shuffle_rows;
     size_t offset_in_block = (i % shuffle_rows) * shuffle_cols;
     size_t dst_index = x_block_id * shuffle_rows * pad_n + offset_in_block;
@@ -134,18 +151,17 @@ void PadQuantizeShuffle2D(uint8_t *dst, size_t m, size_t n, size_t pad_m, size_t
       }
       memset(&dst[dst_index], 0, pad_n - shuffle_cols_num);
     }
-  }
+  });
 }
 
 template <typename DType, size_t shuffle_rows, size_t shuffle_cols>
 void PadQuantizeShuffle2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t pad_n, DType *src, DType *min,
-                          DType *max, DType *ratio, float sw_threshold) {
+                          DType *max, DType *ratio, float sw_threshold, DType *quantized_sum) {
   assert(GetAlignmentLength(m, shuffle_rows) == pad_m);
   assert(GetAlignmentLength(n, shuffle_cols) == pad_n);
   size_t shuffle_cols_num = n / shuffle_cols * shuffle_cols;
   size_t patch_size = shuffle_cols * shuffle_rows;
-#pragma omp parallel for proc_bind(close)
-  for (size_t i = 0; i < pad_m; ++i) {
+  ParallelFor(pad_m, [&](size_t i) {
     size_t x_block_id = i / shuffle_rows;
     size_t offset_in_block = (i % shuffle_rows) * shuffle_cols;
     size_t dst_index = x_block_id * shuffle_rows * pad_n + offset_in_block;
@@ -157,17 +173,23 @@ void PadQuantizeShuffle2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t
       DType scale =
           std::abs(max[i]) > std::abs(min[i]) ? (sw_threshold / std::abs(max[i])) : (sw_threshold / std::abs(min[i]));
       ratio[i] = 1.0 / scale;
+      int32_t row_sum = 0;
       for (j = 0; j < shuffle_cols_num; j += shuffle_cols) {
         for (size_t k = 0; k < shuffle_cols; ++k) {
           dst[dst_index + k] = static_cast<int8_t>(std::round(src[src_index + k] * scale));
+          row_sum += dst[dst_index + k];
         }
         dst_index += patch_size;
         src_index += shuffle_cols;
       }
       for (j = shuffle_cols_num; j < n; ++j) {
-        dst[dst_index++] = static_cast<int8_t>(std::round(src[src_index++] * scale));
+        dst[dst_index] = static_cast<int8_t>(std::round(src[src_index++] * scale));
+        row_sum += dst[dst_index++];
       }
       memset(&dst[dst_index], 0, pad_n - n);
+      if (quantized_sum != NULL) {
+        quantized_sum[i] = row_sum * ratio[i];
+      }
     } else {  // i >= m; memset;
       for (j = 0; j < shuffle_cols_num; j += shuffle_cols) {
         memset(&dst[dst_index], 0, shuffle_cols);
@@ -175,7 +197,7 @@ void PadQuantizeShuffle2D(int8_t *dst, size_t m, size_t n, size_t pad_m, size_t
       }
       memset(&dst[dst_index], 0, pad_n - shuffle_cols_num);
     }
-  }
+  });
 }
 }
 #endif
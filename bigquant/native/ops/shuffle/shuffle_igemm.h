@@ -19,10 +19,14 @@
 
 #include "../../base.h"
 #include "../../common.h"
+#include "../../numa_weight.h"
+#include "../../autotune.h"
 #include "../kernel-common.h"
 #define UNROLL_NUM 4
 
-#if defined(AVX512)
+#if defined(AMX)
+#include "../kernel/shuffle_amx_igemm_16x16x64.h"
+#elif defined(AVX512)
 #include "../kernel/shuffle_avx512_igemm_8x8x8.h"
 #elif defined(__AVX2__)
 #include "../kernel/shuffle_avx2_sse42_igemm_4xnx8-x64.h"
@@ -31,6 +35,16 @@
 #include "../kernel/shuffle_sse42_igemm2x2x16.h"
 #endif
 
+// Held by every parallel task running kernels, see kernel::amx_igemm16x16x64::TileScope
+#if defined(AMX)
+typedef kernel::amx_igemm16x16x64::TileScope KernelScope;
+#else
+struct KernelScope {
+  KernelScope() {
+  }
+};
+#endif
+
 namespace shuffle {
 
 template <size_t kernel_m, size_t kernel_n, size_t kernel_k, typename GEMM_KERNEL>
@@ -46,41 +60,39 @@ void ShuffleGEMM(int8_t *pa, uint8_t *pb, int *pc, size_t m, size_t n, size_t k,
   std::array<size_t, 10> blocks1 = {n, m, n_in_l3, m_in_l3, n_in_l2, m_in_l2, n_in_l1, m_in_l1, kernel_n, kernel_m};
   std::array<size_t, 10> blocks2 = {m, n, m_in_l3, n_in_l3, m_in_l2, n_in_l2, m_in_l1, n_in_l1, kernel_m, kernel_n};
   std::array<size_t, 10> &blocks = (mltn) ? blocks1 : blocks2;
-#pragma omp parallel proc_bind(close)
-  {
-    for (size_t y3 = 0; y3 < blocks[0]; y3 += blocks[2]) {
-      for (size_t x3 = 0; x3 < blocks[1]; x3 += blocks[3]) {
-#pragma omp for collapse(2) schedule(dynamic) nowait
-        for (size_t y2 = 0; y2 < blocks[2]; y2 += blocks[4]) {
-          for (size_t x2 = 0; x2 < blocks[3]; x2 += blocks[5]) {
-            for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
-              for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
-                for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
-                  for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
-                    auto y_sum = y3 + y2 + y1 + y0;
-                    auto x_sum = x3 + x2 + x1 + x0;
-                    auto j_index = mltn ? y_sum : x_sum;
-                    auto i_index = mltn ? x_sum : y_sum;
-                    if ((j_index < n) && (i_index < m)) {
-                      int8_t *local_pa = pa + i_index * k;
-                      uint8_t *local_pb = pb + j_index * k;
-                      void *result[kernel_m];
-                      for (size_t kx = 0; kx < kernel_m; ++kx) {
-                        size_t dst_addr = (i_index + kx) * valid_n + j_index;
-                        result[kx] = reinterpret_cast<void *>(pc + dst_addr);
-                      }
-                      kernel(local_pa, local_pb, k, fault_tolerance, result, std::min(valid_m - i_index, kernel_m),
-                             std::min(valid_n - j_index, kernel_n));
-                    }
-                  }
-                }
+  // Every L2 block of every L3 block, in order, handed out to the threads as they become free
+  size_t y3_num = (blocks[0] + blocks[2] - 1) / blocks[2], x3_num = (blocks[1] + blocks[3] - 1) / blocks[3];
+  size_t y2_num = (blocks[2] + blocks[4] - 1) / blocks[4], x2_num = (blocks[3] + blocks[5] - 1) / blocks[5];
+  ParallelForDynamic(y3_num * x3_num * y2_num * x2_num, 1, [&](size_t block) {
+    KernelScope kernel_scope;
+    size_t y3 = block / (x3_num * y2_num * x2_num) * blocks[2];
+    size_t x3 = block / (y2_num * x2_num) % x3_num * blocks[3];
+    size_t y2 = block / x2_num % y2_num * blocks[4];
+    size_t x2 = block % x2_num * blocks[5];
+    for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
+      for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
+        for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
+          for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
+            auto y_sum = y3 + y2 + y1 + y0;
+            auto x_sum = x3 + x2 + x1 + x0;
+            auto j_index = mltn ? y_sum : x_sum;
+            auto i_index = mltn ? x_sum : y_sum;
+            if ((j_index < n) && (i_index < m)) {
+              int8_t *local_pa = pa + i_index * k;
+              uint8_t *local_pb = pb + j_index * k;
+              void *result[kernel_m];
+              for (size_t kx = 0; kx < kernel_m; ++kx) {
+                size_t dst_addr = (i_index + kx) * valid_n + j_index;
+                result[kx] = reinterpret_cast<void *>(pc + dst_addr);
               }
+              kernel(local_pa, local_pb, k, fault_tolerance, result, std::min(valid_m - i_index, kernel_m),
+                     std::min(valid_n - j_index, kernel_n));
             }
           }
         }
       }
     }
-  }
+  });
 }
 
 // Common Convolution. It's one purely gemm which can be used in wider application.
@@ -99,6 +111,9 @@ void InternalMixPrecisionGemm(ORDER order, enum TRANSPOSE transA, enum TRANSPOSE
   aligned_malloc(reinterpret_cast<void **>(&pad_a), 64, sizeof(int8_t) * m_out * k_out);
   aligned_malloc(reinterpret_cast<void **>(&pad_b), 64, sizeof(uint8_t) * n_out * k_out);
   PadShuffle2D<int8_t, kernel_m, kernel_k>(pad_a, m, k, a);
+#if defined(AMX)
+  VNNIShuffle2D<kernel_m, kernel_k>(pad_a, m_out, k_out);
+#endif
   PadShuffle2D<uint8_t, kernel_n, kernel_k>(pad_b, n, k, b);
 #ifdef TIME_PROFILE
   auto start = std::chrono::system_clock::now();
@@ -121,20 +136,27 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE QuantizedGemmSelect(
     int8_t *&pa, uint8_t *&pb, size_t k, float fault_tolerance, float *result[], size_t length, size_t valid_lanes,
     size_t i_index, size_t j_index, float *ratio_a, float *ratio_b, float *min_b, float *kernel_sum, float *bias,
     bool conv_relu_fusion, bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
-    float *mul_variance_coeff, float *scale, float *shift, bool is_block) {
-#if defined(AVX512)
+    float *mul_variance_coeff, float *scale, float *shift, bool is_block, bool exact_reduce) {
+#if defined(AMX)
+  if ((kernel_m == 16) && (kernel_n == 16) && (kernel_k == 64)) {
+    kernel::amx_igemm16x16x64::ApplyKernelWrapper<kernel_m, kernel_n, kernel_k, layout>(
+        pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
+        bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
+        mul_variance_coeff, scale, shift, is_block, exact_reduce);
+  }
+#elif defined(AVX512)
   if ((kernel_m == 8) && (kernel_n == 8) && (kernel_k == 8)) {
     kernel::avx512_igemm8x8x8::ApplyKernelWrapper<kernel_m, kernel_n, kernel_k, layout>(
         pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
         bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
-        mul_variance_coeff, scale, shift, is_block);
+        mul_variance_coeff, scale, shift, is_block, exact_reduce);
   }
 #elif defined(__AVX2__)
   if ((kernel_m == 4) && (kernel_n == 8) && (kernel_k == 8)) {
     kernel::igemm4xn::ApplyKernelWrapper<kernel_m, kernel_n, kernel_k, layout>(
         pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
         bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
-        mul_variance_coeff, scale, shift, is_block);
+        mul_variance_coeff, scale, shift, is_block, exact_reduce);
   }
   if ((kernel_m == 4) && (kernel_n == 1) && (kernel_k == 32)) {
     kernel::igemm4x1::ApplyKernelWrapper<kernel_m, kernel_n, kernel_k, layout>(
@@ -158,7 +180,7 @@ static INLINE_SPECIFIER void INLINE_ATTRIBUTE QuantizedGemmSelect(
     kernel::sse42_igemm2x2x16::ApplyKernelWrapper<kernel_m, kernel_n, kernel_k, layout>(
         pa, pb, k, fault_tolerance, result, length, valid_lanes, i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
         bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
-        mul_variance_coeff, scale, shift, is_block);
+        mul_variance_coeff, scale, shift, is_block, exact_reduce);
   }
 #endif
 }
@@ -168,7 +190,12 @@ static INLINE_SPECIFIER bool INLINE_ATTRIBUTE NHWCRTGenrateTargetAddr(DType *res
                                                                       size_t valid_n, size_t i_index, size_t j_index,
                                                                       size_t cur_group, size_t channel_per_group,
                                                                       size_t total_channels) {
-#if defined(AVX512)
+#if defined(AMX)
+  if ((kernel_m == 16) && (kernel_n == 16) && (kernel_k == 64)) {
+    return kernel::amx_igemm16x16x64::NHWCRTGenrateTargetAddr<DType, kernel_m, kernel_n, kernel_k>(
+        result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group, total_channels);
+  }
+#elif defined(AVX512)
   if ((kernel_m == 8) && (kernel_n == 8) && (kernel_k == 8)) {
     return kernel::avx512_igemm8x8x8::NHWCRTGenrateTargetAddr<DType, kernel_m, kernel_n, kernel_k>(
         result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group, total_channels);
@@ -200,7 +227,13 @@ template <typename DType, size_t kernel_m, size_t kernel_n, size_t kernel_k>
 static INLINE_SPECIFIER int INLINE_ATTRIBUTE NCHWRTGenrateTargetAddr(
     DType *result[], DType *pc, size_t valid_m, size_t valid_n, size_t i_index, size_t j_index, size_t cur_group,
     size_t feature_map_size_per_image, size_t feature_map_size_per_group, size_t feature_map_size_per_channel) {
-#if defined(AVX512)
+#if defined(AMX)
+  if ((kernel_m == 16) && (kernel_n == 16) && (kernel_k == 64)) {
+    return kernel::amx_igemm16x16x64::NCHWRTGenrateTargetAddr<DType, kernel_m, kernel_n, kernel_k>(
+        result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
+        feature_map_size_per_group, feature_map_size_per_channel);
+  }
+#elif defined(AVX512)
   if ((kernel_m == 8) && (kernel_n == 8) && (kernel_k == 8)) {
     return kernel::avx512_igemm8x8x8::NCHWRTGenrateTargetAddr<DType, kernel_m, kernel_n, kernel_k>(
         result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
@@ -242,77 +275,80 @@ void ConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, size_t m, size_t n, siz
                      size_t channel_per_group, size_t cur_group, size_t height_out, size_t width_out,
                      float fault_tolerance, size_t pad_m, size_t pad_n, bool conv_relu_fusion, bool conv_bn_fusion,
                      bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean, float *mul_variance_coeff,
-                     float *scale, float *shift) {
-#ifdef TIME_PROFILE
-  auto start = std::chrono::system_clock::now();
-#endif
+                     float *scale, float *shift, const BlocksInfo *blocks_info, bool exact_reduce,
+                     const OutputRequantization *requantize, const NumaWeight *numa_weight) {
   assert((fault_tolerance <= 1.0f) && (fault_tolerance >= 0.0f));
   assert((layout == NCHW) || (layout == NHWC));
+  assert((requantize == NULL) || (layout == NHWC));
   size_t feature_map_size_per_channel = height_out * width_out;
   size_t total_channels = channel_per_group * groups;
   size_t feature_map_size_per_image = total_channels * height_out * width_out;
   size_t feature_map_size_per_group = height_out * width_out * channel_per_group;
-  size_t m_in_l1, m_in_l2, m_in_l3, n_in_l1, n_in_l2, n_in_l3;
-  GetBlocksInfo<kernel_m>(m, k, m_in_l1, m_in_l2, m_in_l3);
-  GetBlocksInfo<kernel_n>(n, k, n_in_l1, n_in_l2, n_in_l3);
+  BlocksInfo local_blocks_info;
+  if (blocks_info == NULL) {
+    GetBlocksInfo<kernel_m, kernel_n>(m, n, k, GetThreadsNumWrapper(), local_blocks_info);
+    blocks_info = &local_blocks_info;
+  }
+  size_t m_in_l1 = blocks_info->m_in_l1_, m_in_l2 = blocks_info->m_in_l2_, m_in_l3 = blocks_info->m_in_l3_;
+  size_t n_in_l1 = blocks_info->n_in_l1_, n_in_l2 = blocks_info->n_in_l2_, n_in_l3 = blocks_info->n_in_l3_;
   size_t valid_m = m - pad_m;
   size_t valid_n = n - pad_n;
-  bool mltn = m < n;
+  bool mltn = blocks_info->mltn_;
   std::array<size_t, 10> blocks1 = {n, m, n_in_l3, m_in_l3, n_in_l2, m_in_l2, n_in_l1, m_in_l1, kernel_n, kernel_m};
   std::array<size_t, 10> blocks2 = {m, n, m_in_l3, n_in_l3, m_in_l2, n_in_l2, m_in_l1, n_in_l1, kernel_m, kernel_n};
   std::array<size_t, 10> &blocks = (mltn) ? blocks1 : blocks2;
-#pragma omp parallel proc_bind(close)
-  {
-    for (size_t y3 = 0; y3 < blocks[0]; y3 += blocks[2]) {
-      for (size_t x3 = 0; x3 < blocks[1]; x3 += blocks[3]) {
-#pragma omp for collapse(2) schedule(dynamic, 4) nowait
-        for (size_t y2 = 0; y2 < blocks[2]; y2 += blocks[4]) {
-          for (size_t x2 = 0; x2 < blocks[3]; x2 += blocks[5]) {
-            for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
-              for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
-                for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
-                  for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
-                    auto y_sum = y3 + y2 + y1 + y0;
-                    auto x_sum = x3 + x2 + x1 + x0;
-                    auto j_index = mltn ? y_sum : x_sum;
-                    auto i_index = mltn ? x_sum : y_sum;
-                    if ((j_index < n) && (i_index < m)) {
-                      float *result[kernel_m * kernel_n];
-                      int8_t *local_pa = pa + i_index * k;
-                      uint8_t *local_pb = pb + j_index * k;
-                      bool is_block;
-                      if (layout == NCHW) {
-                        is_block = NCHWRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
-                            result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
-                            feature_map_size_per_group, feature_map_size_per_channel);
-                      } else {
-                        is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
-                            result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group,
-                            total_channels);
-                      }
-                      QuantizedGemmSelect<kernel_m, kernel_n, kernel_k, layout>(
-                          local_pa, local_pb, k, fault_tolerance, result, std::min(valid_m - i_index, kernel_m),
-                          std::min(valid_n - j_index, kernel_n), i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
-                          bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
-                          mul_variance_coeff, scale, shift, is_block);
-                    }
-                  }
-                }
+  // Every L2 block of every L3 block, in order, handed out to the threads as they become free
+  size_t y3_num = (blocks[0] + blocks[2] - 1) / blocks[2], x3_num = (blocks[1] + blocks[3] - 1) / blocks[3];
+  size_t y2_num = (blocks[2] + blocks[4] - 1) / blocks[4], x2_num = (blocks[3] + blocks[5] - 1) / blocks[5];
+  ParallelForDynamic(y3_num * x3_num * y2_num * x2_num, 4, [&](size_t block) {
+    KernelScope kernel_scope;
+    size_t y3 = block / (x3_num * y2_num * x2_num) * blocks[2];
+    size_t x3 = block / (y2_num * x2_num) % x3_num * blocks[3];
+    size_t y2 = block / x2_num % y2_num * blocks[4];
+    size_t x2 = block % x2_num * blocks[5];
+    int8_t *node_pa = NumaLocalPanel(numa_weight, pa);
+    for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
+      for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
+        for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
+          for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
+            auto y_sum = y3 + y2 + y1 + y0;
+            auto x_sum = x3 + x2 + x1 + x0;
+            auto j_index = mltn ? y_sum : x_sum;
+            auto i_index = mltn ? x_sum : y_sum;
+            if ((j_index < n) && (i_index < m)) {
+              float *result[kernel_m * kernel_n];
+              float tile[kernel_m * kernel_n];
+              int8_t *local_pa = node_pa + i_index * k;
+              uint8_t *local_pb = pb + j_index * k;
+              size_t tile_m = std::min(valid_m - i_index, kernel_m);
+              size_t tile_n = std::min(valid_n - j_index, kernel_n);
+              bool is_block;
+              if (requantize != NULL) {
+                is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                    result, tile, tile_m, tile_n, 0, 0, 0, kernel_m, kernel_m);
+              } else if (layout == NCHW) {
+                is_block = NCHWRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                    result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
+                    feature_map_size_per_group, feature_map_size_per_channel);
+              } else {
+                is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                    result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group,
+                    total_channels);
+              }
+              QuantizedGemmSelect<kernel_m, kernel_n, kernel_k, layout>(
+                  local_pa, local_pb, k, fault_tolerance, result, tile_m, tile_n, i_index, j_index, ratio_a,
+                  ratio_b, min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                  conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, is_block, exact_reduce);
+              if (requantize != NULL) {
+                RequantizeTile<kernel_m, kernel_n>(*requantize, tile, tile_m, tile_n, j_index,
+                                                   cur_group * channel_per_group + i_index, total_channels);
               }
             }
           }
         }
       }
     }
-  }
-#ifdef TIME_PROFILE
-  auto end = std::chrono::system_clock::now();
-  auto diff = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  std::cerr << m << "," << n << "," << k << ",";
-  std::cerr << diff.count() << "us, "
-            << (2.0 * m * n * k) / diff.count() / 1.0e3 << " glops"
-            << std::endl;
-#endif
+  });
 }
 #endif
 #if defined(LLC_EXCLUSIVE)
@@ -322,59 +358,71 @@ void ConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, size_t m, size_t n, siz
                      size_t channel_per_group, size_t cur_group, size_t height_out, size_t width_out,
                      float fault_tolerance, size_t pad_m, size_t pad_n, bool conv_relu_fusion, bool conv_bn_fusion,
                      bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean, float *mul_variance_coeff,
-                     float *scale, float *shift) {
-#ifdef TIME_PROFILE
-  auto start = std::chrono::system_clock::now();
-#endif
+                     float *scale, float *shift, const BlocksInfo *blocks_info, bool exact_reduce,
+                     const OutputRequantization *requantize, const NumaWeight *numa_weight) {
   assert((fault_tolerance <= 1.0f) && (fault_tolerance >= 0.0f));
   assert((layout == NCHW) || (layout == NHWC));
+  assert((requantize == NULL) || (layout == NHWC));
   size_t feature_map_size_per_channel = height_out * width_out;
   size_t total_channels = channel_per_group * groups;
   size_t feature_map_size_per_image = total_channels * height_out * width_out;
   size_t feature_map_size_per_group = height_out * width_out * channel_per_group;
-  size_t m_in_l1, m_in_l2, m_in_l3, n_in_l1, n_in_l2, n_in_l3;
-  GetBlocksInfo<kernel_m>(m, k, m_in_l1, m_in_l2, m_in_l3);
-  GetBlocksInfo<kernel_n>(n, k, n_in_l1, n_in_l2, n_in_l3);
+  BlocksInfo local_blocks_info;
+  if (blocks_info == NULL) {
+    GetBlocksInfo<kernel_m, kernel_n>(m, n, k, GetThreadsNumWrapper(), local_blocks_info);
+    blocks_info = &local_blocks_info;
+  }
+  size_t m_in_l1 = blocks_info->m_in_l1_, m_in_l2 = blocks_info->m_in_l2_, m_in_l3 = blocks_info->m_in_l3_;
+  size_t n_in_l1 = blocks_info->n_in_l1_, n_in_l2 = blocks_info->n_in_l2_, n_in_l3 = blocks_info->n_in_l3_;
   size_t valid_m = m - pad_m;
   size_t valid_n = n - pad_n;
-  bool mltn = m < n;
+  bool mltn = blocks_info->mltn_;
   std::array<size_t, 10> blocks1 = {n, m, n_in_l3, m_in_l3, n_in_l2, m_in_l2, n_in_l1, m_in_l1, kernel_n, kernel_m};
   std::array<size_t, 10> blocks2 = {m, n, m_in_l3, n_in_l3, m_in_l2, n_in_l2, m_in_l1, n_in_l1, kernel_m, kernel_n};
   std::array<size_t, 10> &blocks = (mltn) ? blocks1 : blocks2;
-  {
-#pragma omp parallel for collapse(2) schedule(static)
-    for (size_t y3 = 0; y3 < blocks[0]; y3 += blocks[2]) {
-      for (size_t x3 = 0; x3 < blocks[1]; x3 += blocks[3]) {
-        for (size_t y2 = 0; y2 < blocks[2]; y2 += blocks[4]) {
-          for (size_t x2 = 0; x2 < blocks[3]; x2 += blocks[5]) {
-            for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
-              for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
-                for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
-                  for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
-                    auto y_sum = y3 + y2 + y1 + y0;
-                    auto x_sum = x3 + x2 + x1 + x0;
-                    auto j_index = mltn ? y_sum : x_sum;
-                    auto i_index = mltn ? x_sum : y_sum;
-                    if ((j_index < n) && (i_index < m)) {
-                      float *result[kernel_m * kernel_n];
-                      int8_t *local_pa = pa + i_index * k;
-                      uint8_t *local_pb = pb + j_index * k;
-                      bool is_block;
-                      if (layout == NCHW) {
-                        is_block = NCHWRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
-                            result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
-                            feature_map_size_per_group, feature_map_size_per_channel);
-                      } else {
-                        is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
-                            result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group,
-                            total_channels);
-                      }
-                      QuantizedGemmSelect<kernel_m, kernel_n, kernel_k, layout>(
-                          local_pa, local_pb, k, fault_tolerance, result, std::min(valid_m - i_index, kernel_m),
-                          std::min(valid_n - j_index, kernel_n), i_index, j_index, ratio_a, ratio_b, min_b, kernel_sum,
-                          bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion, global_mean,
-                          mul_variance_coeff, scale, shift, is_block);
-                    }
+  size_t y3_num = (blocks[0] + blocks[2] - 1) / blocks[2], x3_num = (blocks[1] + blocks[3] - 1) / blocks[3];
+  ParallelFor(y3_num * x3_num, [&](size_t block) {
+    KernelScope kernel_scope;
+    size_t y3 = block / x3_num * blocks[2];
+    size_t x3 = block % x3_num * blocks[3];
+    int8_t *node_pa = NumaLocalPanel(numa_weight, pa);
+    for (size_t y2 = 0; y2 < blocks[2]; y2 += blocks[4]) {
+      for (size_t x2 = 0; x2 < blocks[3]; x2 += blocks[5]) {
+        for (size_t y1 = 0; y1 < blocks[4]; y1 += blocks[6]) {
+          for (size_t x1 = 0; x1 < blocks[5]; x1 += blocks[7]) {
+            for (size_t y0 = 0; y0 < blocks[6]; y0 += blocks[8]) {
+              for (size_t x0 = 0; x0 < blocks[7]; x0 += blocks[9]) {
+                auto y_sum = y3 + y2 + y1 + y0;
+                auto x_sum = x3 + x2 + x1 + x0;
+                auto j_index = mltn ? y_sum : x_sum;
+                auto i_index = mltn ? x_sum : y_sum;
+                if ((j_index < n) && (i_index < m)) {
+                  float *result[kernel_m * kernel_n];
+                  float tile[kernel_m * kernel_n];
+                  int8_t *local_pa = node_pa + i_index * k;
+                  uint8_t *local_pb = pb + j_index * k;
+                  size_t tile_m = std::min(valid_m - i_index, kernel_m);
+                  size_t tile_n = std::min(valid_n - j_index, kernel_n);
+                  bool is_block;
+                  if (requantize != NULL) {
+                    is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                        result, tile, tile_m, tile_n, 0, 0, 0, kernel_m, kernel_m);
+                  } else if (layout == NCHW) {
+                    is_block = NCHWRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                        result, pc, valid_m, valid_n, i_index, j_index, cur_group, feature_map_size_per_image,
+                        feature_map_size_per_group, feature_map_size_per_channel);
+                  } else {
+                    is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                        result, pc, valid_m, valid_n, i_index, j_index, cur_group, channel_per_group,
+                        total_channels);
+                  }
+                  QuantizedGemmSelect<kernel_m, kernel_n, kernel_k, layout>(
+                      local_pa, local_pb, k, fault_tolerance, result, tile_m, tile_n, i_index, j_index, ratio_a,
+                      ratio_b, min_b, kernel_sum, bias, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion,
+                      conv_relu_bn_fusion, global_mean, mul_variance_coeff, scale, shift, is_block, exact_reduce);
+                  if (requantize != NULL) {
+                    RequantizeTile<kernel_m, kernel_n>(*requantize, tile, tile_m, tile_n, j_index,
+                                                       cur_group * channel_per_group + i_index, total_channels);
                   }
                 }
               }
@@ -383,18 +431,211 @@ void ConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, size_t m, size_t n, siz
         }
       }
     }
-  }
-#ifdef TIME_PROFILE
-  auto end = std::chrono::system_clock::now();
-  auto diff = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-  std::cerr << m << "," << n << "," << k << ",";
-  std::cerr << diff.count() << "us, "
-            << (2.0 * m * n * k) / diff.count() / 1.0e3 << " glops"
-            << std::endl;
+  });
+
+}
+
 #endif
 
+// All the groups of a grouped convolution as one parallel loop over (group, m block, n block) instead of one parallel
+// GEMM per group, so that groups too small to feed every thread still keep them all busy. pa, pb, ratio_a, ratio_b and
+// min_b hold one pointer per group, kernel_sum, bias and the batch norm statistics cover all the output channels.
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k, LAYOUT layout>
+void GroupedConvShuffleGEMM(int8_t *pa[], uint8_t *pb[], float *pc, size_t m, size_t n, size_t k, float *ratio_a[],
+                            float *ratio_b[], float *kernel_sum, float *min_b[], float *bias, size_t batch_size,
+                            size_t groups, size_t channel_per_group, size_t height_out, size_t width_out,
+                            float fault_tolerance, size_t pad_m, size_t pad_n, bool conv_relu_fusion,
+                            bool conv_bn_fusion, bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
+                            float *mul_variance_coeff, float *scale, float *shift, const BlocksInfo *blocks_info,
+                            bool exact_reduce, const OutputRequantization *requantize,
+                            const NumaWeight *numa_weight) {
+  assert((fault_tolerance <= 1.0f) && (fault_tolerance >= 0.0f));
+  assert((layout == NCHW) || (layout == NHWC));
+  assert((requantize == NULL) || (layout == NHWC));
+  size_t feature_map_size_per_channel = height_out * width_out;
+  size_t total_channels = channel_per_group * groups;
+  size_t feature_map_size_per_image = total_channels * height_out * width_out;
+  size_t feature_map_size_per_group = height_out * width_out * channel_per_group;
+  BlocksInfo local_blocks_info;
+  if (blocks_info == NULL) {
+    size_t threads_num = GetThreadsNumWrapper();
+    GetBlocksInfo<kernel_m, kernel_n>(m, n, k, (threads_num + groups - 1) / groups, local_blocks_info);
+    blocks_info = &local_blocks_info;
+  }
+  size_t m_in_l1 = blocks_info->m_in_l1_, m_in_l2 = blocks_info->m_in_l2_;
+  size_t n_in_l1 = blocks_info->n_in_l1_, n_in_l2 = blocks_info->n_in_l2_;
+  size_t valid_m = m - pad_m;
+  size_t valid_n = n - pad_n;
+  size_t m_blocks = (m + m_in_l2 - 1) / m_in_l2;
+  size_t n_blocks = (n + n_in_l2 - 1) / n_in_l2;
+  bool mltn = blocks_info->mltn_;
+  ParallelForDynamic(groups * m_blocks * n_blocks, 1, [&](size_t block) {
+    KernelScope kernel_scope;
+    size_t g = block / (m_blocks * n_blocks);
+    size_t mb = block / n_blocks % m_blocks;
+    size_t nb = block % n_blocks;
+    size_t channel_offset = g * channel_per_group;
+    int8_t *group_pa = NumaLocalPanel(numa_weight, pa[g], g);
+    float *group_kernel_sum = kernel_sum + channel_offset;
+    float *group_bias = (bias == NULL) ? NULL : bias + channel_offset;
+    float *group_global_mean = (global_mean == NULL) ? NULL : global_mean + channel_offset;
+    float *group_mul_variance_coeff = (mul_variance_coeff == NULL) ? NULL : mul_variance_coeff + channel_offset;
+    float *group_scale = (scale == NULL) ? NULL : scale + channel_offset;
+    float *group_shift = (shift == NULL) ? NULL : shift + channel_offset;
+    size_t m_begin = mb * m_in_l2, m_end = std::min(m_begin + m_in_l2, m);
+    size_t n_begin = nb * n_in_l2, n_end = std::min(n_begin + n_in_l2, n);
+    // Same loop order as ConvShuffleGEMM, the longer dimension outside
+    size_t y_begin = mltn ? n_begin : m_begin, y_end = mltn ? n_end : m_end;
+    size_t x_begin = mltn ? m_begin : n_begin, x_end = mltn ? m_end : n_end;
+    size_t y_in_l1 = mltn ? n_in_l1 : m_in_l1, x_in_l1 = mltn ? m_in_l1 : n_in_l1;
+    size_t y_tile = mltn ? kernel_n : kernel_m, x_tile = mltn ? kernel_m : kernel_n;
+    for (size_t y1 = y_begin; y1 < y_end; y1 += y_in_l1) {
+      for (size_t x1 = x_begin; x1 < x_end; x1 += x_in_l1) {
+        for (size_t y0 = y1; y0 < std::min(y1 + y_in_l1, y_end); y0 += y_tile) {
+          for (size_t x0 = x1; x0 < std::min(x1 + x_in_l1, x_end); x0 += x_tile) {
+            size_t j_index = mltn ? y0 : x0;
+            size_t i_index = mltn ? x0 : y0;
+            float *result[kernel_m * kernel_n];
+            float tile[kernel_m * kernel_n];
+            int8_t *local_pa = group_pa + i_index * k;
+            uint8_t *local_pb = pb[g] + j_index * k;
+            size_t tile_m = std::min(valid_m - i_index, kernel_m);
+            size_t tile_n = std::min(valid_n - j_index, kernel_n);
+            bool is_block;
+            if (requantize != NULL) {
+              is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                  result, tile, tile_m, tile_n, 0, 0, 0, kernel_m, kernel_m);
+            } else if (layout == NCHW) {
+              is_block = NCHWRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                  result, pc, valid_m, valid_n, i_index, j_index, g, feature_map_size_per_image,
+                  feature_map_size_per_group, feature_map_size_per_channel);
+            } else {
+              is_block = NHWCRTGenrateTargetAddr<float, kernel_m, kernel_n, kernel_k>(
+                  result, pc, valid_m, valid_n, i_index, j_index, g, channel_per_group, total_channels);
+            }
+            QuantizedGemmSelect<kernel_m, kernel_n, kernel_k, layout>(
+                local_pa, local_pb, k, fault_tolerance, result, tile_m, tile_n, i_index, j_index, ratio_a[g],
+                ratio_b[g], min_b[g], group_kernel_sum, group_bias, conv_relu_fusion, conv_bn_fusion,
+                conv_bn_relu_fusion, conv_relu_bn_fusion, group_global_mean, group_mul_variance_coeff,
+                group_scale, group_shift, is_block, exact_reduce);
+            if (requantize != NULL) {
+              RequantizeTile<kernel_m, kernel_n>(*requantize, tile, tile_m, tile_n, j_index,
+                                                 channel_offset + i_index, total_channels);
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+// Rounds a blocking to whole kernel tiles, every level a multiple of the one below as the GEMM loops expect
+INLINE_SPECIFIER void NormalizeBlocks(size_t extent, size_t tile, size_t &in_l1, size_t &in_l2, size_t &in_l3) {
+  size_t one = 1;
+  in_l1 = std::min(std::max(in_l1 / tile, one) * tile, GetAlignmentLength(extent, tile));
+  in_l2 = std::min(std::max(in_l2 / in_l1, one) * in_l1, GetAlignmentLength(extent, in_l1));
+  in_l3 = std::min(std::max(in_l3 / in_l2, one) * in_l2, GetAlignmentLength(extent, in_l2));
+}
+
+// Best of AUTOTUNE_REPEAT runs of the GEMM with the given blocking, in microseconds
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k>
+double TimeConvShuffleGEMM(int8_t *pa, uint8_t *pb, float *pc, float *ones, float *zeros, size_t m, size_t n,
+                           size_t k, const BlocksInfo &blocks_info) {
+  double best = DBL_MAX;
+  for (size_t r = 0; r < AUTOTUNE_REPEAT; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    ConvShuffleGEMM<kernel_m, kernel_n, kernel_k, NHWC>(pa, pb, pc, m, n, k, ones, ones, zeros, zeros, NULL, n, 1, m,
+                                                        0, 1, 1, 0.5, 0, 0, false, false, false, false, NULL, NULL,
+                                                        NULL, NULL, &blocks_info, false, NULL, NULL);
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  return best;
 }
 
+// The cache file is shared and hand editable, so an entry is only trusted once rounded to whole kernel tiles
+template <size_t kernel_m, size_t kernel_n>
+bool FindTunedBlocksInfo(TuningCache &cache, const TuningKey &key, BlocksInfo &blocks_info) {
+  if (!cache.Find(key, blocks_info)) {
+    return false;
+  }
+  NormalizeBlocks(key[0], kernel_m, blocks_info.m_in_l1_, blocks_info.m_in_l2_, blocks_info.m_in_l3_);
+  NormalizeBlocks(key[1], kernel_n, blocks_info.n_in_l1_, blocks_info.n_in_l2_, blocks_info.n_in_l3_);
+  return true;
+}
+
+// GetBlocksInfo, refined by timing when auto tuning is on. From the heuristic blocking, every block size is halved
+// and doubled in turn and the loop order flipped, keeping each change that runs faster. The operands are scratch
+// buffers of the padded shape, the NHWC output stands for both layouts.
+template <size_t kernel_m, size_t kernel_n, size_t kernel_k>
+void TuneBlocksInfo(size_t m, size_t n, size_t k, size_t threads_num, BlocksInfo &blocks_info) {
+  GetBlocksInfo<kernel_m, kernel_n>(m, n, k, threads_num, blocks_info);
+  TuningCache &cache = GetTuningCache();
+  if (!cache.Enabled()) {
+    return;
+  }
+  TuningKey key = {{m, n, k, threads_num}};
+  if (FindTunedBlocksInfo<kernel_m, kernel_n>(cache, key, blocks_info)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(cache.TuneMutex());
+  if (FindTunedBlocksInfo<kernel_m, kernel_n>(cache, key, blocks_info)) {
+    return;
+  }
+
+  int8_t *pa;
+  uint8_t *pb;
+  float *pc;
+  aligned_malloc(reinterpret_cast<void **>(&pa), 64, sizeof(int8_t) * m * k);
+  aligned_malloc(reinterpret_cast<void **>(&pb), 64, sizeof(uint8_t) * n * k);
+  aligned_malloc(reinterpret_cast<void **>(&pc), 64, sizeof(float) * m * n);
+  for (size_t i = 0; i < m * k; ++i) {
+    pa[i] = static_cast<int8_t>(i % 127 - 63);
+  }
+  for (size_t i = 0; i < n * k; ++i) {
+    pb[i] = static_cast<uint8_t>(i % 127);
+  }
+  std::vector<float> ones(std::max(m, n), 1.0f), zeros(std::max(m, n), 0.0f);
+
+  BlocksInfo best = blocks_info;
+  // The first run also pays for the page faults and the thread wake up
+  TimeConvShuffleGEMM<kernel_m, kernel_n, kernel_k>(pa, pb, pc, ones.data(), zeros.data(), m, n, k, best);
+  double best_time = TimeConvShuffleGEMM<kernel_m, kernel_n, kernel_k>(pa, pb, pc, ones.data(), zeros.data(), m, n,
+                                                                       k, best);
+  size_t BlocksInfo::*fields[] = {&BlocksInfo::m_in_l1_, &BlocksInfo::m_in_l2_, &BlocksInfo::m_in_l3_,
+                                  &BlocksInfo::n_in_l1_, &BlocksInfo::n_in_l2_, &BlocksInfo::n_in_l3_};
+  for (size_t candidate = 0; candidate < 13; ++candidate) {
+    BlocksInfo trial = best;
+    if (candidate < 12) {
+      size_t &field = trial.*fields[candidate / 2];
+      field = (candidate % 2 == 0) ? field / 2 : field * 2;
+      NormalizeBlocks(m, kernel_m, trial.m_in_l1_, trial.m_in_l2_, trial.m_in_l3_);
+      NormalizeBlocks(n, kernel_n, trial.n_in_l1_, trial.n_in_l2_, trial.n_in_l3_);
+      if ((trial.m_in_l1_ == best.m_in_l1_) && (trial.m_in_l2_ == best.m_in_l2_) &&
+          (trial.m_in_l3_ == best.m_in_l3_) && (trial.n_in_l1_ == best.n_in_l1_) &&
+          (trial.n_in_l2_ == best.n_in_l2_) && (trial.n_in_l3_ == best.n_in_l3_)) {
+        continue;
+      }
+    } else {
+      trial.mltn_ = !trial.mltn_;
+    }
+    double time = TimeConvShuffleGEMM<kernel_m, kernel_n, kernel_k>(pa, pb, pc, ones.data(), zeros.data(), m, n, k,
+                                                                    trial);
+    if (time < best_time) {
+      best = trial;
+      best_time = time;
+    }
+  }
+  aligned_free(pa);
+  aligned_free(pb);
+  aligned_free(pc);
+
+#if defined(DEBUG)
+  std::cerr << "tuned m:" << m << " n:" << n << " k:" << k << " m_in_l1:" << best.m_in_l1_ << " n_in_l1:"
+            << best.n_in_l1_ << " mltn:" << best.mltn_ << " " << best_time << "us" << std::endl;
 #endif
+  cache.Store(key, best);
+  blocks_info = best;
+}
 }
 #endif
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OPS_SHUFFLE_SHUFFLE_IGEMV_H
+#define OPS_SHUFFLE_SHUFFLE_IGEMV_H
+
+#include "../../base.h"
+#include "../../common.h"
+#include "../../numa_weight.h"
+#include "../kernel-common.h"
+
+// A GEMM with a handful of columns is bound by streaming the weight, padding the columns to the kernel width only
+// multiplies the work. This variant reads the same shuffled weight panel as the GEMM, a kernel_m x kernel_k patch per
+// vector load (two for SSE4.2), and broadcasts the kernel_k data bytes of every column against it, so each weight byte
+// is loaded once for all the columns. Every int32 lane accumulates 4 products of one row, the data being at most 127
+// the int16 pair sums of the non-VNNI path cannot saturate whatever the weight range.
+namespace shuffle {
+
+// Bytes ahead of the current patch the weight stream is prefetched, one prefetch per cache line consumed
+#define GEMV_PREFETCH_DISTANCE 1024
+#define GEMV_CACHE_LINE 64
+
+#if !defined(AMX)
+static INLINE_SPECIFIER SIMDSITYPE INLINE_ATTRIBUTE GEMVLoadWeight(const int8_t *p) {
+#if defined(AVX512)
+  return _mm512_loadu_si512(p);
+#elif defined(__AVX2__)
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+#else
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+#endif
+}
+
+// The kernel_k data bytes of a column repeated over the rows a vector of the patch holds
+static INLINE_SPECIFIER SIMDSITYPE INLINE_ATTRIBUTE GEMVBroadcastData(const uint8_t *p) {
+#if defined(AVX512) || defined(__AVX2__)
+  int64_t value;
+  memcpy(&value, p, sizeof(value));
+#if defined(AVX512)
+  return _mm512_set1_epi64(value);
+#else
+  return _mm256_set1_epi64x(value);
+#endif
+#else
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+#endif
+}
+
+static INLINE_SPECIFIER SIMDSITYPE INLINE_ATTRIBUTE GEMVDotAccumulate(SIMDSITYPE acc, SIMDSITYPE data,
+                                                                      SIMDSITYPE weight) {
+#if defined(AVX512_VNNI)
+  __asm__("vpdpbusd %2, %1, %0" : "+v"(acc) : "v"(data), "v"(weight));
+  return acc;
+#elif defined(DPBUSD_EPI32)
+  return DPBUSD_EPI32(acc, data, weight);
+#else
+  return ADD_EPI32(acc, MADD_EPI16(MADD_EPI8(data, weight), SET1_EPI16(1)));
+#endif
+}
+
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE GEMVStoreLanes(int32_t *dst, SIMDSITYPE value) {
+#if defined(AVX512)
+  _mm512_storeu_si512(dst, value);
+#elif defined(__AVX2__)
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), value);
+#else
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), value);
+#endif
+}
+
+// One block of kernel_m rows against batch columns. Two accumulator sets over the even and odd patches hide the
+// latency of the dot products when batch is 1.
+template <size_t kernel_m, size_t kernel_k, size_t batch>
+static INLINE_SPECIFIER void INLINE_ATTRIBUTE GEMVBlock(const int8_t *pa, const uint8_t *pb, size_t k,
+                                                        int32_t sum[][kernel_m]) {
+  const size_t vectors = kernel_m * kernel_k / OPERAND_WIDTH;
+  const size_t lanes_per_row = kernel_k / 4;
+  SIMDSITYPE even[batch][vectors], odd[batch][vectors];
+  for (size_t j = 0; j < batch; ++j) {
+    for (size_t v = 0; v < vectors; ++v) {
+      even[j][v] = ZEROS();
+      odd[j][v] = ZEROS();
+    }
+  }
+  size_t patches = k / kernel_k;
+  size_t p = 0;
+  for (; p + 2 <= patches; p += 2) {
+    for (size_t line = 0; line < 2 * kernel_m * kernel_k; line += GEMV_CACHE_LINE) {
+      _mm_prefetch(reinterpret_cast<const char *>(pa) + GEMV_PREFETCH_DISTANCE + line, _MM_HINT_T0);
+    }
+    for (size_t v = 0; v < vectors; ++v) {
+      SIMDSITYPE first = GEMVLoadWeight(pa + v * OPERAND_WIDTH);
+      SIMDSITYPE second = GEMVLoadWeight(pa + (vectors + v) * OPERAND_WIDTH);
+      for (size_t j = 0; j < batch; ++j) {
+        even[j][v] = GEMVDotAccumulate(even[j][v], GEMVBroadcastData(pb + j * k + p * kernel_k), first);
+        odd[j][v] = GEMVDotAccumulate(odd[j][v], GEMVBroadcastData(pb + j * k + (p + 1) * kernel_k), second);
+      }
+    }
+    pa += 2 * kernel_m * kernel_k;
+  }
+  if (p < patches) {
+    for (size_t v = 0; v < vectors; ++v) {
+      SIMDSITYPE weight = GEMVLoadWeight(pa + v * OPERAND_WIDTH);
+      for (size_t j = 0; j < batch; ++j) {
+        even[j][v] = GEMVDotAccumulate(even[j][v], GEMVBroadcastData(pb + j * k + p * kernel_k), weight);
+      }
+    }
+  }
+  int32_t lanes[OPERAND_WIDTH / 4];
+  for (size_t j = 0; j < batch; ++j) {
+    for (size_t v = 0; v < vectors; ++v) {
+      GEMVStoreLanes(lanes, ADD_EPI32(even[j][v], odd[j][v]));
+      for (size_t r = 0; r < OPERAND_WIDTH / kernel_k; ++r) {
+        int32_t row_sum = 0;
+        for (size_t l = 0; l < lanes_per_row; ++l) {
+          row_sum += lanes[r * lanes_per_row + l];
+        }
+        sum[j][v * OPERAND_WIDTH / kernel_k + r] = row_sum;
+      }
+    }
+  }
+}
+
+template <size_t kernel_m, size_t kernel_k, size_t batch>
+void ShuffleGEMVBatch(int8_t *pa, const uint8_t *pb, float *pc, size_t m, size_t k, const float *ratio_a,
+                      const float *ratio_b, const float *kernel_sum, const float *min_b, const float *bias,
+                      size_t valid_m, const NumaWeight *numa_weight) {
+  ParallelFor((m + kernel_m - 1) / kernel_m, [&](size_t block) {
+    size_t i = block * kernel_m;
+    const int8_t *node_pa = NumaLocalPanel(numa_weight, pa);
+    int32_t sum[batch][kernel_m];
+    GEMVBlock<kernel_m, kernel_k, batch>(node_pa + i * k, pb, k, sum);
+    for (size_t j = 0; j < batch; ++j) {
+      for (size_t r = 0; r < std::min(kernel_m, valid_m - i); ++r) {
+        pc[j * valid_m + i + r] = ratio_a[i + r] * ratio_b[j] * sum[j][r] + kernel_sum[i + r] * min_b[j] +
+                                  ((bias == NULL) ? 0.0f : bias[i + r]);
+      }
+    }
+  });
+}
+
+template <size_t kernel_m, size_t kernel_k>
+void ShuffleGEMV(int8_t *pa, const uint8_t *pb, float *pc, size_t m, size_t n, size_t k, const float *ratio_a,
+                 const float *ratio_b, const float *kernel_sum, const float *min_b, const float *bias, size_t valid_m,
+                 const NumaWeight *numa_weight) {
+  switch (n) {
+    case 1:
+      ShuffleGEMVBatch<kernel_m, kernel_k, 1>(pa, pb, pc, m, k, ratio_a, ratio_b, kernel_sum, min_b, bias, valid_m,
+                                              numa_weight);
+      break;
+    case 2:
+      ShuffleGEMVBatch<kernel_m, kernel_k, 2>(pa, pb, pc, m, k, ratio_a, ratio_b, kernel_sum, min_b, bias, valid_m,
+                                              numa_weight);
+      break;
+    case 3:
+      ShuffleGEMVBatch<kernel_m, kernel_k, 3>(pa, pb, pc, m, k, ratio_a, ratio_b, kernel_sum, min_b, bias, valid_m,
+                                              numa_weight);
+      break;
+    case 4:
+      ShuffleGEMVBatch<kernel_m, kernel_k, 4>(pa, pb, pc, m, k, ratio_a, ratio_b, kernel_sum, min_b, bias, valid_m,
+                                              numa_weight);
+      break;
+    default:
+      fprintf(stderr, "GEMV with %zu columns, at most %d supported.\n", n, FC_GEMV_MAX_BATCH);
+      exit(-1);
+  }
+}
+#endif
+}
+#endif
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OPS_WINOGRAD_WINOGRAD_H
+#define OPS_WINOGRAD_WINOGRAD_H
+
+#include "../../base.h"
+#include "../../common.h"
+#include "../kernel-common.h"
+
+#define WINOGRAD_TILE_SIZE 16
+
+// Offset added before the float to int conversion of the quantize kernel, cvttps of sse42 truncates instead of rounding
+#if defined(AVX512) || defined(__AVX2__)
+#define WINOGRAD_QUANTIZE_ROUNDING 0.0f
+#else
+#define WINOGRAD_QUANTIZE_ROUNDING 0.5f
+#endif
+
+// F(2x2, 3x3): every 4x4 input tile gives a 2x2 output tile. With
+//   B^T = [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1], G = [1 0 0; .5 .5 .5; .5 -.5 .5; 0 0 1], A^T = [1 1 1 0; 0 1 -1 -1]
+// the output tile is A^T [(G g G^T) .* (B^T d B)] A. Summed over the input channels, each of the 16 element wise
+// products is a GEMM of channel_out x tiles x channel_in, run by the shuffle igemm.
+namespace winograd {
+
+// weight is channel_out x height x width x channel_in, transformed_weight is WINOGRAD_TILE_SIZE x channel_out x
+// channel_in
+void NHWCWinograd3x3KernelProcess(float *transformed_weight, float *weight, int channel_out, int channel_in, int height,
+                                  int width) {
+  assert((height == 3) && (width == 3));
+  size_t plane = static_cast<size_t>(channel_out) * channel_in;
+  ParallelFor(channel_out * channel_in, [&](size_t idx) {
+    size_t o = idx / channel_in;
+    size_t c = idx % channel_in;
+    const float *g = weight + static_cast<size_t>(o) * height * width * channel_in + c;
+    float gk[3][3];
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        gk[i][j] = g[(i * 3 + j) * channel_in];
+      }
+    }
+    // G g
+    float t[4][3];
+    for (int j = 0; j < 3; ++j) {
+      t[0][j] = gk[0][j];
+      t[1][j] = 0.5f * (gk[0][j] + gk[1][j] + gk[2][j]);
+      t[2][j] = 0.5f * (gk[0][j] - gk[1][j] + gk[2][j]);
+      t[3][j] = gk[2][j];
+    }
+    // (G g) G^T
+    float *u = transformed_weight + static_cast<size_t>(o) * channel_in + c;
+    for (int i = 0; i < 4; ++i) {
+      u[(i * 4 + 0) * plane] = t[i][0];
+      u[(i * 4 + 1) * plane] = 0.5f * (t[i][0] + t[i][1] + t[i][2]);
+      u[(i * 4 + 2) * plane] = 0.5f * (t[i][0] - t[i][1] + t[i][2]);
+      u[(i * 4 + 3) * plane] = t[i][2];
+    }
+  });
+}
+
+// Quantizes and shuffles the m x n kernel of every tile element. quantized_kernel holds WINOGRAD_TILE_SIZE panels of
+// pad_m x pad_n, min, max and ratio WINOGRAD_TILE_SIZE x m values. quantized_sum, if given, receives the per row sum
+// of the quantized kernel scaled back by ratio.
+void NHWCWinogradQuantizeKernelByChannel(int8_t *quantized_kernel, float *transformed_kernel, size_t m, size_t n,
+                                         size_t pad_m, size_t pad_n, float *min, float *max, float *ratio,
+                                         float sw_threshold, float *quantized_sum) {
+  for (size_t t = 0; t < WINOGRAD_TILE_SIZE; ++t) {
+    shuffle::PadQuantizeShuffle2D<float, CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_K>(
+        quantized_kernel + t * pad_m * pad_n, m, n, pad_m, pad_n, transformed_kernel + t * m * n, min + t * m,
+        max + t * m, ratio + t * m, sw_threshold, (quantized_sum == NULL) ? NULL : quantized_sum + t * m);
+#if defined(AMX)
+    shuffle::VNNIShuffle2D<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_K>(quantized_kernel + t * pad_m * pad_n, pad_m,
+                                                                        pad_n);
+#endif
+  }
+}
+
+// data is batch_size x height x width x channel_in. Every 4x4 input tile is transformed along all channels into the
+// workspace of its thread, then each of the 16 transformed rows is quantized with its own range straight into the
+// shuffled panel of its tile element, pad_tiles x pad_channel_in bytes each. workspace holds (WINOGRAD_TILE_SIZE + 1) x
+// channel_in floats per thread.
+void NHWCWinograd3x3DataProcess(uint8_t *transformed_data, float *data, size_t batch_size, size_t channel_in,
+                                size_t height, size_t width, size_t pad_h, size_t pad_w, size_t patch_y_num,
+                                size_t patch_x_num, float *min, float *max, float *ratio, float sw_threshold,
+                                float *workspace) {
+  const size_t rows = CONV_SHUFFLE_KERNEL_N;
+  const size_t cols = CONV_SHUFFLE_KERNEL_K;
+  size_t tiles = batch_size * patch_y_num * patch_x_num;
+  size_t pad_tiles = GetAlignmentLength(tiles, rows);
+  size_t pad_channel_in = GetAlignmentLength(channel_in, cols);
+  size_t panel_size = pad_tiles * pad_channel_in;
+  size_t full_cols = channel_in / cols * cols;
+  size_t simd_channel_in = channel_in / PS_OPERAND_WIDTH * PS_OPERAND_WIDTH;
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    float *v = workspace + thread_id * (WINOGRAD_TILE_SIZE + 1) * channel_in;
+    float *zeros = v + WINOGRAD_TILE_SIZE * channel_in;
+    memset(zeros, 0, sizeof(float) * channel_in);
+    for (size_t n = ThreadRangeBegin(tiles, thread_id, threads_num);
+         n < ThreadRangeBegin(tiles, thread_id + 1, threads_num); ++n) {
+      size_t b = n / (patch_y_num * patch_x_num);
+      size_t ty = n / patch_x_num % patch_y_num;
+      size_t tx = n % patch_x_num;
+      // Rows and columns of the tile falling in the padded border read zeros
+      const float *src[4][4];
+      for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+          int y = static_cast<int>(ty * 2 + i) - static_cast<int>(pad_h);
+          int x = static_cast<int>(tx * 2 + j) - static_cast<int>(pad_w);
+          bool valid = (y >= 0) && (y < static_cast<int>(height)) && (x >= 0) && (x < static_cast<int>(width));
+          src[i][j] = valid ? data + ((b * height + y) * width + x) * channel_in : zeros;
+        }
+      }
+      size_t c = 0;
+      for (; c < simd_channel_in; c += PS_OPERAND_WIDTH) {
+        // B^T d
+        SIMDPSTYPE t[4][4];
+        for (size_t j = 0; j < 4; ++j) {
+          SIMDPSTYPE d0 = LOADU_PS(src[0][j] + c);
+          SIMDPSTYPE d1 = LOADU_PS(src[1][j] + c);
+          SIMDPSTYPE d2 = LOADU_PS(src[2][j] + c);
+          SIMDPSTYPE d3 = LOADU_PS(src[3][j] + c);
+          t[0][j] = SUB_PS(d0, d2);
+          t[1][j] = ADD_PS(d1, d2);
+          t[2][j] = SUB_PS(d2, d1);
+          t[3][j] = SUB_PS(d1, d3);
+        }
+        // (B^T d) B
+        for (size_t i = 0; i < 4; ++i) {
+          STOREU_PS(v + (i * 4 + 0) * channel_in + c, SUB_PS(t[i][0], t[i][2]));
+          STOREU_PS(v + (i * 4 + 1) * channel_in + c, ADD_PS(t[i][1], t[i][2]));
+          STOREU_PS(v + (i * 4 + 2) * channel_in + c, SUB_PS(t[i][2], t[i][1]));
+          STOREU_PS(v + (i * 4 + 3) * channel_in + c, SUB_PS(t[i][1], t[i][3]));
+        }
+      }
+      for (; c < channel_in; ++c) {
+        float t[4][4];
+        for (size_t j = 0; j < 4; ++j) {
+          t[0][j] = src[0][j][c] - src[2][j][c];
+          t[1][j] = src[1][j][c] + src[2][j][c];
+          t[2][j] = src[2][j][c] - src[1][j][c];
+          t[3][j] = src[1][j][c] - src[3][j][c];
+        }
+        for (size_t i = 0; i < 4; ++i) {
+          v[(i * 4 + 0) * channel_in + c] = t[i][0] - t[i][2];
+          v[(i * 4 + 1) * channel_in + c] = t[i][1] + t[i][2];
+          v[(i * 4 + 2) * channel_in + c] = t[i][2] - t[i][1];
+          v[(i * 4 + 3) * channel_in + c] = t[i][1] - t[i][3];
+        }
+      }
+      for (size_t e = 0; e < WINOGRAD_TILE_SIZE; ++e) {
+        float *row = v + e * channel_in;
+        size_t index = e * tiles + n;
+        FindMinMaxValue(row, channel_in, min[index], max[index]);
+        // A tile of the padded border transforms to a constant row
+        if (!(max[index] > min[index])) {
+          max[index] = min[index] + 1.0f;
+        }
+        float scale = sw_threshold / (max[index] - min[index]);
+        float shift = -min[index] * scale;
+        ratio[index] = 1.0f / scale;
+        SIMDPSTYPE simdscale = SET1_PS(scale);
+        SIMDPSTYPE simdshift = SET1_PS(shift + WINOGRAD_QUANTIZE_ROUNDING);
+        uint8_t *dst = transformed_data + e * panel_size + (n / rows) * rows * pad_channel_in + (n % rows) * cols;
+        for (c = 0; c < full_cols; c += cols) {
+          // The quantize kernel the shuffle im2col of this ISA uses
+          QUANTIZE_KERNEL_FUNC(dst, row + c, simdscale, simdshift);
+          dst += rows * cols;
+        }
+        for (; c < channel_in; ++c) {
+          *(dst++) = static_cast<uint8_t>(row[c] * scale + shift + 0.5f);
+        }
+        memset(dst, 0, pad_channel_in - channel_in);
+      }
+    }
+  });
+  // The padded tiles only need to be finite, their results are never stored
+  for (size_t e = 0; e < WINOGRAD_TILE_SIZE; ++e) {
+    for (size_t n = tiles; n < pad_tiles; ++n) {
+      uint8_t *dst = transformed_data + e * panel_size + (n / rows) * rows * pad_channel_in + (n % rows) * cols;
+      for (size_t c = 0; c < pad_channel_in; c += cols) {
+        memset(dst, 0, cols);
+        dst += rows * cols;
+      }
+    }
+  }
+}
+
+// intermedia_out receives WINOGRAD_TILE_SIZE planes of tiles x channel_out, tiles = batch_size * patch_y_num *
+// patch_x_num. ratio_a and sum_a hold WINOGRAD_TILE_SIZE x channel_out values, ratio_b and min_b WINOGRAD_TILE_SIZE x
+// tiles ones.
+void NHWCWinograd3x3ElementWiseBatchMul(float *intermedia_out, int8_t *transformed_kernel, uint8_t *transformed_data,
+                                        size_t batch_size, size_t patch_y_num, size_t patch_x_num, size_t channel_in,
+                                        size_t channel_out, float *ratio_a, float *sum_a, float *ratio_b, float *min_b,
+                                        const BlocksInfo *blocks_info, bool exact_reduce) {
+  size_t tiles = batch_size * patch_y_num * patch_x_num;
+  size_t pad_m = GetAlignmentLength(channel_out, CONV_SHUFFLE_KERNEL_M);
+  size_t pad_n = GetAlignmentLength(tiles, CONV_SHUFFLE_KERNEL_N);
+  size_t pad_k = GetAlignmentLength(channel_in, CONV_SHUFFLE_KERNEL_K);
+  for (size_t e = 0; e < WINOGRAD_TILE_SIZE; ++e) {
+    shuffle::ConvShuffleGEMM<CONV_SHUFFLE_KERNEL_M, CONV_SHUFFLE_KERNEL_N, CONV_SHUFFLE_KERNEL_K, NHWC>(
+        transformed_kernel + e * pad_m * pad_k, transformed_data + e * pad_n * pad_k,
+        intermedia_out + e * tiles * channel_out, pad_m, pad_n, pad_k, ratio_a + e * channel_out, ratio_b + e * tiles,
+        sum_a + e * channel_out, min_b + e * tiles, NULL, 1, 1, channel_out, 0, 1, tiles, 0.5, pad_m - channel_out,
+        pad_n - tiles, false, false, false, false, NULL, NULL, NULL, NULL, blocks_info, exact_reduce);
+  }
+}
+
+// Applies A^T . A to every tile, adds the bias and runs the fused epilogue, writing the valid part of the 2x2 output
+// tiles in the given layout.
+void NHWCWinograd3x3PostProcess(float *out, float *intermedia_out, size_t batch_size, size_t patch_y_num,
+                                size_t patch_x_num, size_t channel_out, size_t height_out, size_t width_out,
+                                LAYOUT layout, float *bias, bool conv_relu_fusion, bool conv_bn_fusion,
+                                bool conv_bn_relu_fusion, bool conv_relu_bn_fusion, float *global_mean,
+                                float *mul_variance_coeff, float *scale, float *shift) {
+  size_t tiles = batch_size * patch_y_num * patch_x_num;
+  size_t plane = tiles * channel_out;
+  size_t simd_channel_out = channel_out / PS_OPERAND_WIDTH * PS_OPERAND_WIDTH;
+  bool fusion = conv_relu_fusion || conv_bn_fusion || conv_bn_relu_fusion || conv_relu_bn_fusion;
+  // Only the NHWC output without post op is stored straight from the vector registers
+  bool direct = (layout == NHWC) && !fusion;
+  ParallelFor(tiles, [&](size_t n) {
+    size_t b = n / (patch_y_num * patch_x_num);
+    size_t y = n / patch_x_num % patch_y_num * 2;
+    size_t x = n % patch_x_num * 2;
+    size_t valid_y = std::min<size_t>(2, height_out - y);
+    size_t valid_x = std::min<size_t>(2, width_out - x);
+    const float *m = intermedia_out + n * channel_out;
+    float r[2][2][PS_OPERAND_WIDTH];
+    size_t o = 0;
+    for (; o < channel_out; o += PS_OPERAND_WIDTH) {
+      size_t lanes = std::min<size_t>(PS_OPERAND_WIDTH, channel_out - o);
+      if (o < simd_channel_out) {
+        // A^T m
+        SIMDPSTYPE s[2][4];
+        for (size_t j = 0; j < 4; ++j) {
+          SIMDPSTYPE m0 = LOADU_PS(m + j * plane + o);
+          SIMDPSTYPE m1 = LOADU_PS(m + (4 + j) * plane + o);
+          SIMDPSTYPE m2 = LOADU_PS(m + (8 + j) * plane + o);
+          SIMDPSTYPE m3 = LOADU_PS(m + (12 + j) * plane + o);
+          s[0][j] = ADD_PS(ADD_PS(m0, m1), m2);
+          s[1][j] = SUB_PS(SUB_PS(m1, m2), m3);
+        }
+        // (A^T m) A
+        SIMDPSTYPE simd_bias = (bias == NULL) ? SET1_PS(0.0f) : LOADU_PS(bias + o);
+        for (size_t i = 0; i < 2; ++i) {
+          SIMDPSTYPE r0 = ADD_PS(ADD_PS(ADD_PS(s[i][0], s[i][1]), s[i][2]), simd_bias);
+          SIMDPSTYPE r1 = ADD_PS(SUB_PS(SUB_PS(s[i][1], s[i][2]), s[i][3]), simd_bias);
+          if (direct) {
+            if (i < valid_y) {
+              float *dst = out + ((b * height_out + y + i) * width_out + x) * channel_out + o;
+              STOREU_PS(dst, r0);
+              if (valid_x > 1) {
+                STOREU_PS(dst + channel_out, r1);
+              }
+            }
+          } else {
+            STOREU_PS(r[i][0], r0);
+            STOREU_PS(r[i][1], r1);
+          }
+        }
+        if (direct) {
+          continue;
+        }
+      } else {
+        for (size_t l = 0; l < lanes; ++l) {
+          float s[2][4];
+          for (size_t j = 0; j < 4; ++j) {
+            s[0][j] = m[j * plane + o + l] + m[(4 + j) * plane + o + l] + m[(8 + j) * plane + o + l];
+            s[1][j] = m[(4 + j) * plane + o + l] - m[(8 + j) * plane + o + l] - m[(12 + j) * plane + o + l];
+          }
+          float b_o = (bias == NULL) ? 0.0f : bias[o + l];
+          for (size_t i = 0; i < 2; ++i) {
+            r[i][0][l] = s[i][0] + s[i][1] + s[i][2] + b_o;
+            r[i][1][l] = s[i][1] - s[i][2] - s[i][3] + b_o;
+          }
+        }
+      }
+      for (size_t i = 0; i < valid_y; ++i) {
+        for (size_t j = 0; j < valid_x; ++j) {
+          for (size_t l = 0; l < lanes; ++l) {
+            float result = r[i][j][l];
+            if (fusion) {
+              ScalarFusion(result, o + l, conv_relu_fusion, conv_bn_fusion, conv_bn_relu_fusion, conv_relu_bn_fusion,
+                           global_mean, mul_variance_coeff, scale, shift);
+            }
+            if (layout == NHWC) {
+              out[((b * height_out + y + i) * width_out + x + j) * channel_out + o + l] = result;
+            } else {
+              out[((b * channel_out + o + l) * height_out + y + i) * width_out + x + j] = result;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+}
+#endif
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include "base.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Every parallel loop of the kernels goes through ParallelRun / ParallelFor / ParallelForDynamic, which dispatch to the
+// backend selected by BigQuantSetParallelBackend or BigQuantSetParallelExecutor:
+//   OPENMP_BACKEND       the OpenMP runtime the library is built with, serial in a build without OpenMP
+//   THREAD_POOL_BACKEND  a pool of std::thread spinning a while between parallel regions before they sleep, so
+//                        back to back layers do not pay a wake up, and that never meets the OpenMP runtime of the host
+//   HOST_BACKEND         an executor supplied by the host, e.g. a wrapper around the JVM's own fork join pool
+// A parallel region entered from inside another one, or from another host thread while the pool is busy, runs on the
+// calling thread alone.
+
+// pause iterations a pool thread spins waiting for the next region before it sleeps
+#define THREAD_POOL_SPIN_COUNT 200000
+
+struct ThreadPool {
+  explicit ThreadPool(size_t threads_num) : state_(0), pending_(0), stop_(false), task_(NULL), task_context_(NULL) {
+    for (size_t id = 1; id < threads_num; ++id) {
+      workers_.push_back(std::thread(&ThreadPool::Work, this, id));
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_.store(true);
+    }
+    wake_.notify_all();
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      workers_[i].join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t ThreadsNum() const {
+    return workers_.size() + 1;
+  }
+
+  // Runs task(task_context, id) for id in [0, tasks_num), id 0 on the calling thread. Returns false without running
+  // anything when another thread holds the pool.
+  bool TryRun(size_t tasks_num, PARALLEL_TASK task, void *task_context) {
+    if (!run_mutex_.try_lock()) {
+      return false;
+    }
+    tasks_num = std::min(tasks_num, ThreadsNum());
+    task_ = task;
+    task_context_ = task_context;
+    pending_.store(tasks_num - 1, std::memory_order_relaxed);
+    // The low bits tell each worker whether it takes part, the high ones make every region a new state
+    uint64_t generation = (state_.load(std::memory_order_relaxed) >> 32) + 1;
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      state_.store((generation << 32) | tasks_num, std::memory_order_release);
+    }
+    wake_.notify_all();
+    task(task_context, 0);
+    for (size_t spins = 0; pending_.load(std::memory_order_acquire) != 0; ++spins) {
+      if (spins < THREAD_POOL_SPIN_COUNT) {
+        _mm_pause();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    run_mutex_.unlock();
+    return true;
+  }
+
+ private:
+  void Work(size_t id) {
+    uint64_t seen = 0;
+    while (true) {
+      uint64_t state = state_.load(std::memory_order_acquire);
+      for (size_t spins = 0; (state == seen) && !stop_.load(std::memory_order_relaxed); ++spins) {
+        if (spins < THREAD_POOL_SPIN_COUNT) {
+          _mm_pause();
+        } else {
+          std::unique_lock<std::mutex> lock(sleep_mutex_);
+          wake_.wait(lock, [&] { return (state_.load(std::memory_order_acquire) != seen) || stop_.load(); });
+        }
+        state = state_.load(std::memory_order_acquire);
+      }
+      if (stop_.load()) {
+        return;
+      }
+      seen = state;
+      // The task stays valid until the last participant is done, the others never read it
+      if (id < (state & 0xffffffff)) {
+        task_(task_context_, id);
+        pending_.fetch_sub(1, std::memory_order_release);
+      }
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::atomic<uint64_t> state_;
+  std::atomic<size_t> pending_;
+  std::atomic<bool> stop_;
+  PARALLEL_TASK task_;
+  void *task_context_;
+  std::mutex run_mutex_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+};
+
+struct ParallelContext {
+  ParallelContext()
+      : backend_(
+#if defined(THREAD_POOL_DEFAULT)
+            THREAD_POOL_BACKEND
+#else
+            OPENMP_BACKEND
+#endif
+            ),
+        threads_num_(0),
+        executor_(NULL),
+        host_context_(NULL),
+        pool_(NULL) {
+  }
+
+  ~ParallelContext() {
+    delete pool_.load();
+  }
+
+  PARALLEL_BACKEND backend_;
+  // 0 is the default of the backend, the OpenMP one or a thread per hardware thread
+  size_t threads_num_;
+  PARALLEL_EXECUTOR executor_;
+  void *host_context_;
+  // Set once by the first region, which several host threads may enter at the same time
+  std::atomic<ThreadPool *> pool_;
+  std::mutex pool_mutex_;
+};
+
+INLINE_SPECIFIER ParallelContext &GetParallelContext() {
+  static ParallelContext context;
+  return context;
+}
+
+INLINE_SPECIFIER bool &InParallelRegion() {
+  static thread_local bool in_region = false;
+  return in_region;
+}
+
+INLINE_SPECIFIER size_t GetHardwareThreadsNum() {
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// The pool is started by the first region, not when the library is loaded
+INLINE_SPECIFIER ThreadPool *GetThreadPool() {
+  ParallelContext &context = GetParallelContext();
+  ThreadPool *pool = context.pool_.load(std::memory_order_acquire);
+  if (pool == NULL) {
+    std::lock_guard<std::mutex> lock(context.pool_mutex_);
+    pool = context.pool_.load(std::memory_order_relaxed);
+    if (pool == NULL) {
+      pool = new ThreadPool((context.threads_num_ == 0) ? GetHardwareThreadsNum() : context.threads_num_);
+      context.pool_.store(pool, std::memory_order_release);
+    }
+  }
+  return pool;
+}
+
+// Not thread safe, no op may execute while the backend changes
+INLINE_SPECIFIER void SetParallelBackend(PARALLEL_BACKEND backend, size_t threads_num, PARALLEL_EXECUTOR executor,
+                                         void *host_context) {
+  ParallelContext &context = GetParallelContext();
+  if ((backend == HOST_BACKEND) && (executor == NULL)) {
+    fprintf(stderr, "Host parallel backend without an executor.\n");
+    exit(-1);
+  }
+  delete context.pool_.exchange(NULL);
+  context.backend_ = backend;
+  context.threads_num_ = threads_num;
+  context.executor_ = executor;
+  context.host_context_ = host_context;
+}
+
+INLINE_SPECIFIER size_t GetBackendThreadsNum() {
+  ParallelContext &context = GetParallelContext();
+  switch (context.backend_) {
+    case THREAD_POOL_BACKEND:
+      return (context.threads_num_ == 0) ? GetHardwareThreadsNum() : context.threads_num_;
+    case HOST_BACKEND:
+      return std::max(context.threads_num_, static_cast<size_t>(1));
+    default:
+#ifdef _OPENMP
+      return (context.threads_num_ == 0) ? omp_get_max_threads() : context.threads_num_;
+#else
+      return 1;
+#endif
+  }
+}
+
+// Bound on the threads of the regions the calling thread opens, 0 for none. Set by an op for its execution only.
+INLINE_SPECIFIER size_t &ThreadsLimit() {
+  static thread_local size_t limit = 0;
+  return limit;
+}
+
+struct ScopedThreadsLimit {
+  explicit ScopedThreadsLimit(size_t limit) : previous_(ThreadsLimit()) {
+    ThreadsLimit() = limit;
+  }
+
+  ~ScopedThreadsLimit() {
+    ThreadsLimit() = previous_;
+  }
+
+  ScopedThreadsLimit(const ScopedThreadsLimit &) = delete;
+
+  ScopedThreadsLimit &operator=(const ScopedThreadsLimit &) = delete;
+
+ private:
+  size_t previous_;
+};
+
+// Number of threads a parallel region runs with, also the number of per-thread workspace slices to reserve
+INLINE_SPECIFIER size_t GetMaxThreadsNum() {
+  size_t limit = ThreadsLimit();
+  size_t threads_num = GetBackendThreadsNum();
+  return (limit == 0) ? threads_num : std::min(limit, threads_num);
+}
+
+// The threads_num of an op, AUTO_THREADS_NUM resolved for work multiply-adds
+INLINE_SPECIFIER size_t GetOpThreadsNum(size_t threads_num, size_t work) {
+  if (threads_num != AUTO_THREADS_NUM) {
+    return threads_num;
+  }
+  size_t threads = (work + AUTO_THREADS_WORK_PER_THREAD - 1) / AUTO_THREADS_WORK_PER_THREAD;
+  return std::max(std::min(threads, GetBackendThreadsNum()), static_cast<size_t>(1));
+}
+
+// First index of the contiguous part of [0, n) thread_id takes, the part ends where the one of thread_id + 1 begins
+INLINE_SPECIFIER size_t ThreadRangeBegin(size_t n, size_t thread_id, size_t threads_num) {
+  return n * thread_id / threads_num;
+}
+
+template <typename F>
+struct ParallelRegion {
+  static void Task(void *task_context, size_t task_id) {
+    ParallelRegion *region = static_cast<ParallelRegion *>(task_context);
+    bool &in_region = InParallelRegion();
+    bool outer = in_region;
+    in_region = true;
+    region->f_(task_id, region->threads_num_);
+    in_region = outer;
+  }
+
+  F &f_;
+  size_t threads_num_;
+};
+
+// Calls f(thread_id, threads_num) once on each thread of a parallel region
+template <typename F>
+void ParallelRun(F f) {
+  size_t threads_num = GetMaxThreadsNum();
+  if (InParallelRegion() || (threads_num == 1)) {
+    f(0, 1);
+    return;
+  }
+  ParallelContext &context = GetParallelContext();
+  if (context.backend_ == OPENMP_BACKEND) {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(threads_num) proc_bind(close)
+    {
+      ParallelRegion<F> region = {f, static_cast<size_t>(omp_get_num_threads())};
+      ParallelRegion<F>::Task(&region, omp_get_thread_num());
+    }
+#else
+    f(0, 1);
+#endif
+    return;
+  }
+  ParallelRegion<F> region = {f, threads_num};
+  if (context.backend_ == HOST_BACKEND) {
+    context.executor_(context.host_context_, threads_num, ParallelRegion<F>::Task, &region);
+    return;
+  }
+  ThreadPool *pool = GetThreadPool();
+  region.threads_num_ = std::min(threads_num, pool->ThreadsNum());
+  if (!pool->TryRun(region.threads_num_, ParallelRegion<F>::Task, &region)) {
+    f(0, 1);
+  }
+}
+
+// Calls f(i) for i in [begin, end), each thread taking one contiguous range
+template <typename F>
+void ParallelFor(size_t begin, size_t end, F f) {
+  if ((GetParallelContext().backend_ == OPENMP_BACKEND) && !InParallelRegion()) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(GetMaxThreadsNum()) proc_bind(close)
+#endif
+    for (size_t i = begin; i < end; ++i) {
+      f(i);
+    }
+    return;
+  }
+  size_t n = (end > begin) ? (end - begin) : 0;
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    for (size_t i = ThreadRangeBegin(n, thread_id, threads_num); i < ThreadRangeBegin(n, thread_id + 1, threads_num);
+         ++i) {
+      f(begin + i);
+    }
+  });
+}
+
+template <typename F>
+void ParallelFor(size_t n, F f) {
+  ParallelFor(0, n, f);
+}
+
+// Calls f(i) for i in [0, n), the threads taking chunks of chunk_size indices in order as they become free
+template <typename F>
+void ParallelForDynamic(size_t n, size_t chunk_size, F f) {
+  if ((GetParallelContext().backend_ == OPENMP_BACKEND) && !InParallelRegion()) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(GetMaxThreadsNum()) proc_bind(close) schedule(dynamic, chunk_size)
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+  std::atomic<size_t> next(0);
+  ParallelRun([&](size_t thread_id, size_t threads_num) {
+    for (size_t begin = next.fetch_add(chunk_size); begin < n; begin = next.fetch_add(chunk_size)) {
+      for (size_t i = begin; i < std::min(begin + chunk_size, n); ++i) {
+        f(i);
+      }
+    }
+  });
+}
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "base.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+// Per-phase timings of the executions of an op, switched on per op at runtime. An execution being profiled points the
+// thread_local CurrentProfile at its counters, the ProfileTimer of every phase the calling thread then enters adds to
+// them. Timers nest: an inner phase is taken out of the outer one, so the phases never count the same time twice.
+// Nothing is recorded on the worker threads, a phase is timed as a whole around its parallel loops.
+typedef enum PROFILE_PHASE {
+  PROFILE_LAYOUT_TRANSFORM = 0,
+  PROFILE_FIND_EXTREME = 1,
+  PROFILE_QUANTIZE = 2,
+  PROFILE_GEMM = 3,
+  PROFILE_EPILOGUE = 4,
+  PROFILE_PHASES_NUM = 5
+} PROFILE_PHASE;
+
+struct ExecutionProfile {
+  double phase_us_[PROFILE_PHASES_NUM];
+};
+
+struct ProfileTimer;
+
+INLINE_SPECIFIER ExecutionProfile *&CurrentProfile() {
+  static thread_local ExecutionProfile *profile = NULL;
+  return profile;
+}
+
+INLINE_SPECIFIER ProfileTimer *&CurrentProfileTimer() {
+  static thread_local ProfileTimer *timer = NULL;
+  return timer;
+}
+
+struct ProfileTimer {
+  explicit ProfileTimer(PROFILE_PHASE phase) : phase_(phase), profile_(CurrentProfile()), parent_(NULL) {
+    if (profile_ == NULL) {
+      return;
+    }
+    parent_ = CurrentProfileTimer();
+    CurrentProfileTimer() = this;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  ~ProfileTimer() {
+    if (profile_ == NULL) {
+      return;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_).count();
+    profile_->phase_us_[phase_] += us;
+    if (parent_ != NULL) {
+      profile_->phase_us_[parent_->phase_] -= us;
+    }
+    CurrentProfileTimer() = parent_;
+  }
+
+  ProfileTimer(const ProfileTimer &) = delete;
+
+  ProfileTimer &operator=(const ProfileTimer &) = delete;
+
+ private:
+  PROFILE_PHASE phase_;
+  ExecutionProfile *profile_;
+  ProfileTimer *parent_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// The counters of an op, summed over its executions since profiling was enabled
+struct OpProfiler {
+  OpProfiler() : enabled_(false) {
+    Clear();
+  }
+
+  // Enabling clears the counters
+  void Enable(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clear();
+    enabled_ = enabled;
+  }
+
+  bool Enabled() const {
+    return enabled_;
+  }
+
+  void Add(const ExecutionProfile &execution, double total_us, double bytes, double ops) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++profile_.executions;
+    profile_.total_us += total_us;
+    profile_.layout_transform_us += execution.phase_us_[PROFILE_LAYOUT_TRANSFORM];
+    profile_.find_extreme_us += execution.phase_us_[PROFILE_FIND_EXTREME];
+    profile_.quantize_us += execution.phase_us_[PROFILE_QUANTIZE];
+    profile_.gemm_us += execution.phase_us_[PROFILE_GEMM];
+    profile_.epilogue_us += execution.phase_us_[PROFILE_EPILOGUE];
+    profile_.bytes += bytes;
+    ops_ += ops;
+  }
+
+  bool Get(QuantizedOpProfile &profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_) {
+      return false;
+    }
+    profile = profile_;
+    profile.gops = (profile_.total_us > 0.0) ? ops_ / profile_.total_us / 1.0e3 : 0.0;
+    return true;
+  }
+
+ private:
+  void Clear() {
+    profile_ = QuantizedOpProfile();
+    ops_ = 0.0;
+  }
+
+  std::atomic<bool> enabled_;
+  std::mutex mutex_;
+  QuantizedOpProfile profile_;
+  double ops_;
+};
+
+// Profiles the execution in its scope when the profiler is enabled, bytes and ops being the traffic and the operations
+// of that execution
+struct ScopedProfile {
+  ScopedProfile(OpProfiler &profiler, double bytes, double ops)
+      : profiler_(profiler.Enabled() ? &profiler : NULL), bytes_(bytes), ops_(ops), previous_(NULL),
+        previous_timer_(NULL) {
+    if (profiler_ == NULL) {
+      return;
+    }
+    execution_ = ExecutionProfile();
+    previous_ = CurrentProfile();
+    previous_timer_ = CurrentProfileTimer();
+    CurrentProfile() = &execution_;
+    CurrentProfileTimer() = NULL;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedProfile() {
+    if (profiler_ == NULL) {
+      return;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_).count();
+    CurrentProfile() = previous_;
+    CurrentProfileTimer() = previous_timer_;
+    profiler_->Add(execution_, us, bytes_, ops_);
+  }
+
+  ScopedProfile(const ScopedProfile &) = delete;
+
+  ScopedProfile &operator=(const ScopedProfile &) = delete;
+
+ private:
+  OpProfiler *profiler_;
+  double bytes_;
+  double ops_;
+  ExecutionProfile execution_;
+  ExecutionProfile *previous_;
+  ProfileTimer *previous_timer_;
+  std::chrono::steady_clock::time_point start_;
+};
+#endif
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <array>
 #include <vector>
+#include <string>
+#include <functional>
 #include <algorithm>
+#include <cmath>
+#include <random>
 #include "bigquant.h"
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
@@ -90,6 +94,740 @@ void TestConvolutionTensor(size_t data_batch, size_t data_channel, size_t data_h
   delete kernel_sum_tensor;
 }
 
+void TestConvolutionWorkspaceReuse(size_t max_batch, size_t data_channel, size_t data_height, size_t data_width,
+                                   size_t group, size_t filter_num, size_t filter_size, LAYOUT layout) {
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  std::vector<float> weight(filter_num * data_channel * filter_size * filter_size / group, 1.0f);
+  QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1, 0,
+                                    0, 1, 1, 0, SHUFFLE_CONV);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  QuantizedConvOpReserveWorkspace(desc, max_batch, data_channel, data_height, data_width);
+  size_t out_height = GetConvOutSize(data_height, filter_size, 1, 0, 1);
+  size_t out_width = GetConvOutSize(data_width, filter_size, 1, 0, 1);
+  // shrink below and grow beyond the reserved batch size
+  for (size_t batch = 1; batch <= 2 * max_batch; batch *= 2) {
+    std::vector<float> data(batch * data_channel * data_height * data_width, 1.0f);
+    std::vector<float> out(batch * filter_num * out_height * out_width, 0.0f);
+    QuantizedConvOpExecute(desc, out.data(), data.data(), NULL, batch, data_channel, data_height, data_width);
+    for (auto iter = out.begin(); iter < out.end(); ++iter) {
+      DOUBLES_EQUAL(*iter, data_channel / group * filter_size * filter_size, 1e-6);
+    }
+  }
+  QuantizedConvOpFree(desc);
+}
+
+void TestConvolutionFusion(size_t data_batch, size_t data_channel, size_t data_size, size_t group, size_t filter_num,
+                           size_t filter_size, size_t fusion_mask, LAYOUT layout, CONV_ALGORITHM algo = SHUFFLE_CONV) {
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  std::vector<float> weight(filter_num * data_channel * filter_size * filter_size / group, 1.0f);
+  std::vector<float> data(data_batch * data_channel * data_size * data_size, 1.0f);
+  size_t out_size = GetConvOutSize(data_size, filter_size, 1, 0, 1);
+  std::vector<float> out(data_batch * filter_num * out_size * out_size, 0.0f);
+  float sum = data_channel / group * filter_size * filter_size;
+  // make a part of the channels negative so that relu takes effect
+  std::vector<float> bias(filter_num), mean(filter_num), variance(filter_num), scale(filter_num), shift(filter_num);
+  for (size_t c = 0; c < filter_num; ++c) {
+    bias[c] = (c % 3 == 0) ? -2.0f * sum : 0.5f * c;
+    mean[c] = 0.1f * c;
+    variance[c] = 1.0f + 0.5f * c;
+    scale[c] = (c % 2 == 0) ? 2.0f : -1.0f;
+    shift[c] = 0.25f * c;
+  }
+  float eps = 1e-5f;
+  QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1, 0,
+                                    0, 1, 1, fusion_mask, algo);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  QuantizedConvOpSetBatchNorm(desc, mean.data(), variance.data(), scale.data(), shift.data(), eps);
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+  for (size_t i = 0; i < out.size(); ++i) {
+    size_t c = (layout == NCHW) ? (i / (out_size * out_size)) % filter_num : i % filter_num;
+    float expect = sum + bias[c];
+    if (fusion_mask & (CONV_RELU_FUSION | CONV_RELU_BN_FUSION)) {
+      expect = std::max(expect, 0.0f);
+    }
+    if (fusion_mask & (CONV_BN_FUSION | CONV_BN_RELU_FUSION | CONV_RELU_BN_FUSION)) {
+      expect = (expect - mean[c]) / sqrtf(variance[c] + eps) * scale[c] + shift[c];
+    }
+    if (fusion_mask & CONV_BN_RELU_FUSION) {
+      expect = std::max(expect, 0.0f);
+    }
+    DOUBLES_EQUAL(out[i], expect, 1e-3);
+  }
+}
+
+// The weights and data of the tests that change a setting of an op, which may change how the op computes but never
+// its output. expect holds the output of the op as created, out the one checked against it.
+struct ConvFixture {
+  ConvFixture(size_t data_batch, size_t data_channel, size_t data_size, size_t group, size_t filter_num,
+              size_t filter_size, size_t pad, LAYOUT layout, CONV_ALGORITHM algo)
+      : data_batch(data_batch), data_channel(data_channel), data_size(data_size), group(group),
+        filter_num(filter_num), filter_size(filter_size), pad(pad), layout(layout), algo(algo) {
+    weight.resize(filter_num * data_channel * filter_size * filter_size / group);
+    for (size_t i = 0; i < weight.size(); ++i) {
+      weight[i] = static_cast<float>((i * 37) % 17) - 8.0f;
+    }
+    data.resize(data_batch * data_channel * data_size * data_size);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = static_cast<float>((i * 13) % 11) * 0.5f;
+    }
+    size_t out_size = GetConvOutSize(data_size, filter_size, 1, pad, 1);
+    expect.resize(data_batch * filter_num * out_size * out_size, 0.0f);
+    out.resize(expect.size(), 0.0f);
+  }
+
+  // An op set up for the shape, without a weight
+  QuantizedConvOp* Setup() {
+    QuantizedConvOp* desc = QuantizedConvOpCreate();
+    QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1,
+                                      pad, pad, 1, 1, 0, algo);
+    return desc;
+  }
+
+  QuantizedConvOp* Create() {
+    QuantizedConvOp* desc = Setup();
+    QuantizedConvOpInitWeight(desc, weight.data());
+    return desc;
+  }
+
+  void Execute(QuantizedConvOp* desc, std::vector<float>& output) {
+    QuantizedConvOpExecute(desc, output.data(), data.data(), NULL, data_batch, data_channel, data_size, data_size);
+  }
+
+  void Check(QuantizedConvOp* desc) {
+    std::fill(out.begin(), out.end(), 0.0f);
+    Execute(desc, out);
+    for (size_t i = 0; i < out.size(); ++i) {
+      DOUBLES_EQUAL(expect[i], out[i], 1e-6);
+    }
+  }
+
+  // Applies the settings to one op in turn, checking its output after each
+  void CheckSettings(size_t settings_num, const std::function<void(QuantizedConvOp*, size_t)>& setting) {
+    QuantizedConvOp* desc = Create();
+    Execute(desc, expect);
+    for (size_t s = 0; s < settings_num; ++s) {
+      setting(desc, s);
+      Check(desc);
+    }
+    QuantizedConvOpFree(desc);
+  }
+
+  size_t data_batch, data_channel, data_size, group, filter_num, filter_size, pad;
+  LAYOUT layout;
+  CONV_ALGORITHM algo;
+  std::vector<float> weight, data, expect, out;
+};
+
+void TestConvolutionWeightBlob(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                               size_t filter_num, size_t filter_size, LAYOUT layout) {
+  const char* path = "test_conv_weight.blob";
+  ConvFixture fixture(data_batch, data_channel, data_size, group, filter_num, filter_size, 0, layout, SHUFFLE_CONV);
+  QuantizedConvOp* desc = fixture.Setup();
+  CHECK_EQUAL(WEIGHT_BLOB_UNSUPPORTED, QuantizedConvOpSaveWeight(desc, path));
+  QuantizedConvOpInitWeight(desc, fixture.weight.data());
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedConvOpSaveWeight(desc, path));
+  fixture.Execute(desc, fixture.expect);
+  QuantizedConvOpFree(desc);
+
+  QuantizedConvOp* loaded = fixture.Setup();
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedConvOpLoadWeight(loaded, path));
+  fixture.Check(loaded);
+  QuantizedConvOpFree(loaded);
+
+  // a blob can not be loaded into an op with a different weight shape
+  QuantizedConvOp* mismatch = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(mismatch, layout, filter_num + 1, data_channel, group, filter_size, filter_size, 1,
+                                    1, 0, 0, 1, 1, 0, SHUFFLE_CONV);
+  CHECK_EQUAL(WEIGHT_BLOB_MISMATCH, QuantizedConvOpLoadWeight(mismatch, path));
+  CHECK_EQUAL(WEIGHT_BLOB_MISMATCH, QuantizedConvOpMapWeight(mismatch, path));
+  QuantizedConvOpFree(mismatch);
+
+  // two ops sharing one mapping of the blob, which stays valid after the file is removed
+  QuantizedConvOp* mapped[2];
+  for (size_t n = 0; n < 2; ++n) {
+    mapped[n] = fixture.Setup();
+    CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedConvOpMapWeight(mapped[n], path));
+  }
+  remove(path);
+  for (size_t n = 0; n < 2; ++n) {
+    fixture.Check(mapped[n]);
+    QuantizedConvOpFree(mapped[n]);
+  }
+}
+
+// The placed weight is a copy of the quantized one, so every NUMA mode gives the same output. On a single node or
+// without libnuma the modes fall back to NUMA_NONE.
+void TestConvolutionNumaMode(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                             size_t filter_num, size_t filter_size, LAYOUT layout) {
+  ConvFixture fixture(data_batch, data_channel, data_size, group, filter_num, filter_size, 0, layout, SHUFFLE_CONV);
+  NUMA_MODE modes[] = {NUMA_REPLICATE, NUMA_INTERLEAVE, NUMA_NONE};
+  fixture.CheckSettings(4, [&](QuantizedConvOp* desc, size_t m) {
+    if (m < 3) {
+      QuantizedConvOpSetNumaMode(desc, modes[m]);
+    } else {
+      // a weight initialized later is placed as well
+      QuantizedConvOpSetNumaMode(desc, NUMA_REPLICATE);
+      QuantizedConvOpInitWeight(desc, fixture.weight.data());
+    }
+  });
+}
+
+// Runs the tasks one after the other in reverse order, as a host executor is free to
+static void ReverseExecutor(void* host_context, size_t tasks_num, PARALLEL_TASK task, void* task_context) {
+  ++*static_cast<size_t*>(host_context);
+  for (size_t i = tasks_num; i > 0; --i) {
+    task(task_context, i - 1);
+  }
+}
+
+// Every backend splits the same loops differently, the output must not depend on it
+void TestConvolutionParallelBackend(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                                    size_t filter_num, size_t filter_size, LAYOUT layout, CONV_ALGORITHM algo) {
+  ConvFixture fixture(data_batch, data_channel, data_size, group, filter_num, filter_size, 1, layout, algo);
+  size_t regions = 0;
+  BigQuantSetParallelBackend(OPENMP_BACKEND, 1);
+  fixture.CheckSettings(3, [&](QuantizedConvOp*, size_t backend) {
+    if (backend == 0) {
+      BigQuantSetParallelBackend(OPENMP_BACKEND, 0);
+    } else if (backend == 1) {
+      BigQuantSetParallelBackend(THREAD_POOL_BACKEND, 4);
+    } else {
+      BigQuantSetParallelExecutor(ReverseExecutor, &regions, 3);
+    }
+  });
+  BigQuantSetParallelBackend(OPENMP_BACKEND, 0);
+  CHECK(regions > 0);
+}
+
+// The op bounded to fewer threads than the pool holds, or sizing them from its work, still computes the same output
+void TestConvolutionNumThreads(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                               size_t filter_num, size_t filter_size, LAYOUT layout, CONV_ALGORITHM algo) {
+  ConvFixture fixture(data_batch, data_channel, data_size, group, filter_num, filter_size, 1, layout, algo);
+  size_t threads[] = {1, 2, AUTO_THREADS_NUM, 0};
+  BigQuantSetParallelBackend(THREAD_POOL_BACKEND, 4);
+  fixture.CheckSettings(4, [&](QuantizedConvOp* desc, size_t t) {
+    QuantizedConvOpSetNumThreads(desc, threads[t]);
+    QuantizedConvOpReserveWorkspace(desc, data_batch, data_channel, data_size, data_size);
+  });
+  BigQuantSetParallelBackend(OPENMP_BACKEND, 0);
+}
+
+// The file holds the single winner of the tuned run, the third run found it. Its blocking is replaced with sizes off
+// the kernel tiles, which the cache has to round back to whole tiles.
+void CorruptTuningCache(const char* path) {
+  FILE* fp = fopen(path, "r");
+  CHECK(fp != NULL);
+  std::vector<std::string> lines;
+  char line[1024];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lines.push_back(line);
+  }
+  fclose(fp);
+  CHECK(lines.size() == 1);
+  // cpu, isa, then m n k threads_num before the blocking
+  size_t blocking = lines[0].rfind('\t') + 1;
+  for (size_t i = 0; i < 4; ++i) {
+    blocking = lines[0].find(' ', blocking) + 1;
+  }
+  fp = fopen(path, "w");
+  CHECK(fp != NULL);
+  fprintf(fp, "%s12 36 64 40 200 200 0\n", lines[0].substr(0, blocking).c_str());
+  fclose(fp);
+}
+
+// The tuned blocking, whether measured or read back from the cache file, only changes the order of the tiles
+void TestConvolutionAutoTuning(size_t data_batch, size_t data_channel, size_t data_size, size_t filter_num,
+                               size_t filter_size, LAYOUT layout, CONV_ALGORITHM algo) {
+  const char* path = "test_conv_tuning.txt";
+  remove(path);
+  ConvFixture fixture(data_batch, data_channel, data_size, 1, filter_num, filter_size, 1, layout, algo);
+  for (size_t run = 0; run < 4; ++run) {
+    // Heuristic, then tuned and stored, then loaded from the file, then loaded from a hand edited file
+    if (run == 3) {
+      CorruptTuningCache(path);
+    }
+    BigQuantSetAutoTuning(run > 0, (run > 0) ? path : NULL);
+    // a new op each run, the blocking is chosen with its plan
+    QuantizedConvOp* desc = fixture.Create();
+    if (run == 0) {
+      fixture.Execute(desc, fixture.expect);
+    } else {
+      fixture.Check(desc);
+    }
+    QuantizedConvOpFree(desc);
+  }
+  BigQuantSetAutoTuning(0, NULL);
+  remove(path);
+}
+
+void TestConvolutionProfile(size_t data_batch, size_t data_channel, size_t data_size, size_t filter_num,
+                            size_t filter_size, LAYOUT layout, CONV_ALGORITHM algo) {
+  ConvFixture fixture(data_batch, data_channel, data_size, 1, filter_num, filter_size, 1, layout, algo);
+  QuantizedConvOp* desc = fixture.Create();
+  QuantizedOpProfile profile;
+  CHECK(QuantizedConvOpGetProfile(desc, &profile) == -1);
+
+  const size_t runs = 3;
+  QuantizedConvOpSetProfiling(desc, 1);
+  for (size_t run = 0; run < runs; ++run) {
+    fixture.Execute(desc, fixture.out);
+  }
+  CHECK(QuantizedConvOpGetProfile(desc, &profile) == 0);
+  CHECK(profile.executions == runs);
+  double phases[] = {profile.layout_transform_us, profile.find_extreme_us, profile.quantize_us, profile.gemm_us,
+                     profile.epilogue_us};
+  double phases_us = 0.0;
+  for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); ++i) {
+    CHECK(phases[i] >= 0.0);
+    phases_us += phases[i];
+  }
+  CHECK(profile.gemm_us > 0.0);
+  CHECK(profile.quantize_us > 0.0);
+  CHECK(phases_us <= profile.total_us);
+  // Only winograd transforms an NCHW input on its own, shuffle reads it while scanning the ranges
+  CHECK((profile.layout_transform_us > 0.0) == ((algo == WINOGRAD_CONV) && (layout == NCHW)));
+  double bytes = (fixture.data.size() + fixture.out.size()) * sizeof(float) + fixture.weight.size();
+  DOUBLES_EQUAL(runs * bytes, profile.bytes, 1e-3);
+  CHECK(profile.gops > 0.0);
+
+  QuantizedConvOpSetProfiling(desc, 0);
+  CHECK(QuantizedConvOpGetProfile(desc, &profile) == -1);
+  QuantizedConvOpFree(desc);
+}
+
+// Integer weights reaching +-127 in every output channel and data spanning [0, 127] in every patch are quantized
+// without loss by WEIGHT_8BIT, so the output has to match the fp convolution exactly. The many 127 x 127 products
+// would also saturate the int16 accumulation of the 7 bit kernels.
+void TestConvolutionWeightQuantization(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                                       size_t filter_num, size_t filter_size, LAYOUT layout) {
+  const char* path = "test_conv_weight_8bit.blob";
+  size_t channel_in_per_group = data_channel / group;
+  size_t channel_out_per_group = filter_num / group;
+  size_t kernel_size = filter_size * filter_size;
+  std::vector<float> weight(filter_num * channel_in_per_group * kernel_size);
+  for (size_t o = 0; o < filter_num; ++o) {
+    for (size_t c = 0; c < channel_in_per_group; ++c) {
+      for (size_t k = 0; k < kernel_size; ++k) {
+        size_t index = (layout == NCHW) ? (o * channel_in_per_group + c) * kernel_size + k
+                                        : (o * kernel_size + k) * channel_in_per_group + c;
+        weight[index] = ((o + c + k) % 4 != 3) ? 127.0f : -static_cast<float>((c * 7 + o) % 128);
+      }
+    }
+  }
+  std::vector<float> data(data_batch * data_channel * data_size * data_size);
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      for (size_t hw = 0; hw < data_size * data_size; ++hw) {
+        size_t index = (layout == NCHW) ? (n * data_channel + c) * data_size * data_size + hw
+                                        : (n * data_size * data_size + hw) * data_channel + c;
+        size_t c_in_group = c % channel_in_per_group;
+        float value = ((hw + c) % 5 != 4) ? 127.0f : static_cast<float>((c * 3 + hw) % 128);
+        data[index] = (c_in_group == 0) ? 0.0f : ((c_in_group == 1) ? 127.0f : value);
+      }
+    }
+  }
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.5f * o;
+  }
+  size_t out_size = GetConvOutSize(data_size, filter_size, 1, 0, 1);
+  std::vector<float> out(data_batch * filter_num * out_size * out_size, 0.0f);
+  std::vector<float> loaded_out(out.size(), 0.0f);
+
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1, 0,
+                                    0, 1, 1, 0, SHUFFLE_CONV);
+  QuantizedConvOpSetWeightQuantization(desc, WEIGHT_8BIT);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedConvOpSaveWeight(desc, path));
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t o = 0; o < filter_num; ++o) {
+      size_t g = o / channel_out_per_group;
+      for (size_t y = 0; y < out_size; ++y) {
+        for (size_t x = 0; x < out_size; ++x) {
+          double expect = bias[o];
+          for (size_t c = 0; c < channel_in_per_group; ++c) {
+            for (size_t kh = 0; kh < filter_size; ++kh) {
+              for (size_t kw = 0; kw < filter_size; ++kw) {
+                size_t k = kh * filter_size + kw;
+                size_t hw = (y + kh) * data_size + x + kw;
+                size_t ci = g * channel_in_per_group + c;
+                size_t w_index = (layout == NCHW) ? (o * channel_in_per_group + c) * kernel_size + k
+                                                  : (o * kernel_size + k) * channel_in_per_group + c;
+                size_t d_index = (layout == NCHW) ? (n * data_channel + ci) * data_size * data_size + hw
+                                                  : (n * data_size * data_size + hw) * data_channel + ci;
+                expect += static_cast<double>(weight[w_index]) * data[d_index];
+              }
+            }
+          }
+          size_t out_index = (layout == NCHW) ? ((n * filter_num + o) * out_size + y) * out_size + x
+                                              : ((n * out_size + y) * out_size + x) * filter_num + o;
+          DOUBLES_EQUAL(expect, out[out_index], 1e-6 * fabs(expect) + 1e-3);
+        }
+      }
+    }
+  }
+
+  // the blob records the scheme, an op expecting the 7 bit weight refuses it
+  QuantizedConvOp* mismatch = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(mismatch, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1,
+                                    0, 0, 1, 1, 0, SHUFFLE_CONV);
+  CHECK_EQUAL(WEIGHT_BLOB_MISMATCH, QuantizedConvOpLoadWeight(mismatch, path));
+  QuantizedConvOpFree(mismatch);
+
+  QuantizedConvOp* loaded = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(loaded, layout, filter_num, data_channel, group, filter_size, filter_size, 1, 1, 0,
+                                    0, 1, 1, 0, SHUFFLE_CONV);
+  QuantizedConvOpSetWeightQuantization(loaded, WEIGHT_8BIT);
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedConvOpLoadWeight(loaded, path));
+  remove(path);
+  QuantizedConvOpExecute(loaded, loaded_out.data(), data.data(), bias.data(), data_batch, data_channel, data_size,
+                         data_size);
+  QuantizedConvOpFree(loaded);
+  for (size_t i = 0; i < out.size(); ++i) {
+    DOUBLES_EQUAL(out[i], loaded_out[i], 1e-6);
+  }
+}
+
+// Every pixel spans [0, 127] in each group, or is constant, so the per pixel quantization of the 1x1 path is exact and
+// so is the output with full range weights.
+void TestConvolution1x1(size_t data_batch, size_t data_channel, size_t data_size, size_t group, size_t filter_num,
+                        size_t stride) {
+  size_t channel_in_per_group = data_channel / group;
+  size_t channel_out_per_group = filter_num / group;
+  size_t spatial_size = data_size * data_size;
+  std::vector<float> weight(filter_num * channel_in_per_group);
+  for (size_t o = 0; o < filter_num; ++o) {
+    for (size_t c = 0; c < channel_in_per_group; ++c) {
+      weight[o * channel_in_per_group + c] = ((o + c) % 3 != 2) ? 127.0f : -static_cast<float>((c * 5 + o) % 128);
+    }
+  }
+  std::vector<float> data(data_batch * spatial_size * data_channel);
+  for (size_t p = 0; p < data_batch * spatial_size; ++p) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      size_t c_in_group = c % channel_in_per_group;
+      float value = (c_in_group == 0) ? 0.0f : ((c_in_group == 1) ? 127.0f : static_cast<float>((c * 3 + p) % 128));
+      data[p * data_channel + c] = (p % 7 == 3) ? 3.0f : value;
+    }
+  }
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.5f * o;
+  }
+  size_t out_size = GetConvOutSize(data_size, 1, stride, 0, 1);
+  std::vector<float> out(data_batch * out_size * out_size * filter_num, 0.0f);
+
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(desc, NHWC, filter_num, data_channel, group, 1, 1, stride, stride, 0, 0, 1, 1, 0,
+                                    SHUFFLE_CONV);
+  QuantizedConvOpSetWeightQuantization(desc, WEIGHT_8BIT);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t y = 0; y < out_size; ++y) {
+      for (size_t x = 0; x < out_size; ++x) {
+        size_t p = n * spatial_size + y * stride * data_size + x * stride;
+        for (size_t o = 0; o < filter_num; ++o) {
+          size_t g = o / channel_out_per_group;
+          double expect = bias[o];
+          for (size_t c = 0; c < channel_in_per_group; ++c) {
+            expect += static_cast<double>(weight[o * channel_in_per_group + c]) *
+                      data[p * data_channel + g * channel_in_per_group + c];
+          }
+          size_t out_index = ((n * out_size + y) * out_size + x) * filter_num + o;
+          DOUBLES_EQUAL(expect, out[out_index], 1e-6 * fabs(expect) + 1e-3);
+        }
+      }
+    }
+  }
+}
+
+// Integer data and full range weights both quantize with a unit scale, so the statically quantized output is exact
+// against the input clamped to the calibrated range.
+void TestConvolutionStaticCalibration(size_t data_batch, size_t data_channel, size_t data_size, size_t group,
+                                      size_t filter_num, size_t filter_size, size_t pad, size_t stride, LAYOUT layout) {
+  size_t channel_in_per_group = data_channel / group;
+  size_t channel_out_per_group = filter_num / group;
+  size_t kernel_size = filter_size * filter_size;
+  size_t spatial_size = data_size * data_size;
+  std::vector<float> weight(filter_num * channel_in_per_group * kernel_size);
+  for (size_t o = 0; o < filter_num; ++o) {
+    for (size_t c = 0; c < channel_in_per_group; ++c) {
+      for (size_t k = 0; k < kernel_size; ++k) {
+        size_t index = (layout == NCHW) ? (o * channel_in_per_group + c) * kernel_size + k
+                                        : (o * kernel_size + k) * channel_in_per_group + c;
+        weight[index] = ((o + c + k) % 3 != 2) ? 127.0f : -static_cast<float>((c * 5 + o) % 128);
+      }
+    }
+  }
+  // calibrated to [0, 127] in every group, then executed with values on both sides of that range
+  std::vector<float> calibration(data_batch * data_channel * spatial_size);
+  std::vector<float> data(calibration.size());
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      for (size_t hw = 0; hw < spatial_size; ++hw) {
+        size_t index = (layout == NCHW) ? (n * data_channel + c) * spatial_size + hw
+                                        : (n * spatial_size + hw) * data_channel + c;
+        calibration[index] = static_cast<float>((c * 3 + hw * 5 + n) % 128);
+        data[index] = static_cast<float>((c * 7 + hw * 3 + n) % 160) - 16.0f;
+      }
+    }
+  }
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.5f * o;
+  }
+  size_t out_size = GetConvOutSize(data_size, filter_size, stride, pad, 1);
+  std::vector<float> out(data_batch * filter_num * out_size * out_size, 0.0f);
+
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, group, filter_size, filter_size, stride,
+                                    stride, pad, pad, 1, 1, 0, SHUFFLE_CONV);
+  QuantizedConvOpSetWeightQuantization(desc, WEIGHT_8BIT);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  CHECK_EQUAL(0, QuantizedConvOpCalibrate(desc, calibration.data(), data_batch, data_channel, data_size, data_size));
+  CHECK_EQUAL(0, QuantizedConvOpFreezeCalibration(desc));
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t o = 0; o < filter_num; ++o) {
+      size_t g = o / channel_out_per_group;
+      for (size_t y = 0; y < out_size; ++y) {
+        for (size_t x = 0; x < out_size; ++x) {
+          double expect = bias[o];
+          for (size_t c = 0; c < channel_in_per_group; ++c) {
+            for (size_t kh = 0; kh < filter_size; ++kh) {
+              for (size_t kw = 0; kw < filter_size; ++kw) {
+                int in_y = static_cast<int>(y * stride + kh) - static_cast<int>(pad);
+                int in_x = static_cast<int>(x * stride + kw) - static_cast<int>(pad);
+                if (in_y < 0 || in_y >= static_cast<int>(data_size) || in_x < 0 ||
+                    in_x >= static_cast<int>(data_size)) {
+                  continue;
+                }
+                size_t k = kh * filter_size + kw;
+                size_t hw = in_y * data_size + in_x;
+                size_t ci = g * channel_in_per_group + c;
+                size_t w_index = (layout == NCHW) ? (o * channel_in_per_group + c) * kernel_size + k
+                                                  : (o * kernel_size + k) * channel_in_per_group + c;
+                size_t d_index = (layout == NCHW) ? (n * data_channel + ci) * spatial_size + hw
+                                                  : (n * spatial_size + hw) * data_channel + ci;
+                float clamped = std::min(std::max(data[d_index], 0.0f), 127.0f);
+                expect += static_cast<double>(weight[w_index]) * clamped;
+              }
+            }
+          }
+          size_t out_index = (layout == NCHW) ? ((n * filter_num + o) * out_size + y) * out_size + x
+                                              : ((n * out_size + y) * out_size + x) * filter_num + o;
+          DOUBLES_EQUAL(expect, out[out_index], 1e-6 * fabs(expect) + 1e-3);
+        }
+      }
+    }
+  }
+}
+
+// Winograd transforms the data and the weight before quantizing them, so the output is compared against the fp
+// reference with a relative error bound rather than exactly. The 7 bit weight roughly doubles the error.
+void TestConvolutionWinograd(size_t data_batch, size_t data_channel, size_t data_size, size_t filter_num, size_t pad,
+                             WEIGHT_QUANTIZATION weight_quantization, LAYOUT layout) {
+  size_t spatial_size = data_size * data_size;
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> weight(filter_num * data_channel * 9);
+  std::generate(weight.begin(), weight.end(), [&] { return distribution(generator); });
+  std::vector<float> data(data_batch * data_channel * spatial_size);
+  std::generate(data.begin(), data.end(), [&] { return distribution(generator); });
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.1f * o;
+  }
+  size_t out_size = GetConvOutSize(data_size, 3, 1, pad, 1);
+  std::vector<float> out(data_batch * filter_num * out_size * out_size, 0.0f);
+
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(desc, layout, filter_num, data_channel, 1, 3, 3, 1, 1, pad, pad, 1, 1, 0,
+                                    WINOGRAD_CONV);
+  QuantizedConvOpSetWeightQuantization(desc, weight_quantization);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  // the data is quantized per transformed tile, a static input range cannot apply
+  CHECK_EQUAL(-1, QuantizedConvOpCalibrate(desc, data.data(), data_batch, data_channel, data_size, data_size));
+  CHECK_EQUAL(-1, QuantizedConvOpFreezeCalibration(desc));
+  float scale;
+  uint8_t zero_point;
+  CHECK_EQUAL(-1, QuantizedConvOpGetInputQuantization(desc, &scale, &zero_point));
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+
+  double error = 0.0, norm = 0.0;
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t o = 0; o < filter_num; ++o) {
+      for (size_t y = 0; y < out_size; ++y) {
+        for (size_t x = 0; x < out_size; ++x) {
+          double expect = bias[o];
+          for (size_t c = 0; c < data_channel; ++c) {
+            for (size_t k = 0; k < 9; ++k) {
+              int in_y = static_cast<int>(y + k / 3) - static_cast<int>(pad);
+              int in_x = static_cast<int>(x + k % 3) - static_cast<int>(pad);
+              if (in_y < 0 || in_y >= static_cast<int>(data_size) || in_x < 0 ||
+                  in_x >= static_cast<int>(data_size)) {
+                continue;
+              }
+              size_t hw = in_y * data_size + in_x;
+              size_t w_index = (layout == NCHW) ? (o * data_channel + c) * 9 + k : (o * 9 + k) * data_channel + c;
+              size_t d_index = (layout == NCHW) ? (n * data_channel + c) * spatial_size + hw
+                                                : (n * spatial_size + hw) * data_channel + c;
+              expect += static_cast<double>(weight[w_index]) * data[d_index];
+            }
+          }
+          size_t out_index = (layout == NCHW) ? ((n * filter_num + o) * out_size + y) * out_size + x
+                                              : ((n * out_size + y) * out_size + x) * filter_num + o;
+          error += (expect - out[out_index]) * (expect - out[out_index]);
+          norm += expect * expect;
+        }
+      }
+    }
+  }
+  CHECK(sqrt(error / norm) < ((weight_quantization == WEIGHT_8BIT) ? 0.03 : 0.06));
+}
+
+// Depthwise quantizes the data and the weight per channel with 8 bits each, compared against the fp reference with a
+// relative error bound. With calibrate the range is frozen from the same data first.
+void TestConvolutionDepthwise(size_t data_batch, size_t data_channel, size_t data_size, size_t filter_size, size_t pad,
+                              size_t stride, size_t dilation, LAYOUT layout, bool calibrate) {
+  size_t kernel_size = filter_size * filter_size;
+  size_t spatial_size = data_size * data_size;
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> weight(data_channel * kernel_size);
+  std::generate(weight.begin(), weight.end(), [&] { return distribution(generator); });
+  std::vector<float> data(data_batch * data_channel * spatial_size);
+  std::generate(data.begin(), data.end(), [&] { return distribution(generator); });
+  std::vector<float> bias(data_channel);
+  for (size_t c = 0; c < data_channel; ++c) {
+    bias[c] = 0.1f * c;
+  }
+  size_t out_size = GetConvOutSize(data_size, filter_size, stride, pad, dilation);
+  std::vector<float> out(data_batch * data_channel * out_size * out_size, 0.0f);
+
+  QuantizedConvOp* desc = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(desc, layout, data_channel, data_channel, data_channel, filter_size, filter_size,
+                                    stride, stride, pad, pad, dilation, dilation, 0, DEPTHWISE_CONV);
+  QuantizedConvOpInitWeight(desc, weight.data());
+  if (calibrate) {
+    QuantizedConvOpCalibrate(desc, data.data(), data_batch, data_channel, data_size, data_size);
+    QuantizedConvOpFreezeCalibration(desc);
+  }
+  QuantizedConvOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel, data_size, data_size);
+  QuantizedConvOpFree(desc);
+
+  double error = 0.0, norm = 0.0;
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      for (size_t y = 0; y < out_size; ++y) {
+        for (size_t x = 0; x < out_size; ++x) {
+          double expect = bias[c];
+          for (size_t k = 0; k < kernel_size; ++k) {
+            int in_y = static_cast<int>(y * stride + k / filter_size * dilation) - static_cast<int>(pad);
+            int in_x = static_cast<int>(x * stride + k % filter_size * dilation) - static_cast<int>(pad);
+            if (in_y < 0 || in_y >= static_cast<int>(data_size) || in_x < 0 || in_x >= static_cast<int>(data_size)) {
+              continue;
+            }
+            size_t hw = in_y * data_size + in_x;
+            size_t d_index = (layout == NCHW) ? (n * data_channel + c) * spatial_size + hw
+                                              : (n * spatial_size + hw) * data_channel + c;
+            expect += static_cast<double>(weight[c * kernel_size + k]) * data[d_index];
+          }
+          size_t out_index = (layout == NCHW) ? ((n * data_channel + c) * out_size + y) * out_size + x
+                                              : ((n * out_size + y) * out_size + x) * data_channel + c;
+          error += (expect - out[out_index]) * (expect - out[out_index]);
+          norm += expect * expect;
+        }
+      }
+    }
+  }
+  CHECK(sqrt(error / norm) < 0.01);
+}
+
+// Two NHWC convolutions chained through u8 activations: the first one requantizes its output with the input
+// quantization of the calibrated second one, which then skips quantizing its data. Both are compared against the fp32
+// chain, the u8 activations within one step of the quantization.
+void TestConvolutionChaining(size_t data_batch, size_t data_channel, size_t data_size, size_t mid_channel,
+                             size_t group, size_t filter_num, CONV_ALGORITHM algo) {
+  std::mt19937 generator(13);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> first_weight(mid_channel * data_channel * 9);
+  std::generate(first_weight.begin(), first_weight.end(), [&] { return distribution(generator); });
+  std::vector<float> second_weight(filter_num * mid_channel / group * 9);
+  std::generate(second_weight.begin(), second_weight.end(), [&] { return distribution(generator); });
+  std::vector<float> data(data_batch * data_size * data_size * data_channel);
+  std::generate(data.begin(), data.end(), [&] { return distribution(generator); });
+  std::vector<float> first_bias(mid_channel), second_bias(filter_num);
+  std::generate(first_bias.begin(), first_bias.end(), [&] { return distribution(generator); });
+  std::generate(second_bias.begin(), second_bias.end(), [&] { return distribution(generator); });
+  size_t mid_size = data_batch * data_size * data_size * mid_channel;
+  size_t out_size = data_batch * data_size * data_size * filter_num;
+
+  QuantizedConvOp* first = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(first, NHWC, mid_channel, data_channel, 1, 3, 3, 1, 1, 1, 1, 1, 1,
+                                    CONV_RELU_FUSION, SHUFFLE_CONV);
+  QuantizedConvOpInitWeight(first, first_weight.data());
+  QuantizedConvOp* second = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(second, NHWC, filter_num, mid_channel, group, 3, 3, 1, 1, 1, 1, 1, 1, 0, algo);
+  QuantizedConvOpInitWeight(second, second_weight.data());
+
+  std::vector<float> mid(mid_size), expect(out_size);
+  QuantizedConvOpExecute(first, mid.data(), data.data(), first_bias.data(), data_batch, data_channel, data_size,
+                         data_size);
+  float scale;
+  uint8_t zero_point;
+  CHECK_EQUAL(-1, QuantizedConvOpGetInputQuantization(second, &scale, &zero_point));
+  CHECK_EQUAL(0, QuantizedConvOpCalibrate(second, mid.data(), data_batch, mid_channel, data_size, data_size));
+  CHECK_EQUAL(0, QuantizedConvOpFreezeCalibration(second));
+  CHECK_EQUAL(0, QuantizedConvOpGetInputQuantization(second, &scale, &zero_point));
+  QuantizedConvOpExecute(second, expect.data(), mid.data(), second_bias.data(), data_batch, mid_channel, data_size,
+                         data_size);
+
+  std::vector<uint8_t> quantized_mid(mid_size);
+  QuantizedConvOpSetOutputQuantization(first, scale, zero_point);
+  QuantizedConvOpExecuteToU8(first, quantized_mid.data(), data.data(), first_bias.data(), data_batch, data_channel,
+                             data_size, data_size);
+  for (size_t i = 0; i < mid_size; ++i) {
+    CHECK(quantized_mid[i] <= 127);
+    DOUBLES_EQUAL(mid[i], (quantized_mid[i] - zero_point) * scale, scale);
+  }
+
+  std::vector<float> out(out_size);
+  QuantizedConvOpExecuteFromU8(second, out.data(), quantized_mid.data(), scale, zero_point, second_bias.data(),
+                               data_batch, mid_channel, data_size, data_size);
+  double error = 0.0, norm = 0.0, range = 0.0;
+  for (size_t i = 0; i < out_size; ++i) {
+    error += (expect[i] - out[i]) * (expect[i] - out[i]);
+    norm += expect[i] * expect[i];
+    range = std::max(range, fabs(static_cast<double>(out[i])));
+  }
+  CHECK(sqrt(error / norm) < 0.03);
+
+  // symmetric around zero, so that the clamped codes stay rare
+  float out_scale = static_cast<float>(range) / 63.0f;
+  uint8_t out_zero_point = 64;
+  std::vector<uint8_t> quantized_out(out_size);
+  QuantizedConvOpSetOutputQuantization(second, out_scale, out_zero_point);
+  QuantizedConvOpExecuteU8(second, quantized_out.data(), quantized_mid.data(), scale, zero_point, second_bias.data(),
+                           data_batch, mid_channel, data_size, data_size);
+  for (size_t i = 0; i < out_size; ++i) {
+    float code = std::min(std::max(roundf(out[i] / out_scale) + out_zero_point, 0.0f), 127.0f);
+    DOUBLES_EQUAL(code, quantized_out[i], 1.0);
+  }
+  QuantizedConvOpFree(first);
+  QuantizedConvOpFree(second);
+}
+
 TEST_GROUP(CONVOLUTION){
 
 };
@@ -158,6 +896,120 @@ TEST(CONVOLUTION, TEST_NCHW_CONVOLUTION_TENSOR) {
   TestConvolutionTensor(32, 128, 16, 16, 1, 1, 11, 11, 1, 1, 0, 0, 1, 1, NCHW);
 }
 
+TEST(CONVOLUTION, TEST_CONVOLUTION_WORKSPACE_REUSE) {
+  TestConvolutionWorkspaceReuse(4, 32, 10, 10, 1, 16, 3, NHWC);
+  TestConvolutionWorkspaceReuse(4, 32, 10, 10, 1, 16, 3, NCHW);
+  TestConvolutionWorkspaceReuse(4, 32, 10, 10, 2, 16, 1, NHWC);
+  TestConvolutionWorkspaceReuse(4, 32, 10, 10, 2, 16, 1, NCHW);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_FUSION) {
+  size_t masks[] = {NO_FUSION, CONV_RELU_FUSION, CONV_BN_FUSION, CONV_BN_RELU_FUSION, CONV_RELU_BN_FUSION};
+  for (size_t i = 0; i < sizeof(masks) / sizeof(masks[0]); ++i) {
+    TestConvolutionFusion(2, 32, 10, 1, 20, 3, masks[i], NHWC);
+    TestConvolutionFusion(2, 32, 10, 1, 20, 3, masks[i], NCHW);
+    TestConvolutionFusion(2, 32, 10, 2, 36, 1, masks[i], NHWC);
+    TestConvolutionFusion(2, 32, 10, 2, 36, 1, masks[i], NCHW);
+    TestConvolutionFusion(2, 32, 10, 1, 20, 3, masks[i], NHWC, WINOGRAD_CONV);
+    TestConvolutionFusion(2, 32, 10, 1, 20, 3, masks[i], NCHW, WINOGRAD_CONV);
+    TestConvolutionFusion(2, 64, 10, 32, 64, 3, masks[i], NHWC);
+    TestConvolutionFusion(2, 64, 10, 32, 64, 3, masks[i], NCHW);
+    TestConvolutionFusion(2, 36, 10, 36, 36, 3, masks[i], NHWC, DEPTHWISE_CONV);
+    TestConvolutionFusion(2, 36, 10, 36, 36, 3, masks[i], NCHW, DEPTHWISE_CONV);
+  }
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_WEIGHT_BLOB) {
+  TestConvolutionWeightBlob(2, 32, 10, 1, 20, 3, NHWC);
+  TestConvolutionWeightBlob(2, 32, 10, 1, 20, 3, NCHW);
+  TestConvolutionWeightBlob(2, 32, 10, 2, 36, 1, NHWC);
+  TestConvolutionWeightBlob(2, 32, 10, 2, 36, 1, NCHW);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_NUMA_MODE) {
+  TestConvolutionNumaMode(2, 32, 10, 1, 20, 3, NHWC);
+  TestConvolutionNumaMode(2, 32, 10, 1, 20, 3, NCHW);
+  TestConvolutionNumaMode(2, 32, 10, 2, 36, 1, NHWC);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_PARALLEL_BACKEND) {
+  TestConvolutionParallelBackend(2, 32, 10, 1, 20, 3, NHWC, SHUFFLE_CONV);
+  TestConvolutionParallelBackend(2, 32, 10, 1, 20, 3, NCHW, SHUFFLE_CONV);
+  TestConvolutionParallelBackend(2, 32, 10, 2, 36, 3, NHWC, SHUFFLE_CONV);
+  TestConvolutionParallelBackend(2, 32, 10, 1, 64, 3, NHWC, WINOGRAD_CONV);
+  TestConvolutionParallelBackend(2, 32, 10, 32, 32, 3, NHWC, DEPTHWISE_CONV);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_NUM_THREADS) {
+  TestConvolutionNumThreads(2, 32, 10, 1, 20, 3, NHWC, SHUFFLE_CONV);
+  TestConvolutionNumThreads(1, 64, 56, 1, 64, 3, NCHW, SHUFFLE_CONV);
+  TestConvolutionNumThreads(2, 32, 10, 1, 64, 3, NHWC, WINOGRAD_CONV);
+  TestConvolutionNumThreads(2, 32, 10, 32, 32, 3, NHWC, DEPTHWISE_CONV);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_AUTO_TUNING) {
+  TestConvolutionAutoTuning(2, 64, 28, 96, 3, NHWC, SHUFFLE_CONV);
+  TestConvolutionAutoTuning(1, 32, 20, 64, 3, NCHW, SHUFFLE_CONV);
+  TestConvolutionAutoTuning(2, 32, 10, 64, 3, NHWC, WINOGRAD_CONV);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_PROFILE) {
+  TestConvolutionProfile(2, 32, 10, 20, 3, NHWC, SHUFFLE_CONV);
+  TestConvolutionProfile(1, 32, 20, 64, 3, NCHW, SHUFFLE_CONV);
+  TestConvolutionProfile(2, 32, 10, 64, 3, NHWC, WINOGRAD_CONV);
+  TestConvolutionProfile(2, 32, 10, 64, 3, NCHW, WINOGRAD_CONV);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_WEIGHT_8BIT) {
+  TestConvolutionWeightQuantization(2, 64, 10, 1, 20, 3, NHWC);
+  TestConvolutionWeightQuantization(2, 64, 10, 1, 20, 3, NCHW);
+  TestConvolutionWeightQuantization(2, 64, 10, 2, 36, 1, NHWC);
+  TestConvolutionWeightQuantization(2, 64, 10, 2, 36, 1, NCHW);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_STATIC_CALIBRATION) {
+  TestConvolutionStaticCalibration(2, 32, 10, 1, 20, 3, 1, 1, NHWC);
+  TestConvolutionStaticCalibration(2, 32, 10, 1, 20, 3, 1, 1, NCHW);
+  TestConvolutionStaticCalibration(2, 32, 11, 2, 36, 3, 1, 2, NHWC);
+  TestConvolutionStaticCalibration(2, 32, 11, 2, 36, 3, 1, 2, NCHW);
+  TestConvolutionStaticCalibration(3, 6, 9, 1, 8, 1, 0, 1, NHWC);
+  TestConvolutionStaticCalibration(3, 6, 9, 1, 8, 1, 0, 1, NCHW);
+}
+
+TEST(CONVOLUTION, TEST_NHWC_CONVOLUTION_1X1) {
+  TestConvolution1x1(2, 64, 10, 1, 20, 1);
+  TestConvolution1x1(2, 64, 11, 1, 20, 2);
+  TestConvolution1x1(3, 36, 9, 1, 17, 1);
+  TestConvolution1x1(2, 64, 10, 4, 32, 1);
+  TestConvolution1x1(2, 96, 12, 3, 48, 3);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_WINOGRAD) {
+  TestConvolutionWinograd(2, 32, 10, 20, 1, WEIGHT_7BIT, NHWC);
+  TestConvolutionWinograd(2, 32, 10, 20, 1, WEIGHT_7BIT, NCHW);
+  TestConvolutionWinograd(2, 64, 9, 24, 0, WEIGHT_7BIT, NHWC);
+  TestConvolutionWinograd(3, 19, 7, 13, 1, WEIGHT_8BIT, NHWC);
+  TestConvolutionWinograd(3, 19, 7, 13, 1, WEIGHT_8BIT, NCHW);
+  TestConvolutionWinograd(1, 70, 12, 33, 1, WEIGHT_8BIT, NHWC);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_DEPTHWISE) {
+  TestConvolutionDepthwise(2, 32, 10, 3, 1, 1, 1, NHWC, false);
+  TestConvolutionDepthwise(2, 32, 10, 3, 1, 1, 1, NCHW, false);
+  TestConvolutionDepthwise(3, 19, 11, 3, 1, 2, 1, NHWC, false);
+  TestConvolutionDepthwise(3, 19, 11, 3, 1, 2, 1, NCHW, false);
+  TestConvolutionDepthwise(1, 70, 12, 5, 2, 1, 1, NHWC, false);
+  TestConvolutionDepthwise(2, 24, 13, 3, 2, 1, 2, NHWC, false);
+  TestConvolutionDepthwise(2, 32, 10, 3, 0, 1, 1, NHWC, true);
+  TestConvolutionDepthwise(2, 19, 9, 3, 1, 2, 1, NCHW, true);
+}
+
+TEST(CONVOLUTION, TEST_CONVOLUTION_U8_CHAINING) {
+  TestConvolutionChaining(2, 16, 10, 32, 1, 24, SHUFFLE_CONV);
+  TestConvolutionChaining(2, 16, 9, 32, 2, 20, SHUFFLE_CONV);
+  TestConvolutionChaining(2, 16, 10, 32, 32, 32, DEPTHWISE_CONV);
+}
+
 int main(int argc, char** argv) {
   return RUN_ALL_TESTS(argc, argv);
 }
@@ -2,6 +2,9 @@
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
 #include "bigquant.h"
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
@@ -43,6 +46,225 @@ void TestFC(size_t data_batch, size_t data_channel, size_t filter_num) {
   }
 }
 
+void TestFCWeightBlob(size_t data_batch, size_t data_channel, size_t filter_num) {
+  const char *path = "test_fc_weight.blob";
+  std::vector<float> weight(filter_num * data_channel);
+  for (size_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>((i * 37) % 17) - 8.0f;
+  }
+  std::vector<float> data(data_batch * data_channel);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>((i * 13) % 11) * 0.5f;
+  }
+  std::vector<float> out(data_batch * filter_num, 0.0f);
+  std::vector<float> loaded_out(out.size(), 0.0f);
+
+  QuantizedFCOp *desc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(desc, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  QuantizedFCOpInitWeight(desc, weight.data());
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedFCOpSaveWeight(desc, path));
+  QuantizedFCOpExecute(desc, out.data(), data.data(), NULL, data_batch, data_channel);
+  QuantizedFCOpFree(desc);
+
+  QuantizedFCOp *loaded = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(loaded, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedFCOpLoadWeight(loaded, path));
+  QuantizedFCOpExecute(loaded, loaded_out.data(), data.data(), NULL, data_batch, data_channel);
+  QuantizedFCOpFree(loaded);
+  for (size_t i = 0; i < out.size(); ++i) {
+    DOUBLES_EQUAL(out[i], loaded_out[i], 1e-6);
+  }
+
+  QuantizedFCOp *mismatch = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(mismatch, NCHW, filter_num, data_channel + 1, SHUFFLE_FC);
+  CHECK_EQUAL(WEIGHT_BLOB_MISMATCH, QuantizedFCOpLoadWeight(mismatch, path));
+  CHECK_EQUAL(WEIGHT_BLOB_MISMATCH, QuantizedFCOpMapWeight(mismatch, path));
+  QuantizedFCOpFree(mismatch);
+
+  // two ops sharing one mapping of the blob, which stays valid after the file is removed
+  QuantizedFCOp *mapped[2];
+  for (size_t n = 0; n < 2; ++n) {
+    mapped[n] = QuantizedFCOpCreate();
+    QuantizedFCOpSetupFCParameter(mapped[n], NCHW, filter_num, data_channel, SHUFFLE_FC);
+    CHECK_EQUAL(WEIGHT_BLOB_OK, QuantizedFCOpMapWeight(mapped[n], path));
+  }
+  remove(path);
+  for (size_t n = 0; n < 2; ++n) {
+    std::fill(loaded_out.begin(), loaded_out.end(), 0.0f);
+    QuantizedFCOpExecute(mapped[n], loaded_out.data(), data.data(), NULL, data_batch, data_channel);
+    QuantizedFCOpFree(mapped[n]);
+    for (size_t i = 0; i < out.size(); ++i) {
+      DOUBLES_EQUAL(out[i], loaded_out[i], 1e-6);
+    }
+  }
+}
+
+// Integer weights reaching +-127 in every row and data spanning [0, 127] in every sample are quantized without loss by
+// WEIGHT_8BIT, so the output has to match the fp product exactly.
+void TestFCWeightQuantization(size_t data_batch, size_t data_channel, size_t filter_num) {
+  std::vector<float> weight(filter_num * data_channel);
+  for (size_t o = 0; o < filter_num; ++o) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      weight[o * data_channel + c] = ((o + c) % 4 != 3) ? 127.0f : -static_cast<float>((c * 7 + o) % 128);
+    }
+  }
+  std::vector<float> data(data_batch * data_channel);
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t c = 0; c < data_channel; ++c) {
+      float value = ((n + c) % 5 != 4) ? 127.0f : static_cast<float>((c * 3 + n) % 128);
+      data[n * data_channel + c] = (c == 0) ? 0.0f : ((c == 1) ? 127.0f : value);
+    }
+  }
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.5f * o;
+  }
+  std::vector<float> out(data_batch * filter_num, 0.0f);
+
+  QuantizedFCOp *desc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(desc, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  QuantizedFCOpSetWeightQuantization(desc, WEIGHT_8BIT);
+  QuantizedFCOpInitWeight(desc, weight.data());
+  QuantizedFCOpExecute(desc, out.data(), data.data(), bias.data(), data_batch, data_channel);
+  QuantizedFCOpFree(desc);
+
+  for (size_t n = 0; n < data_batch; ++n) {
+    for (size_t o = 0; o < filter_num; ++o) {
+      double expect = bias[o];
+      for (size_t c = 0; c < data_channel; ++c) {
+        expect += static_cast<double>(weight[o * data_channel + c]) * data[n * data_channel + c];
+      }
+      DOUBLES_EQUAL(expect, out[n * filter_num + o], 1e-6 * fabs(expect) + 1e-3);
+    }
+  }
+}
+
+// Several threads executing one op with different batch sizes have to get the results of a serial execution
+void TestFCConcurrentExecute(size_t data_channel, size_t filter_num, size_t threads_num) {
+  std::vector<float> weight(filter_num * data_channel);
+  for (size_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>((i * 37) % 17) - 8.0f;
+  }
+  std::vector<std::vector<float>> data(threads_num);
+  std::vector<std::vector<float>> expect(threads_num);
+  std::vector<std::vector<float>> out(threads_num);
+  for (size_t t = 0; t < threads_num; ++t) {
+    size_t batch = t + 1;
+    data[t].resize(batch * data_channel);
+    for (size_t i = 0; i < data[t].size(); ++i) {
+      data[t][i] = static_cast<float>((i * 13 + t) % 11) * 0.5f;
+    }
+    expect[t].resize(batch * filter_num);
+    out[t].resize(batch * filter_num);
+  }
+
+  QuantizedFCOp *desc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(desc, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  QuantizedFCOpInitWeight(desc, weight.data());
+  for (size_t t = 0; t < threads_num; ++t) {
+    QuantizedFCOpExecute(desc, expect[t].data(), data[t].data(), NULL, t + 1, data_channel);
+  }
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_num; ++t) {
+    threads.push_back(std::thread([&, t] {
+      for (size_t repeat = 0; repeat < 8; ++repeat) {
+        QuantizedFCOpExecute(desc, out[t].data(), data[t].data(), NULL, t + 1, data_channel);
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads_num; ++t) {
+    threads[t].join();
+  }
+  QuantizedFCOpFree(desc);
+
+  for (size_t t = 0; t < threads_num; ++t) {
+    for (size_t i = 0; i < out[t].size(); ++i) {
+      DOUBLES_EQUAL(expect[t][i], out[t][i], 1e-6);
+    }
+  }
+}
+
+// Batches up to FC_GEMV_MAX_BATCH run as a GEMV. The data is quantized per sample, so the first rows of a batch large
+// enough for the GEMM have to come out the same.
+void TestFCGEMV(size_t data_channel, size_t filter_num, WEIGHT_QUANTIZATION weight_quantization) {
+  const size_t gemm_batch = 9;
+  std::vector<float> weight(filter_num * data_channel);
+  for (size_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>((i * 37) % 17) * 0.1f - 0.8f;
+  }
+  std::vector<float> data(gemm_batch * data_channel);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>((i * 13) % 23) * 0.25f - 2.0f;
+  }
+  std::vector<float> bias(filter_num);
+  for (size_t o = 0; o < filter_num; ++o) {
+    bias[o] = 0.01f * o;
+  }
+
+  QuantizedFCOp *desc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(desc, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  QuantizedFCOpSetWeightQuantization(desc, weight_quantization);
+  QuantizedFCOpInitWeight(desc, weight.data());
+  std::vector<float> expect(gemm_batch * filter_num);
+  QuantizedFCOpExecute(desc, expect.data(), data.data(), bias.data(), gemm_batch, data_channel);
+  for (size_t batch = 1; batch <= 4; ++batch) {
+    std::vector<float> out(batch * filter_num, 0.0f);
+    QuantizedFCOpExecute(desc, out.data(), data.data(), bias.data(), batch, data_channel);
+    for (size_t i = 0; i < out.size(); ++i) {
+      DOUBLES_EQUAL(expect[i], out[i], 1e-5 * fabs(expect[i]) + 1e-5);
+    }
+  }
+  QuantizedFCOpFree(desc);
+}
+
+// Applies the settings to one op in turn. After each, the GEMV and the GEMM batches have to give the output of the op
+// as created.
+void CheckFCSettings(size_t data_channel, size_t filter_num, size_t settings_num,
+                     const std::function<void(QuantizedFCOp *, size_t)> &setting) {
+  const size_t batch = 17;
+  std::vector<float> weight(filter_num * data_channel);
+  for (size_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>((i * 37) % 17) * 0.1f - 0.8f;
+  }
+  std::vector<float> data(batch * data_channel);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>((i * 13) % 23) * 0.25f - 2.0f;
+  }
+
+  QuantizedFCOp *desc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(desc, NCHW, filter_num, data_channel, SHUFFLE_FC);
+  QuantizedFCOpInitWeight(desc, weight.data());
+  std::vector<float> expect(batch * filter_num), out(expect.size());
+  QuantizedFCOpExecute(desc, expect.data(), data.data(), NULL, batch, data_channel);
+  for (size_t s = 0; s < settings_num; ++s) {
+    setting(desc, s);
+    for (size_t n = 1; n <= batch; n += batch - 1) {
+      std::fill(out.begin(), out.end(), 0.0f);
+      QuantizedFCOpExecute(desc, out.data(), data.data(), NULL, n, data_channel);
+      for (size_t i = 0; i < n * filter_num; ++i) {
+        DOUBLES_EQUAL(expect[i], out[i], 1e-5 * fabs(expect[i]) + 1e-5);
+      }
+    }
+  }
+  QuantizedFCOpFree(desc);
+}
+
+// Every NUMA mode reads a copy of the same quantized weight
+void TestFCNumaMode(size_t data_channel, size_t filter_num) {
+  NUMA_MODE modes[] = {NUMA_REPLICATE, NUMA_INTERLEAVE};
+  CheckFCSettings(data_channel, filter_num, 2,
+                  [&](QuantizedFCOp *desc, size_t m) { QuantizedFCOpSetNumaMode(desc, modes[m]); });
+}
+
+// Every thread count of the op, fixed or chosen from the work, computes the same output on a 4 thread pool
+void TestFCNumThreads(size_t data_channel, size_t filter_num) {
+  size_t threads[] = {1, 3, AUTO_THREADS_NUM, 0};
+  BigQuantSetParallelBackend(THREAD_POOL_BACKEND, 4);
+  CheckFCSettings(data_channel, filter_num, 4,
+                  [&](QuantizedFCOp *desc, size_t t) { QuantizedFCOpSetNumThreads(desc, threads[t]); });
+  BigQuantSetParallelBackend(OPENMP_BACKEND, 0);
+}
+
 TEST_GROUP(FC){
 
 };
@@ -60,6 +282,37 @@ TEST(FC, TEST_FC) {
   TestFC(128, 200, 10001);
 }
 
+TEST(FC, TEST_FC_WEIGHT_BLOB) {
+  TestFCWeightBlob(4, 128, 128);
+  TestFCWeightBlob(3, 1023, 1001);
+}
+
+TEST(FC, TEST_FC_WEIGHT_8BIT) {
+  TestFCWeightQuantization(1, 1024, 100);
+  TestFCWeightQuantization(4, 128, 128);
+  TestFCWeightQuantization(17, 1023, 1001);
+}
+
+TEST(FC, TEST_FC_GEMV) {
+  TestFCGEMV(1023, 1001, WEIGHT_7BIT);
+  TestFCGEMV(1023, 1001, WEIGHT_8BIT);
+  TestFCGEMV(5, 3, WEIGHT_7BIT);
+  TestFCGEMV(4096, 64, WEIGHT_8BIT);
+}
+
+TEST(FC, TEST_FC_NUMA_MODE) {
+  TestFCNumaMode(1023, 1001);
+}
+
+TEST(FC, TEST_FC_NUM_THREADS) {
+  TestFCNumThreads(1023, 1001);
+  TestFCNumThreads(64, 16);
+}
+
+TEST(FC, TEST_FC_CONCURRENT_EXECUTE) {
+  TestFCConcurrentExecute(1023, 257, 4);
+}
+
 int main(int argc, char **argv) {
   return RUN_ALL_TESTS(argc, argv);
 }
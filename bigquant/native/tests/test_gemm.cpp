@@ -7,6 +7,7 @@
 #include "../base.h"
 #include "../common.h"
 #include "../ops/ops.h"
+#include "../ops/kernel/shuffle_amx_igemm_16x16x64.h"
 #include "CppUTest/TestHarness.h"
 #include "CppUTest/CommandLineTestRunner.h"
 
@@ -248,6 +249,56 @@ TEST(GEMM, RandMixPrecisionGEMM) {
   }
 }
 
+TEST(GEMM, AMXTileEmulation) {
+  // Checks the VNNI weight packing and the 16x16x64 tile sequence of the AMX kernel with the scalar tile model, so it
+  // runs on machines without AMX.
+  std::vector<std::tuple<size_t, size_t, size_t>> data;
+  data.push_back(std::move(std::make_tuple(1, 1, 1)));
+  data.push_back(std::move(std::make_tuple(16, 16, 64)));
+  data.push_back(std::move(std::make_tuple(17, 15, 65)));
+  data.push_back(std::move(std::make_tuple(32, 48, 128)));
+  data.push_back(std::move(std::make_tuple(64, 200, 576)));
+  data.push_back(std::move(std::make_tuple(127, 33, 393)));
+  const size_t kernel_m = 16, kernel_n = 16, kernel_k = 64;
+  for (auto it = data.begin(); it < data.end(); ++it) {
+    size_t m = std::get<0>(*it);
+    size_t n = std::get<1>(*it);
+    size_t k = std::get<2>(*it);
+    size_t m_out = GetAlignmentLength(m, kernel_m);
+    size_t n_out = GetAlignmentLength(n, kernel_n);
+    size_t k_out = GetAlignmentLength(k, kernel_k);
+    std::vector<int8_t> a(m * k);
+    for (size_t i = 0; i < m * k; ++i) {
+      a[i] = static_cast<int8_t>(std::rand() % 256 - 128);
+    }
+    std::vector<uint8_t> b(n * k);
+    for (size_t i = 0; i < n * k; ++i) {
+      b[i] = static_cast<uint8_t>(std::rand() % 256);
+    }
+    std::vector<int8_t> pad_a(m_out * k_out);
+    std::vector<uint8_t> pad_b(n_out * k_out);
+    shuffle::PadShuffle2D<int8_t, kernel_m, kernel_k>(pad_a.data(), m, k, a.data());
+    shuffle::VNNIShuffle2D<kernel_m, kernel_k>(pad_a.data(), m_out, k_out);
+    shuffle::PadShuffle2D<uint8_t, kernel_n, kernel_k>(pad_b.data(), n, k, b.data());
+    for (size_t i = 0; i < m_out; i += kernel_m) {
+      for (size_t j = 0; j < n_out; j += kernel_n) {
+        int32_t c[kernel_n * kernel_m] = {0};
+        kernel::amx_igemm16x16x64::ReferenceKernelReduce(pad_a.data() + i * k_out, pad_b.data() + j * k_out, c,
+                                                         k_out);
+        for (size_t x = i; x < std::min(i + kernel_m, m); ++x) {
+          for (size_t y = j; y < std::min(j + kernel_n, n); ++y) {
+            int32_t ref = 0;
+            for (size_t z = 0; z < k; ++z) {
+              ref += static_cast<int32_t>(a[x * k + z]) * static_cast<int32_t>(b[y * k + z]);
+            }
+            LONGS_EQUAL(ref, c[(y - j) * kernel_m + (x - i)]);
+          }
+        }
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   return RUN_ALL_TESTS(argc, argv);
 }
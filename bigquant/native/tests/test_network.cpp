@@ -0,0 +1,217 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "bigquant.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+static std::vector<float> RandomVector(size_t size, std::mt19937& generator) {
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  std::vector<float> values(size);
+  std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+  return values;
+}
+
+static QuantizedConvOp* CreateConv(size_t channel_in, size_t channel_out, size_t filter_size, size_t stride,
+                                   size_t pad, size_t fusion_mask, CONV_ALGORITHM algo, std::mt19937& generator) {
+  QuantizedConvOp* conv = QuantizedConvOpCreate();
+  QuantizedConvOpSetupConvParameter(conv, NHWC, channel_out, channel_in, 1, filter_size, filter_size, stride, stride,
+                                    pad, pad, 1, 1, fusion_mask, algo);
+  std::vector<float> weight = RandomVector(channel_out * channel_in * filter_size * filter_size, generator);
+  QuantizedConvOpInitWeight(conv, weight.data());
+  return conv;
+}
+
+// NHWC reference of the network pooling, the padded taps are skipped
+static std::vector<float> ReferencePool(const std::vector<float>& data, size_t batch, size_t channel, size_t height,
+                                        size_t width, size_t kernel, size_t stride, size_t pad, bool average,
+                                        size_t& height_out, size_t& width_out) {
+  height_out = (height + 2 * pad - kernel) / stride + 1;
+  width_out = (width + 2 * pad - kernel) / stride + 1;
+  std::vector<float> out(batch * height_out * width_out * channel);
+  for (size_t n = 0; n < batch; ++n) {
+    for (size_t y = 0; y < height_out; ++y) {
+      for (size_t x = 0; x < width_out; ++x) {
+        for (size_t c = 0; c < channel; ++c) {
+          float result = average ? 0.0f : -1e30f;
+          size_t count = 0;
+          for (size_t ky = 0; ky < kernel; ++ky) {
+            for (size_t kx = 0; kx < kernel; ++kx) {
+              int in_y = static_cast<int>(y * stride + ky) - static_cast<int>(pad);
+              int in_x = static_cast<int>(x * stride + kx) - static_cast<int>(pad);
+              if (in_y < 0 || in_y >= static_cast<int>(height) || in_x < 0 || in_x >= static_cast<int>(width)) {
+                continue;
+              }
+              float value = data[((n * height + in_y) * width + in_x) * channel + c];
+              result = average ? result + value : std::max(result, value);
+              ++count;
+            }
+          }
+          out[((n * height_out + y) * width_out + x) * channel + c] = average ? result / count : result;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+// conv, conv, max pool, conv, global average pool and fc against the same ops executed one by one
+void TestNetworkSequence(size_t batch, size_t channel, size_t size) {
+  std::mt19937 generator(3);
+  QuantizedConvOp* conv1 = CreateConv(channel, 24, 3, 1, 1, CONV_RELU_FUSION, SHUFFLE_CONV, generator);
+  QuantizedConvOp* conv2 = CreateConv(24, 32, 3, 1, 1, NO_FUSION, WINOGRAD_CONV, generator);
+  QuantizedConvOp* conv3 = CreateConv(32, 40, 1, 1, 0, CONV_RELU_FUSION, SHUFFLE_CONV, generator);
+  QuantizedFCOp* fc = QuantizedFCOpCreate();
+  QuantizedFCOpSetupFCParameter(fc, NCHW, 10, 40, SHUFFLE_FC);
+  std::vector<float> fc_weight = RandomVector(10 * 40, generator);
+  QuantizedFCOpInitWeight(fc, fc_weight.data());
+  std::vector<float> bias1 = RandomVector(24, generator), bias3 = RandomVector(40, generator);
+  std::vector<float> fc_bias = RandomVector(10, generator);
+  std::vector<float> data = RandomVector(batch * size * size * channel, generator);
+
+  QuantizedNetwork* network = QuantizedNetworkCreate();
+  int t = QuantizedNetworkAddConv(network, conv1, 0, bias1.data());
+  t = QuantizedNetworkAddConv(network, conv2, t, NULL);
+  t = QuantizedNetworkAddPool(network, t, MAX_POOL, 3, 3, 2, 2, 1, 1);
+  t = QuantizedNetworkAddConv(network, conv3, t, bias3.data());
+  size_t pool_size = (size + 1) / 2;
+  t = QuantizedNetworkAddPool(network, t, AVG_POOL, pool_size, pool_size, 1, 1, 0, 0);
+  t = QuantizedNetworkAddFC(network, fc, t, fc_bias.data());
+  CHECK_EQUAL(6, t);
+  QuantizedNetworkCompile(network, channel, size, size);
+  size_t channel_out, height_out, width_out;
+  QuantizedNetworkGetOutputShape(network, &channel_out, &height_out, &width_out);
+  CHECK_EQUAL(10, channel_out);
+  CHECK_EQUAL(1, height_out);
+  CHECK_EQUAL(1, width_out);
+  std::vector<float> out(batch * 10);
+  QuantizedNetworkExecute(network, out.data(), data.data(), batch);
+
+  std::vector<float> out1(batch * size * size * 24), out2(batch * size * size * 32);
+  QuantizedConvOpExecute(conv1, out1.data(), data.data(), bias1.data(), batch, channel, size, size);
+  QuantizedConvOpExecute(conv2, out2.data(), out1.data(), NULL, batch, 24, size, size);
+  size_t pooled_h, pooled_w, global_h, global_w;
+  std::vector<float> pooled = ReferencePool(out2, batch, 32, size, size, 3, 2, 1, false, pooled_h, pooled_w);
+  std::vector<float> out3(batch * pooled_h * pooled_w * 40);
+  QuantizedConvOpExecute(conv3, out3.data(), pooled.data(), bias3.data(), batch, 32, pooled_h, pooled_w);
+  std::vector<float> global = ReferencePool(out3, batch, 40, pooled_h, pooled_w, pool_size, 1, 0, true, global_h,
+                                            global_w);
+  std::vector<float> expect(batch * 10);
+  QuantizedFCOpExecute(fc, expect.data(), global.data(), fc_bias.data(), batch, 40);
+  for (size_t i = 0; i < expect.size(); ++i) {
+    DOUBLES_EQUAL(expect[i], out[i], 1e-4 * fabs(expect[i]) + 1e-4);
+  }
+
+  // a smaller batch than the first execution reuses the arena
+  QuantizedNetworkExecute(network, out.data(), data.data(), 1);
+  for (size_t i = 0; i < 10; ++i) {
+    DOUBLES_EQUAL(expect[i], out[i], 1e-4 * fabs(expect[i]) + 1e-4);
+  }
+  QuantizedNetworkFree(network);
+  QuantizedConvOpFree(conv1);
+  QuantizedConvOpFree(conv2);
+  QuantizedConvOpFree(conv3);
+  QuantizedFCOpFree(fc);
+}
+
+// A residual block: the output of the first convolution stays alive across the second one
+void TestNetworkResidual(size_t batch, size_t channel, size_t size) {
+  std::mt19937 generator(5);
+  QuantizedConvOp* conv1 = CreateConv(channel, channel, 3, 1, 1, CONV_RELU_FUSION, SHUFFLE_CONV, generator);
+  QuantizedConvOp* conv2 = CreateConv(channel, channel, 3, 1, 1, NO_FUSION, SHUFFLE_CONV, generator);
+  QuantizedConvOp* conv3 = CreateConv(channel, 8, 1, 1, 0, NO_FUSION, SHUFFLE_CONV, generator);
+  std::vector<float> data = RandomVector(batch * size * size * channel, generator);
+
+  QuantizedNetwork* network = QuantizedNetworkCreate();
+  int shortcut = QuantizedNetworkAddConv(network, conv1, 0, NULL);
+  int t = QuantizedNetworkAddConv(network, conv2, shortcut, NULL);
+  t = QuantizedNetworkAddEltwiseSum(network, shortcut, t, 1);
+  t = QuantizedNetworkAddConv(network, conv3, t, NULL);
+  QuantizedNetworkCompile(network, channel, size, size);
+  std::vector<float> out(batch * size * size * 8);
+  QuantizedNetworkExecute(network, out.data(), data.data(), batch);
+  // the shortcut and the second convolution are alive together, the sum reuses neither of them
+  size_t tensor_size = (sizeof(float) * size * size * channel + 63) / 64 * 64;
+  CHECK_EQUAL(3 * tensor_size * batch, QuantizedNetworkGetArenaSize(network, batch));
+
+  std::vector<float> out1(batch * size * size * channel), out2(out1.size()), expect(out.size());
+  QuantizedConvOpExecute(conv1, out1.data(), data.data(), NULL, batch, channel, size, size);
+  QuantizedConvOpExecute(conv2, out2.data(), out1.data(), NULL, batch, channel, size, size);
+  for (size_t i = 0; i < out1.size(); ++i) {
+    out1[i] = std::max(out1[i] + out2[i], 0.0f);
+  }
+  QuantizedConvOpExecute(conv3, expect.data(), out1.data(), NULL, batch, channel, size, size);
+  for (size_t i = 0; i < expect.size(); ++i) {
+    DOUBLES_EQUAL(expect[i], out[i], 1e-4 * fabs(expect[i]) + 1e-4);
+  }
+  QuantizedNetworkFree(network);
+  QuantizedConvOpFree(conv1);
+  QuantizedConvOpFree(conv2);
+  QuantizedConvOpFree(conv3);
+}
+
+// A plain chain needs two slabs whatever its depth. With the calibration of the convolutions frozen, the activations
+// between them are u8 and the arena shrinks to a quarter.
+void TestNetworkChain(size_t batch, size_t channel, size_t size, size_t depth, bool calibrate) {
+  std::mt19937 generator(9);
+  std::vector<QuantizedConvOp*> convs;
+  std::vector<float> data = RandomVector(batch * size * size * channel, generator);
+  std::vector<float> expect(data), next(data.size());
+  for (size_t i = 0; i < depth; ++i) {
+    convs.push_back(CreateConv(channel, channel, 3, 1, 1, CONV_RELU_FUSION, SHUFFLE_CONV, generator));
+    if (calibrate) {
+      QuantizedConvOpCalibrate(convs[i], expect.data(), batch, channel, size, size);
+      QuantizedConvOpFreezeCalibration(convs[i]);
+    }
+    QuantizedConvOpExecute(convs[i], next.data(), expect.data(), NULL, batch, channel, size, size);
+    expect.swap(next);
+  }
+
+  QuantizedNetwork* network = QuantizedNetworkCreate();
+  int t = 0;
+  for (size_t i = 0; i < depth; ++i) {
+    t = QuantizedNetworkAddConv(network, convs[i], t, NULL);
+  }
+  QuantizedNetworkCompile(network, channel, size, size);
+  size_t element_size = calibrate ? sizeof(uint8_t) : sizeof(float);
+  size_t tensor_size = (element_size * size * size * channel + 63) / 64 * 64;
+  CHECK_EQUAL(2 * tensor_size * batch, QuantizedNetworkGetArenaSize(network, batch));
+  std::vector<float> out(data.size());
+  QuantizedNetworkExecute(network, out.data(), data.data(), batch);
+
+  double error = 0.0, norm = 0.0;
+  for (size_t i = 0; i < out.size(); ++i) {
+    error += (expect[i] - out[i]) * (expect[i] - out[i]);
+    norm += expect[i] * expect[i];
+  }
+  CHECK(sqrt(error / norm) < (calibrate ? 0.05 : 1e-6));
+  QuantizedNetworkFree(network);
+  for (size_t i = 0; i < depth; ++i) {
+    QuantizedConvOpFree(convs[i]);
+  }
+}
+
+TEST_GROUP(NETWORK){
+
+};
+
+TEST(NETWORK, TEST_NETWORK_SEQUENCE) {
+  TestNetworkSequence(2, 16, 10);
+  TestNetworkSequence(3, 8, 9);
+}
+
+TEST(NETWORK, TEST_NETWORK_RESIDUAL) {
+  TestNetworkResidual(2, 16, 8);
+}
+
+TEST(NETWORK, TEST_NETWORK_CHAIN) {
+  TestNetworkChain(2, 32, 8, 5, false);
+  TestNetworkChain(2, 32, 8, 5, true);
+}
+
+int main(int argc, char** argv) {
+  return RUN_ALL_TESTS(argc, argv);
+}
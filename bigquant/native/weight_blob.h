@@ -0,0 +1,240 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WEIGHT_BLOB_H
+#define WEIGHT_BLOB_H
+
+#include <stdio.h>
+#if !defined(WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "alloc.h"
+
+// On-disk layout of a pre-quantized weight blob (all integers little endian, every section starts on a
+// WEIGHT_BLOB_ALIGNMENT boundary so that a mapped file can be used in place):
+//
+//   WeightBlobHeader
+//   kernel sum per output channel            float[channel_out]
+//   for each group:
+//     padded and shuffled weight panel       int8_t[aligned_gemm_m * aligned_gemm_k]
+//     min, max, ratio per output channel     float[gemm_m] x 3
+//
+// The panel is shuffled for one kernel tile shape, so a blob can only be loaded by a library built for an ISA with
+// the same (kernel_m, kernel_k).
+#define WEIGHT_BLOB_MAGIC 0x42575142U  // "BQWB"
+#define WEIGHT_BLOB_VERSION 1
+#define WEIGHT_BLOB_ALIGNMENT 64
+
+typedef enum WEIGHT_BLOB_TYPE { CONV_WEIGHT_BLOB = 0, FC_WEIGHT_BLOB = 1 } WEIGHT_BLOB_TYPE;
+
+struct WeightBlobHeader {
+  uint32_t magic_;
+  uint32_t version_;
+  uint32_t type_;
+  uint32_t layout_;
+
+  uint64_t kernel_m_;
+  uint64_t kernel_n_;
+  uint64_t kernel_k_;
+
+  uint64_t channel_out_;
+  uint64_t channel_in_;
+  uint64_t group_;
+  uint64_t kernel_h_;
+  uint64_t kernel_w_;
+
+  uint64_t gemm_m_;
+  uint64_t gemm_k_;
+  uint64_t aligned_gemm_m_;
+  uint64_t aligned_gemm_k_;
+
+  float weight_threshold_;
+  // WEIGHT_QUANTIZATION, blobs written before it existed hold 0 here which is WEIGHT_7BIT
+  uint32_t weight_quantization_;
+  // Total size of the blob in bytes, including the header
+  uint64_t size_;
+};
+
+// Two blobs are interchangeable when they hold the same weight shape, quantized the same way and shuffled for the same
+// kernel tile
+static inline bool WeightBlobMatch(const WeightBlobHeader &a, const WeightBlobHeader &b) {
+  return (a.type_ == b.type_) && (a.kernel_m_ == b.kernel_m_) && (a.kernel_k_ == b.kernel_k_) &&
+         (a.channel_out_ == b.channel_out_) && (a.channel_in_ == b.channel_in_) && (a.group_ == b.group_) &&
+         (a.kernel_h_ == b.kernel_h_) && (a.kernel_w_ == b.kernel_w_) && (a.gemm_m_ == b.gemm_m_) &&
+         (a.gemm_k_ == b.gemm_k_) && (a.aligned_gemm_m_ == b.aligned_gemm_m_) &&
+         (a.aligned_gemm_k_ == b.aligned_gemm_k_) && (a.weight_quantization_ == b.weight_quantization_);
+}
+
+struct WeightBlobWriter {
+  WeightBlobWriter() : file_(NULL), offset_(0) {
+  }
+
+  ~WeightBlobWriter() {
+    Close();
+  }
+
+  WeightBlobWriter(const WeightBlobWriter &) = delete;
+
+  WeightBlobWriter &operator=(const WeightBlobWriter &) = delete;
+
+  int Open(const char *path) {
+    file_ = fopen(path, "wb");
+    offset_ = 0;
+    return (file_ == NULL) ? WEIGHT_BLOB_IO_ERROR : WEIGHT_BLOB_OK;
+  }
+
+  // Append one section and pad it to the blob alignment
+  int Write(const void *src, size_t size) {
+    static const char padding[WEIGHT_BLOB_ALIGNMENT] = {0};
+    size_t aligned_size = (size + WEIGHT_BLOB_ALIGNMENT - 1) / WEIGHT_BLOB_ALIGNMENT * WEIGHT_BLOB_ALIGNMENT;
+    if (fwrite(src, 1, size, file_) != size) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    if (fwrite(padding, 1, aligned_size - size, file_) != aligned_size - size) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    offset_ += aligned_size;
+    return WEIGHT_BLOB_OK;
+  }
+
+  // Write the header first with size_ unknown, then patch it once all the sections are written
+  int WriteHeader(WeightBlobHeader &header) {
+    header.size_ = offset_;
+    if (fseek(file_, 0, SEEK_SET) != 0) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    if (fwrite(&header, 1, sizeof(header), file_) != sizeof(header)) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    return (fseek(file_, 0, SEEK_END) == 0) ? WEIGHT_BLOB_OK : WEIGHT_BLOB_IO_ERROR;
+  }
+
+  int Close() {
+    int ret = WEIGHT_BLOB_OK;
+    if (file_) {
+      ret = (fclose(file_) == 0) ? WEIGHT_BLOB_OK : WEIGHT_BLOB_IO_ERROR;
+      file_ = NULL;
+    }
+    return ret;
+  }
+
+  FILE *file_;
+  size_t offset_;
+};
+
+// Maps a blob read-only. Falls back to reading the whole file into an aligned buffer where mmap is not available.
+struct WeightBlobReader {
+  WeightBlobReader() : data_(NULL), size_(0), offset_(0), mapped_(false) {
+  }
+
+  ~WeightBlobReader() {
+    Close();
+  }
+
+  WeightBlobReader(const WeightBlobReader &) = delete;
+
+  WeightBlobReader &operator=(const WeightBlobReader &) = delete;
+
+  int Open(const char *path) {
+#if !defined(WINDOWS)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    size_ = st.st_size;
+    void *p = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+      size_ = 0;
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    data_ = p;
+    mapped_ = true;
+#else
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+    fseek(file, 0, SEEK_END);
+    size_ = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    aligned_malloc(&data_, WEIGHT_BLOB_ALIGNMENT, size_);
+    size_t read_size = fread(data_, 1, size_, file);
+    fclose(file);
+    if (read_size != size_) {
+      Close();
+      return WEIGHT_BLOB_IO_ERROR;
+    }
+#endif
+    offset_ = 0;
+    return WEIGHT_BLOB_OK;
+  }
+
+  // Returns the header if the blob is well formed, NULL otherwise
+  const WeightBlobHeader *Header() {
+    if (size_ < sizeof(WeightBlobHeader)) {
+      return NULL;
+    }
+    const WeightBlobHeader *header = reinterpret_cast<const WeightBlobHeader *>(data_);
+    if (header->magic_ != WEIGHT_BLOB_MAGIC || header->version_ != WEIGHT_BLOB_VERSION || header->size_ != size_) {
+      return NULL;
+    }
+    offset_ = (sizeof(WeightBlobHeader) + WEIGHT_BLOB_ALIGNMENT - 1) / WEIGHT_BLOB_ALIGNMENT * WEIGHT_BLOB_ALIGNMENT;
+    return header;
+  }
+
+  // Returns the next section, or NULL when it runs past the end of the blob
+  template <typename DType>
+  const DType *Read(size_t count) {
+    size_t size = sizeof(DType) * count;
+    size_t aligned_size = (size + WEIGHT_BLOB_ALIGNMENT - 1) / WEIGHT_BLOB_ALIGNMENT * WEIGHT_BLOB_ALIGNMENT;
+    if (offset_ + size > size_) {
+      return NULL;
+    }
+    const DType *p = reinterpret_cast<const DType *>(reinterpret_cast<const char *>(data_) + offset_);
+    offset_ += aligned_size;
+    return p;
+  }
+
+  void Close() {
+    if (data_) {
+#if !defined(WINDOWS)
+      munmap(data_, size_);
+#else
+      aligned_free(data_);
+#endif
+      data_ = NULL;
+    }
+    size_ = 0;
+    offset_ = 0;
+    mapped_ = false;
+  }
+
+  void *data_;
+  size_t size_;
+  size_t offset_;
+  bool mapped_;
+};
+
+#endif
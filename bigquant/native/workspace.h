@@ -0,0 +1,142 @@
+/*
+ * Copyright 2016 The BigDL Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include "alloc.h"
+
+// A grow-only scratch arena. The buffer is kept across executions and only reallocated when a request
+// exceeds the current capacity, so repeated executions with the same (or smaller) shapes never touch the heap.
+// Buffers handed out by Acquire are valid until the next Reset/Reserve and their contents are not preserved
+// across a growth.
+struct Workspace {
+  Workspace() : data_(NULL), capacity_(0), offset_(0) {
+  }
+
+  ~Workspace() {
+    Release();
+  }
+
+  Workspace(const Workspace &) = delete;
+
+  Workspace &operator=(const Workspace &) = delete;
+
+  static size_t AlignedSize(size_t size, size_t alignment = 64) {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  void Reserve(size_t size) {
+    if (size > capacity_) {
+      Release();
+      aligned_malloc(&data_, 64, size);
+      capacity_ = size;
+    }
+    offset_ = 0;
+  }
+
+  void Reset() {
+    offset_ = 0;
+  }
+
+  template <typename DType>
+  DType *Acquire(size_t count) {
+    size_t size = AlignedSize(sizeof(DType) * count);
+    if (offset_ + size > capacity_) {
+      fprintf(stderr, "Workspace overflow: request %zu bytes, %zu bytes left.\n", size, capacity_ - offset_);
+      exit(-1);
+    }
+    DType *p = reinterpret_cast<DType *>(reinterpret_cast<char *>(data_) + offset_);
+    offset_ += size;
+    return p;
+  }
+
+  void Release() {
+    if (data_) {
+      aligned_free(data_);
+      data_ = NULL;
+    }
+    capacity_ = 0;
+    offset_ = 0;
+  }
+
+  size_t Capacity() {
+    return capacity_;
+  }
+
+  void *data_;
+  size_t capacity_;
+  size_t offset_;
+};
+
+// The workspaces of one op. Every execution takes one for its whole duration and gives it back afterwards, so
+// executions running concurrently on the same op each get their own scratch memory, while sequential ones keep reusing
+// the same already grown workspace.
+struct WorkspacePool {
+  WorkspacePool() {
+  }
+
+  ~WorkspacePool() {
+    for (size_t i = 0; i < free_.size(); ++i) {
+      delete free_[i];
+    }
+  }
+
+  WorkspacePool(const WorkspacePool &) = delete;
+
+  WorkspacePool &operator=(const WorkspacePool &) = delete;
+
+  Workspace *Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      return new Workspace();
+    }
+    Workspace *workspace = free_.back();
+    free_.pop_back();
+    return workspace;
+  }
+
+  void Release(Workspace *workspace) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(workspace);
+  }
+
+  std::mutex mutex_;
+  std::vector<Workspace *> free_;
+};
+
+// Holds a workspace of the pool for the current scope
+struct ScopedWorkspace {
+  explicit ScopedWorkspace(WorkspacePool &pool) : pool_(pool), workspace_(pool.Acquire()) {
+  }
+
+  ~ScopedWorkspace() {
+    pool_.Release(workspace_);
+  }
+
+  ScopedWorkspace(const ScopedWorkspace &) = delete;
+
+  ScopedWorkspace &operator=(const ScopedWorkspace &) = delete;
+
+  Workspace &Get() {
+    return *workspace_;
+  }
+
+  WorkspacePool &pool_;
+  Workspace *workspace_;
+};
+
+#endif
@@ -22,9 +22,12 @@
 typedef enum LAYOUT { NCHW = 0, NHWC = 1 } LAYOUT;
 typedef enum CONV_ALGORITHM {
   AUTO_SELECT_CONV = 0,
-  SHUFFLE_CONV = 1
+  SHUFFLE_CONV = 1,
+  WINOGRAD_CONV = 2,
+  DEPTHWISE_CONV = 3
 } CONV_ALGORITHM;
 typedef enum FC_ALGORITHM { AUTO_SELECT_FC = 0, SHUFFLE_FC = 1 } FC_ALGORITHM;
+typedef enum POOL_MODE { MAX_POOL = 0, AVG_POOL = 1 } POOL_MODE;
 
 struct FPTensorDesc {
   void *data;
@@ -45,12 +48,28 @@ struct QuantizedTensorDesc {
   size_t workspace_size;
 };
 
+struct QuantizedOpProfile {
+  size_t executions;
+  double total_us;
+  double layout_transform_us;
+  double find_extreme_us;
+  double quantize_us;
+  double gemm_us;
+  double epilogue_us;
+  double bytes;
+  double gops;
+};
+typedef struct QuantizedOpProfile QuantizedOpProfile;
+
 struct QuantizedConvOp;
 typedef struct QuantizedConvOp QuantizedConvOp;
 
 struct QuantizedFCOp;
 typedef struct QuantizedFCOp QuantizedFCOp;
 
+struct QuantizedNetwork;
+typedef struct QuantizedNetwork QuantizedNetwork;
+
 #ifdef WINDOWS
 #define API_PREFIX __declspec(dllexport)
 #else
@@ -78,6 +97,17 @@ API_PREFIX void QuantizedConvOpExecute(QuantizedConvOp *p, float *dst,
                                        size_t batch_size, size_t channel_in,
                                        size_t height_in, size_t width_in);
 
+API_PREFIX void QuantizedConvOpSetProfiling(QuantizedConvOp *p, int enable);
+
+API_PREFIX int QuantizedConvOpGetProfile(QuantizedConvOp *p,
+                                         QuantizedOpProfile *profile);
+
+API_PREFIX int QuantizedConvOpCalibrate(QuantizedConvOp *p, float *data,
+                                        size_t batch_size, size_t channel_in,
+                                        size_t height_in, size_t width_in);
+
+API_PREFIX int QuantizedConvOpFreezeCalibration(QuantizedConvOp *p);
+
 API_PREFIX void QuantizedConvOpFree(QuantizedConvOp *p);
 
 QuantizedFCOp *QuantizedFCOpCreate();
@@ -95,6 +125,35 @@ API_PREFIX void QuantizedFCOpExecute(QuantizedFCOp *p, float *dst, float *data,
 
 API_PREFIX void QuantizedFCOpFree(QuantizedFCOp *p);
 
+API_PREFIX QuantizedNetwork *QuantizedNetworkCreate();
+
+API_PREFIX int QuantizedNetworkAddConv(QuantizedNetwork *p, QuantizedConvOp *op,
+                                       int input, float *bias);
+
+API_PREFIX int QuantizedNetworkAddFC(QuantizedNetwork *p, QuantizedFCOp *op,
+                                     int input, float *bias);
+
+API_PREFIX int QuantizedNetworkAddPool(QuantizedNetwork *p, int input,
+                                       POOL_MODE mode, size_t kernel_h,
+                                       size_t kernel_w, size_t stride_h,
+                                       size_t stride_w, size_t pad_h,
+                                       size_t pad_w);
+
+API_PREFIX int QuantizedNetworkAddEltwiseSum(QuantizedNetwork *p, int input_a,
+                                             int input_b, int relu);
+
+API_PREFIX void QuantizedNetworkCompile(QuantizedNetwork *p, size_t channel_in,
+                                        size_t height_in, size_t width_in);
+
+API_PREFIX void QuantizedNetworkGetOutputShape(QuantizedNetwork *p,
+                                               size_t *channel, size_t *height,
+                                               size_t *width);
+
+API_PREFIX void QuantizedNetworkExecute(QuantizedNetwork *p, float *dst,
+                                        float *data, size_t batch_size);
+
+API_PREFIX void QuantizedNetworkFree(QuantizedNetwork *p);
+
 API_PREFIX void
 QuantizedConvKernelDescInit(struct QuantizedTensorDesc *quantized_tensor,
                             size_t c_out, size_t c_in, size_t kernel_h,
@@ -11,6 +11,18 @@ extern "C" {
 #define com_intel_analytics_bigdl_bigquant_BigQuant_NCHW 0L
 #undef com_intel_analytics_bigdl_bigquant_BigQuant_NHWC
 #define com_intel_analytics_bigdl_bigquant_BigQuant_NHWC 1L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_AUTO_SELECT_CONV
+#define com_intel_analytics_bigdl_bigquant_BigQuant_AUTO_SELECT_CONV 0L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_SHUFFLE_CONV
+#define com_intel_analytics_bigdl_bigquant_BigQuant_SHUFFLE_CONV 1L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_WINOGRAD_CONV
+#define com_intel_analytics_bigdl_bigquant_BigQuant_WINOGRAD_CONV 2L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_DEPTHWISE_CONV
+#define com_intel_analytics_bigdl_bigquant_BigQuant_DEPTHWISE_CONV 3L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_MAX_POOL
+#define com_intel_analytics_bigdl_bigquant_BigQuant_MAX_POOL 0L
+#undef com_intel_analytics_bigdl_bigquant_BigQuant_AVG_POOL
+#define com_intel_analytics_bigdl_bigquant_BigQuant_AVG_POOL 1L
 /*
  * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
  * Method:    printHello
@@ -158,6 +170,227 @@ Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCDataInit(JNIEnv *, jclass,
                                                             jint, jint, jint,
                                                             jfloat, jint);
 
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpCreate(JNIEnv *, jclass);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpSetupConvParameter
+ * Signature: (JIIIIIIIIIIIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpSetupConvParameter(
+    JNIEnv *, jclass, jlong, jint, jint, jint, jint, jint, jint, jint, jint,
+    jint, jint, jint, jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpInitWeight
+ * Signature: (J[FI)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpInitWeight(JNIEnv *,
+                                                                  jclass,
+                                                                  jlong,
+                                                                  jfloatArray,
+                                                                  jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpExecute
+ * Signature: (J[FI[FI[FIIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpExecute(
+    JNIEnv *, jclass, jlong, jfloatArray, jint, jfloatArray, jint, jfloatArray,
+    jint, jint, jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpFree(JNIEnv *, jclass,
+                                                            jlong);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpCalibrate
+ * Signature: (J[FIIIII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpCalibrate(
+    JNIEnv *, jclass, jlong, jfloatArray, jint, jint, jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpFreezeCalibration
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpFreezeCalibration(
+    JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpCreate(JNIEnv *, jclass);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpSetupFCParameter
+ * Signature: (JIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpSetupFCParameter(
+    JNIEnv *, jclass, jlong, jint, jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpInitWeight
+ * Signature: (J[FI)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpInitWeight(JNIEnv *,
+                                                                jclass, jlong,
+                                                                jfloatArray,
+                                                                jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpExecute
+ * Signature: (J[FI[FI[FIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpExecute(
+    JNIEnv *, jclass, jlong, jfloatArray, jint, jfloatArray, jint, jfloatArray,
+    jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpFree(JNIEnv *, jclass,
+                                                          jlong);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkCreate(JNIEnv *,
+                                                               jclass);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddConv
+ * Signature: (JJI[FI)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddConv(
+    JNIEnv *, jclass, jlong, jlong, jint, jfloatArray, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddFC
+ * Signature: (JJI[FI)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddFC(JNIEnv *, jclass,
+                                                              jlong, jlong,
+                                                              jint, jfloatArray,
+                                                              jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddPool
+ * Signature: (JIIIIIIII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddPool(
+    JNIEnv *, jclass, jlong, jint, jint, jint, jint, jint, jint, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddEltwiseSum
+ * Signature: (JIIZ)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddEltwiseSum(
+    JNIEnv *, jclass, jlong, jint, jint, jboolean);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkCompile
+ * Signature: (JIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkCompile(JNIEnv *,
+                                                                jclass, jlong,
+                                                                jint, jint,
+                                                                jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkGetOutputShape
+ * Signature: (J[I)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkGetOutputShape(
+    JNIEnv *, jclass, jlong, jintArray);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkExecute
+ * Signature: (J[FI[FII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkExecute(
+    JNIEnv *, jclass, jlong, jfloatArray, jint, jfloatArray, jint, jint);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkFree(JNIEnv *, jclass,
+                                                             jlong);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpSetProfiling
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpSetProfiling(JNIEnv *,
+                                                                    jclass,
+                                                                    jlong,
+                                                                    jboolean);
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpGetProfile
+ * Signature: (J[D)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpGetProfile(JNIEnv *,
+                                                                  jclass,
+                                                                  jlong,
+                                                                  jdoubleArray);
+
 #ifdef __cplusplus
 }
 #endif
@@ -282,6 +282,404 @@ Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCDataInit(
   (*env)->ReleasePrimitiveArrayCritical(env, src, jni_src, 0);
 }
 
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpCreate(JNIEnv *env,
+                                                              jclass cls)
+{
+  return (jlong)QuantizedConvOpCreate();
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpSetupConvParameter
+ * Signature: (JIIIIIIIIIIIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpSetupConvParameter(
+    JNIEnv *env, jclass cls, jlong op, jint layout, jint channel_out,
+    jint channel_in, jint group, jint kernel_h, jint kernel_w, jint stride_h,
+    jint stride_w, jint pad_h, jint pad_w, jint dilation_h, jint dilation_w,
+    jint fusion_mask, jint algo)
+{
+  QuantizedConvOpSetupConvParameter(
+      (QuantizedConvOp *)op, layout, channel_out, channel_in, group, kernel_h,
+      kernel_w, stride_h, stride_w, pad_h, pad_w, dilation_h, dilation_w,
+      fusion_mask, algo);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpInitWeight
+ * Signature: (J[FI)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpInitWeight(
+    JNIEnv *env, jclass cls, jlong op, jfloatArray weight, jint weightOffset)
+{
+  jfloat *jni_weight =
+      (*env)->GetPrimitiveArrayCritical(env, weight, JNI_FALSE);
+  QuantizedConvOpInitWeight((QuantizedConvOp *)op, jni_weight + weightOffset);
+  (*env)->ReleasePrimitiveArrayCritical(env, weight, jni_weight, 0);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpExecute
+ * Signature: (J[FI[FI[FIIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpExecute(
+    JNIEnv *env, jclass cls, jlong op, jfloatArray dst, jint dstOffset,
+    jfloatArray data, jint dataOffset, jfloatArray bias, jint biasOffset,
+    jint batch_size, jint channel_in, jint height_in, jint width_in)
+{
+  jfloat *jni_dst = (*env)->GetPrimitiveArrayCritical(env, dst, JNI_FALSE);
+  jfloat *jni_data = (*env)->GetPrimitiveArrayCritical(env, data, JNI_FALSE);
+  jfloat *jni_bias = NULL;
+  if (bias != NULL) {
+    jni_bias = (*env)->GetPrimitiveArrayCritical(env, bias, JNI_FALSE);
+  }
+
+  QuantizedConvOpExecute((QuantizedConvOp *)op, jni_dst + dstOffset,
+                         jni_data + dataOffset,
+                         jni_bias == NULL ? NULL : jni_bias + biasOffset,
+                         batch_size, channel_in, height_in, width_in);
+
+  if (bias != NULL) {
+    (*env)->ReleasePrimitiveArrayCritical(env, bias, jni_bias, 0);
+  }
+  (*env)->ReleasePrimitiveArrayCritical(env, data, jni_data, 0);
+  (*env)->ReleasePrimitiveArrayCritical(env, dst, jni_dst, 0);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpFree(JNIEnv *env,
+                                                            jclass cls,
+                                                            jlong op)
+{
+  QuantizedConvOpFree((QuantizedConvOp *)op);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpCalibrate
+ * Signature: (J[FIIIII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpCalibrate(
+    JNIEnv *env, jclass cls, jlong op, jfloatArray data, jint dataOffset,
+    jint batch_size, jint channel_in, jint height_in, jint width_in)
+{
+  jint ret;
+  jfloat *jni_data = (*env)->GetPrimitiveArrayCritical(env, data, JNI_FALSE);
+  ret = QuantizedConvOpCalibrate((QuantizedConvOp *)op, jni_data + dataOffset,
+                                 batch_size, channel_in, height_in, width_in);
+  (*env)->ReleasePrimitiveArrayCritical(env, data, jni_data, 0);
+  return ret;
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpFreezeCalibration
+ * Signature: (J)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpFreezeCalibration(
+    JNIEnv *env, jclass cls, jlong op)
+{
+  return QuantizedConvOpFreezeCalibration((QuantizedConvOp *)op);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpCreate(JNIEnv *env,
+                                                            jclass cls)
+{
+  return (jlong)QuantizedFCOpCreate();
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpSetupFCParameter
+ * Signature: (JIIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpSetupFCParameter(
+    JNIEnv *env, jclass cls, jlong op, jint layout, jint channel_out,
+    jint channel_in, jint algo)
+{
+  QuantizedFCOpSetupFCParameter((QuantizedFCOp *)op, layout, channel_out,
+                                channel_in, algo);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpInitWeight
+ * Signature: (J[FI)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpInitWeight(
+    JNIEnv *env, jclass cls, jlong op, jfloatArray weight, jint weightOffset)
+{
+  jfloat *jni_weight =
+      (*env)->GetPrimitiveArrayCritical(env, weight, JNI_FALSE);
+  QuantizedFCOpInitWeight((QuantizedFCOp *)op, jni_weight + weightOffset);
+  (*env)->ReleasePrimitiveArrayCritical(env, weight, jni_weight, 0);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpExecute
+ * Signature: (J[FI[FI[FIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpExecute(
+    JNIEnv *env, jclass cls, jlong op, jfloatArray dst, jint dstOffset,
+    jfloatArray data, jint dataOffset, jfloatArray bias, jint biasOffset,
+    jint batch_size, jint channel_in)
+{
+  jfloat *jni_dst = (*env)->GetPrimitiveArrayCritical(env, dst, JNI_FALSE);
+  jfloat *jni_data = (*env)->GetPrimitiveArrayCritical(env, data, JNI_FALSE);
+  jfloat *jni_bias = NULL;
+  if (bias != NULL) {
+    jni_bias = (*env)->GetPrimitiveArrayCritical(env, bias, JNI_FALSE);
+  }
+
+  QuantizedFCOpExecute((QuantizedFCOp *)op, jni_dst + dstOffset,
+                       jni_data + dataOffset,
+                       jni_bias == NULL ? NULL : jni_bias + biasOffset,
+                       batch_size, channel_in);
+
+  if (bias != NULL) {
+    (*env)->ReleasePrimitiveArrayCritical(env, bias, jni_bias, 0);
+  }
+  (*env)->ReleasePrimitiveArrayCritical(env, data, jni_data, 0);
+  (*env)->ReleasePrimitiveArrayCritical(env, dst, jni_dst, 0);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    FCOpFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_FCOpFree(JNIEnv *env,
+                                                          jclass cls,
+                                                          jlong op)
+{
+  QuantizedFCOpFree((QuantizedFCOp *)op);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkCreate
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkCreate(JNIEnv *env,
+                                                               jclass cls)
+{
+  return (jlong)QuantizedNetworkCreate();
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddConv
+ * Signature: (JJI[FI)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddConv(
+    JNIEnv *env, jclass cls, jlong network, jlong op, jint input,
+    jfloatArray bias, jint biasOffset)
+{
+  jint ret;
+  jfloat *jni_bias = NULL;
+  if (bias != NULL) {
+    jni_bias = (*env)->GetPrimitiveArrayCritical(env, bias, JNI_FALSE);
+  }
+  ret = QuantizedNetworkAddConv(
+      (QuantizedNetwork *)network, (QuantizedConvOp *)op, input,
+      jni_bias == NULL ? NULL : jni_bias + biasOffset);
+  if (bias != NULL) {
+    (*env)->ReleasePrimitiveArrayCritical(env, bias, jni_bias, 0);
+  }
+  return ret;
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddFC
+ * Signature: (JJI[FI)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddFC(
+    JNIEnv *env, jclass cls, jlong network, jlong op, jint input,
+    jfloatArray bias, jint biasOffset)
+{
+  jint ret;
+  jfloat *jni_bias = NULL;
+  if (bias != NULL) {
+    jni_bias = (*env)->GetPrimitiveArrayCritical(env, bias, JNI_FALSE);
+  }
+  ret = QuantizedNetworkAddFC((QuantizedNetwork *)network, (QuantizedFCOp *)op,
+                              input,
+                              jni_bias == NULL ? NULL : jni_bias + biasOffset);
+  if (bias != NULL) {
+    (*env)->ReleasePrimitiveArrayCritical(env, bias, jni_bias, 0);
+  }
+  return ret;
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddPool
+ * Signature: (JIIIIIIII)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddPool(
+    JNIEnv *env, jclass cls, jlong network, jint input, jint mode,
+    jint kernel_h, jint kernel_w, jint stride_h, jint stride_w, jint pad_h,
+    jint pad_w)
+{
+  return QuantizedNetworkAddPool((QuantizedNetwork *)network, input, mode,
+                                 kernel_h, kernel_w, stride_h, stride_w, pad_h,
+                                 pad_w);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkAddEltwiseSum
+ * Signature: (JIIZ)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkAddEltwiseSum(
+    JNIEnv *env, jclass cls, jlong network, jint input_a, jint input_b,
+    jboolean relu)
+{
+  return QuantizedNetworkAddEltwiseSum((QuantizedNetwork *)network, input_a,
+                                       input_b, relu == JNI_TRUE);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkCompile
+ * Signature: (JIII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkCompile(
+    JNIEnv *env, jclass cls, jlong network, jint channel_in, jint height_in,
+    jint width_in)
+{
+  QuantizedNetworkCompile((QuantizedNetwork *)network, channel_in, height_in,
+                          width_in);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkGetOutputShape
+ * Signature: (J[I)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkGetOutputShape(
+    JNIEnv *env, jclass cls, jlong network, jintArray shape)
+{
+  size_t channel, height, width;
+  jint values[3];
+
+  QuantizedNetworkGetOutputShape((QuantizedNetwork *)network, &channel, &height,
+                                 &width);
+  values[0] = (jint)channel;
+  values[1] = (jint)height;
+  values[2] = (jint)width;
+  (*env)->SetIntArrayRegion(env, shape, 0, 3, values);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkExecute
+ * Signature: (J[FI[FII)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkExecute(
+    JNIEnv *env, jclass cls, jlong network, jfloatArray dst, jint dstOffset,
+    jfloatArray data, jint dataOffset, jint batch_size)
+{
+  jfloat *jni_dst = (*env)->GetPrimitiveArrayCritical(env, dst, JNI_FALSE);
+  jfloat *jni_data = (*env)->GetPrimitiveArrayCritical(env, data, JNI_FALSE);
+  QuantizedNetworkExecute((QuantizedNetwork *)network, jni_dst + dstOffset,
+                          jni_data + dataOffset, batch_size);
+  (*env)->ReleasePrimitiveArrayCritical(env, data, jni_data, 0);
+  (*env)->ReleasePrimitiveArrayCritical(env, dst, jni_dst, 0);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    NetworkFree
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_NetworkFree(JNIEnv *env,
+                                                             jclass cls,
+                                                             jlong network)
+{
+  QuantizedNetworkFree((QuantizedNetwork *)network);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpSetProfiling
+ * Signature: (JZ)V
+ */
+JNIEXPORT void JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpSetProfiling(
+    JNIEnv *env, jclass cls, jlong op, jboolean enable)
+{
+  QuantizedConvOpSetProfiling((QuantizedConvOp *)op, enable == JNI_TRUE);
+}
+
+/*
+ * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
+ * Method:    ConvOpGetProfile
+ * Signature: (J[D)I
+ */
+JNIEXPORT jint JNICALL
+Java_com_intel_analytics_bigdl_bigquant_BigQuant_ConvOpGetProfile(
+    JNIEnv *env, jclass cls, jlong op, jdoubleArray profile)
+{
+  QuantizedOpProfile counters;
+  jdouble values[9];
+
+  if ((*env)->GetArrayLength(env, profile) < 9 ||
+      QuantizedConvOpGetProfile((QuantizedConvOp *)op, &counters) != 0) {
+    return -1;
+  }
+  values[0] = (jdouble)counters.executions;
+  values[1] = counters.total_us;
+  values[2] = counters.layout_transform_us;
+  values[3] = counters.find_extreme_us;
+  values[4] = counters.quantize_us;
+  values[5] = counters.gemm_us;
+  values[6] = counters.epilogue_us;
+  values[7] = counters.bytes;
+  values[8] = counters.gops;
+  (*env)->SetDoubleArrayRegion(env, profile, 0, 9, values);
+  return 0;
+}
+
 /*
  * Class:     com_intel_analytics_bigdl_bigquant_BigQuant
  * Method:    loadRuntime
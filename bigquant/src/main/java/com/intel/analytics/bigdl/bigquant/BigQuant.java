@@ -20,6 +20,12 @@ public class BigQuant {
     private static boolean isLoaded = false;
     public final static int NCHW = 0;
     public final static int NHWC = 1;
+    public final static int AUTO_SELECT_CONV = 0;
+    public final static int SHUFFLE_CONV = 1;
+    public final static int WINOGRAD_CONV = 2;
+    public final static int DEPTHWISE_CONV = 3;
+    public final static int MAX_POOL = 0;
+    public final static int AVG_POOL = 1;
 
     static {
         try {
@@ -142,4 +148,126 @@ public class BigQuant {
                                          int channel,
                                          float threshold,
                                          int layout);
+
+    public native static long ConvOpCreate();
+
+    public native static void ConvOpSetupConvParameter(long op,
+                                                       int layout,
+                                                       int channel_out,
+                                                       int channel_in,
+                                                       int group,
+                                                       int kernel_h,
+                                                       int kernel_w,
+                                                       int stride_h,
+                                                       int stride_w,
+                                                       int pad_h,
+                                                       int pad_w,
+                                                       int dilation_h,
+                                                       int dilation_w,
+                                                       int fusion_mask,
+                                                       int algo);
+
+    public native static void ConvOpInitWeight(long op, float[] weight, int weightOffset);
+
+    /**
+     * bias may be null.
+     */
+    public native static void ConvOpExecute(long op,
+                                            float[] dst, int dstOffset,
+                                            float[] data, int dataOffset,
+                                            float[] bias, int biasOffset,
+                                            int batch_size,
+                                            int channel_in,
+                                            int height_in,
+                                            int width_in);
+
+    /**
+     * Calibrate and FreezeCalibration return 0, or -1 when the op quantizes
+     * its data dynamically (WINOGRAD_CONV).
+     */
+    public native static int ConvOpCalibrate(long op,
+                                             float[] data, int dataOffset,
+                                             int batch_size,
+                                             int channel_in,
+                                             int height_in,
+                                             int width_in);
+
+    public native static int ConvOpFreezeCalibration(long op);
+
+    public native static void ConvOpFree(long op);
+
+    public native static long FCOpCreate();
+
+    public native static void FCOpSetupFCParameter(long op,
+                                                   int layout,
+                                                   int channel_out,
+                                                   int channel_in,
+                                                   int algo);
+
+    public native static void FCOpInitWeight(long op, float[] weight, int weightOffset);
+
+    /**
+     * bias may be null.
+     */
+    public native static void FCOpExecute(long op,
+                                          float[] dst, int dstOffset,
+                                          float[] data, int dataOffset,
+                                          float[] bias, int biasOffset,
+                                          int batch_size,
+                                          int channel_in);
+
+    public native static void FCOpFree(long op);
+
+    /**
+     * A network of ops run in one call on NHWC activations. Tensor 0 is the input and every Add
+     * returns the tensor written by the new node. The ops are not owned by the network and must
+     * outlive it, with their weight initialized and their calibration frozen before Compile.
+     * The bias of a node is copied and may be null.
+     */
+    public native static long NetworkCreate();
+
+    public native static int NetworkAddConv(long network, long op, int input,
+                                            float[] bias, int biasOffset);
+
+    public native static int NetworkAddFC(long network, long op, int input,
+                                          float[] bias, int biasOffset);
+
+    public native static int NetworkAddPool(long network,
+                                            int input,
+                                            int mode,
+                                            int kernel_h,
+                                            int kernel_w,
+                                            int stride_h,
+                                            int stride_w,
+                                            int pad_h,
+                                            int pad_w);
+
+    public native static int NetworkAddEltwiseSum(long network, int input_a, int input_b,
+                                                  boolean relu);
+
+    public native static void NetworkCompile(long network,
+                                             int channel_in,
+                                             int height_in,
+                                             int width_in);
+
+    /**
+     * Fills shape, of at least 3 elements, with the channel, height and width of the output.
+     */
+    public native static void NetworkGetOutputShape(long network, int[] shape);
+
+    public native static void NetworkExecute(long network,
+                                             float[] dst, int dstOffset,
+                                             float[] data, int dataOffset,
+                                             int batch_size);
+
+    public native static void NetworkFree(long network);
+
+    public native static void ConvOpSetProfiling(long op, boolean enable);
+
+    /**
+     * Fills profile, of at least 9 elements, with the counters of a profiled op from ConvOpCreate:
+     * executions, total, layout transform, find extreme, quantize, GEMM and epilogue
+     * microseconds, bytes moved and GOPS. Returns -1 when profiling is off or profile is short.
+     */
+    public native static int ConvOpGetProfile(long op, double[] profile);
 }
@@ -30,6 +30,8 @@ import java.util.List;
 public class Loader {
     private String prefix = "lib";
     private List<String> libraries = new ArrayList<String>();
+    // built only when the compiler supports the ISA, the runtime falls back to the next tier without them
+    private List<String> optionalLibraries = new ArrayList<String>();
     private String os = System.getProperty("os.name").toLowerCase();
 
     public void init() throws IOException {
@@ -42,6 +44,9 @@ public class Loader {
         // because the default version of gcc installed by brew doesn't enable this feature
         if (!os.contains("mac")) {
             libraries.add("bigquant_avx512");
+            libraries.add("bigquant_avx512vnni");
+            optionalLibraries.add("bigquant_avxvnni");
+            optionalLibraries.add("bigquant_amx");
         }
 
         // TODO for windows, we don't create bigquant.native dir
@@ -86,6 +91,14 @@ public class Loader {
             copyLibraryToTemp(src, library, tempDir);
             src.close();
         }
+        for (String name: optionalLibraries) {
+            String library = libraryName(name);
+            if (Loader.class.getResource("/" + library) != null) {
+                ReadableByteChannel src = resource(library);
+                copyLibraryToTemp(src, library, tempDir);
+                src.close();
+            }
+        }
     }
 
     private ReadableByteChannel resource(String name) throws NullPointerException {